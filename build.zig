@@ -48,6 +48,7 @@ const okaylib_headers = &[_][]const u8{
     "construct.h",
     "context.h",
     "defer.h",
+    "hash.h",
     "opt.h",
     "res.h",
     "short_arithmetic_types.h",
@@ -57,14 +58,21 @@ const okaylib_headers = &[_][]const u8{
     "stdmem.h",
     "version.h",
 
+    "algorithm/binary_search.h",
+    "algorithm/parallel_sort.h",
+    "algorithm/select.h",
+    "algorithm/sort.h",
+
     "allocators/allocator.h",
     "allocators/arena.h",
     "allocators/block_allocator.h",
     "allocators/c_allocator.h",
+    "allocators/fallback_allocator.h",
     "allocators/linked_blockpool_allocator.h",
     "allocators/linked_slab_allocator.h",
     "allocators/page_allocator.h",
     "allocators/reserving_page_allocator.h",
+    "allocators/sampling_allocator.h",
     "allocators/slab_allocator.h",
 
     "containers/array.h",
@@ -73,6 +81,19 @@ const okaylib_headers = &[_][]const u8{
     "containers/bit_array.h",
     "containers/fixed_arraylist.h",
     "containers/segmented_list.h",
+    "containers/concurrent_segmented_list.h",
+    "containers/eytzinger_index.h",
+    "containers/rank_select_index.h",
+    "containers/roaring_bitmap.h",
+    "containers/atomic_bit_array.h",
+    "containers/hashmap.h",
+    "containers/concurrent_hashmap.h",
+    "containers/btree_map.h",
+    "containers/flat_map.h",
+    "containers/flat_set.h",
+    "containers/ring_deque.h",
+    "containers/bounded_queue.h",
+    "containers/small_arraylist.h",
     "containers/arcpool.h",
 
     "detail/template_util/c_array_length.h",
@@ -99,9 +120,11 @@ const okaylib_headers = &[_][]const u8{
     "detail/ok_unreachable.h",
     "detail/view_common.h",
     "detail/memory.h",
+    "detail/traits/is_trivially_relocatable.h",
 
     "macros/try.h",
 
+    "math/fast_divisor.h",
     "math/math.h",
     "math/ordering.h",
     "math/rounding.h",
@@ -111,6 +134,7 @@ const okaylib_headers = &[_][]const u8{
     "iterables/iterables.h",
 
     "platform/memory_map.h",
+    "platform/numa.h",
     "smart_pointers/arc.h",
 };
 
@@ -123,19 +147,39 @@ const test_source_files = &[_][]const u8{
     "status/status.cpp",
     "stdmem/stdmem.cpp",
     "ordering/ordering.cpp",
+    "fast_divisor/fast_divisor.cpp",
     "tuple/tuple.cpp",
     "c_allocator/c_allocator.cpp",
     "arena_allocator/arena_allocator.cpp",
+    "fallback_allocator/fallback_allocator.cpp",
+    "sampling_allocator/sampling_allocator.cpp",
     "linked_blockpool_allocator/linked_blockpool_allocator.cpp",
     "slab_allocator/slab_allocator.cpp",
     "block_allocator/block_allocator.cpp",
     "arc/arc.cpp",
     "arcpool/arcpool.cpp",
     "arraylist/arraylist.cpp",
+    "small_arraylist/small_arraylist.cpp",
     "bit_array/bit_array.cpp",
     "bit_arraylist/bit_arraylist.cpp",
     "segmented_list/segmented_list.cpp",
+    "concurrent_segmented_list/concurrent_segmented_list.cpp",
+    "trivially_relocatable/trivially_relocatable.cpp",
     "reflection/reflection.cpp",
+    "sort/sort.cpp",
+    "select/select.cpp",
+    "binary_search/binary_search.cpp",
+    "eytzinger_index/eytzinger_index.cpp",
+    "rank_select_index/rank_select_index.cpp",
+    "roaring_bitmap/roaring_bitmap.cpp",
+    "atomic_bit_array/atomic_bit_array.cpp",
+    "hashmap/hashmap.cpp",
+    "concurrent_hashmap/concurrent_hashmap.cpp",
+    "btree_map/btree_map.cpp",
+    "flat_map/flat_map.cpp",
+    "flat_set/flat_set.cpp",
+    "ring_deque/ring_deque.cpp",
+    "bounded_queue/bounded_queue.cpp",
 
     "iterables/iterables.cpp",
     "iterables/algorithm/iterators_copy.cpp",
@@ -0,0 +1,140 @@
+#ifndef __OKAYLIB_ALGORITHM_BINARY_SEARCH_H__
+#define __OKAYLIB_ALGORITHM_BINARY_SEARCH_H__
+
+#include "okay/detail/type_traits.h"
+#include "okay/math/ordering.h"
+#include "okay/slice.h"
+
+/// Binary search over sorted slices. Comparators take an item and the value
+/// being searched for, and return an ordering, the same as ok::cmp(item,
+/// value). The default is to compare them with operator<=>.
+///
+/// The searches are branchless: each step is a conditional move rather than a
+/// branch, so there are no mispredictions and the loop always runs
+/// log2(size) + 1 times. That makes them several times faster than a branchy
+/// search for tables which fit in the cache. For tables much bigger than the
+/// cache, every step is a cache miss either way: see
+/// okay/containers/eytzinger_index.h, which lays the table out so that
+/// lookups can prefetch.
+namespace ok {
+namespace detail {
+
+/// Returns the index of the first item for which is_before(item) is false. All
+/// the items for which it is true must come first.
+template <typename T, typename is_before_t>
+[[nodiscard]] constexpr size_t
+partition_point(const T* begin, size_t size,
+                const is_before_t& is_before) OKAYLIB_NOEXCEPT
+{
+    if (size == 0)
+        return 0;
+
+    // the answer is always within [base, base + size]
+    const T* base = begin;
+    while (size > 1) {
+        const size_t half = size / 2;
+        base = is_before(base[half]) ? base + half : base;
+        size -= half;
+    }
+    return size_t(base - begin) + size_t(is_before(*base));
+}
+
+template <typename T, typename value_t, typename compare_t>
+concept search_compare_c =
+    requires(const compare_t& compare, const T& item, const value_t& value) {
+        { compare(item, value) < 0 } -> ok::stdc::convertible_to_c<bool>;
+    };
+
+template <typename T, typename value_t>
+concept default_searchable_c = requires(const T& item, const value_t& value) {
+    { (item <=> value) < 0 } -> ok::stdc::convertible_to_c<bool>;
+};
+
+struct default_search_compare_t
+{
+    template <typename T, typename value_t>
+    [[nodiscard]] constexpr auto
+    operator()(const T& item, const value_t& value) const OKAYLIB_NOEXCEPT
+    {
+        return item <=> value;
+    }
+};
+
+template <bool is_upper> struct bound_fn_t
+{
+    template <typename T, typename value_t>
+        requires default_searchable_c<T, value_t>
+    [[nodiscard]] constexpr size_t
+    operator()(slice<T> items, const value_t& value) const OKAYLIB_NOEXCEPT
+    {
+        return (*this)(items, value, default_search_compare_t{});
+    }
+
+    template <typename T, typename value_t, typename compare_t>
+        requires search_compare_c<T, value_t, compare_t>
+    [[nodiscard]] constexpr size_t
+    operator()(slice<T> items, const value_t& value,
+               const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        if (items.is_empty())
+            return 0;
+        return detail::partition_point(
+            items.unchecked_address_of_first_item(), items.size(),
+            [&](const T& item) {
+                if constexpr (is_upper)
+                    return compare(item, value) <= 0;
+                else
+                    return compare(item, value) < 0;
+            });
+    }
+};
+
+struct equal_range_fn_t
+{
+    template <typename T, typename value_t>
+        requires default_searchable_c<T, value_t>
+    [[nodiscard]] constexpr subslice_options_t
+    operator()(slice<T> items, const value_t& value) const OKAYLIB_NOEXCEPT
+    {
+        return (*this)(items, value, default_search_compare_t{});
+    }
+
+    template <typename T, typename value_t, typename compare_t>
+        requires search_compare_c<T, value_t, compare_t>
+    [[nodiscard]] constexpr subslice_options_t
+    operator()(slice<T> items, const value_t& value,
+               const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        const size_t start = bound_fn_t<false>{}(items, value, compare);
+        if (start == items.size())
+            return {.start = start, .length = 0};
+        // the upper bound can only be at or after the lower bound
+        const T* const rest = items.unchecked_address_of_first_item() + start;
+        const size_t length = detail::partition_point(
+            rest, items.size() - start,
+            [&](const T& item) { return compare(item, value) <= 0; });
+        return {.start = start, .length = length};
+    }
+};
+
+} // namespace detail
+
+/// Index of the first item in a sorted slice which is not less than value, or
+/// the size of the slice if there is none.
+/// ok::lower_bound(items, value) or ok::lower_bound(items, value, compare)
+inline constexpr detail::bound_fn_t<false> lower_bound;
+
+/// Index of the first item in a sorted slice which is greater than value, or
+/// the size of the slice if there is none.
+/// ok::upper_bound(items, value) or ok::upper_bound(items, value, compare)
+inline constexpr detail::bound_fn_t<true> upper_bound;
+
+/// The start and length of the run of items in a sorted slice which are equal
+/// to value. If there are none, the length is zero and the start is where
+/// value would be inserted.
+/// ok::equal_range(items, value) or ok::equal_range(items, value, compare)
+inline constexpr detail::equal_range_fn_t equal_range;
+
+} // namespace ok
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef __OKAYLIB_ALGORITHM_PARALLEL_SORT_H__
+#define __OKAYLIB_ALGORITHM_PARALLEL_SORT_H__
+
+#include "okay/algorithm/sort.h"
+#include <thread>
+
+namespace ok {
+struct parallel_sort_options_t
+{
+    // zero means one per hardware thread
+    size_t num_threads = 0;
+    // inputs smaller than this many items per thread use fewer threads, and
+    // small enough inputs are just sorted on the calling thread
+    size_t min_items_per_thread = size_t(1) << 16;
+};
+
+namespace detail {
+namespace parallel_merge_sort {
+
+/// Calls fn(thread_index) for each thread index, on num_threads threads,
+/// including the calling thread, and waits for all of them.
+template <typename fn_t>
+inline void run_on_threads(size_t num_threads, const fn_t& fn)
+{
+    constexpr size_t max_threads = 256;
+    __ok_internal_assert(num_threads <= max_threads);
+    std::thread threads[max_threads];
+    for (size_t i = 1; i < num_threads; ++i)
+        threads[i] = std::thread([&fn, i] { fn(i); });
+    fn(0);
+    for (size_t i = 1; i < num_threads; ++i)
+        threads[i].join();
+}
+
+/// The number of items that the first output_index items of a stable merge of
+/// a and b take from a.
+template <typename T, typename less_t>
+[[nodiscard]] size_t items_taken_from_left(const T* a, size_t a_size,
+                                           const T* b, size_t b_size,
+                                           size_t output_index,
+                                           const less_t& less)
+{
+    size_t low = output_index > b_size ? output_index - b_size : 0;
+    size_t high = output_index < a_size ? output_index : a_size;
+    while (low < high) {
+        const size_t i = low + (high - low) / 2;
+        const size_t j = output_index - i;
+        // if b[j - 1] does not come before a[i], then a[i] is also within the
+        // first output_index items
+        if (j > 0 && i < a_size && !less(b[j - 1], a[i]))
+            low = i + 1;
+        else
+            high = i;
+    }
+    return low;
+}
+
+/// Stable merge, relocating items bytewise from a and b into out.
+template <typename T, typename less_t>
+void merge(const T* a, const T* a_end, const T* b, const T* b_end, T* out,
+           const less_t& less)
+{
+    while (a != a_end && b != b_end) {
+        const T* taken = less(*b, *a) ? b++ : a++;
+        ::memcpy((void*)out++, (const void*)taken, sizeof(T));
+    }
+    if (a != a_end)
+        ::memcpy((void*)out, (const void*)a, sizeof(T) * size_t(a_end - a));
+    if (b != b_end)
+        ::memcpy((void*)out, (const void*)b, sizeof(T) * size_t(b_end - b));
+}
+
+/// Sort each of num_threads chunks on its own thread, then merge pairs of
+/// sorted runs until there is one left. Every merge is split into pieces by
+/// binary searching for where each piece starts in both inputs, so all the
+/// threads are busy even during the last merge.
+template <typename T, typename less_t>
+void sort(T* begin, size_t size, T* scratch, size_t num_threads,
+          const less_t& less)
+{
+    constexpr bool branchless = stdc::is_arithmetic_v<T> ||
+                                stdc::is_pointer_v<T> || stdc::is_enum_v<T>;
+
+    // run * size / num_runs, without overflowing for huge inputs
+    const auto run_start = [size](size_t run, size_t num_runs) {
+        return run * (size / num_runs) + run * (size % num_runs) / num_runs;
+    };
+
+    run_on_threads(num_threads, [&](size_t thread) {
+        pdqsort::sort<branchless>(begin + run_start(thread, num_threads),
+                                  begin + run_start(thread + 1, num_threads),
+                                  less);
+    });
+
+    // runs are kept as boundaries into the current source buffer
+    constexpr size_t max_runs = 256;
+    size_t boundaries[max_runs + 1];
+    size_t num_runs = num_threads;
+    for (size_t i = 0; i <= num_runs; ++i)
+        boundaries[i] = run_start(i, num_runs);
+
+    T* source = begin;
+    T* destination = scratch;
+    while (num_runs > 1) {
+        run_on_threads(num_threads, [&](size_t thread) {
+            // this thread's share of the output of this round
+            const size_t output_begin = run_start(thread, num_threads);
+            const size_t output_end = run_start(thread + 1, num_threads);
+
+            for (size_t pair = 0; pair < num_runs; pair += 2) {
+                const size_t pair_begin = boundaries[pair];
+                const size_t pair_end =
+                    boundaries[pair + 2 <= num_runs ? pair + 2 : num_runs];
+                const size_t piece_begin =
+                    pair_begin > output_begin ? pair_begin : output_begin;
+                const size_t piece_end =
+                    pair_end < output_end ? pair_end : output_end;
+                if (piece_begin >= piece_end)
+                    continue;
+
+                const T* const a = source + pair_begin;
+                if (pair + 1 >= num_runs) {
+                    // odd run out, just carry it over to the other buffer
+                    ::memcpy((void*)(destination + piece_begin),
+                             (const void*)(source + piece_begin),
+                             sizeof(T) * (piece_end - piece_begin));
+                    continue;
+                }
+                const size_t a_size = boundaries[pair + 1] - pair_begin;
+                const T* const b = source + boundaries[pair + 1];
+                const size_t b_size = pair_end - boundaries[pair + 1];
+
+                const size_t from_a_begin = items_taken_from_left(
+                    a, a_size, b, b_size, piece_begin - pair_begin, less);
+                const size_t from_a_end = items_taken_from_left(
+                    a, a_size, b, b_size, piece_end - pair_begin, less);
+                const size_t from_b_begin =
+                    piece_begin - pair_begin - from_a_begin;
+                const size_t from_b_end = piece_end - pair_begin - from_a_end;
+
+                merge(a + from_a_begin, a + from_a_end, b + from_b_begin,
+                      b + from_b_end, destination + piece_begin, less);
+            }
+        });
+
+        size_t merged_runs = 0;
+        for (size_t i = 0; i < num_runs; i += 2)
+            boundaries[merged_runs++] = boundaries[i];
+        boundaries[merged_runs] = size;
+        num_runs = merged_runs;
+
+        T* const swap = source;
+        source = destination;
+        destination = swap;
+    }
+
+    if (source != begin) {
+        run_on_threads(num_threads, [&](size_t thread) {
+            const size_t start = run_start(thread, num_threads);
+            const size_t end = run_start(thread + 1, num_threads);
+            ::memcpy((void*)(begin + start), (const void*)(source + start),
+                     sizeof(T) * (end - start));
+        });
+    }
+}
+} // namespace parallel_merge_sort
+
+struct parallel_sort_fn_t
+{
+    template <typename T, allocator_c allocator_t>
+        requires default_sortable_c<T>
+    [[nodiscard]] status<alloc::error>
+    operator()(allocator_t& allocator, slice<T> items,
+               const parallel_sort_options_t& options = {}) const
+        OKAYLIB_NOEXCEPT
+    {
+        return sort_impl(allocator, items, default_sort_less_t{}, options);
+    }
+
+    template <typename T, allocator_c allocator_t, typename compare_t>
+        requires sort_compare_c<T, compare_t>
+    [[nodiscard]] status<alloc::error>
+    operator()(allocator_t& allocator, slice<T> items, const compare_t& compare,
+               const parallel_sort_options_t& options = {}) const
+        OKAYLIB_NOEXCEPT
+    {
+        return sort_impl(allocator, items,
+                         less_from_compare_t<compare_t>{compare}, options);
+    }
+
+  private:
+    template <typename T, typename allocator_t, typename less_t>
+    static status<alloc::error>
+    sort_impl(allocator_t& allocator, slice<T> items, const less_t& less,
+              const parallel_sort_options_t& options) OKAYLIB_NOEXCEPT
+    {
+        static_assert(is_trivially_relocatable_v<T>,
+                      "parallel_sort moves items between buffers by copying "
+                      "their bytes, so they must be trivially relocatable.");
+
+        size_t num_threads = options.num_threads;
+        if (num_threads == 0)
+            num_threads = std::thread::hardware_concurrency();
+        const size_t min_items_per_thread =
+            options.min_items_per_thread ? options.min_items_per_thread : 1;
+        const size_t max_useful_threads = items.size() / min_items_per_thread;
+        if (num_threads > max_useful_threads)
+            num_threads = max_useful_threads;
+        if (num_threads > 256)
+            num_threads = 256;
+
+        if (num_threads <= 1) {
+            detail::sort_slice(items, less);
+            return alloc::error::success;
+        }
+
+        auto buffer = allocator.allocate(alloc::request_t{
+            .num_bytes = sizeof(T) * items.size(),
+            .alignment = alignof(T),
+            .leave_nonzeroed = true,
+        });
+        if (!buffer.is_success()) [[unlikely]]
+            return buffer.status();
+        T* const scratch = reinterpret_cast<T*>(
+            buffer.unwrap().unchecked_address_of_first_item());
+
+        parallel_merge_sort::sort(items.unchecked_address_of_first_item(),
+                                  items.size(), scratch, num_threads, less);
+
+        allocator.deallocate(scratch);
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Sort using multiple threads: each thread sorts a chunk with ok::sort, and
+/// then the chunks are merged, also in parallel. Not stable. Allocates a buffer
+/// the size of the items, and only errors if that allocation fails. Items must
+/// be trivially relocatable.
+/// ok::parallel_sort(allocator, items, options) or
+/// ok::parallel_sort(allocator, items, compare, options)
+inline constexpr detail::parallel_sort_fn_t parallel_sort;
+
+} // namespace ok
+
+#endif
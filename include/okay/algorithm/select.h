@@ -0,0 +1,295 @@
+#ifndef __OKAYLIB_ALGORITHM_SELECT_H__
+#define __OKAYLIB_ALGORITHM_SELECT_H__
+
+#include "okay/algorithm/sort.h"
+#include "okay/containers/arraylist.h"
+#include "okay/iterables/iterables.h"
+
+/// Selection: finding the smallest or largest few items without sorting all
+/// of them. Comparators are the same as for ok::sort, taking two items and
+/// returning an ordering.
+///
+/// - ok::nth_element: introselect. O(n) on average, O(n log n) worst case.
+/// - ok::partial_sort: sort just the first k items of a slice.
+/// - ok::top_k: the k greatest items from any iterable, keeping only k of them
+///   at a time in a heap.
+namespace ok {
+namespace detail {
+namespace select {
+
+/// Sort the first k items of [begin, end) into place with a heap, leaving the
+/// rest in an unspecified order. O(n log k), used when quickselect keeps
+/// picking bad pivots.
+template <typename T, typename less_t>
+constexpr void heap_select(T* begin, T* middle, T* end, const less_t& less)
+{
+    const int64_t k = middle - begin;
+    if (k == 0)
+        return;
+    for (int64_t i = k / 2; i-- > 0;)
+        pdqsort::sift_down(begin, k, i, less);
+    // the root is the greatest of the smallest k seen so far
+    for (T* cur = middle; cur != end; ++cur) {
+        if (less(*cur, *begin)) {
+            pdqsort::swap(cur, begin);
+            pdqsort::sift_down(begin, k, 0, less);
+        }
+    }
+    for (int64_t last = k - 1; last > 0; --last) {
+        pdqsort::swap(begin, begin + last);
+        pdqsort::sift_down(begin, last, 0, less);
+    }
+}
+
+/// Quickselect with pdqsort's pivot selection and partitioning. Only the side
+/// containing nth is partitioned further. Adapted from pdqsort's main loop, so
+/// it falls under the license notice on detail::pdqsort in sort.h.
+template <bool branchless, typename T, typename less_t>
+constexpr void nth_element(T* begin, T* nth, T* end, const less_t& less)
+{
+    int64_t bad_allowed = int64_t(log2_uint(size_t(end - begin))) + 1;
+    bool leftmost = true;
+
+    while (end - begin >= pdqsort::insertion_sort_threshold) {
+        const int64_t size = end - begin;
+        const int64_t s2 = size / 2;
+        if (size > pdqsort::ninther_threshold) {
+            pdqsort::sort3(begin, begin + s2, end - 1, less);
+            pdqsort::sort3(begin + 1, begin + (s2 - 1), end - 2, less);
+            pdqsort::sort3(begin + 2, begin + (s2 + 1), end - 3, less);
+            pdqsort::sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1),
+                           less);
+            pdqsort::swap(begin, begin + s2);
+        } else {
+            pdqsort::sort3(begin + s2, begin, end - 1, less);
+        }
+
+        // same as in pdqsort: if the pivot equals the item before this range,
+        // then every item equal to it is already in its final place. without
+        // this, inputs with lots of duplicates never converge
+        if (!leftmost && !less(*(begin - 1), *begin)) {
+            T* const last_equal = pdqsort::partition_left(begin, end, less);
+            if (nth <= last_equal)
+                return;
+            begin = last_equal + 1;
+            continue;
+        }
+
+        const pdqsort::partition_result_t<T> result =
+            branchless ? pdqsort::partition_right_branchless(begin, end, less)
+                       : pdqsort::partition_right(begin, end, less);
+        T* const pivot_pos = result.pivot;
+
+        const int64_t l_size = pivot_pos - begin;
+        const int64_t r_size = end - (pivot_pos + 1);
+        if (l_size < size / 8 || r_size < size / 8) {
+            if (--bad_allowed == 0) {
+                select::heap_select(begin, nth + 1, end, less);
+                return;
+            }
+        }
+
+        if (nth == pivot_pos)
+            return;
+        if (nth < pivot_pos) {
+            end = pivot_pos;
+        } else {
+            begin = pivot_pos + 1;
+            leftmost = false;
+        }
+    }
+
+    if (leftmost)
+        pdqsort::insertion_sort(begin, end, less);
+    else
+        pdqsort::unguarded_insertion_sort(begin, end, less);
+}
+
+template <typename T, typename less_t>
+constexpr void nth_element_slice(slice<T> items, size_t n, const less_t& less)
+{
+    if (n >= items.size()) [[unlikely]] {
+        __ok_abort("Attempt to nth_element() with an index which is out of "
+                   "bounds of the slice.");
+    }
+    T* const begin = items.unchecked_address_of_first_item();
+    constexpr bool branchless = stdc::is_arithmetic_v<T> ||
+                                stdc::is_pointer_v<T> || stdc::is_enum_v<T>;
+    select::nth_element<branchless>(begin, begin + n, begin + items.size(),
+                                    less);
+}
+
+template <typename T, typename less_t>
+constexpr void partial_sort_slice(slice<T> items, size_t k, const less_t& less)
+{
+    if (k >= items.size()) {
+        detail::sort_slice(items, less);
+        return;
+    }
+    if (k == 0)
+        return;
+    // after selecting, the first k - 1 items are the smallest and just need
+    // sorting. this is O(n + k log k), which beats a heap for all but tiny k
+    select::nth_element_slice(items, k - 1, less);
+    detail::sort_slice(items.subslice({.start = 0, .length = k - 1}), less);
+}
+
+} // namespace select
+
+struct nth_element_fn_t
+{
+    template <typename T>
+        requires default_sortable_c<T>
+    constexpr void operator()(slice<T> items,
+                              size_t n) const OKAYLIB_NOEXCEPT
+    {
+        select::nth_element_slice(items, n, default_sort_less_t{});
+    }
+
+    template <typename T, typename compare_t>
+        requires sort_compare_c<T, compare_t>
+    constexpr void operator()(slice<T> items, size_t n,
+                              const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        select::nth_element_slice(items, n,
+                                  less_from_compare_t<compare_t>{compare});
+    }
+};
+
+struct partial_sort_fn_t
+{
+    template <typename T>
+        requires default_sortable_c<T>
+    constexpr void operator()(slice<T> items,
+                              size_t k) const OKAYLIB_NOEXCEPT
+    {
+        select::partial_sort_slice(items, k, default_sort_less_t{});
+    }
+
+    template <typename T, typename compare_t>
+        requires sort_compare_c<T, compare_t>
+    constexpr void operator()(slice<T> items, size_t k,
+                              const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        select::partial_sort_slice(items, k,
+                                   less_from_compare_t<compare_t>{compare});
+    }
+};
+
+struct top_k_fn_t
+{
+    template <allocator_c allocator_t, typename iterable_t>
+        requires iterable_c<iterable_t> &&
+                 default_sortable_c<stdc::remove_cvref_t<
+                     value_type_for<iterable_t>>>
+    [[nodiscard]] constexpr auto
+    operator()(allocator_t& allocator, iterable_t&& iterable,
+               size_t k) const OKAYLIB_NOEXCEPT
+    {
+        return top_k_impl(allocator, stdc::forward<iterable_t>(iterable), k,
+                          default_sort_less_t{});
+    }
+
+    template <allocator_c allocator_t, typename iterable_t,
+              typename compare_t>
+        requires iterable_c<iterable_t> &&
+                 sort_compare_c<stdc::remove_cvref_t<
+                                    value_type_for<iterable_t>>,
+                                compare_t>
+    [[nodiscard]] constexpr auto
+    operator()(allocator_t& allocator, iterable_t&& iterable, size_t k,
+               const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        return top_k_impl(allocator, stdc::forward<iterable_t>(iterable), k,
+                          less_from_compare_t<compare_t>{compare});
+    }
+
+  private:
+    template <typename allocator_t, typename iterable_t, typename less_t>
+    static constexpr auto top_k_impl(allocator_t& allocator,
+                                     iterable_t&& iterable, size_t k,
+                                     const less_t& less) OKAYLIB_NOEXCEPT
+    {
+        using yielded_t = value_type_for<iterable_t>;
+        using T = stdc::remove_cvref_t<yielded_t>;
+        static_assert(!is_iterable_infinite<iterable_t>,
+                      "Attempt to take the top k items of an infinite "
+                      "iterable, which would never finish.");
+
+        // the heap is ordered so that the smallest item kept so far is at the
+        // root, ready to be replaced by anything bigger
+        const auto greater = [&less](const T& lhs, const T& rhs) {
+            return less(rhs, lhs);
+        };
+
+        // move out of items which the iterator yields by value
+        const auto take = [](auto& item) -> decltype(auto) {
+            if constexpr (stdc::is_reference_v<yielded_t>)
+                return item.ref_unchecked();
+            else
+                return stdc::move(item.ref_unchecked());
+        };
+
+        auto result = arraylist::spots_preallocated<T>(allocator, k ? k : 1);
+        if (!result.is_success()) [[unlikely]]
+            return result;
+        arraylist_t<T, allocator_t>& heap = result.unwrap();
+        if (k == 0)
+            return result;
+
+        auto&& iterator = ok::iter(stdc::forward<iterable_t>(iterable));
+        while (true) {
+            auto item = iterator.next();
+            if (!item)
+                break;
+
+            if (heap.size() < k) {
+                heap.append_assume_capacity(take(item));
+                if (heap.size() == k) {
+                    T* const begin =
+                        heap.items().unchecked_address_of_first_item();
+                    for (int64_t i = int64_t(k) / 2; i-- > 0;)
+                        pdqsort::sift_down(begin, int64_t(k), i, greater);
+                }
+                continue;
+            }
+
+            T* const root = heap.items().unchecked_address_of_first_item();
+            if (less(*root, item.ref_unchecked())) {
+                *root = take(item);
+                pdqsort::sift_down(root, int64_t(k), 0, greater);
+            }
+        }
+
+        // greatest first
+        if (!heap.is_empty()) {
+            T* const begin = heap.items().unchecked_address_of_first_item();
+            pdqsort::sort<false>(begin, begin + heap.size(), greater);
+        }
+        return result;
+    }
+};
+
+} // namespace detail
+
+/// Reorder the items so that items[n] is the item which would be there if the
+/// slice were sorted, with everything before it not greater and everything
+/// after it not less.
+/// ok::nth_element(items, n) or ok::nth_element(items, n, compare)
+inline constexpr detail::nth_element_fn_t nth_element;
+
+/// Sort the smallest k items into the start of the slice. The order of the
+/// remaining items is unspecified.
+/// ok::partial_sort(items, k) or ok::partial_sort(items, k, compare)
+inline constexpr detail::partial_sort_fn_t partial_sort;
+
+/// Collect the k greatest items from an iterable into a new arraylist, greatest
+/// first. Only k items are held at once, so this works on iterables much
+/// bigger than memory. Only errors if allocating the arraylist fails.
+/// ok::top_k(allocator, iterable, k) or
+/// ok::top_k(allocator, iterable, k, compare)
+inline constexpr detail::top_k_fn_t top_k;
+
+} // namespace ok
+
+#endif
@@ -0,0 +1,966 @@
+#ifndef __OKAYLIB_ALGORITHM_SORT_H__
+#define __OKAYLIB_ALGORITHM_SORT_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/detail/utility.h"
+#include "okay/error.h"
+#include "okay/math/math.h"
+#include "okay/math/ordering.h"
+#include "okay/math/rounding.h"
+#include "okay/slice.h"
+#include "okay/stdmem.h"
+#include <cstring>
+
+/// Sorting for slices (and so for anything with an items() slice, like
+/// arraylist_t). Comparators take two items and return an ordering, the same
+/// as ok::cmp. The default is to compare items with operator<=>.
+///
+/// - ok::sort: pattern-defeating quicksort. In place, not stable, O(n log n)
+///   worst case.
+/// - ok::sort_by_key: ok::sort, comparing the result of a key function.
+/// - ok::stable_sort: merge sort, allocates a buffer of half the items.
+/// - ok::radix_sort / ok::radix_sort_by_key: stable LSD radix sort for integer
+///   and floating point keys, allocates a buffer of all the items (and of
+///   their keys, for radix_sort_by_key).
+///
+/// See also okay/algorithm/parallel_sort.h.
+namespace ok {
+namespace detail {
+
+/// Compare with operator<=>. Also works for floats, but NaN breaks the
+/// ordering that the comparison sorts need: use radix sort for floats that may
+/// be NaN.
+struct default_sort_less_t
+{
+    template <typename T>
+    [[nodiscard]] constexpr bool operator()(const T& lhs,
+                                            const T& rhs) const OKAYLIB_NOEXCEPT
+    {
+        return (lhs <=> rhs) < 0;
+    }
+};
+
+template <typename compare_t> struct less_from_compare_t
+{
+    const compare_t& compare;
+
+    template <typename T>
+    [[nodiscard]] constexpr bool operator()(const T& lhs,
+                                            const T& rhs) const OKAYLIB_NOEXCEPT
+    {
+        return compare(lhs, rhs) < 0;
+    }
+};
+
+template <typename key_fn_t> struct less_by_key_t
+{
+    const key_fn_t& key_fn;
+
+    template <typename T>
+    [[nodiscard]] constexpr bool operator()(const T& lhs,
+                                            const T& rhs) const OKAYLIB_NOEXCEPT
+    {
+        return (key_fn(lhs) <=> key_fn(rhs)) < 0;
+    }
+};
+
+/*
+ * everything in this namespace is a modified version of pdqsort, by Orson
+ * Peters: https://github.com/orlp/pdqsort
+ */
+
+/*
+  pdqsort.h - Pattern-defeating quicksort.
+
+  Copyright (c) 2021 Orson Peters
+
+  This software is provided 'as-is', without any express or implied warranty.
+  In no event will the authors be held liable for any damages arising from the
+  use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software in
+     a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+
+  3. This notice may not be removed or altered from any source distribution.
+ */
+namespace pdqsort {
+// below this size, insertion sort is used
+inline constexpr int64_t insertion_sort_threshold = 24;
+// above this size, the pivot is the median of three medians of three
+inline constexpr int64_t ninther_threshold = 128;
+// partial_insertion_sort gives up after moving this many items
+inline constexpr int64_t partial_insertion_sort_limit = 8;
+// number of items to classify at a time during branchless partitioning
+inline constexpr int64_t block_size = 64;
+inline constexpr size_t cacheline_size = 64;
+
+template <typename T> constexpr void swap(T* a, T* b) OKAYLIB_NOEXCEPT
+{
+    T tmp(stdc::move(*a));
+    *a = stdc::move(*b);
+    *b = stdc::move(tmp);
+}
+
+template <typename T, typename less_t>
+constexpr void insertion_sort(T* begin, T* end, const less_t& less)
+{
+    if (begin == end)
+        return;
+
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        if (less(*sift, *sift_1)) {
+            T tmp(stdc::move(*sift));
+            do {
+                *sift-- = stdc::move(*sift_1);
+            } while (sift != begin && less(tmp, *--sift_1));
+            *sift = stdc::move(tmp);
+        }
+    }
+}
+
+/// Like insertion_sort, but assumes that *(begin - 1) is not greater than any
+/// item in [begin, end), so the bounds check can be skipped.
+template <typename T, typename less_t>
+constexpr void unguarded_insertion_sort(T* begin, T* end, const less_t& less)
+{
+    if (begin == end)
+        return;
+
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        if (less(*sift, *sift_1)) {
+            T tmp(stdc::move(*sift));
+            do {
+                *sift-- = stdc::move(*sift_1);
+            } while (less(tmp, *--sift_1));
+            *sift = stdc::move(tmp);
+        }
+    }
+}
+
+/// Insertion sort which gives up if it has to move too many items. Returns
+/// true if the range ended up sorted.
+template <typename T, typename less_t>
+constexpr bool partial_insertion_sort(T* begin, T* end, const less_t& less)
+{
+    if (begin == end)
+        return true;
+
+    int64_t limit = 0;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        if (less(*sift, *sift_1)) {
+            T tmp(stdc::move(*sift));
+            do {
+                *sift-- = stdc::move(*sift_1);
+            } while (sift != begin && less(tmp, *--sift_1));
+            *sift = stdc::move(tmp);
+            limit += cur - sift;
+        }
+
+        if (limit > partial_insertion_sort_limit)
+            return false;
+    }
+    return true;
+}
+
+template <typename T, typename less_t>
+constexpr void sort2(T* a, T* b, const less_t& less)
+{
+    if (less(*b, *a))
+        pdqsort::swap(a, b);
+}
+
+template <typename T, typename less_t>
+constexpr void sort3(T* a, T* b, T* c, const less_t& less)
+{
+    sort2(a, b, less);
+    sort2(b, c, less);
+    sort2(a, b, less);
+}
+
+template <typename T, typename less_t>
+constexpr void sift_down(T* begin, int64_t size, int64_t root,
+                         const less_t& less)
+{
+    while (true) {
+        int64_t child = 2 * root + 1;
+        if (child >= size)
+            return;
+        if (child + 1 < size && less(begin[child], begin[child + 1]))
+            ++child;
+        if (!less(begin[root], begin[child]))
+            return;
+        pdqsort::swap(begin + root, begin + child);
+        root = child;
+    }
+}
+
+/// Fallback when too many partitions are bad, which keeps the worst case at
+/// O(n log n).
+template <typename T, typename less_t>
+constexpr void heapsort(T* begin, T* end, const less_t& less)
+{
+    const int64_t size = end - begin;
+    for (int64_t i = size / 2; i-- > 0;)
+        sift_down(begin, size, i, less);
+    for (int64_t last = size - 1; last > 0; --last) {
+        pdqsort::swap(begin, begin + last);
+        sift_down(begin, last, 0, less);
+    }
+}
+
+template <typename T>
+constexpr void swap_offsets(T* first, T* last, const uint8_t* offsets_l,
+                            const uint8_t* offsets_r, int64_t num,
+                            bool use_swaps) OKAYLIB_NOEXCEPT
+{
+    if (use_swaps) {
+        // this case is needed for the descending distribution, where we need
+        // to have proper swapping for pdqsort to remain O(n)
+        for (int64_t i = 0; i < num; ++i)
+            pdqsort::swap(first + offsets_l[i], last - offsets_r[i]);
+    } else if (num > 0) {
+        T* l = first + offsets_l[0];
+        T* r = last - offsets_r[0];
+        T tmp(stdc::move(*l));
+        *l = stdc::move(*r);
+        for (int64_t i = 1; i < num; ++i) {
+            l = first + offsets_l[i];
+            *r = stdc::move(*l);
+            r = last - offsets_r[i];
+            *l = stdc::move(*r);
+        }
+        *r = stdc::move(tmp);
+    }
+}
+
+template <typename T> struct partition_result_t
+{
+    T* pivot;
+    bool already_partitioned;
+};
+
+/// Partition [begin, end) around the pivot *begin. Items equal to the pivot
+/// end up on the right. Uses BlockQuicksort's technique of recording which
+/// items are out of place in a buffer of offsets first, and then swapping them
+/// all, so that comparisons do not turn into mispredicted branches.
+template <typename T, typename less_t>
+constexpr partition_result_t<T>
+partition_right_branchless(T* begin, T* end, const less_t& less)
+{
+    T pivot(stdc::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    // find the first item greater than or equal to the pivot (the median of 3
+    // guarantees this exists)
+    while (less(*++first, pivot))
+        ;
+
+    // find the first item strictly smaller than the pivot. we have to guard
+    // this search if there was no item before *first
+    if (first - 1 == begin)
+        while (first < last && !less(*--last, pivot))
+            ;
+    else
+        while (!less(*--last, pivot))
+            ;
+
+    // if the first pair of items that should be swapped to partition are the
+    // same item, the passed in sequence already was correctly partitioned
+    const bool already_partitioned = first >= last;
+    if (!already_partitioned) {
+        pdqsort::swap(first, last);
+        ++first;
+
+        alignas(cacheline_size) uint8_t offsets_l[block_size];
+        alignas(cacheline_size) uint8_t offsets_r[block_size];
+
+        T* offsets_l_base = first;
+        T* offsets_r_base = last;
+        int64_t num_l = 0;
+        int64_t num_r = 0;
+        int64_t start_l = 0;
+        int64_t start_r = 0;
+
+        while (first < last) {
+            // fill up offset blocks with items that are on the wrong side. the
+            // last block needs special handling, since it may be smaller
+            const int64_t num_unknown = last - first;
+            const int64_t left_split =
+                num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            const int64_t right_split =
+                num_r == 0 ? (num_unknown - left_split) : 0;
+
+            const int64_t left_count =
+                left_split >= block_size ? block_size : left_split;
+            for (int64_t i = 0; i < left_count;) {
+                offsets_l[num_l] = uint8_t(i++);
+                num_l += !less(*first, pivot);
+                ++first;
+            }
+
+            const int64_t right_count =
+                right_split >= block_size ? block_size : right_split;
+            for (int64_t i = 0; i < right_count;) {
+                offsets_r[num_r] = uint8_t(++i);
+                num_r += less(*--last, pivot);
+            }
+
+            // swap items and update block sizes and first/last boundaries
+            const int64_t num = num_l < num_r ? num_l : num_r;
+            swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l,
+                         offsets_r + start_r, num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        // we have now fully identified [first, last)'s proper position. swap
+        // the last items into place
+        if (num_l) {
+            const uint8_t* remaining = offsets_l + start_l;
+            while (num_l--)
+                pdqsort::swap(offsets_l_base + remaining[num_l], --last);
+            first = last;
+        }
+        if (num_r) {
+            const uint8_t* remaining = offsets_r + start_r;
+            while (num_r--) {
+                pdqsort::swap(offsets_r_base - remaining[num_r], first);
+                ++first;
+            }
+            last = first;
+        }
+    }
+
+    // put the pivot in the right place
+    T* pivot_pos = first - 1;
+    *begin = stdc::move(*pivot_pos);
+    *pivot_pos = stdc::move(pivot);
+
+    return {pivot_pos, already_partitioned};
+}
+
+/// Same as partition_right_branchless, but for types where comparisons are
+/// expensive enough that branching on each one is cheaper than classifying
+/// blocks.
+template <typename T, typename less_t>
+constexpr partition_result_t<T> partition_right(T* begin, T* end,
+                                                const less_t& less)
+{
+    T pivot(stdc::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    while (less(*++first, pivot))
+        ;
+
+    if (first - 1 == begin)
+        while (first < last && !less(*--last, pivot))
+            ;
+    else
+        while (!less(*--last, pivot))
+            ;
+
+    const bool already_partitioned = first >= last;
+
+    // keep swapping pairs of items that are on the wrong side of the pivot.
+    // previously swapped pairs guard the searches, which is why the first
+    // iteration is special-cased above
+    while (first < last) {
+        pdqsort::swap(first, last);
+        while (less(*++first, pivot))
+            ;
+        while (!less(*--last, pivot))
+            ;
+    }
+
+    T* pivot_pos = first - 1;
+    *begin = stdc::move(*pivot_pos);
+    *pivot_pos = stdc::move(pivot);
+
+    return {pivot_pos, already_partitioned};
+}
+
+/// Partition with items equal to the pivot on the left. Used when the pivot
+/// is equal to the item before this range, in which case everything equal to
+/// it is already in its final place and only the right side needs sorting.
+template <typename T, typename less_t>
+constexpr T* partition_left(T* begin, T* end, const less_t& less)
+{
+    T pivot(stdc::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    while (less(pivot, *--last))
+        ;
+
+    if (last + 1 == end)
+        while (first < last && !less(pivot, *++first))
+            ;
+    else
+        while (!less(pivot, *++first))
+            ;
+
+    while (first < last) {
+        pdqsort::swap(first, last);
+        while (less(pivot, *--last))
+            ;
+        while (!less(pivot, *++first))
+            ;
+    }
+
+    T* pivot_pos = last;
+    *begin = stdc::move(*pivot_pos);
+    *pivot_pos = stdc::move(pivot);
+
+    return pivot_pos;
+}
+
+template <bool branchless, typename T, typename less_t>
+constexpr void sort_loop(T* begin, T* end, const less_t& less,
+                         int64_t bad_allowed, bool leftmost = true)
+{
+    // use a while loop for tail recursion elimination
+    while (true) {
+        const int64_t size = end - begin;
+
+        if (size < insertion_sort_threshold) {
+            if (leftmost)
+                insertion_sort(begin, end, less);
+            else
+                unguarded_insertion_sort(begin, end, less);
+            return;
+        }
+
+        // choose pivot as median of 3 or pseudomedian of 9
+        const int64_t s2 = size / 2;
+        if (size > ninther_threshold) {
+            sort3(begin, begin + s2, end - 1, less);
+            sort3(begin + 1, begin + (s2 - 1), end - 2, less);
+            sort3(begin + 2, begin + (s2 + 1), end - 3, less);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), less);
+            pdqsort::swap(begin, begin + s2);
+        } else {
+            sort3(begin + s2, begin, end - 1, less);
+        }
+
+        // if *(begin - 1) is the end of the right partition of a previous
+        // partition operation, there is no item in [begin, end) that is
+        // smaller than *(begin - 1). then if our pivot compares equal to
+        // *(begin - 1) we change strategy, putting equal items in the left
+        // partition, greater items in the right partition. we do not have to
+        // recurse on the left partition, since it's sorted (all equal)
+        if (!leftmost && !less(*(begin - 1), *begin)) {
+            begin = partition_left(begin, end, less) + 1;
+            continue;
+        }
+
+        const partition_result_t<T> result =
+            branchless ? partition_right_branchless(begin, end, less)
+                       : partition_right(begin, end, less);
+        T* const pivot_pos = result.pivot;
+
+        // check for a highly unbalanced partition
+        const int64_t l_size = pivot_pos - begin;
+        const int64_t r_size = end - (pivot_pos + 1);
+        const bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+        if (highly_unbalanced) {
+            // if we had too many bad partitions, switch to heapsort to
+            // guarantee O(n log n)
+            if (--bad_allowed == 0) {
+                heapsort(begin, end, less);
+                return;
+            }
+
+            // otherwise, shuffle some items around to break patterns
+            if (l_size >= insertion_sort_threshold) {
+                pdqsort::swap(begin, begin + l_size / 4);
+                pdqsort::swap(pivot_pos - 1, pivot_pos - l_size / 4);
+
+                if (l_size > ninther_threshold) {
+                    pdqsort::swap(begin + 1, begin + (l_size / 4 + 1));
+                    pdqsort::swap(begin + 2, begin + (l_size / 4 + 2));
+                    pdqsort::swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    pdqsort::swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+
+            if (r_size >= insertion_sort_threshold) {
+                pdqsort::swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                pdqsort::swap(end - 1, end - r_size / 4);
+
+                if (r_size > ninther_threshold) {
+                    pdqsort::swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    pdqsort::swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    pdqsort::swap(end - 2, end - (1 + r_size / 4));
+                    pdqsort::swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else {
+            // decently balanced and the range was already partitioned: try
+            // to finish with insertion sort, in case it is (nearly) sorted
+            if (result.already_partitioned &&
+                partial_insertion_sort(begin, pivot_pos, less) &&
+                partial_insertion_sort(pivot_pos + 1, end, less))
+                return;
+        }
+
+        // sort the left partition first using recursion and do tail
+        // recursion elimination for the right-hand partition
+        sort_loop<branchless>(begin, pivot_pos, less, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+template <bool branchless, typename T, typename less_t>
+constexpr void sort(T* begin, T* end, const less_t& less)
+{
+    if (end - begin < 2)
+        return;
+    sort_loop<branchless>(begin, end, less,
+                          int64_t(log2_uint(size_t(end - begin))) + 1);
+}
+} // namespace pdqsort
+
+namespace merge_sort {
+inline constexpr int64_t insertion_sort_threshold = 24;
+
+/// Sort [begin, end), moving the left half out into the buffer before merging
+/// back. The buffer needs space for half of the items (rounded up) and is
+/// left uninitialized afterwards.
+template <typename T, typename less_t>
+constexpr void sort(T* begin, T* end, T* buffer, const less_t& less)
+{
+    const int64_t size = end - begin;
+    if (size <= insertion_sort_threshold) {
+        pdqsort::insertion_sort(begin, end, less);
+        return;
+    }
+
+    T* mid = begin + (size + 1) / 2;
+    merge_sort::sort(begin, mid, buffer, less);
+    merge_sort::sort(mid, end, buffer, less);
+
+    // already in order
+    if (!less(*mid, *(mid - 1)))
+        return;
+
+    const int64_t num_left = mid - begin;
+    for (int64_t i = 0; i < num_left; ++i)
+        stdc::construct_at(buffer + i, stdc::move(begin[i]));
+
+    T* left = buffer;
+    T* const left_end = buffer + num_left;
+    T* right = mid;
+    T* out = begin;
+    // taking from the left on ties is what keeps this stable
+    while (left != left_end && right != end) {
+        if (less(*right, *left))
+            *out++ = stdc::move(*right++);
+        else
+            *out++ = stdc::move(*left++);
+    }
+    while (left != left_end)
+        *out++ = stdc::move(*left++);
+
+    if constexpr (!stdc::is_trivially_destructible_v<T>) {
+        for (int64_t i = 0; i < num_left; ++i)
+            buffer[i].~T();
+    }
+}
+} // namespace merge_sort
+
+template <typename T, typename less_t>
+constexpr void sort_slice(slice<T> items, const less_t& less)
+{
+    if (items.size() < 2)
+        return;
+    T* const begin = items.unchecked_address_of_first_item();
+    constexpr bool branchless = stdc::is_arithmetic_v<T> ||
+                                stdc::is_pointer_v<T> ||
+                                stdc::is_enum_v<T>;
+    pdqsort::sort<branchless>(begin, begin + items.size(), less);
+}
+
+template <typename T, typename compare_t>
+concept sort_compare_c = requires(const compare_t& compare, const T& item) {
+    { compare(item, item) < 0 } -> ok::stdc::convertible_to_c<bool>;
+};
+
+template <typename T>
+concept default_sortable_c = requires(const T& item) {
+    { (item <=> item) < 0 } -> ok::stdc::convertible_to_c<bool>;
+};
+
+template <typename T, typename key_fn_t>
+concept sort_key_fn_c = requires(const key_fn_t& key_fn, const T& item) {
+    { (key_fn(item) <=> key_fn(item)) < 0 } -> ok::stdc::convertible_to_c<bool>;
+};
+
+struct sort_fn_t
+{
+    template <typename T>
+        requires default_sortable_c<T>
+    constexpr void operator()(slice<T> items) const OKAYLIB_NOEXCEPT
+    {
+        detail::sort_slice(items, default_sort_less_t{});
+    }
+
+    template <typename T, typename compare_t>
+        requires sort_compare_c<T, compare_t>
+    constexpr void operator()(slice<T> items,
+                              const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        detail::sort_slice(items, less_from_compare_t<compare_t>{compare});
+    }
+};
+
+struct sort_by_key_fn_t
+{
+    template <typename T, typename key_fn_t>
+        requires sort_key_fn_c<T, key_fn_t>
+    constexpr void operator()(slice<T> items,
+                              const key_fn_t& key_fn) const OKAYLIB_NOEXCEPT
+    {
+        T* const begin = items.size() ? items.unchecked_address_of_first_item()
+                                      : nullptr;
+        pdqsort::sort<false>(begin, begin + items.size(),
+                             less_by_key_t<key_fn_t>{key_fn});
+    }
+};
+
+struct stable_sort_fn_t
+{
+    template <typename T, allocator_c allocator_t>
+        requires default_sortable_c<T>
+    [[nodiscard]] constexpr status<alloc::error>
+    operator()(allocator_t& allocator, slice<T> items) const OKAYLIB_NOEXCEPT
+    {
+        return sort_impl(allocator, items, default_sort_less_t{});
+    }
+
+    template <typename T, allocator_c allocator_t, typename compare_t>
+        requires sort_compare_c<T, compare_t>
+    [[nodiscard]] constexpr status<alloc::error>
+    operator()(allocator_t& allocator, slice<T> items,
+               const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        return sort_impl(allocator, items,
+                         less_from_compare_t<compare_t>{compare});
+    }
+
+  private:
+    template <typename T, typename allocator_t, typename less_t>
+    static constexpr status<alloc::error>
+    sort_impl(allocator_t& allocator, slice<T> items,
+              const less_t& less) OKAYLIB_NOEXCEPT
+    {
+        static_assert(stdc::is_move_constructible_v<T> &&
+                          stdc::is_move_assignable_v<T>,
+                      "Attempt to stable_sort items which cannot be moved.");
+        T* const begin = items.size() ? items.unchecked_address_of_first_item()
+                                      : nullptr;
+        if (items.size() <= merge_sort::insertion_sort_threshold) {
+            pdqsort::insertion_sort(begin, begin + items.size(), less);
+            return alloc::error::success;
+        }
+
+        auto buffer = allocator.allocate(alloc::request_t{
+            .num_bytes = sizeof(T) * ((items.size() + 1) / 2),
+            .alignment = alignof(T),
+            .leave_nonzeroed = true,
+        });
+        if (!buffer.is_success()) [[unlikely]]
+            return buffer.status();
+
+        void* const buffer_start =
+            buffer.unwrap().unchecked_address_of_first_item();
+        merge_sort::sort(begin, begin + items.size(),
+                         static_cast<T*>(buffer_start), less);
+        allocator.deallocate(buffer_start);
+        return alloc::error::success;
+    }
+};
+
+template <typename key_t>
+concept radix_key_c = (stdc::is_integral_v<key_t> &&
+                       !stdc::is_same_v<key_t, bool>) ||
+                      stdc::is_floating_point_v<key_t>;
+
+template <typename key_t>
+using radix_bits_t = stdc::conditional_t<
+    sizeof(key_t) == 1, uint8_t,
+    stdc::conditional_t<
+        sizeof(key_t) == 2, uint16_t,
+        stdc::conditional_t<sizeof(key_t) == 4, uint32_t, uint64_t>>>;
+
+/// Map a key to an unsigned integer with the same ordering. Negative floats
+/// have all their bits flipped (bigger magnitude means smaller), positive
+/// floats and signed integers just have their sign bit flipped. NaNs with the
+/// sign bit set sort first, and others sort last.
+template <typename key_t>
+[[nodiscard]] constexpr radix_bits_t<key_t> to_radix_bits(key_t key) noexcept
+{
+    using bits_t = radix_bits_t<key_t>;
+    static_assert(sizeof(bits_t) == sizeof(key_t));
+    constexpr bits_t sign_bit = bits_t(bits_t(1) << (sizeof(bits_t) * 8 - 1));
+
+    const bits_t bits = stdc::bit_cast<bits_t>(key);
+    if constexpr (stdc::is_floating_point_v<key_t>) {
+        const bits_t mask = (bits & sign_bit) ? bits_t(~bits_t(0)) : sign_bit;
+        return bits_t(bits ^ mask);
+    } else if constexpr (stdc::is_signed_v<key_t>) {
+        return bits_t(bits ^ sign_bit);
+    } else {
+        return bits;
+    }
+}
+
+/// Key function used by radix_sort, where the items are their own keys. The
+/// radix sort recognizes it and reads keys straight out of the items instead
+/// of storing a copy of every key.
+struct radix_identity_key_t
+{
+    template <typename T>
+    [[nodiscard]] constexpr T operator()(const T& item) const noexcept
+    {
+        return item;
+    }
+};
+
+struct radix_sort_by_key_fn_t
+{
+    template <typename T, allocator_c allocator_t, typename key_fn_t>
+        requires radix_key_c<
+            stdc::remove_cvref_t<decltype(stdc::declval<const key_fn_t&>()(
+                stdc::declval<const T&>()))>>
+    [[nodiscard]] status<alloc::error>
+    operator()(allocator_t& allocator, slice<T> items,
+               const key_fn_t& key_fn) const OKAYLIB_NOEXCEPT
+    {
+        static_assert(is_trivially_relocatable_v<T>,
+                      "radix sort moves items between buffers by copying "
+                      "their bytes, so they must be trivially relocatable.");
+        using key_t = stdc::remove_cvref_t<decltype(key_fn(
+            stdc::declval<const T&>()))>;
+        using bits_t = radix_bits_t<key_t>;
+        // otherwise every key is computed once up front and then moved around
+        // alongside its item, so that key_fn is only called once per item
+        constexpr bool keys_are_items =
+            stdc::is_same_v<key_fn_t, radix_identity_key_t>;
+
+        const size_t size = items.size();
+        if (size < 2)
+            return alloc::error::success;
+
+        T* const begin = items.unchecked_address_of_first_item();
+
+        // insertion sort is stable, and faster than counting for tiny inputs
+        if (size <= small_size) {
+            bits_t keys[small_size];
+            for (size_t i = 0; i < size; ++i)
+                keys[i] = detail::to_radix_bits<key_t>(key_fn(begin[i]));
+            insertion_sort_by_bits(begin, keys, size);
+            return alloc::error::success;
+        }
+
+        // scratch items first, then (if needed) the keys and scratch keys
+        const size_t keys_offset =
+            ok::round_up_to_multiple_of<alignof(bits_t)>(sizeof(T) * size);
+        auto buffer = allocator.allocate(alloc::request_t{
+            .num_bytes = keys_are_items
+                             ? sizeof(T) * size
+                             : keys_offset + sizeof(bits_t) * size * 2,
+            .alignment = ok::max(alignof(T), alignof(bits_t)),
+            .leave_nonzeroed = true,
+        });
+        if (!buffer.is_success()) [[unlikely]]
+            return buffer.status();
+        uint8_t* const buffer_start =
+            buffer.unwrap().unchecked_address_of_first_item();
+
+        if constexpr (keys_are_items) {
+            radix_passes<T, bits_t, keys_are_items>(
+                begin, reinterpret_cast<T*>(buffer_start), nullptr, nullptr,
+                size);
+        } else {
+            bits_t* const keys =
+                reinterpret_cast<bits_t*>(buffer_start + keys_offset);
+            for (size_t i = 0; i < size; ++i)
+                keys[i] = detail::to_radix_bits<key_t>(key_fn(begin[i]));
+            radix_passes<T, bits_t, keys_are_items>(
+                begin, reinterpret_cast<T*>(buffer_start), keys, keys + size,
+                size);
+        }
+
+        allocator.deallocate(buffer_start);
+        return alloc::error::success;
+    }
+
+  private:
+    static constexpr size_t small_size = 64;
+
+    /// Stable insertion sort of the items by their precomputed keys, keeping
+    /// the keys in step with the items.
+    template <typename T, typename bits_t>
+    static void insertion_sort_by_bits(T* items, bits_t* keys,
+                                       size_t size) OKAYLIB_NOEXCEPT
+    {
+        for (size_t i = 1; i < size; ++i) {
+            const bits_t key = keys[i];
+            size_t j = i;
+            while (j > 0 && key < keys[j - 1]) {
+                keys[j] = keys[j - 1];
+                --j;
+            }
+            if (j == i)
+                continue;
+            keys[j] = key;
+            alignas(T) uint8_t item[sizeof(T)];
+            ::memcpy(item, (const void*)(items + i), sizeof(T));
+            ::memmove((void*)(items + j + 1), (const void*)(items + j),
+                      sizeof(T) * (i - j));
+            ::memcpy((void*)(items + j), item, sizeof(T));
+        }
+    }
+
+    /// LSD passes over each byte of the keys, ping-ponging the items (and the
+    /// keys, if they are stored separately) between the input and scratch.
+    /// Leaves the sorted items in begin.
+    template <typename T, typename bits_t, bool keys_are_items>
+    static void radix_passes(T* const begin, T* const scratch, bits_t* keys,
+                             bits_t* scratch_keys,
+                             const size_t size) OKAYLIB_NOEXCEPT
+    {
+        constexpr size_t num_digits = sizeof(bits_t);
+        T* source = begin;
+        T* destination = scratch;
+        const auto key_at = [&](size_t i) -> bits_t {
+            if constexpr (keys_are_items)
+                return detail::to_radix_bits(source[i]);
+            else
+                return keys[i];
+        };
+
+        // count every digit in one pass
+        size_t counts[num_digits][256] = {};
+        for (size_t i = 0; i < size; ++i) {
+            const bits_t bits = key_at(i);
+            for (size_t d = 0; d < num_digits; ++d)
+                ++counts[d][(bits >> (d * 8)) & 0xff];
+        }
+
+        const bits_t first_bits = key_at(0);
+        for (size_t d = 0; d < num_digits; ++d) {
+            size_t* const digit_counts = counts[d];
+            // every key has the same digit here, so this pass changes nothing
+            if (digit_counts[(first_bits >> (d * 8)) & 0xff] == size)
+                continue;
+
+            size_t offset = 0;
+            for (size_t b = 0; b < 256; ++b) {
+                const size_t count = digit_counts[b];
+                digit_counts[b] = offset;
+                offset += count;
+            }
+
+            const size_t shift = d * 8;
+            for (size_t i = 0; i < size; ++i) {
+                const bits_t bits = key_at(i);
+                const size_t to = digit_counts[(bits >> shift) & 0xff]++;
+                ::memcpy((void*)(destination + to), (const void*)(source + i),
+                         sizeof(T));
+                if constexpr (!keys_are_items)
+                    scratch_keys[to] = bits;
+            }
+
+            T* const swap = source;
+            source = destination;
+            destination = swap;
+            if constexpr (!keys_are_items) {
+                bits_t* const swap_keys = keys;
+                keys = scratch_keys;
+                scratch_keys = swap_keys;
+            }
+        }
+
+        if (source != begin)
+            ::memcpy((void*)begin, (const void*)source, sizeof(T) * size);
+    }
+};
+
+struct radix_sort_fn_t
+{
+    template <typename T, allocator_c allocator_t>
+        requires radix_key_c<T>
+    [[nodiscard]] status<alloc::error>
+    operator()(allocator_t& allocator, slice<T> items) const OKAYLIB_NOEXCEPT
+    {
+        return radix_sort_by_key_fn_t{}(allocator, items,
+                                        radix_identity_key_t{});
+    }
+};
+
+} // namespace detail
+
+/// Sort the items in place. Not stable.
+/// ok::sort(items) or ok::sort(items, compare)
+inline constexpr detail::sort_fn_t sort;
+
+/// Sort the items in place by comparing key_fn(item) for each one. Not stable.
+/// The key function is called for every comparison, so it should be cheap.
+inline constexpr detail::sort_by_key_fn_t sort_by_key;
+
+/// Sort the items so that equal items keep their original order. Allocates a
+/// buffer for half of the items, and only errors if that allocation fails.
+/// ok::stable_sort(allocator, items) or
+/// ok::stable_sort(allocator, items, compare)
+inline constexpr detail::stable_sort_fn_t stable_sort;
+
+/// Stable LSD radix sort of integers or floats. Allocates a buffer the size of
+/// the items, and only errors if that allocation fails. Passes over bytes
+/// which are the same for every key are skipped. Much faster than stable_sort,
+/// and faster than sort for keys of 32 bits or less, but sort usually wins
+/// for random 64 bit keys when stability does not matter.
+inline constexpr detail::radix_sort_fn_t radix_sort;
+
+/// Stable LSD radix sort of trivially relocatable items, by an integer or float
+/// key. The key function is called once per item, and the keys are stored in
+/// a second buffer alongside the scratch items.
+inline constexpr detail::radix_sort_by_key_fn_t radix_sort_by_key;
+
+} // namespace ok
+
+#endif
@@ -49,7 +49,7 @@ class arena_t : public allocator_t
     {
         // just allocate a new block with the new size and do a copy
         res allocation = this->allocate(alloc::request_t{
-            .num_bytes = options.preferred_size_bytes,
+            .num_bytes = options.calculate_preferred_size(),
             .alignment = options.alignment,
             .leave_nonzeroed = true,
         });
@@ -2,12 +2,21 @@
 #define __OKAYLIB_ALLOCATORS_BLOCK_ALLOCATOR_H__
 
 #include "okay/allocators/allocator.h"
+#include "okay/detail/no_unique_addr.h"
+#include "okay/math/fast_divisor.h"
 #include "okay/math/rounding.h"
+#include "okay/platform/atomic.h"
 #include "okay/stdmem.h"
 
 namespace ok {
 
 namespace block_allocator {
+/// Passed as the template parameter of basic_block_allocator_t to mean that the
+/// blocksize is decided at runtime, from the options.
+inline constexpr size_t dynamic_blocksize = 0;
+
+/// For static_block_allocator_t, num_bytes_per_block may be left as zero, in
+/// which case the compile time blocksize is used.
 struct fixed_buffer_options_t
 {
     bytes_t fixed_buffer;
@@ -21,7 +30,7 @@ struct alloc_initial_buf_options_t
     size_t minimum_alignment;
 };
 namespace detail {
-struct alloc_initial_buf_t;
+template <size_t static_blocksize> struct alloc_initial_buf_t;
 
 template <typename free_block_t>
 [[nodiscard]] constexpr free_block_t*
@@ -44,7 +53,23 @@ free_everything_in_block_allocator_buffer(bytes_t memory, size_t blocksize,
 } // namespace detail
 } // namespace block_allocator
 
-class block_allocator_t : public ok::allocator_t
+/// Allocator which hands out fixed-size blocks from one contiguous buffer,
+/// which it grows in place. If static_blocksize is not
+/// block_allocator::dynamic_blocksize, then it is the size of every block, and
+/// finding the block which contains a pointer during deallocation is compiled
+/// down to constant arithmetic. Otherwise the blocksize is picked at runtime,
+/// and that is done with a precomputed reciprocal (or a shift, for powers of
+/// two) instead of a division.
+template <size_t static_blocksize> class basic_block_allocator_t;
+
+using block_allocator_t =
+    basic_block_allocator_t<block_allocator::dynamic_blocksize>;
+
+template <size_t blocksize>
+using static_block_allocator_t = basic_block_allocator_t<blocksize>;
+
+template <size_t static_blocksize>
+class basic_block_allocator_t : public ok::allocator_t
 {
   private:
     struct free_block_t
@@ -52,39 +77,94 @@ class block_allocator_t : public ok::allocator_t
         free_block_t* prev;
     };
 
+    static constexpr bool has_static_blocksize =
+        static_blocksize != block_allocator::dynamic_blocksize;
+
+    static_assert(!has_static_blocksize ||
+                      (static_blocksize >= sizeof(free_block_t) &&
+                       static_blocksize % alignof(free_block_t) == 0),
+                  "Compile time blocksize of block allocator must be large "
+                  "enough and aligned enough to fit a pointer.");
+
+    using divisor_t =
+        stdc::conditional_t<has_static_blocksize,
+                            static_divisor_t<static_blocksize>, fast_divisor_t>;
+
     struct members_t
     {
-        bytes_t memory;
+        // the buffer only grows in place, so its start never changes and other
+        // threads may read it
+        uint8_t* start;
         size_t blocksize;
         size_t minimum_alignment;
         free_block_t* free_head;
         allocator_t* backing;
+        // used to turn a pointer into its block index without dividing
+        OKAYLIB_NO_UNIQUE_ADDR divisor_t divisor;
     } m;
 
+    // blocks freed by threads other than the owner, waiting to be moved into
+    // free_head by the owning thread
+    ok::atomic_t<free_block_t*> m_remote_free_head;
+    // size of the buffer in bytes. only the owning thread changes it, when
+    // growing, but contains() may read it from any thread
+    ok::atomic_t<size_t> m_num_bytes;
+
+    /// The whole buffer. Only for the owning thread.
+    [[nodiscard]] constexpr bytes_t memory() const noexcept
+    {
+        return raw_slice(*m.start, m_num_bytes.load(memory_order::relaxed));
+    }
+
     constexpr void destroy() OKAYLIB_NOEXCEPT
     {
         if (!m.backing)
             return;
-
-        if (!m.memory.is_empty()) [[likely]]
-            m.backing->deallocate(m.memory.unchecked_address_of_first_item());
+        m.backing->deallocate(m.start);
     }
 
-    constexpr block_allocator_t(members_t&& m) OKAYLIB_NOEXCEPT
+    constexpr basic_block_allocator_t(members_t&& m,
+                                      size_t num_bytes) OKAYLIB_NOEXCEPT
         : m(stdc::forward<members_t>(m))
     {
+        m_num_bytes.store(num_bytes, memory_order::relaxed);
     }
 
     constexpr alloc::error grow() OKAYLIB_NOEXCEPT;
 
+    [[nodiscard]] constexpr free_block_t*
+    block_containing(void* memory) const OKAYLIB_NOEXCEPT;
+
+    /// Round the requested blocksize up so that every block can hold a free
+    /// list entry and is aligned, or just check the request against the
+    /// compile time blocksize.
+    [[nodiscard]] static constexpr size_t
+    choose_blocksize(size_t num_bytes_per_block,
+                     size_t actual_minimum_alignment) OKAYLIB_NOEXCEPT
+    {
+        const size_t rounded = runtime_round_up_to_multiple_of(
+            actual_minimum_alignment,
+            ok::max(num_bytes_per_block, sizeof(free_block_t)));
+        if constexpr (has_static_blocksize) {
+            __ok_usage_error(rounded <= static_blocksize &&
+                                 static_blocksize % actual_minimum_alignment ==
+                                     0,
+                             "Options given to static_block_allocator_t ask "
+                             "for blocks which do not fit in, or are not "
+                             "aligned with, its compile time blocksize.");
+            return static_blocksize;
+        } else {
+            return rounded;
+        }
+    }
+
     constexpr members_t members_from_fixed_buffer_options(
         const block_allocator::fixed_buffer_options_t& options)
     {
         const size_t actual_minimum_alignment =
             ok::max(options.minimum_alignment, alignof(free_block_t));
-        const size_t actual_blocksize = runtime_round_up_to_multiple_of(
-            actual_minimum_alignment,
-            ok::max(options.num_bytes_per_block, sizeof(free_block_t)));
+        const size_t actual_blocksize = choose_blocksize(
+            options.num_bytes_per_block, actual_minimum_alignment);
         const size_t num_blocks =
             options.fixed_buffer.size() / actual_blocksize;
         __ok_usage_error(num_blocks > 0,
@@ -92,13 +172,14 @@ class block_allocator_t : public ok::allocator_t
                          "enough to fit any blocks, it will OOM immediately.");
 
         return members_t{
-            .memory = options.fixed_buffer,
+            .start = options.fixed_buffer.unchecked_address_of_first_item(),
             .blocksize = actual_blocksize,
             .minimum_alignment = actual_minimum_alignment,
             .free_head = block_allocator::detail::
                 free_everything_in_block_allocator_buffer<free_block_t>(
                     options.fixed_buffer, actual_blocksize),
             .backing = nullptr,
+            .divisor = divisor_t(actual_blocksize),
         };
     }
 
@@ -107,40 +188,59 @@ class block_allocator_t : public ok::allocator_t
         alloc::feature_flags::can_reclaim |
         alloc::feature_flags::can_predictably_realloc_in_place;
 
-    friend class block_allocator::detail::alloc_initial_buf_t;
+    friend struct block_allocator::detail::alloc_initial_buf_t<static_blocksize>;
 
-    block_allocator_t() = delete;
-    constexpr block_allocator_t(
+    basic_block_allocator_t() = delete;
+    constexpr basic_block_allocator_t(
         const block_allocator::fixed_buffer_options_t& options) OKAYLIB_NOEXCEPT
         : m(members_from_fixed_buffer_options(options))
     {
+        m_num_bytes.store(options.fixed_buffer.size(), memory_order::relaxed);
     }
 
-    constexpr block_allocator_t(block_allocator_t&& other) OKAYLIB_NOEXCEPT
+    constexpr basic_block_allocator_t(basic_block_allocator_t&& other)
+        OKAYLIB_NOEXCEPT
         : m(other.m)
     {
+        m_num_bytes.store(other.m_num_bytes.load(memory_order::relaxed),
+                          memory_order::relaxed);
         other.m.free_head = nullptr; // not really necessary
         other.m.backing = nullptr;
+        m_remote_free_head.store(
+            other.m_remote_free_head.exchange(nullptr, memory_order::acquire),
+            memory_order::relaxed);
     }
 
-    constexpr block_allocator_t&
-    operator=(block_allocator_t&& other) OKAYLIB_NOEXCEPT
+    constexpr basic_block_allocator_t&
+    operator=(basic_block_allocator_t&& other) OKAYLIB_NOEXCEPT
     {
         if (&other == this) [[unlikely]]
             return *this;
         destroy();
         m = other.m;
+        m_num_bytes.store(other.m_num_bytes.load(memory_order::relaxed),
+                          memory_order::relaxed);
         other.m.free_head = nullptr; // not really necessary
         other.m.backing = nullptr;
+        m_remote_free_head.store(
+            other.m_remote_free_head.exchange(nullptr, memory_order::acquire),
+            memory_order::relaxed);
         return *this;
     }
 
-    constexpr block_allocator_t& operator=(const block_allocator_t&) = delete;
-    constexpr block_allocator_t(const block_allocator_t&) = delete;
+    constexpr basic_block_allocator_t&
+    operator=(const basic_block_allocator_t&) = delete;
+    constexpr basic_block_allocator_t(const basic_block_allocator_t&) = delete;
 
-    constexpr ~block_allocator_t() OKAYLIB_NOEXCEPT_FORCE { destroy(); }
+    constexpr ~basic_block_allocator_t() OKAYLIB_NOEXCEPT_FORCE { destroy(); }
 
-    constexpr size_t block_size() const noexcept { return m.blocksize; }
+    constexpr size_t block_size() const noexcept
+    {
+        if constexpr (has_static_blocksize)
+            return static_blocksize;
+        else
+            return m.blocksize;
+    }
     constexpr size_t block_align() const noexcept
     {
         return m.minimum_alignment;
@@ -148,17 +248,37 @@ class block_allocator_t : public ok::allocator_t
 
     constexpr bool contains(const bytes_t& bytes) const noexcept
     {
-        return ok_memcontains(.outer = m.memory, .inner = bytes);
+        return ok_memcontains(.outer = this->visible_memory(),
+                              .inner = bytes);
     }
 
+    /// Can be used to find which allocator owns a block, from any thread. The
+    /// start of the allocator's memory never moves (it only grows in place),
+    /// and growing publishes the new size before handing out any of the new
+    /// blocks, so a block which was handed off to another thread after being
+    /// allocated will always be found by this.
     constexpr bool contains(const void* memory) const noexcept
     {
-        return ok_memcontains(.outer = m.memory,
+        return ok_memcontains(.outer = this->visible_memory(),
                               .inner = slice_from_one(*(uint8_t*)memory));
     }
 
+    /// Free a block from a thread which does not own this allocator. The block
+    /// is pushed onto a lock-free stack, and the owning thread takes it back
+    /// the next time it runs out of free blocks while allocating. Safe to call
+    /// from any number of threads at once, concurrently with the owner
+    /// allocating and deallocating.
+    constexpr void deallocate_remote(void* memory) OKAYLIB_NOEXCEPT;
+
     constexpr void clear() OKAYLIB_NOEXCEPT;
 
+  private:
+    /// The buffer as of the last time it grew, safe to read from any thread.
+    [[nodiscard]] constexpr bytes_t visible_memory() const noexcept
+    {
+        return raw_slice(*m.start, m_num_bytes.load(memory_order::acquire));
+    }
+
   protected:
     [[nodiscard]] constexpr alloc::result_t<bytes_t>
     impl_allocate(const alloc::request_t&) OKAYLIB_NOEXCEPT final;
@@ -176,18 +296,21 @@ class block_allocator_t : public ok::allocator_t
     impl_reallocate(const alloc::reallocate_request_t&) OKAYLIB_NOEXCEPT final;
 };
 
-constexpr alloc::error block_allocator_t::grow() OKAYLIB_NOEXCEPT
+template <size_t static_blocksize>
+constexpr alloc::error
+basic_block_allocator_t<static_blocksize>::grow() OKAYLIB_NOEXCEPT
 {
     __ok_internal_assert(!m.free_head);
     if (!m.backing)
         // consider no allocator == no memory
         return alloc::error::oom;
 
+    const bytes_t memory = this->memory();
     alloc::result_t<bytes_t> reallocation =
         m.backing->reallocate(alloc::reallocate_request_t{
-            .memory = m.memory,
-            .new_size_bytes = m.memory.size() + m.blocksize,
-            .preferred_size_bytes = m.memory.size() * 2,
+            .memory = memory,
+            .new_size_bytes = memory.size() + m.blocksize,
+            .preferred_size_bytes = memory.size() * 2,
             .alignment = m.minimum_alignment,
             .flags = alloc::realloc_flags::in_place_orelse_fail |
                      alloc::realloc_flags::leave_nonzeroed,
@@ -197,30 +320,38 @@ constexpr alloc::error block_allocator_t::grow() OKAYLIB_NOEXCEPT
         return reallocation.status();
 
     bytes_t& newmem = reallocation.unwrap();
-    __ok_internal_assert(newmem.unchecked_address_of_first_item() ==
-                         m.memory.unchecked_address_of_first_item());
+    __ok_internal_assert(newmem.unchecked_address_of_first_item() == m.start);
     // there may be extra space at the end
-    const size_t padding = m.memory.size() % m.blocksize;
-    uint8_t* const first_new_byte =
-        newmem.unchecked_address_of_first_item() + m.memory.size() - padding;
-    const size_t additional_size = newmem.size() - m.memory.size() + padding;
+    const size_t padding = memory.size() % m.blocksize;
+    uint8_t* const first_new_byte = m.start + memory.size() - padding;
+    const size_t additional_size = newmem.size() - memory.size() + padding;
 
     m.free_head =
         block_allocator::detail::free_everything_in_block_allocator_buffer(
             ok::raw_slice(*first_new_byte, additional_size), m.blocksize,
             m.free_head);
+    // before any of the new blocks are handed out, so that whichever thread
+    // they end up on can see that they belong to this allocator
+    m_num_bytes.store(newmem.size(), memory_order::release);
 
     __ok_internal_assert(m.free_head);
     return ok::make_success<alloc::error>();
 }
 
+template <size_t static_blocksize>
 [[nodiscard]] constexpr alloc::result_t<bytes_t>
-block_allocator_t::impl_allocate(const alloc::request_t& request)
-    OKAYLIB_NOEXCEPT
+basic_block_allocator_t<static_blocksize>::impl_allocate(
+    const alloc::request_t& request) OKAYLIB_NOEXCEPT
 {
-    if (!m.free_head) [[unlikely]]
-        if (auto err = grow(); !ok::is_success(err)) [[unlikely]]
-            return err;
+    if (!m.free_head) [[unlikely]] {
+        // take back anything other threads have freed, before asking for more
+        // memory
+        m.free_head =
+            m_remote_free_head.exchange(nullptr, memory_order::acquire);
+        if (!m.free_head)
+            if (auto err = grow(); !ok::is_success(err)) [[unlikely]]
+                return err;
+    }
     __ok_internal_assert(m.free_head);
 
     if (request.num_bytes > m.blocksize ||
@@ -241,43 +372,77 @@ block_allocator_t::impl_allocate(const alloc::request_t& request)
     return output_memory;
 }
 
-constexpr void block_allocator_t::clear() OKAYLIB_NOEXCEPT
+template <size_t static_blocksize>
+constexpr void basic_block_allocator_t<static_blocksize>::clear() OKAYLIB_NOEXCEPT
 {
+    m_remote_free_head.store(nullptr, memory_order::relaxed);
     m.free_head =
         block_allocator::detail::free_everything_in_block_allocator_buffer<
-            free_block_t>(m.memory, m.blocksize);
+            free_block_t>(this->memory(), m.blocksize);
 }
 
-constexpr void
-block_allocator_t::impl_deallocate(void* memory,
-                                   size_t /* size_hint */) OKAYLIB_NOEXCEPT
+template <size_t static_blocksize>
+constexpr void basic_block_allocator_t<static_blocksize>::impl_deallocate(
+    void* memory, size_t /* size_hint */) OKAYLIB_NOEXCEPT
 {
     __ok_assert(this->contains(memory),
                 "Attempt to free bytes from block allocator which do not all "
                 "belong to that allocator");
 
+    auto* const free_block = block_containing(memory);
+    free_block->prev = stdc::exchange(m.free_head, free_block);
+}
+
+template <size_t static_blocksize>
+constexpr void basic_block_allocator_t<static_blocksize>::deallocate_remote(
+    void* memory) OKAYLIB_NOEXCEPT
+{
+    if (!memory) [[unlikely]]
+        return;
+
+    __ok_assert(this->contains(memory),
+                "Attempt to remotely free bytes from block allocator which do "
+                "not all belong to that allocator");
+
+    auto* const free_block = block_containing(memory);
+
+    // treiber stack push. only the owning thread pops, and it always takes
+    // the whole stack at once, so there is no ABA problem.
+    free_block_t* expected =
+        m_remote_free_head.load(memory_order::relaxed);
+    do {
+        free_block->prev = expected;
+    } while (!m_remote_free_head.compare_exchange_weak(
+        expected, free_block, memory_order::release, memory_order::relaxed));
+}
+
+template <size_t static_blocksize>
+[[nodiscard]] constexpr auto
+basic_block_allocator_t<static_blocksize>::block_containing(void* memory) const
+    OKAYLIB_NOEXCEPT -> free_block_t*
+{
     // "align" memory to blocksize, relative to the start of our memory block.
     // aligning it to our minimum align or to our blocksize will not work- the
     // minimum align may be much smaller than blocksize.
-    const auto memstart = uint64_t(m.memory.unchecked_address_of_first_item());
+    const auto memstart = uint64_t(m.start);
     const auto alignedmemory =
-        (void*)((((uint64_t(memory) - memstart) / m.blocksize) * m.blocksize) +
+        (void*)(m.divisor.round_down_to_multiple(uint64_t(memory) - memstart) +
                 memstart);
     __ok_internal_assert(this->contains(alignedmemory));
-
-    auto* const free_block = reinterpret_cast<free_block_t*>(alignedmemory);
-    free_block->prev = stdc::exchange(m.free_head, free_block);
+    auto* const block = reinterpret_cast<free_block_t*>(alignedmemory);
+    return block;
 }
 
+template <size_t static_blocksize>
 [[nodiscard]] constexpr alloc::result_t<bytes_t>
-block_allocator_t::impl_reallocate(const alloc::reallocate_request_t& request)
-    OKAYLIB_NOEXCEPT
+basic_block_allocator_t<static_blocksize>::impl_reallocate(
+    const alloc::reallocate_request_t& request) OKAYLIB_NOEXCEPT
 {
     __ok_assert(this->contains(request.memory),
                 "Attempt to realloc bytes from block allocator which do not "
                 "all belong to that allocator");
     __ok_assert((request.memory.unchecked_address_of_first_item() -
-                 m.memory.unchecked_address_of_first_item()) %
+                 m.start) %
                         m.blocksize ==
                     0,
                 "Attempt to realloc something from block allocator that is not "
@@ -309,12 +474,12 @@ block_allocator_t::impl_reallocate(const alloc::reallocate_request_t& request)
 
 namespace block_allocator {
 namespace detail {
-struct alloc_initial_buf_t
+template <size_t static_blocksize> struct alloc_initial_buf_t
 {
     static constexpr auto implemented_make_function =
         ok::implemented_make_function::make_into_uninit;
 
-    using associated_type = block_allocator_t;
+    using associated_type = basic_block_allocator_t<static_blocksize>;
 
     [[nodiscard]] constexpr auto operator()(
         allocator_t& allocator,
@@ -324,16 +489,15 @@ struct alloc_initial_buf_t
     }
 
     [[nodiscard]] constexpr alloc::error make_into_uninit(
-        ok::block_allocator_t& uninit, allocator_t& allocator,
+        associated_type& uninit, allocator_t& allocator,
         const alloc_initial_buf_options_t& options) const OKAYLIB_NOEXCEPT
     {
-        using block_allocator_t = ok::block_allocator_t;
+        using block_allocator_t = associated_type;
         using free_block_t = typename block_allocator_t::free_block_t;
         const size_t actual_minimum_alignment =
             ok::max(options.minimum_alignment, alignof(free_block_t));
-        const size_t actual_blocksize = runtime_round_up_to_multiple_of(
-            actual_minimum_alignment,
-            ok::max(options.num_bytes_per_block, sizeof(free_block_t)));
+        const size_t actual_blocksize = block_allocator_t::choose_blocksize(
+            options.num_bytes_per_block, actual_minimum_alignment);
 
         alloc::result_t<bytes_t> result = allocator.allocate(alloc::request_t{
             .num_bytes = actual_blocksize * options.num_initial_spots,
@@ -348,15 +512,19 @@ struct alloc_initial_buf_t
 
         ok::stdc::construct_at(
             ok::addressof(uninit),
-            block_allocator_t(typename block_allocator_t::members_t{
-                .memory = allocation,
-                .blocksize = actual_blocksize,
-                .minimum_alignment = actual_minimum_alignment,
-                .free_head =
-                    free_everything_in_block_allocator_buffer<free_block_t>(
-                        allocation, actual_blocksize),
-                .backing = ok::addressof(allocator),
-            }));
+            block_allocator_t(
+                typename block_allocator_t::members_t{
+                    .start = allocation.unchecked_address_of_first_item(),
+                    .blocksize = actual_blocksize,
+                    .minimum_alignment = actual_minimum_alignment,
+                    .free_head =
+                        free_everything_in_block_allocator_buffer<free_block_t>(
+                            allocation, actual_blocksize),
+                    .backing = ok::addressof(allocator),
+                    .divisor = typename block_allocator_t::divisor_t(
+                        actual_blocksize),
+                },
+                allocation.size()));
 
         __ok_usage_error(uninit.m.free_head,
                          "Created block allocator without enough memory, it "
@@ -367,9 +535,16 @@ struct alloc_initial_buf_t
 };
 } // namespace detail
 
-inline constexpr detail::alloc_initial_buf_t alloc_initial_buf;
+inline constexpr detail::alloc_initial_buf_t<dynamic_blocksize>
+    alloc_initial_buf;
 
 } // namespace block_allocator
+
+namespace static_block_allocator {
+template <size_t blocksize>
+inline constexpr block_allocator::detail::alloc_initial_buf_t<blocksize>
+    alloc_initial_buf;
+} // namespace static_block_allocator
 } // namespace ok
 
 #endif
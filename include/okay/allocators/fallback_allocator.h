@@ -0,0 +1,215 @@
+#ifndef __OKAYLIB_ALLOCATORS_FALLBACK_ALLOCATOR_H__
+#define __OKAYLIB_ALLOCATORS_FALLBACK_ALLOCATOR_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/containers/array.h"
+#include "okay/stdmem.h"
+
+namespace ok {
+
+/// An allocator which serves requests out of an inline buffer of
+/// num_inline_bytes, and then falls through to a backing allocator once the
+/// inline buffer is exhausted. Deallocation is routed by address. The inline
+/// buffer behaves like a small arena: freeing the most recent inline allocation
+/// gives its bytes back, and once every inline allocation has been freed the
+/// whole buffer becomes available again.
+///
+/// Intended for "up to N bytes on the stack, spill to the heap otherwise"
+/// scratch space.
+template <size_t num_inline_bytes>
+class fallback_allocator_t : public ok::allocator_t
+{
+  public:
+    static_assert(num_inline_bytes > 0,
+                  "Cannot create a fallback_allocator_t with no inline "
+                  "storage, use the backing allocator directly.");
+
+    static constexpr alloc::feature_flags type_features =
+        alloc::feature_flags::can_reclaim;
+
+    fallback_allocator_t() = delete;
+
+    constexpr explicit fallback_allocator_t(allocator_t& backing_allocator)
+        OKAYLIB_NOEXCEPT : m_backing(ok::addressof(backing_allocator))
+    {
+    }
+
+    /// Moving is only allowed when there are no live allocations in the inline
+    /// buffer, otherwise they would be left pointing into the moved-from
+    /// allocator.
+    constexpr fallback_allocator_t(fallback_allocator_t&& other)
+        OKAYLIB_NOEXCEPT : m_backing(other.m_backing)
+    {
+        __ok_usage_error(other.m_num_live_inline_allocations == 0,
+                         "Attempt to move a fallback_allocator_t which has "
+                         "live allocations inside of its inline buffer.");
+    }
+
+    constexpr fallback_allocator_t&
+    operator=(fallback_allocator_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (&other == this) [[unlikely]]
+            return *this;
+        __ok_usage_error(other.m_num_live_inline_allocations == 0,
+                         "Attempt to move a fallback_allocator_t which has "
+                         "live allocations inside of its inline buffer.");
+        m_backing = other.m_backing;
+        m_first_available_byte_index = 0;
+        m_last_allocation_start_index = 0;
+        m_num_live_inline_allocations = 0;
+        return *this;
+    }
+
+    fallback_allocator_t& operator=(const fallback_allocator_t&) = delete;
+    fallback_allocator_t(const fallback_allocator_t&) = delete;
+
+    constexpr ~fallback_allocator_t() = default;
+
+    /// Whether the given memory lives inside of the inline buffer (as opposed
+    /// to having come from the backing allocator)
+    [[nodiscard]] constexpr bool
+    inline_buffer_contains(const void* memory) const noexcept
+    {
+        const auto start = uintptr_t(m_buffer.data());
+        return uintptr_t(memory) >= start &&
+               uintptr_t(memory) < start + num_inline_bytes;
+    }
+
+    [[nodiscard]] constexpr size_t inline_bytes_remaining() const noexcept
+    {
+        return num_inline_bytes - m_first_available_byte_index;
+    }
+
+  protected:
+    [[nodiscard]] constexpr alloc::result_t<bytes_t>
+    impl_allocate(const alloc::request_t& request) OKAYLIB_NOEXCEPT final
+    {
+        if (uint8_t* const inline_allocation = try_allocate_inline(request))
+            [[likely]] {
+            if (!request.leave_nonzeroed) {
+                ::memset(inline_allocation, 0, request.num_bytes);
+            }
+            return raw_slice(*inline_allocation, request.num_bytes);
+        }
+        return m_backing->allocate(request);
+    }
+
+    [[nodiscard]] constexpr alloc::feature_flags
+    impl_features() const OKAYLIB_NOEXCEPT final
+    {
+        // frees which spill over pass their size hint on, so if the backing
+        // allocator needs it to be accurate then so does this one
+        if (m_backing->features() &
+            alloc::feature_flags::needs_accurate_sizehint)
+            return type_features |
+                   alloc::feature_flags::needs_accurate_sizehint;
+        return type_features;
+    }
+
+    constexpr void impl_deallocate(void* memory,
+                                   size_t size_hint) OKAYLIB_NOEXCEPT final
+    {
+        if (!inline_buffer_contains(memory)) {
+            m_backing->deallocate(memory, size_hint);
+            return;
+        }
+
+        __ok_assert(m_num_live_inline_allocations > 0,
+                    "Double free detected in fallback_allocator_t");
+        --m_num_live_inline_allocations;
+
+        if (m_num_live_inline_allocations == 0) {
+            // everything in the buffer is free, start over from the beginning
+            m_first_available_byte_index = 0;
+            m_last_allocation_start_index = 0;
+        } else if (memory == m_buffer.data() + m_last_allocation_start_index) {
+            // popping the most recent allocation off of the "stack"
+            m_first_available_byte_index = m_last_allocation_start_index;
+        }
+    }
+
+    [[nodiscard]] constexpr alloc::result_t<bytes_t> impl_reallocate(
+        const alloc::reallocate_request_t& request) OKAYLIB_NOEXCEPT final
+    {
+        uint8_t* const start = request.memory.unchecked_address_of_first_item();
+        if (!inline_buffer_contains(start))
+            return m_backing->reallocate(request);
+
+        const size_t newsize = request.calculate_preferred_size();
+
+        // most recent allocation can grow or shrink in place
+        if (start == m_buffer.data() + m_last_allocation_start_index &&
+            m_last_allocation_start_index + newsize <= num_inline_bytes) {
+            m_first_available_byte_index =
+                m_last_allocation_start_index + newsize;
+            if (!(request.flags & alloc::realloc_flags::leave_nonzeroed) &&
+                newsize > request.memory.size()) {
+                ::memset(start + request.memory.size(), 0,
+                         newsize - request.memory.size());
+            }
+            return raw_slice(*start, newsize);
+        }
+
+        if (request.flags & alloc::realloc_flags::in_place_orelse_fail)
+            return alloc::error::couldnt_expand_in_place;
+
+        if (newsize <= request.memory.size()) {
+            // shrinking something which is not on top: just keep it as-is
+            return raw_slice(*start, newsize);
+        }
+
+        res allocation = this->allocate(alloc::request_t{
+            .num_bytes = newsize,
+            .alignment = request.alignment,
+            .leave_nonzeroed = true,
+        });
+
+        if (!allocation.is_success()) [[unlikely]]
+            return allocation;
+
+        bytes_t& newmem = allocation.unwrap();
+
+        auto&& _ = ok_memcopy(.to = newmem, .from = request.memory);
+
+        if (!(request.flags & alloc::realloc_flags::leave_nonzeroed)) {
+            ::memset(newmem.unchecked_address_of_first_item() +
+                         request.memory.size(),
+                     0, newmem.size() - request.memory.size());
+        }
+
+        this->deallocate(start);
+        return newmem;
+    }
+
+  private:
+    /// Returns nullptr if there is not enough space left in the inline buffer
+    [[nodiscard]] constexpr uint8_t*
+    try_allocate_inline(const alloc::request_t& request) OKAYLIB_NOEXCEPT
+    {
+        const auto first_available =
+            uintptr_t(m_buffer.data() + m_first_available_byte_index);
+        const size_t padding =
+            (request.alignment - (first_available % request.alignment)) %
+            request.alignment;
+
+        if (request.num_bytes + padding > inline_bytes_remaining())
+            return nullptr;
+
+        const size_t start_index = m_first_available_byte_index + padding;
+        m_last_allocation_start_index = start_index;
+        m_first_available_byte_index = start_index + request.num_bytes;
+        ++m_num_live_inline_allocations;
+        return m_buffer.data() + start_index;
+    }
+
+    alignas(alloc::default_align)
+        maybe_undefined_array_t<uint8_t, num_inline_bytes> m_buffer;
+    allocator_t* m_backing;
+    size_t m_first_available_byte_index = 0;
+    size_t m_last_allocation_start_index = 0;
+    size_t m_num_live_inline_allocations = 0;
+};
+
+} // namespace ok
+
+#endif
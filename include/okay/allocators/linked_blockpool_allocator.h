@@ -2,6 +2,7 @@
 #define __OKAYLIB_ALLOCATORS_LINKED_BLOCK_ALLOCATOR_H__
 
 #include "okay/allocators/allocator.h"
+#include "okay/math/fast_divisor.h"
 #include "okay/math/rounding.h"
 #include "okay/stdmem.h"
 
@@ -171,6 +172,8 @@ class linked_blockpool_allocator_t : public ok::allocator_t
         // how much to increase each new blockpool's block count by, with each
         // new one allocated. usually 2.0
         float growth_factor;
+        // blocksize, for finding the start of a block without dividing
+        fast_divisor_t divisor;
     } m;
 
     constexpr linked_blockpool_allocator_t(M&& members) noexcept : m(members) {}
@@ -303,10 +306,10 @@ linked_blockpool_allocator_t::impl_deallocate(void* memory,
     // minimum align may be much smaller than blocksize.
     const auto memstart = uint64_t(iter->blocks_start());
     const auto alignedmemory =
-        (void*)((((uint64_t(memory) - memstart) / m.blocksize) * m.blocksize) +
+        (void*)(m.divisor.round_down_to_multiple(uint64_t(memory) - memstart) +
                 memstart);
 
-    free_block_t* new_free = reinterpret_cast<free_block_t*>(memory);
+    free_block_t* new_free = reinterpret_cast<free_block_t*>(alignedmemory);
     ok::mark_bytes_freed_if_debugging(
         ok::raw_slice(*(uint8_t*)new_free, m.blocksize));
     new_free->prev = m.free_head;
@@ -449,6 +452,7 @@ struct start_with_one_pool_t
                 .backing = ok::addressof(allocator),
                 .free_head = free_list_iter,
                 .growth_factor = options.pool_growth_factor,
+                .divisor = fast_divisor_t(actual_blocksize),
             }));
 
         return alloc::error::success;
@@ -4,6 +4,7 @@
 #include "okay/allocators/allocator.h"
 #include "okay/math/rounding.h"
 #include "okay/platform/memory_map.h"
+#include "okay/platform/numa.h"
 #include <cstring>
 
 namespace ok {
@@ -21,7 +22,18 @@ class page_allocator_t : public allocator_t
         alloc::feature_flags::can_reclaim |
         alloc::feature_flags::needs_accurate_sizehint;
 
+    struct options_t
+    {
+        // NUMA placement policy applied to every allocation. Does nothing on
+        // machines with one NUMA node.
+        numa::placement_t placement;
+    };
+
     page_allocator_t() = default;
+    explicit page_allocator_t(const options_t& options) noexcept
+        : m_placement(options.placement)
+    {
+    }
 
   protected:
     [[nodiscard]] inline alloc::result_t<bytes_t>
@@ -48,6 +60,13 @@ class page_allocator_t : public allocator_t
 
         __ok_internal_assert(result.bytes >= total_bytes);
 
+        // must happen before memset, which is the first touch
+        if (numa::apply_placement(result.data, result.bytes, m_placement) !=
+            0) [[unlikely]] {
+            mmap::memory_unmap(result.data, result.bytes);
+            return alloc::error::platform_failure;
+        }
+
         if (!(request.leave_nonzeroed)) {
             ::memset(result.data, 0, result.bytes);
         }
@@ -83,6 +102,9 @@ class page_allocator_t : public allocator_t
     {
         return alloc::error::unsupported;
     }
+
+  private:
+    numa::placement_t m_placement;
 };
 } // namespace ok
 
@@ -5,6 +5,7 @@
 #include "okay/math/math.h"
 #include "okay/math/rounding.h"
 #include "okay/platform/memory_map.h"
+#include "okay/platform/numa.h"
 #include <cstring>
 
 namespace ok {
@@ -36,11 +37,16 @@ class reserving_page_allocator_t : public allocator_t
     {
         // four gigabytes on systems with 4K page size
         size_t pages_reserved = 1000000UL;
+        // NUMA placement policy applied to every reservation, so it also
+        // covers pages committed later by reallocating. Does nothing on
+        // machines with one NUMA node.
+        numa::placement_t placement;
     };
 
     reserving_page_allocator_t() = delete;
     explicit reserving_page_allocator_t(const options_t& options) noexcept
-        : m_pages_reserved(options.pages_reserved)
+        : m_pages_reserved(options.pages_reserved),
+          m_placement(options.placement)
     {
     }
 
@@ -78,6 +84,11 @@ class reserving_page_allocator_t : public allocator_t
             mmap::map_result_t result = mmap::alloc_pages(nullptr, total_pages);
             if (result.code != 0) [[unlikely]]
                 return alloc::error::oom;
+            if (numa::apply_placement(result.data, result.bytes,
+                                      m_placement) != 0) [[unlikely]] {
+                mmap::memory_unmap(result.data, result.bytes);
+                return alloc::error::platform_failure;
+            }
             return ok::raw_slice(*static_cast<uint8_t*>(result.data),
                                  result.bytes);
         }
@@ -89,6 +100,14 @@ class reserving_page_allocator_t : public allocator_t
             return alloc::error::oom;
         }
 
+        if (numa::apply_placement(reservation_result.data,
+                                  reservation_result.bytes,
+                                  m_placement) != 0) [[unlikely]] {
+            mmap::memory_unmap(reservation_result.data,
+                               reservation_result.bytes);
+            return alloc::error::platform_failure;
+        }
+
         int64_t code = mmap::commit_pages(reservation_result.data,
                                           total_bytes / page_size);
 
@@ -176,6 +195,7 @@ class reserving_page_allocator_t : public allocator_t
 
   private:
     size_t m_pages_reserved;
+    numa::placement_t m_placement;
 };
 } // namespace ok
 
@@ -0,0 +1,367 @@
+#ifndef __OKAYLIB_ALLOCATORS_SAMPLING_ALLOCATOR_H__
+#define __OKAYLIB_ALLOCATORS_SAMPLING_ALLOCATOR_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/containers/arraylist.h"
+#include "okay/containers/hashmap.h"
+#include <cmath>
+#include <cstdio>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define OKAYLIB_SAMPLING_ALLOCATOR_HAS_BACKTRACE
+#endif
+
+namespace ok {
+
+namespace sampling_allocator {
+inline constexpr size_t max_stack_depth = 16;
+
+struct options_t
+{
+    // The average number of bytes allocated between each sample. The actual
+    // distance between samples is drawn from an exponential distribution with
+    // this mean, so every byte allocated has an equal chance of being sampled.
+    size_t mean_bytes_between_samples = 512 * 1024;
+    uint64_t seed = 0x9E3779B97F4A7C15;
+};
+
+/// The stack at the time that an allocation was requested, innermost frame
+/// first. Resolve the addresses with addr2line or a debugger. Stacks are only
+/// captured on platforms that provide backtrace(), elsewhere the call site is
+/// just the return address of the allocator.
+struct call_site_t
+{
+    ok::maybe_undefined_array_t<void*, max_stack_depth> frames;
+    size_t depth;
+
+    [[nodiscard]] inline slice<void* const> stack() const OKAYLIB_NOEXCEPT
+    {
+        return raw_slice(*frames.data(), depth);
+    }
+
+    [[nodiscard]] constexpr friend bool
+    operator==(const call_site_t& a, const call_site_t& b) OKAYLIB_NOEXCEPT
+    {
+        if (a.depth != b.depth)
+            return false;
+        for (size_t i = 0; i < a.depth; ++i) {
+            if (a.frames[i] != b.frames[i])
+                return false;
+        }
+        return true;
+    }
+};
+
+/// A sampled allocation which has not yet been freed
+struct sample_t
+{
+    void* memory;
+    size_t num_bytes;
+    call_site_t call_site;
+};
+
+/// An aggregate of all the live samples with the same call site
+struct call_site_summary_t
+{
+    const call_site_t& call_site;
+    size_t num_live_samples;
+    size_t sampled_bytes;
+    // estimate of the total live bytes allocated at this call site, including
+    // the ones which were not sampled
+    size_t estimated_bytes;
+};
+} // namespace sampling_allocator
+
+/// Heap profiler which wraps another allocator. Allocations are sampled at
+/// random with a probability proportional to their size (like tcmalloc's heap
+/// sampling), and each sample records the call site that requested it. Samples
+/// are removed once they are freed, so the set of live samples is an estimate
+/// of what is currently using memory, and where it came from.
+///
+/// When an allocation is not sampled, the only overhead is decrementing a
+/// counter, and freeing it costs one hash lookup while any samples are live.
+/// Sample bookkeeping is stored using a separate allocator so that it does not
+/// show up in the profile.
+class sampling_allocator_t : public ok::allocator_t
+{
+  public:
+    using options_t = sampling_allocator::options_t;
+    using sample_t = sampling_allocator::sample_t;
+    using call_site_t = sampling_allocator::call_site_t;
+    using call_site_summary_t = sampling_allocator::call_site_summary_t;
+
+    sampling_allocator_t() = delete;
+
+    inline sampling_allocator_t(allocator_t& backing,
+                                allocator_t& bookkeeping_allocator,
+                                const options_t& options = {})
+        OKAYLIB_NOEXCEPT
+        : m_backing(ok::addressof(backing)),
+          m_live_samples(arraylist::empty<sample_t>(bookkeeping_allocator)),
+          m_sample_indices(bookkeeping_allocator),
+          m_mean_bytes_between_samples(options.mean_bytes_between_samples),
+          m_rng_state(options.seed == 0 ? 1 : options.seed)
+    {
+        __ok_usage_error(options.mean_bytes_between_samples != 0,
+                         "Attempt to create a sampling_allocator_t with a "
+                         "sample interval of zero bytes.");
+        m_bytes_until_next_sample = pick_next_sample_distance();
+    }
+
+    sampling_allocator_t(sampling_allocator_t&&) = default;
+    sampling_allocator_t& operator=(sampling_allocator_t&&) = default;
+
+    sampling_allocator_t& operator=(const sampling_allocator_t&) = delete;
+    sampling_allocator_t(const sampling_allocator_t&) = delete;
+
+    [[nodiscard]] constexpr slice<const sample_t>
+    live_samples() const OKAYLIB_NOEXCEPT
+    {
+        return m_live_samples.items();
+    }
+
+    [[nodiscard]] constexpr size_t
+    mean_bytes_between_samples() const OKAYLIB_NOEXCEPT
+    {
+        return m_mean_bytes_between_samples;
+    }
+
+    /// Estimate how many bytes a sample of the given size stands in for. A
+    /// sample of N bytes had a probability of 1 - e^(-N / mean) of being
+    /// taken, so it represents N / probability bytes on average.
+    [[nodiscard]] inline size_t
+    estimate_bytes_represented(size_t sample_bytes) const OKAYLIB_NOEXCEPT
+    {
+        const double probability =
+            1.0 - std::exp(-double(sample_bytes) /
+                           double(m_mean_bytes_between_samples));
+        return size_t(double(sample_bytes) / probability);
+    }
+
+    /// Call the given callable with a call_site_summary_t for each call site
+    /// which has live samples.
+    template <typename callable_t>
+    constexpr void
+    for_each_call_site(const callable_t& callable) const OKAYLIB_NOEXCEPT
+    {
+        const slice<const sample_t> samples = live_samples();
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const call_site_t& call_site = samples[i].call_site;
+
+            bool already_reported = false;
+            for (size_t j = 0; j < i; ++j) {
+                if (samples[j].call_site == call_site) {
+                    already_reported = true;
+                    break;
+                }
+            }
+            if (already_reported)
+                continue;
+
+            call_site_summary_t summary{.call_site = call_site};
+            for (size_t j = i; j < samples.size(); ++j) {
+                if (samples[j].call_site != call_site)
+                    continue;
+                ++summary.num_live_samples;
+                summary.sampled_bytes += samples[j].num_bytes;
+                summary.estimated_bytes +=
+                    estimate_bytes_represented(samples[j].num_bytes);
+            }
+            callable(summary);
+        }
+    }
+
+    /// Write a human readable heap profile, one line per call site.
+    inline void write_text_profile(FILE* output) const OKAYLIB_NOEXCEPT
+    {
+        size_t total_estimated_bytes = 0;
+        for_each_call_site([&](const call_site_summary_t& summary) {
+            total_estimated_bytes += summary.estimated_bytes;
+        });
+
+        ::fprintf(output,
+                  "heap profile: %zu live samples, ~%zu bytes live, sampled "
+                  "every ~%zu bytes\n",
+                  m_live_samples.size(), total_estimated_bytes,
+                  m_mean_bytes_between_samples);
+
+        for_each_call_site([&](const call_site_summary_t& summary) {
+            ::fprintf(output, "%12zu bytes %8zu samples  @",
+                      summary.estimated_bytes, summary.num_live_samples);
+            const slice<void* const> stack = summary.call_site.stack();
+            for (size_t i = 0; i < stack.size(); ++i) {
+                ::fprintf(output, " %p", stack[i]);
+            }
+            ::fprintf(output, "\n");
+        });
+    }
+
+  protected:
+    [[nodiscard]] inline alloc::result_t<bytes_t>
+    impl_allocate(const alloc::request_t& request) OKAYLIB_NOEXCEPT final
+    {
+        alloc::result_t<bytes_t> result = m_backing->allocate(request);
+
+        if (request.num_bytes < m_bytes_until_next_sample) [[likely]] {
+            m_bytes_until_next_sample -= request.num_bytes;
+            return result;
+        }
+
+        if (result.is_success()) [[likely]] {
+            record_sample(result.unwrap_unchecked());
+        }
+        return result;
+    }
+
+    [[nodiscard]] constexpr alloc::feature_flags
+    impl_features() const OKAYLIB_NOEXCEPT final
+    {
+        return m_backing->features();
+    }
+
+    constexpr void impl_deallocate(void* memory,
+                                   size_t size_hint) OKAYLIB_NOEXCEPT final
+    {
+        if (!m_live_samples.is_empty()) [[unlikely]] {
+            if (opt<size_t> index = find_sample(memory))
+                remove_sample(index.ref_unchecked());
+        }
+        m_backing->deallocate(memory, size_hint);
+    }
+
+    [[nodiscard]] inline alloc::result_t<bytes_t>
+    impl_reallocate(const alloc::reallocate_request_t& request)
+        OKAYLIB_NOEXCEPT final
+    {
+        alloc::result_t<bytes_t> result = m_backing->reallocate(request);
+        if (!result.is_success()) [[unlikely]]
+            return result;
+
+        const bytes_t& newmem = result.unwrap_unchecked();
+
+        // a sampled allocation has moved or changed size, keep it up to date
+        if (!m_live_samples.is_empty()) [[unlikely]] {
+            void* const old_address =
+                request.memory.unchecked_address_of_first_item();
+            if (opt<size_t> index = find_sample(old_address)) {
+                this->move_sample(index.ref_unchecked(), newmem);
+                return result;
+            }
+        }
+
+        // count growth as newly allocated bytes
+        const size_t growth = newmem.size() > request.memory.size()
+                                  ? newmem.size() - request.memory.size()
+                                  : 0;
+        if (growth < m_bytes_until_next_sample) [[likely]] {
+            m_bytes_until_next_sample -= growth;
+            return result;
+        }
+
+        record_sample(newmem);
+        return result;
+    }
+
+  private:
+    inline void record_sample(const bytes_t& memory) OKAYLIB_NOEXCEPT
+    {
+        m_bytes_until_next_sample = pick_next_sample_distance();
+
+        sample_t sample{
+            .memory = memory.unchecked_address_of_first_item(),
+            .num_bytes = memory.size(),
+        };
+#if defined(OKAYLIB_SAMPLING_ALLOCATOR_HAS_BACKTRACE)
+        sample.call_site.depth =
+            ::backtrace(sample.call_site.frames.data(),
+                        int(sampling_allocator::max_stack_depth));
+#else
+        sample.call_site.frames[0] = __builtin_return_address(0);
+        sample.call_site.depth = 1;
+#endif
+
+        // if bookkeeping runs out of memory, just drop the sample
+        const size_t index = m_live_samples.size();
+        if (!m_live_samples.append(sample).is_success()) [[unlikely]]
+            return;
+        if (!m_sample_indices.insert(sample.memory, index).is_success())
+            [[unlikely]] {
+            m_live_samples.pop_last();
+        }
+    }
+
+    [[nodiscard]] inline opt<size_t>
+    find_sample(void* memory) const OKAYLIB_NOEXCEPT
+    {
+        if (opt<const size_t&> index = m_sample_indices.get(memory))
+            return index.ref_unchecked();
+        return {};
+    }
+
+    /// Forget a sample, moving the last one into its place.
+    inline void remove_sample(size_t index) OKAYLIB_NOEXCEPT
+    {
+        m_sample_indices.remove(m_live_samples[index].memory);
+        const size_t last = m_live_samples.size() - 1;
+        if (index != last) {
+            m_sample_indices.get(m_live_samples[last].memory).ref_unchecked() =
+                index;
+        }
+        m_live_samples.remove_and_swap_last(index);
+    }
+
+    /// Update a sample after its allocation was reallocated.
+    inline void move_sample(size_t index,
+                            const bytes_t& newmem) OKAYLIB_NOEXCEPT
+    {
+        sample_t& sample = m_live_samples[index];
+        sample.num_bytes = newmem.size();
+        void* const new_address = newmem.unchecked_address_of_first_item();
+        if (sample.memory == new_address)
+            return;
+        m_sample_indices.remove(sample.memory);
+        sample.memory = new_address;
+        // if bookkeeping runs out of memory, just drop the sample
+        if (!m_sample_indices.insert(new_address, index).is_success())
+            [[unlikely]] {
+            m_live_samples.remove_and_swap_last(index);
+            if (index != m_live_samples.size()) {
+                m_sample_indices
+                    .get(m_live_samples[index].memory)
+                    .ref_unchecked() = index;
+            }
+        }
+    }
+
+    /// Draw from an exponential distribution with a mean of
+    /// m_mean_bytes_between_samples, which is what you get when each byte
+    /// independently has a 1 / mean chance of being sampled.
+    [[nodiscard]] inline size_t pick_next_sample_distance() OKAYLIB_NOEXCEPT
+    {
+        // xorshift64*
+        m_rng_state ^= m_rng_state >> 12;
+        m_rng_state ^= m_rng_state << 25;
+        m_rng_state ^= m_rng_state >> 27;
+        const uint64_t random = m_rng_state * 0x2545F4914F6CDD1DULL;
+
+        // top 53 bits as a double in (0, 1]
+        const double uniform = (double(random >> 11) + 1.0) * 0x1.0p-53;
+        const double distance =
+            -std::log(uniform) * double(m_mean_bytes_between_samples);
+        return size_t(distance) + 1;
+    }
+
+    allocator_t* m_backing;
+    arraylist_t<sample_t> m_live_samples;
+    // address of each live sample to its index in m_live_samples, so that
+    // frees do not have to search for it
+    hashmap_t<void*, size_t> m_sample_indices;
+    size_t m_mean_bytes_between_samples;
+    size_t m_bytes_until_next_sample = 0;
+    uint64_t m_rng_state;
+};
+
+} // namespace ok
+
+#endif
@@ -145,6 +145,19 @@ template <typename T, typename... pack>
     requires(stdc::is_same_v<T, pack> && ...)
 maybe_undefined_array_t(T, pack...)
     -> maybe_undefined_array_t<T, 1 + sizeof...(pack)>;
+
+template <typename T, size_t num_items>
+struct is_trivially_relocatable<array_t<T, num_items>>
+    : stdc::bool_constant<is_trivially_relocatable_v<T>>
+{};
+template <typename T, size_t num_items>
+struct is_trivially_relocatable<zeroed_array_t<T, num_items>>
+    : stdc::bool_constant<is_trivially_relocatable_v<T>>
+{};
+template <typename T, size_t num_items>
+struct is_trivially_relocatable<maybe_undefined_array_t<T, num_items>>
+    : stdc::bool_constant<is_trivially_relocatable_v<T>>
+{};
 } // namespace ok
 
 #if defined(OKAYLIB_USE_FMT)
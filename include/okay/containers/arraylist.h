@@ -3,6 +3,7 @@
 
 #include "okay/allocators/allocator.h"
 #include "okay/defer.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
 #include "okay/error.h"
 #include "okay/iterables/iterables.h"
 
@@ -13,14 +14,101 @@
 namespace ok {
 
 namespace arraylist {
+/// Growth policies decide how much capacity an arraylist_t asks for when it
+/// runs out. They are given the current capacity and the capacity that is
+/// needed (both in bytes), and return the capacity they would prefer, which
+/// must be at least the needed amount. Whatever the allocator actually returns
+/// becomes the capacity, so extra slack from the allocator is never wasted.
+namespace growth {
+/// 2x growth. The default: fewest reallocations for an append-heavy list.
+struct doubling_t
+{
+    [[nodiscard]] static constexpr size_t
+    preferred_capacity_bytes(size_t current_bytes,
+                             size_t required_bytes) noexcept
+    {
+        const size_t doubled = current_bytes > (~size_t(0) >> 1)
+                                   ? required_bytes
+                                   : current_bytes * 2;
+        return doubled > required_bytes ? doubled : required_bytes;
+    }
+};
+
+/// 1.5x growth. Wastes less memory on average, at the cost of more frequent
+/// reallocation.
+struct one_and_a_half_t
+{
+    [[nodiscard]] static constexpr size_t
+    preferred_capacity_bytes(size_t current_bytes,
+                             size_t required_bytes) noexcept
+    {
+        const size_t grown = current_bytes + (current_bytes / 2);
+        return grown > required_bytes ? grown : required_bytes;
+    }
+};
+
+/// Double until the capacity reaches threshold_bytes, then grow by a fixed
+/// linear_step_bytes at a time. Bounds the amount of unused capacity for very
+/// large lists.
+template <size_t threshold_bytes = size_t(16) * 1024 * 1024,
+          size_t linear_step_bytes = threshold_bytes>
+struct exponential_then_linear_t
+{
+    static_assert(linear_step_bytes > 0,
+                  "exponential_then_linear_t needs a nonzero linear step.");
+
+    [[nodiscard]] static constexpr size_t
+    preferred_capacity_bytes(size_t current_bytes,
+                             size_t required_bytes) noexcept
+    {
+        if (current_bytes < threshold_bytes) {
+            return doubling_t::preferred_capacity_bytes(current_bytes,
+                                                        required_bytes);
+        }
+        const size_t grown = current_bytes + linear_step_bytes;
+        return grown > required_bytes ? grown : required_bytes;
+    }
+};
+
+/// Use another policy, then round up to a multiple of the page size once the
+/// list is at least a page big. Page allocators hand out whole pages anyways,
+/// this just makes the arraylist ask for what it is going to get.
+template <typename base_policy_t = doubling_t, size_t page_size = 4096>
+struct page_rounded_t
+{
+    static_assert(page_size != 0 && (page_size & (page_size - 1)) == 0,
+                  "page_rounded_t page size must be a power of two.");
+
+    [[nodiscard]] static constexpr size_t
+    preferred_capacity_bytes(size_t current_bytes,
+                             size_t required_bytes) noexcept
+    {
+        const size_t preferred = base_policy_t::preferred_capacity_bytes(
+            current_bytes, required_bytes);
+        if (preferred < page_size)
+            return preferred;
+        return (preferred + page_size - 1) & ~(page_size - 1);
+    }
+};
+
+using default_t = doubling_t;
+} // namespace growth
+
 namespace detail {
-template <typename T> struct empty_t;
+template <typename T, typename growth_policy_t> struct empty_t;
 struct copy_items_from_iterator_t;
-template <typename T> struct spots_preallocated_t;
+template <typename T, typename growth_policy_t> struct spots_preallocated_t;
 } // namespace detail
 } // namespace arraylist
 
-template <typename T, allocator_c backing_allocator_t = ok::allocator_t>
+template <typename T>
+concept arraylist_growth_policy_c = requires(size_t bytes) {
+    { T::preferred_capacity_bytes(bytes, bytes) } -> same_as_c<size_t>;
+};
+
+template <typename T, allocator_c backing_allocator_t = ok::allocator_t,
+          arraylist_growth_policy_c growth_policy_t =
+              arraylist::growth::default_t>
 class arraylist_t
 {
     // arraylist is 32 bytes on the stack:
@@ -49,9 +137,9 @@ class arraylist_t
     {
     }
 
-    friend class arraylist::detail::spots_preallocated_t<T>;
-    friend class arraylist::detail::copy_items_from_iterator_t;
-    friend class arraylist::detail::empty_t<T>;
+    friend struct arraylist::detail::spots_preallocated_t<T, growth_policy_t>;
+    friend struct arraylist::detail::copy_items_from_iterator_t;
+    friend struct arraylist::detail::empty_t<T, growth_policy_t>;
 #if defined(OKAYLIB_USE_FMT)
     friend struct fmt::formatter<arraylist_t>;
 #endif
@@ -70,6 +158,7 @@ class arraylist_t
                   "const reference to the arraylist instead.");
 
     using value_type = T;
+    using growth_policy = growth_policy_t;
 
     [[nodiscard]] constexpr size_t size() const OKAYLIB_NOEXCEPT
     {
@@ -130,15 +219,14 @@ class arraylist_t
     [[nodiscard]] constexpr status<alloc::error>
     ensure_additional_capacity() OKAYLIB_NOEXCEPT
     {
-        if (this->capacity() == 0) {
-            auto status = this->make_first_allocation();
-            if (!status.is_success()) [[unlikely]] {
-                return status;
-            }
-        } else if (this->capacity() <= this->size()) {
-            // 2x growth rate
-            auto status =
-                this->reallocate(sizeof(T), this->capacity() * sizeof(T));
+        if (this->capacity() <= this->size()) {
+            // the first allocation makes room for a few items so that the
+            // first handful of appends don't each reallocate. the growth
+            // policy may still ask for more
+            constexpr size_t min_initial_capacity = 4;
+            auto status = this->grow_to_fit(this->capacity() == 0
+                                                ? min_initial_capacity
+                                                : this->size() + 1);
             if (!status.is_success()) [[unlikely]] {
                 return status;
             }
@@ -146,6 +234,21 @@ class arraylist_t
         return alloc::error::success;
     }
 
+    /// Make the capacity at least total_capacity items, asking the allocator
+    /// for exactly that much instead of growing according to the growth
+    /// policy. Does nothing if there is already enough capacity. For when the
+    /// final size of the list is known up front.
+    [[nodiscard]] constexpr status<alloc::error>
+    reserve_exact(size_t total_capacity) OKAYLIB_NOEXCEPT
+    {
+        if (total_capacity <= this->capacity())
+            return alloc::error::success;
+
+        if (this->capacity() == 0)
+            return make_first_allocation(total_capacity * sizeof(T));
+        return reallocate(total_capacity * sizeof(T), 0);
+    }
+
     /// Returns error describing any potential failure due to allocation, but
     /// just aborts if called with an out of bound index.
     template <typename... args_t>
@@ -174,8 +277,8 @@ class arraylist_t
 
         if (idx < this->size()) {
             // move all other items towards the back of the arraylist
-            if constexpr (stdc::is_trivially_copyable_v<T>) {
-                ::memmove(m.items + idx + 1, m.items + idx,
+            if constexpr (is_trivially_relocatable_v<T>) {
+                ::memmove((void*)(m.items + idx + 1), (void*)(m.items + idx),
                           (this->size() - idx) * sizeof(T));
             } else {
                 __ok_internal_assert(this->size() != 0);
@@ -220,8 +323,9 @@ class arraylist_t
                 // move all other items BACK to where they were before (this is
                 // supposed to be the cold path and it only invokes nonfailing
                 // operations so it should be fine to do this)
-                if constexpr (stdc::is_trivially_copyable_v<T>) {
-                    ::memmove(m.items + idx, m.items + idx + 1,
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    ::memmove((void*)(m.items + idx),
+                              (void*)(m.items + idx + 1),
                               (this->size() - idx) * sizeof(T));
                 } else {
                     // this accesses spots[i + 1] but that is initialized
@@ -254,11 +358,7 @@ class arraylist_t
             __ok_assert(false, "Attempt to increase capacity by 0.");
             return alloc::error::unsupported;
         }
-        if (this->capacity() == 0) {
-            return make_first_allocation(new_spots * sizeof(T));
-        } else {
-            return reallocate(new_spots * sizeof(T), 0);
-        }
+        return reserve_exact(this->capacity() + new_spots);
     }
 
     constexpr T remove(size_t idx) OKAYLIB_NOEXCEPT
@@ -282,14 +382,19 @@ class arraylist_t
             return out;
         }
 
-        if constexpr (stdc::is_trivially_copyable_v<T>) {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            // `removed` is in a moved-from state, finish it off before its
+            // bytes get written over
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                removed.~T();
+            }
             const size_t idxplusone = idx + 1;
-            ::memmove(m.items + idx, m.items + idxplusone,
+            ::memmove((void*)(m.items + idx), (void*)(m.items + idxplusone),
                       (this->size() - idxplusone) * sizeof(T));
         } else {
-            for (size_t i = this->size() - 1; i > idx; --i) {
-                T& source = m.items[i];
-                T& target = m.items[i - 1];
+            for (size_t i = idx; i < this->size() - 1; ++i) {
+                T& source = m.items[i + 1];
+                T& target = m.items[i];
                 target = stdc::move(source);
             }
 
@@ -311,7 +416,7 @@ class arraylist_t
         // moved out at index
         T out(stdc::move(target));
 
-        defer decrement([this, target] { --m.size; });
+        defer decrement([this] { --m.size; });
 
         if (idx == this->size() - 1) {
             if constexpr (!stdc::is_trivially_destructible_v<T>) {
@@ -322,6 +427,15 @@ class arraylist_t
 
         T& last = m.items[this->size() - 1];
 
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                target.~T();
+            }
+            ::memcpy((void*)ok::addressof(target), (void*)ok::addressof(last),
+                     sizeof(T));
+            return out;
+        }
+
         target = stdc::move(last);
 
         if constexpr (!stdc::is_trivially_destructible_v<T>) {
@@ -468,8 +582,7 @@ class arraylist_t
         } else {
             // growing amount
             if (capacity() < new_size) {
-                status<alloc::error> status =
-                    reallocate((new_size - capacity()) * sizeof(T), 0);
+                status<alloc::error> status = reserve_exact(new_size);
 
                 if (!status.is_success())
                     return status;
@@ -499,6 +612,25 @@ class arraylist_t
         return alloc::error::success;
     }
 
+    /// Like resize(), but new items are left uninitialized instead of being
+    /// zeroed, for when they are about to be overwritten anyways (for example
+    /// by a decoder writing into items()). Only available for types with no
+    /// constructor or destructor to skip.
+    [[nodiscard]] constexpr status<alloc::error>
+    resize_uninitialized(size_t new_size) OKAYLIB_NOEXCEPT
+        requires(stdc::is_trivially_default_constructible_v<T> &&
+                 stdc::is_trivially_destructible_v<T>)
+    {
+        if (new_size > this->capacity()) {
+            auto status = this->reserve_exact(new_size);
+            if (!status.is_success()) [[unlikely]] {
+                return status;
+            }
+        }
+        m.size = new_size;
+        return alloc::error::success;
+    }
+
     /// the old shrink and leak. the shrinky leaky
     [[nodiscard]] constexpr slice<T> shrink_and_leak() OKAYLIB_NOEXCEPT
     {
@@ -526,6 +658,63 @@ class arraylist_t
         return insert_at(this->size(), stdc::forward<args_t>(args)...);
     }
 
+    /// Append an item without checking whether there is room for it, for when
+    /// capacity was already ensured with ensure_additional_capacity() or
+    /// increase_capacity_by_at_least(). Running out of capacity is a usage
+    /// error.
+    template <typename... args_t>
+        requires is_infallible_constructible_c<T, args_t...>
+    constexpr T& append_assume_capacity(args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        __ok_usage_error(this->capacity() > this->size(),
+                         "Attempt to append_assume_capacity() to a full "
+                         "arraylist_t.");
+        T& uninit = m.items[m.size];
+        ok::make_into_uninitialized<T>(uninit, stdc::forward<args_t>(args)...);
+        ++m.size;
+        return uninit;
+    }
+
+    /// Copy all of the given items onto the end of the arraylist, with only
+    /// one capacity check. Trivially copyable items are copied with a single
+    /// memcpy. The slice is allowed to point into this arraylist.
+    [[nodiscard]] constexpr status<alloc::error>
+    append_slice(slice<const T> items) OKAYLIB_NOEXCEPT
+        requires stdc::is_copy_constructible_v<T>
+    {
+        if (items.is_empty())
+            return alloc::error::success;
+
+        const T* source = items.unchecked_address_of_first_item();
+        const size_t count = items.size();
+
+        // if the items are our own, they may get moved by reallocation
+        const bool is_own_items =
+            m.items && source >= m.items && source < m.items + m.size;
+        const size_t own_offset = is_own_items ? size_t(source - m.items) : 0;
+
+        {
+            auto status = this->ensure_capacity_for_additional(count);
+            if (!status.is_success()) [[unlikely]] {
+                return status;
+            }
+        }
+
+        if (is_own_items)
+            source = m.items + own_offset;
+
+        if constexpr (stdc::is_trivially_copyable_v<T>) {
+            ::memcpy((void*)(m.items + m.size), (const void*)source,
+                     count * sizeof(T));
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                stdc::construct_at(m.items + m.size + i, source[i]);
+            }
+        }
+        m.size += count;
+        return alloc::error::success;
+    }
+
     /// Returns an error only if allocation to expand space for the new items
     /// errored.
     template <iterator_c iterator_t>
@@ -544,53 +733,98 @@ class arraylist_t
 
         if constexpr (detail::sized_iterator_c<iterator_t>) {
             const size_t size = ok::size(iterator);
-
-            // TODO: make a new function like ensure_additional_capacity(size)
-            // and use it here
-            const size_t extra_space = this->capacity() - this->size();
-            if (size > extra_space) {
-                auto status =
-                    this->increase_capacity_by_at_least(size - extra_space);
+            {
+                auto status = this->ensure_capacity_for_additional(size);
                 if (!status.is_success()) [[unlikely]] {
                     return status;
                 }
             }
-        }
 
-        while (true) {
-            auto&& value = iterator.next();
-            if (!value)
-                break; // out of items in the iterator
+            const size_t expected_size = this->size() + size;
+            while (true) {
+                auto&& value = iterator.next();
+                if (!value)
+                    break; // out of items in the iterator
+
+                if (this->size() == expected_size) [[unlikely]] {
+                    __ok_usage_error(false,
+                                     "Attempt to append an iterator which "
+                                     "incorrectly reported its size.");
+                    break;
+                }
 
-            auto status = [&] {
                 if constexpr (stdc::is_lvalue_reference_v<
                                   value_type_for<iterator_t>>) {
-                    return this->append(value.ref_unchecked());
+                    this->append_assume_capacity(value.ref_unchecked());
                 } else {
-                    return this->append(stdc::move(value.ref_unchecked()));
+                    this->append_assume_capacity(
+                        stdc::move(value.ref_unchecked()));
                 }
-            }();
+            }
+            return alloc::error::success;
+        } else {
+            while (true) {
+                auto&& value = iterator.next();
+                if (!value)
+                    break; // out of items in the iterator
+
+                auto status = [&] {
+                    if constexpr (stdc::is_lvalue_reference_v<
+                                      value_type_for<iterator_t>>) {
+                        return this->append(value.ref_unchecked());
+                    } else {
+                        return this->append(
+                            stdc::move(value.ref_unchecked()));
+                    }
+                }();
 
-            // TODO: implement append_assume_capacity() and use it if we already
-            // did ensure_additional_capacity
-            if constexpr (!detail::sized_iterator_c<iterator_t>) {
                 if (!status.is_success()) [[unlikely]]
                     return status;
-            } else {
-                // if you manage to make this happen, congrats honestly
-                __ok_assert(ok::is_success(status),
-                            "Attempt to append an iterator which incorrectly "
-                            "gave its size and then caused OOM");
             }
+            return alloc::error::success;
         }
-        return alloc::error::success;
     }
 
     constexpr ~arraylist_t() { destroy(); }
 
   private:
+    /// Make sure there is space for count more items. Grows according to the
+    /// growth policy so that repeatedly appending small slices is still
+    /// amortized.
     [[nodiscard]] constexpr status<alloc::error>
-    make_first_allocation(size_t initial_bytes = sizeof(T) * 4)
+    ensure_capacity_for_additional(size_t count) OKAYLIB_NOEXCEPT
+    {
+        const size_t extra_space = this->capacity() - this->size();
+        if (count <= extra_space) [[likely]]
+            return alloc::error::success;
+
+        return this->grow_to_fit(this->size() + count);
+    }
+
+    /// Reallocate so that there is room for required_capacity items, asking
+    /// for as much more as the growth policy wants.
+    [[nodiscard]] constexpr status<alloc::error>
+    grow_to_fit(size_t required_capacity) OKAYLIB_NOEXCEPT
+    {
+        __ok_internal_assert(required_capacity > this->capacity());
+        const size_t required_bytes = required_capacity * sizeof(T);
+        const size_t preferred_bytes =
+            growth_policy_t::preferred_capacity_bytes(
+                this->capacity() * sizeof(T), required_bytes);
+        __ok_assert(preferred_bytes >= required_bytes,
+                    "arraylist_t growth policy returned less capacity than "
+                    "was required.");
+
+        if (this->capacity() == 0)
+            return make_first_allocation(preferred_bytes);
+        // allocators want no preference rather than an equal one
+        return reallocate(required_bytes, preferred_bytes == required_bytes
+                                              ? 0
+                                              : preferred_bytes);
+    }
+
+    [[nodiscard]] constexpr status<alloc::error>
+    make_first_allocation(size_t initial_bytes)
     {
         alloc::result_t<bytes_t> res =
             m.backing_allocator->allocate(alloc::request_t{
@@ -611,16 +845,17 @@ class arraylist_t
         return alloc::error::success;
     }
 
-    /// "spots" is the currently allocated spots, including uninitialized
-    /// capacity. it is modified by this function
+    /// Change the capacity to at least required_bytes, or preferably
+    /// preferred_bytes (zero if there is no preference). Capacity is set from
+    /// whatever the allocator actually returned.
     [[nodiscard]] constexpr status<alloc::error>
     reallocate(size_t required_bytes, size_t preferred_bytes)
     {
         using namespace alloc;
         const auto realloc_flags = realloc_flags::leave_nonzeroed;
 
-        if constexpr (!stdc::is_trivially_copyable_v<T>) {
-            // if we're not trivially copyable, dont let the allocator do
+        if constexpr (!is_trivially_relocatable_v<T>) {
+            // if we're not trivially relocatable, dont let the allocator do
             // the memcpying, we will do it ourselves after
             result_t<potentially_in_place_reallocation_t> res =
                 reallocate_in_place_orelse_keep_old_nocopy(
@@ -628,10 +863,8 @@ class arraylist_t
                     reallocate_request_t{
                         .memory = reinterpret_as_bytes(
                             raw_slice(*m.items, this->capacity())),
-                        .new_size_bytes =
-                            this->items().size_bytes() + required_bytes,
-                        .preferred_size_bytes =
-                            this->items().size_bytes() + preferred_bytes,
+                        .new_size_bytes = required_bytes,
+                        .preferred_size_bytes = preferred_bytes,
                         .flags =
                             realloc_flags | realloc_flags::in_place_orelse_fail,
                     });
@@ -677,15 +910,12 @@ class arraylist_t
             }
             return alloc::error::success;
         } else {
-            const size_t capacity_bytes = this->capacity() * sizeof(T);
             result_t<bytes_t> res =
                 m.backing_allocator->reallocate(reallocate_request_t{
                     .memory = reinterpret_as_bytes(
                         raw_slice(*m.items, this->capacity())),
-                    .new_size_bytes = capacity_bytes + required_bytes,
-                    .preferred_size_bytes =
-                        preferred_bytes == 0 ? 0
-                                             : capacity_bytes + preferred_bytes,
+                    .new_size_bytes = required_bytes,
+                    .preferred_size_bytes = preferred_bytes,
                     .flags = realloc_flags,
                 });
 
@@ -732,20 +962,22 @@ class arraylist_t
 namespace arraylist {
 
 namespace detail {
-template <typename T> struct empty_t
+template <typename T, typename growth_policy_t> struct empty_t
 {
     static constexpr auto implemented_make_function =
         ok::implemented_make_function::make;
 
     template <typename backing_allocator_arg_t>
     using associated_type =
-        arraylist_t<T, stdc::remove_cvref_t<backing_allocator_arg_t>>;
+        arraylist_t<T, stdc::remove_cvref_t<backing_allocator_arg_t>,
+                    growth_policy_t>;
 
     template <allocator_c backing_allocator_t>
-    [[nodiscard]] constexpr arraylist_t<T, backing_allocator_t>
+    [[nodiscard]] constexpr arraylist_t<T, backing_allocator_t, growth_policy_t>
     operator()(backing_allocator_t& allocator) const noexcept
     {
-        return typename arraylist_t<T, backing_allocator_t>::members_t{
+        return typename arraylist_t<T, backing_allocator_t,
+                                    growth_policy_t>::members_t{
             .items = nullptr,
             .capacity = 0,
             .size = 0,
@@ -754,14 +986,15 @@ template <typename T> struct empty_t
     }
 };
 
-template <typename T> struct spots_preallocated_t
+template <typename T, typename growth_policy_t> struct spots_preallocated_t
 {
     static constexpr auto implemented_make_function =
         ok::implemented_make_function::make_into_uninit;
 
     template <typename backing_allocator_t, typename...>
     using associated_type =
-        ok::arraylist_t<T, ok::remove_cvref_t<backing_allocator_t>>;
+        ok::arraylist_t<T, ok::remove_cvref_t<backing_allocator_t>,
+                        growth_policy_t>;
 
     template <typename backing_allocator_t>
     [[nodiscard]] constexpr auto
@@ -773,11 +1006,12 @@ template <typename T> struct spots_preallocated_t
 
     template <typename backing_allocator_t>
     [[nodiscard]] constexpr alloc::error
-    make_into_uninit(arraylist_t<T, backing_allocator_t>& output,
-                     backing_allocator_t& allocator,
-                     size_t num_spots_preallocated) const OKAYLIB_NOEXCEPT
+    make_into_uninit(
+        arraylist_t<T, backing_allocator_t, growth_policy_t>& output,
+        backing_allocator_t& allocator,
+        size_t num_spots_preallocated) const OKAYLIB_NOEXCEPT
     {
-        using output_t = arraylist_t<T, backing_allocator_t>;
+        using output_t = arraylist_t<T, backing_allocator_t, growth_policy_t>;
         auto res = allocator.allocate(alloc::request_t{
             .num_bytes = sizeof(T) * num_spots_preallocated,
             .alignment = alignof(T),
@@ -881,20 +1115,31 @@ struct copy_items_from_iterator_t
 
 } // namespace detail
 
-template <typename T> inline constexpr detail::empty_t<T> empty;
+template <typename T,
+          arraylist_growth_policy_c growth_policy_t = growth::default_t>
+inline constexpr detail::empty_t<T, growth_policy_t> empty;
 
-template <typename T>
-inline constexpr detail::spots_preallocated_t<T> spots_preallocated;
+template <typename T,
+          arraylist_growth_policy_c growth_policy_t = growth::default_t>
+inline constexpr detail::spots_preallocated_t<T, growth_policy_t>
+    spots_preallocated;
 
 inline constexpr detail::copy_items_from_iterator_t copy_items_from_iterator;
 }; // namespace arraylist
+
+template <typename T, typename backing_allocator_t, typename growth_policy_t>
+struct is_trivially_relocatable<
+    arraylist_t<T, backing_allocator_t, growth_policy_t>>
+    : stdc::true_type
+{};
 } // namespace ok
 
 #if defined(OKAYLIB_USE_FMT)
-template <typename T, typename backing_allocator_t>
-struct fmt::formatter<ok::arraylist_t<T, backing_allocator_t>>
+template <typename T, typename backing_allocator_t, typename growth_policy_t>
+struct fmt::formatter<ok::arraylist_t<T, backing_allocator_t, growth_policy_t>>
 {
-    using formatted_type_t = ok::arraylist_t<T, backing_allocator_t>;
+    using formatted_type_t =
+        ok::arraylist_t<T, backing_allocator_t, growth_policy_t>;
     static_assert(
         fmt::is_formattable<T>::value,
         "Attempt to format an arraylist whose items are not formattable.");
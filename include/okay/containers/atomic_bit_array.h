@@ -0,0 +1,358 @@
+#ifndef __OKAYLIB_CONTAINERS_ATOMIC_BIT_ARRAY_H__
+#define __OKAYLIB_CONTAINERS_ATOMIC_BIT_ARRAY_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/error.h"
+#include "okay/math/math.h"
+#include "okay/math/rounding.h"
+#include "okay/opt.h"
+#include "okay/platform/atomic.h"
+
+namespace ok {
+
+namespace allocated_atomic_bit_array::detail {
+struct zeroed_t;
+}
+
+namespace detail {
+/// The operations shared by the fixed size and allocated atomic bit arrays.
+/// derived_t provides words() and size_bits(). Every bit past size_bits() in
+/// the last word is kept off.
+template <typename derived_t> class atomic_bit_array_common_t
+{
+    using word_t = ok::atomic_t<uint64_t>;
+
+    [[nodiscard]] constexpr word_t* words() const noexcept
+    {
+        return static_cast<const derived_t*>(this)->words();
+    }
+
+    [[nodiscard]] constexpr size_t num_bits() const noexcept
+    {
+        return static_cast<const derived_t*>(this)->size_bits();
+    }
+
+    /// The bits of a word which are inside the array.
+    [[nodiscard]] constexpr uint64_t
+    valid_mask(size_t word_index) const noexcept
+    {
+        const size_t bits_in_last_word = this->num_bits() % 64;
+        if (word_index + 1 == this->size_words() && bits_in_last_word != 0)
+            return (uint64_t(1) << bits_in_last_word) - 1;
+        return ~uint64_t(0);
+    }
+
+    constexpr void check_bit_index(size_t idx) const OKAYLIB_NOEXCEPT
+    {
+        if (idx >= this->num_bits()) [[unlikely]] {
+            __ok_abort("Out of bounds access to atomic bit array.");
+        }
+    }
+
+    constexpr void check_word_index(size_t word_index) const OKAYLIB_NOEXCEPT
+    {
+        if (word_index >= this->size_words()) [[unlikely]] {
+            __ok_abort("Out of bounds word access to atomic bit array.");
+        }
+    }
+
+  public:
+    [[nodiscard]] constexpr size_t size_words() const noexcept
+    {
+        return round_up_to_multiple_of<64>(this->num_bits()) / 64;
+    }
+
+    [[nodiscard]] constexpr bool
+    test(size_t idx,
+         memory_order order = memory_order::seq_cst) const OKAYLIB_NOEXCEPT
+    {
+        this->check_bit_index(idx);
+        return (this->words()[idx / 64].load(order) >> (idx % 64)) & 1;
+    }
+
+    /// Turn a bit on, returning whether it was already on. Exactly one of any
+    /// number of threads setting the same bit at once sees false.
+    constexpr bool
+    test_and_set(size_t idx,
+                 memory_order order = memory_order::seq_cst) OKAYLIB_NOEXCEPT
+    {
+        this->check_bit_index(idx);
+        const uint64_t bit = uint64_t(1) << (idx % 64);
+        return this->words()[idx / 64].fetch_or(bit, order) & bit;
+    }
+
+    /// Turn a bit off, returning whether it was on.
+    constexpr bool
+    test_and_clear(size_t idx,
+                   memory_order order = memory_order::seq_cst) OKAYLIB_NOEXCEPT
+    {
+        this->check_bit_index(idx);
+        const uint64_t bit = uint64_t(1) << (idx % 64);
+        return this->words()[idx / 64].fetch_and(~bit, order) & bit;
+    }
+
+    /// Load the 64 bits starting at bit word_index * 64.
+    [[nodiscard]] constexpr uint64_t
+    load_word(size_t word_index,
+              memory_order order = memory_order::seq_cst) const OKAYLIB_NOEXCEPT
+    {
+        this->check_word_index(word_index);
+        return this->words()[word_index].load(order);
+    }
+
+    /// Turn on many bits of one word in a single atomic operation, returning
+    /// the word from before. Bits past the end of the array are ignored.
+    constexpr uint64_t
+    fetch_or_word(size_t word_index, uint64_t bits,
+                  memory_order order = memory_order::seq_cst) OKAYLIB_NOEXCEPT
+    {
+        this->check_word_index(word_index);
+        return this->words()[word_index].fetch_or(
+            bits & this->valid_mask(word_index), order);
+    }
+
+    /// Keep only the given bits of one word on, in a single atomic operation,
+    /// returning the word from before.
+    constexpr uint64_t
+    fetch_and_word(size_t word_index, uint64_t bits,
+                   memory_order order = memory_order::seq_cst) OKAYLIB_NOEXCEPT
+    {
+        this->check_word_index(word_index);
+        return this->words()[word_index].fetch_and(bits, order);
+    }
+
+    /// Find a bit which is off and turn it on, for handing out slots. Looks
+    /// from start_hint to the end and then wraps around, so threads can start
+    /// at different places to avoid fighting over the same words. Lock free:
+    /// if another thread claims a bit first, this just moves on to the next
+    /// one. Returns null only if every bit was seen to be on.
+    [[nodiscard]] constexpr opt<size_t> find_and_claim_first_unset(
+        size_t start_hint = 0,
+        memory_order order = memory_order::seq_cst) OKAYLIB_NOEXCEPT
+    {
+        const size_t num_words = this->size_words();
+        if (num_words == 0)
+            return nullopt;
+        if (start_hint >= this->num_bits()) [[unlikely]] {
+            __ok_abort("Hint passed to find_and_claim_first_unset() is out of "
+                       "bounds of the atomic bit array.");
+        }
+
+        word_t* const words = this->words();
+        size_t word_index = start_hint / 64;
+        // the first word is visited twice: from the hint onwards, then all of
+        // it after wrapping around
+        for (size_t visited = 0; visited <= num_words; ++visited) {
+            uint64_t unavailable = ~this->valid_mask(word_index);
+            if (visited == 0)
+                unavailable |= (uint64_t(1) << (start_hint % 64)) - 1;
+
+            uint64_t word =
+                words[word_index].load(memory_order::relaxed) | unavailable;
+            while (word != ~uint64_t(0)) {
+                const uint64_t bit = uint64_t(1)
+                                     << ok::count_trailing_zeros(~word);
+                const uint64_t before = words[word_index].fetch_or(bit, order);
+                if (!(before & bit))
+                    return word_index * 64 + ok::count_trailing_zeros(bit);
+                // someone else got there first. try what is left of the word
+                word = before | unavailable;
+            }
+
+            if (++word_index == num_words)
+                word_index = 0;
+        }
+        return nullopt;
+    }
+
+    /// The number of bits which are on. Only exact if nothing is changing the
+    /// bits at the same time.
+    [[nodiscard]] constexpr size_t
+    count(memory_order order = memory_order::relaxed) const OKAYLIB_NOEXCEPT
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < this->size_words(); ++i)
+            total += ok::popcount(this->words()[i].load(order));
+        return total;
+    }
+
+    /// Turn every bit off, one word at a time.
+    constexpr void
+    clear_all(memory_order order = memory_order::seq_cst) OKAYLIB_NOEXCEPT
+    {
+        for (size_t i = 0; i < this->size_words(); ++i)
+            this->words()[i].store(0, order);
+    }
+};
+} // namespace detail
+
+/// A fixed size array of bits which any number of threads can set, clear and
+/// test at once, for things like visited flags in a parallel traversal. Starts
+/// with every bit off. Bits live in 64 bit atomic words, so threads working on
+/// bits far apart do not contend.
+template <size_t num_bits>
+class atomic_bit_array_t
+    : public detail::atomic_bit_array_common_t<atomic_bit_array_t<num_bits>>
+{
+    static_assert(num_bits != 0,
+                  "Cannot create an atomic_bit_array of zero bits");
+    friend class detail::atomic_bit_array_common_t<atomic_bit_array_t>;
+
+    // atomic_t's default constructor zeroes it
+    mutable ok::atomic_t<uint64_t> m_words[round_up_to_multiple_of<64>(
+                                               num_bits) /
+                                           64];
+
+    [[nodiscard]] constexpr ok::atomic_t<uint64_t>* words() const noexcept
+    {
+        return m_words;
+    }
+
+  public:
+    constexpr atomic_bit_array_t() = default;
+
+    atomic_bit_array_t(const atomic_bit_array_t&) = delete;
+    atomic_bit_array_t& operator=(const atomic_bit_array_t&) = delete;
+    atomic_bit_array_t(atomic_bit_array_t&&) = delete;
+    atomic_bit_array_t& operator=(atomic_bit_array_t&&) = delete;
+
+    [[nodiscard]] constexpr size_t size_bits() const noexcept
+    {
+        return num_bits;
+    }
+};
+
+/// The same as atomic_bit_array_t, but with a size chosen at runtime and the
+/// words coming from an allocator. Moving or destroying it must not happen
+/// while other threads are using it.
+template <allocator_c backing_allocator_t = ok::allocator_t>
+class allocated_atomic_bit_array_t
+    : public detail::atomic_bit_array_common_t<
+          allocated_atomic_bit_array_t<backing_allocator_t>>
+{
+    friend class detail::atomic_bit_array_common_t<
+        allocated_atomic_bit_array_t>;
+    friend struct allocated_atomic_bit_array::detail::zeroed_t;
+
+    struct members_t
+    {
+        ok::atomic_t<uint64_t>* words;
+        size_t num_bits;
+        backing_allocator_t* allocator;
+    } m;
+
+    [[nodiscard]] constexpr ok::atomic_t<uint64_t>* words() const noexcept
+    {
+        return m.words;
+    }
+
+  public:
+    [[nodiscard]] constexpr size_t size_bits() const noexcept
+    {
+        return m.num_bits;
+    }
+
+    constexpr allocated_atomic_bit_array_t(
+        allocated_atomic_bit_array_t&& other) noexcept
+        : m(other.m)
+    {
+        other.m.words = nullptr;
+        other.m.num_bits = 0;
+    }
+
+    constexpr allocated_atomic_bit_array_t&
+    operator=(allocated_atomic_bit_array_t&& other) noexcept
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = other.m;
+        other.m.words = nullptr;
+        other.m.num_bits = 0;
+        return *this;
+    }
+
+    allocated_atomic_bit_array_t(const allocated_atomic_bit_array_t&) = delete;
+    allocated_atomic_bit_array_t&
+    operator=(const allocated_atomic_bit_array_t&) = delete;
+
+    constexpr ~allocated_atomic_bit_array_t() { destroy(); }
+
+  private:
+    constexpr void destroy() noexcept
+    {
+        if (m.words)
+            m.allocator->deallocate(m.words);
+    }
+
+  public:
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    constexpr allocated_atomic_bit_array_t(members_t&& members) noexcept
+        : m(stdc::forward<members_t>(members))
+    {
+    }
+};
+
+namespace allocated_atomic_bit_array {
+namespace detail {
+struct zeroed_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type = ok::allocated_atomic_bit_array_t<
+        ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               size_t num_bits) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, num_bits);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::allocated_atomic_bit_array_t<backing_allocator_t>&
+                         output,
+                     backing_allocator_t& allocator,
+                     size_t num_bits) const OKAYLIB_NOEXCEPT
+    {
+        using output_t = ok::allocated_atomic_bit_array_t<backing_allocator_t>;
+        using word_t = ok::atomic_t<uint64_t>;
+        const size_t num_words = round_up_to_multiple_of<64>(num_bits) / 64;
+
+        word_t* words = nullptr;
+        if (num_words != 0) {
+            auto res = allocator.allocate(alloc::request_t{
+                .num_bytes = num_words * sizeof(word_t),
+                .alignment = alignof(word_t),
+                .leave_nonzeroed = true,
+            });
+            if (!res.is_success()) [[unlikely]]
+                return res.status();
+            words = reinterpret_cast<word_t*>(
+                res.unwrap().unchecked_address_of_first_item());
+            for (size_t i = 0; i < num_words; ++i)
+                stdc::construct_at(words + i);
+        }
+
+        stdc::construct_at(ok::addressof(output),
+                           typename output_t::members_t{
+                               .words = words,
+                               .num_bits = num_bits,
+                               .allocator = ok::addressof(allocator),
+                           });
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Allocate an atomic bit array of num_bits bits, all off.
+inline constexpr detail::zeroed_t zeroed;
+} // namespace allocated_atomic_bit_array
+} // namespace ok
+
+#endif
@@ -185,6 +185,31 @@ template <size_t num_bits> class bit_array_t
         return items().get_bit(idx);
     }
 
+    [[nodiscard]] constexpr size_t popcount() const OKAYLIB_NOEXCEPT
+    {
+        return items().popcount();
+    }
+
+    [[nodiscard]] constexpr opt<size_t>
+    find_first_set(size_t from = 0) const OKAYLIB_NOEXCEPT
+    {
+        return items().find_first_set(from);
+    }
+
+    [[nodiscard]] constexpr opt<size_t>
+    find_first_unset(size_t from = 0) const OKAYLIB_NOEXCEPT
+    {
+        return items().find_first_unset(from);
+    }
+
+    /// Iterate over the indices of the bits which are on. See
+    /// const_bit_slice_t::iter_set_bits().
+    [[nodiscard]] constexpr auto iter_set_bits() const& OKAYLIB_NOEXCEPT
+    {
+        return items().iter_set_bits();
+    }
+    constexpr auto iter_set_bits() const&& = delete;
+
     friend constexpr bool operator==(const bit_array_t& lhs,
                                      const bit_array_t& rhs)
     {
@@ -2,9 +2,16 @@
 #define __OKAYLIB_CONTAINERS_DYNAMIC_BITSET_H__
 
 #include "okay/allocators/allocator.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
 #include "okay/iterables/iterables.h"
 #include "okay/stdmem.h"
 
+// bits are stored in 64 bit words but viewed as bytes by bit slices, which
+// only agree on the order of the bits on little endian targets
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "okay/containers/bit_arraylist.h requires a little endian target"
+#endif
+
 namespace ok {
 namespace bit_arraylist {
 struct upcast_tag
@@ -21,10 +28,29 @@ class bit_arraylist_t
     struct members_t
     {
         size_t num_bits;
+        // a whole number of 64 bit words, aligned to 8 bytes. every bit at or
+        // past num_bits is kept zero, so word-wide operations never need to
+        // mask off the unused part of the last word before reading it
         bytes_t allocation;
         backing_allocator_t* allocator;
     } m;
 
+    [[nodiscard]] constexpr uint64_t* words() const OKAYLIB_NOEXCEPT
+    {
+        return reinterpret_cast<uint64_t*>(
+            m.allocation.unchecked_address_of_first_item());
+    }
+
+    [[nodiscard]] constexpr size_t size_words() const OKAYLIB_NOEXCEPT
+    {
+        return round_up_to_multiple_of<64>(m.num_bits) / 64;
+    }
+
+    [[nodiscard]] constexpr size_t capacity_words() const OKAYLIB_NOEXCEPT
+    {
+        return m.allocation.size() / 8;
+    }
+
     constexpr void destroy() OKAYLIB_NOEXCEPT
     {
         if (m.allocation.size() != 0) {
@@ -124,11 +150,17 @@ class bit_arraylist_t
 
     constexpr void set_all_bits(ok::bit value) OKAYLIB_NOEXCEPT
     {
-        if (m.allocation.size() == 0) [[unlikely]] {
+        if (this->is_empty()) [[unlikely]] {
             return;
         }
-        ::memset(m.allocation.unchecked_address_of_first_item(),
-                 value ? char(-1) : char(0), this->size_bytes());
+        uint64_t* const words = this->words();
+        const size_t num_words = this->size_words();
+        const uint64_t fill = value ? ~uint64_t(0) : uint64_t(0);
+        for (size_t i = 0; i < num_words; ++i)
+            words[i] = fill;
+        // keep the bits past the end zeroed
+        if (const size_t used = m.num_bits % 64; used != 0)
+            words[num_words - 1] &= (uint64_t(1) << used) - 1;
     }
 
     [[nodiscard]] constexpr size_t size_bytes() const OKAYLIB_NOEXCEPT
@@ -151,6 +183,31 @@ class bit_arraylist_t
         return items().get_bit(idx);
     }
 
+    [[nodiscard]] constexpr size_t popcount() const OKAYLIB_NOEXCEPT
+    {
+        return items().popcount();
+    }
+
+    [[nodiscard]] constexpr opt<size_t>
+    find_first_set(size_t from = 0) const OKAYLIB_NOEXCEPT
+    {
+        return items().find_first_set(from);
+    }
+
+    [[nodiscard]] constexpr opt<size_t>
+    find_first_unset(size_t from = 0) const OKAYLIB_NOEXCEPT
+    {
+        return items().find_first_unset(from);
+    }
+
+    /// Iterate over the indices of the bits which are on. See
+    /// const_bit_slice_t::iter_set_bits().
+    [[nodiscard]] constexpr auto iter_set_bits() const& OKAYLIB_NOEXCEPT
+    {
+        return items().iter_set_bits();
+    }
+    constexpr auto iter_set_bits() const&& = delete;
+
     constexpr void toggle_bit(size_t idx) OKAYLIB_NOEXCEPT
     {
         items().toggle_bit(idx);
@@ -178,19 +235,10 @@ class bit_arraylist_t
     [[nodiscard]] constexpr status<alloc::error>
     ensure_additional_capacity() OKAYLIB_NOEXCEPT
     {
-        if (m.allocation.size() == 0) {
-            auto status = this->first_allocation();
-            if (!status.is_success()) [[unlikely]] {
-                return status;
-            }
-        } else if (this->size_bytes() == this->capacity_bytes()) {
-            auto status = reallocate(1, m.allocation.size() * 2);
-            if (!status.is_success()) [[unlikely]] {
-                return status;
-            }
-        }
-        __ok_internal_assert(this->size_bytes() < this->capacity_bytes());
-        return alloc::error::success;
+        auto status = this->ensure_capacity_for(m.num_bits + 1);
+        __ok_internal_assert(!status.is_success() ||
+                             this->size_bits() < this->capacity_bits());
+        return status;
     }
 
     [[nodiscard]] constexpr status<alloc::error>
@@ -199,75 +247,77 @@ class bit_arraylist_t
         if (idx > this->size_bits()) [[unlikely]] {
             __ok_abort("insert_at into bit_arraylist out of bounds");
         }
-        __ok_internal_assert(this->capacity_bytes() >= this->size_bytes());
         if (auto status = this->ensure_additional_capacity();
             !status.is_success()) [[unlikely]] {
             return status;
         }
-        constexpr uint8_t carry_in_mask = 0b001;
-        constexpr uint8_t carry_check_mask = 0b10000000;
-
-        constexpr auto shift_byte_zero_return_carry =
-            [](uint8_t* byte, size_t bit_index, ok::bit bit) -> bool {
-            __ok_internal_assert(bit_index < 8);
-
-            // mask of the bits that should be shifted
-            const uint8_t shift_mask = uint8_t(-1) << bit_index;
-            const bool carry = (*byte & carry_check_mask) != 0;
-            const uint8_t shifted = (*byte & shift_mask) << 1;
-
-            // zero stuff that was shifted, so only unmoved stuff is left in the
-            // bit
-            *byte &= ~shift_mask;
-            // insert the shifted stuff
-            *byte |= shifted;
-            // insert the byte we're setting. if (!bit_is_on), this does nothing
-            *byte |= (bit ? uint8_t(1) : uint8_t(0)) << bit_index;
-
-            return carry;
-        };
 
-        const size_t first_byte_index = idx / 8;
-        const size_t sub_byte_bit_index = idx % 8;
+        uint64_t* const words = this->words();
+        const size_t word_index = idx / 64;
+        const uint64_t unmoved_mask = (uint64_t(1) << (idx % 64)) - 1;
+        const uint64_t first = words[word_index];
+
+        // shift every word after the insertion point up by one, carrying in the
+        // top bit of the word below it. each word only reads the one below,
+        // which has not been written yet, so this vectorizes
+        const size_t last_word = m.num_bits / 64;
+        for (size_t i = last_word; i > word_index; --i)
+            words[i] = (words[i] << 1) | (words[i - 1] >> 63);
+
+        words[word_index] = (first & unmoved_mask) |
+                            ((first & ~unmoved_mask) << 1) |
+                            ((value ? uint64_t(1) : uint64_t(0)) << (idx % 64));
+        ++m.num_bits;
 
-        bool carry = shift_byte_zero_return_carry(
-            m.allocation.unchecked_address_of_first_item() + first_byte_index,
-            sub_byte_bit_index, value);
+        return alloc::error::success;
+    }
 
-        // loop from zero to the number of bytes in use, shifting everything up
-        // TODO: check if this gets optimized, maybe a good idea for
-        // dynamic bit_array to use u64 internally
+    [[nodiscard]] constexpr status<alloc::error>
+    append(bool value) OKAYLIB_NOEXCEPT
+    {
+        return this->insert_at(this->size_bits(), ok::bit(value));
+    }
 
-        const size_t num_bytes =
-            round_up_to_multiple_of<8>(m.num_bits - idx) / 8;
+    /// Append all of the bits in a bit slice, a word at a time. The slice is
+    /// allowed to point into this arraylist.
+    [[nodiscard]] constexpr status<alloc::error>
+    append_bits(const_bit_slice_t bits) OKAYLIB_NOEXCEPT
+    {
+        if (bits.is_empty())
+            return alloc::error::success;
 
-        // num_bytes + 1 going off the end, but bytes are zeroed and we
-        // have additional byte capacity, so we can read there
-        for (size_t i = first_byte_index + 1;
-             i < first_byte_index + num_bytes + 1; ++i) {
-            const bool new_carry =
-                m.allocation.unchecked_access(i) & carry_check_mask;
+        // if the bits are our own, they may get moved by reallocation. after
+        // that, reading them while appending is fine since only bits past the
+        // old end get written
+        const size_t own_start =
+            ok::detail::bit_slice_start_within(bits, m.allocation);
 
-            // at the end (when iter == num_bytes), we should not be carrying
-            // unless we have perfectly filled up the previous byte
-            __ok_internal_assert(i != num_bytes - 1 ||
-                                 this->size_bits() % 8 != 0 || !new_carry);
+        if (auto status = this->ensure_capacity_for(m.num_bits + bits.size());
+            !status.is_success()) [[unlikely]] {
+            return status;
+        }
 
-            m.allocation.unchecked_access(i) <<= 1;
-            m.allocation.unchecked_access(i) ^= carry_in_mask * carry;
-            carry = new_carry;
+        if (own_start != size_t(-1)) {
+            bits = this->items().subslice(
+                {.start = own_start, .length = bits.size()});
         }
-        // carry should be zero at the end, last byte is extra/uninitialized
-        __ok_internal_assert(!carry);
-        ++m.num_bits;
 
-        return alloc::error::success;
-    }
+        uint64_t* const words = this->words();
+        const size_t num_words = this->capacity_words();
+        size_t destination = m.num_bits;
+        for (size_t i = 0; i < bits.size(); i += 64, destination += 64) {
+            const uint64_t word = bits.get_word(i);
+            const size_t word_index = destination / 64;
+            const size_t shift = destination % 64;
+            // everything past the end is zero, so the new bits can just be
+            // or-ed in, spilling over into the next word if not aligned
+            words[word_index] |= word << shift;
+            if (shift != 0 && word_index + 1 < num_words)
+                words[word_index + 1] |= word >> (64 - shift);
+        }
+        m.num_bits += bits.size();
 
-    [[nodiscard]] constexpr status<alloc::error>
-    append(bool value) OKAYLIB_NOEXCEPT
-    {
-        return this->insert_at(this->size_bits(), value);
+        return alloc::error::success;
     }
 
     constexpr ok::bit remove_at(size_t idx) OKAYLIB_NOEXCEPT
@@ -277,47 +327,51 @@ class bit_arraylist_t
                 "Out of bounds access to bit_arraylist_t in remove_at()");
         }
 
-        constexpr uint8_t carry_check_mask = 0b001;
-        constexpr uint8_t carry_in_mask = 0b10000000;
-
-        const size_t byte_index = idx / 8;
-        const size_t sub_byte_bit_index = idx % 8;
+        uint64_t* const words = this->words();
+        const size_t word_index = idx / 64;
+        const uint64_t unmoved_mask = (uint64_t(1) << (idx % 64)) - 1;
+        const uint64_t first = words[word_index];
+
+        // shift everything from the removed bit onwards down by one. the bit
+        // carried into the top of the last word is past the end, so zero
+        const size_t last_word = (m.num_bits - 1) / 64;
+        for (size_t i = word_index; i < last_word; ++i)
+            words[i] = (words[i] >> 1) | (words[i + 1] << 63);
+        words[last_word] >>= 1;
+
+        // the bits below the removed one should not have moved
+        words[word_index] =
+            (words[word_index] & ~unmoved_mask) | (first & unmoved_mask);
+        m.num_bits -= 1;
 
-        constexpr auto shift_last_byte_and_return_whether_bit_was_on =
-            [](uint8_t* byte, size_t bit_index, bool removal_carry_in) -> bool {
-            __ok_internal_assert(bit_index < 8);
+        return ok::bit(((first >> (idx % 64)) & 1) != 0);
+    }
 
-            const uint8_t shift_mask = uint8_t(-1) << (bit_index + 1);
-            const uint8_t bit_mask = uint8_t(1) << bit_index;
-            const uint8_t out = *byte & bit_mask;
-            const uint8_t shifted = (*byte & shift_mask) >> 1;
+    /// Bitwise and with a slice of bits of the same size, a word at a time.
+    constexpr bit_arraylist_t&
+    operator&=(const const_bit_slice_t& other) OKAYLIB_NOEXCEPT
+    {
+        this->combine_words(other,
+                            [](uint64_t a, uint64_t b) { return a & b; });
+        return *this;
+    }
 
-            *byte &= ~(uint8_t(-1) << bit_index);
-            *byte |= shifted;
-            *byte |= carry_in_mask * removal_carry_in;
-            return out;
-        };
+    /// Bitwise or with a slice of bits of the same size, a word at a time.
+    constexpr bit_arraylist_t&
+    operator|=(const const_bit_slice_t& other) OKAYLIB_NOEXCEPT
+    {
+        this->combine_words(other,
+                            [](uint64_t a, uint64_t b) { return a | b; });
+        return *this;
+    }
 
-        // always carrying in a zero, it will be unused after this anyways
-        // bc we decrease m.num_bits
-        bool carry = false;
-        const size_t num_bytes_in_use =
-            round_up_to_multiple_of<8>(m.num_bits) / 8;
-        // NOTE: skipping last byte in this for loop
-        for (size_t i = num_bytes_in_use; i > byte_index; --i) {
-            const bool new_carry =
-                (m.allocation.unchecked_address_of_first_item()[i] &
-                 carry_check_mask) != 0;
-            m.allocation.unchecked_address_of_first_item()[i] >>= 1;
-            // add most significant bit if it carried from above
-            m.allocation.unchecked_address_of_first_item()[i] |=
-                (carry * carry_in_mask);
-            carry = new_carry;
-        }
-        m.num_bits -= 1;
-        return ok::bit(shift_last_byte_and_return_whether_bit_was_on(
-            m.allocation.unchecked_address_of_first_item() + byte_index,
-            sub_byte_bit_index, carry));
+    /// Bitwise xor with a slice of bits of the same size, a word at a time.
+    constexpr bit_arraylist_t&
+    operator^=(const const_bit_slice_t& other) OKAYLIB_NOEXCEPT
+    {
+        this->combine_words(other,
+                            [](uint64_t a, uint64_t b) { return a ^ b; });
+        return *this;
     }
 
     constexpr status<alloc::error>
@@ -331,8 +385,8 @@ class bit_arraylist_t
         if (m.allocation.size() == 0) {
             return this->first_allocation(new_spots);
         } else {
-            return this->reallocate(round_up_to_multiple_of<8>(new_spots) / 8,
-                                    0);
+            return this->reallocate(
+                round_up_to_multiple_of<64>(new_spots) / 8, 0);
         }
     }
 
@@ -345,12 +399,12 @@ class bit_arraylist_t
 
     [[nodiscard]] constexpr size_t capacity_bits() const OKAYLIB_NOEXCEPT
     {
-        return m.allocation.size() * 8;
+        return this->capacity_words() * 64;
     }
 
     [[nodiscard]] constexpr size_t capacity_bytes() const OKAYLIB_NOEXCEPT
     {
-        return m.allocation.size();
+        return this->capacity_words() * 8;
     }
 
     [[nodiscard]] constexpr bool is_empty() const OKAYLIB_NOEXCEPT
@@ -362,7 +416,7 @@ class bit_arraylist_t
     {
         if (this->is_empty())
             return {};
-        return this->remove_at(this->size_bits() - 1);
+        return bool(this->remove_at(this->size_bits() - 1));
     }
 
     [[nodiscard]] constexpr const backing_allocator_t&
@@ -376,7 +430,15 @@ class bit_arraylist_t
         return *m.allocator;
     }
 
-    constexpr void clear() OKAYLIB_NOEXCEPT { m.num_bits = 0; }
+    constexpr void clear() OKAYLIB_NOEXCEPT
+    {
+        // keep the bits past the end zeroed
+        uint64_t* const words = this->words();
+        const size_t num_words = this->size_words();
+        for (size_t i = 0; i < num_words; ++i)
+            words[i] = 0;
+        m.num_bits = 0;
+    }
 
     ~bit_arraylist_t() { destroy(); }
 
@@ -455,6 +517,40 @@ class bit_arraylist_t
     }
 
   private:
+    template <typename operation_t>
+    constexpr void combine_words(const const_bit_slice_t& other,
+                                 const operation_t& operation) OKAYLIB_NOEXCEPT
+    {
+        if (other.size() != this->size_bits()) [[unlikely]] {
+            __ok_abort("Attempt to combine bit_arraylist_t with a different "
+                       "number of bits.");
+        }
+        uint64_t* const words = this->words();
+        const size_t num_words = this->size_words();
+        // the last word loaded from other has zeroes past the end, so and, or
+        // and xor all keep the bits past the end zeroed
+        for (size_t i = 0; i < num_words; ++i) {
+            words[i] = operation(words[i], other.get_word(i * 64));
+        }
+    }
+
+    [[nodiscard]] constexpr status<alloc::error>
+    ensure_capacity_for(size_t total_bits) OKAYLIB_NOEXCEPT
+    {
+        if (total_bits <= this->capacity_bits())
+            return alloc::error::success;
+        if (m.allocation.size() == 0)
+            return this->first_allocation(total_bits);
+
+        const size_t bytes_required =
+            round_up_to_multiple_of<64>(total_bits) / 8 - m.allocation.size();
+        // grow geometrically unless a bigger jump is needed
+        const size_t bytes_preferred = m.allocation.size() > bytes_required
+                                           ? m.allocation.size()
+                                           : 0;
+        return this->reallocate(bytes_required, bytes_preferred);
+    }
+
     /// This function initializes m.allocation
     [[nodiscard]] constexpr status<alloc::error>
     first_allocation(size_t total_allocated_bits = 40) OKAYLIB_NOEXCEPT
@@ -464,12 +560,12 @@ class bit_arraylist_t
         __ok_internal_assert(total_allocated_bits != 0);
 
         const size_t bytes_needed =
-            round_up_to_multiple_of<8>(total_allocated_bits) / 8UL;
+            round_up_to_multiple_of<64>(total_allocated_bits) / 8UL;
 
         alloc::result_t<bytes_t> result =
             m.allocator->allocate(alloc::request_t{
                 .num_bytes = bytes_needed,
-                .alignment = 1,
+                .alignment = alignof(uint64_t),
             });
 
         if (!result.is_success()) [[unlikely]] {
@@ -492,6 +588,7 @@ class bit_arraylist_t
             .preferred_size_bytes = bytes_preferred == 0
                                         ? 0
                                         : m.allocation.size() + bytes_preferred,
+            .alignment = alignof(uint64_t),
         });
 
         if (!res.is_success()) [[unlikely]] {
@@ -661,6 +758,11 @@ inline constexpr detail::bit_string_t bit_string;
 
 } // namespace bit_arraylist
 
+template <typename backing_allocator_t>
+struct is_trivially_relocatable<bit_arraylist_t<backing_allocator_t>>
+    : stdc::true_type
+{};
+
 } // namespace ok
 
 #if defined(OKAYLIB_USE_FMT)
@@ -0,0 +1,769 @@
+#ifndef __OKAYLIB_CONTAINERS_BOUNDED_QUEUE_H__
+#define __OKAYLIB_CONTAINERS_BOUNDED_QUEUE_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/detail/template_util/uninitialized_storage.h"
+#include "okay/error.h"
+#include "okay/math/math.h"
+#include "okay/math/ordering.h"
+#include "okay/math/rounding.h"
+#include "okay/opt.h"
+#include "okay/platform/atomic.h"
+#include "okay/slice.h"
+
+namespace ok {
+
+namespace allocated_spsc_queue::detail {
+template <typename T> struct with_capacity_t;
+}
+namespace allocated_mpmc_queue::detail {
+template <typename T> struct with_capacity_t;
+}
+
+namespace bounded_queue {
+enum class push_error : uint8_t
+{
+    success,
+    // the queue was full, and the arguments were left untouched
+    full,
+};
+
+namespace detail {
+inline constexpr size_t cache_line_size = 64;
+
+/// The indices of a single producer single consumer ring. Each is on a cache
+/// line of its own: the producer writes tail and cached_head, the consumer
+/// writes head and cached_tail, and neither writes a line the other reads
+/// on every operation. The indices only ever increase, and are masked to get
+/// a slot.
+struct spsc_indices_t
+{
+    alignas(cache_line_size) ok::atomic_t<size_t> tail;
+    // the last head the producer saw. the producer only reloads head when
+    // this says the queue is full
+    alignas(cache_line_size) size_t cached_head = 0;
+    alignas(cache_line_size) ok::atomic_t<size_t> head;
+    // the last tail the consumer saw. the consumer only reloads tail when
+    // this says the queue is empty
+    alignas(cache_line_size) size_t cached_tail = 0;
+};
+
+/// The positions of a multi producer multi consumer queue, on separate cache
+/// lines so that producers and consumers do not contend with each other.
+struct mpmc_indices_t
+{
+    alignas(cache_line_size) ok::atomic_t<size_t> enqueue_pos;
+    alignas(cache_line_size) ok::atomic_t<size_t> dequeue_pos;
+};
+
+/// A slot of an MPMC queue. The sequence says what the slot is waiting for:
+/// when it equals the position of a push, the slot is free for that push, and
+/// when it equals the position of a pop plus one, it holds that pop's item.
+template <typename T> struct mpmc_slot_t
+{
+    ok::atomic_t<size_t> sequence;
+    ok::detail::uninitialized_storage_t<T> storage;
+};
+
+/// The operations shared by the fixed size and allocated SPSC queues.
+/// derived_t provides indices(), slots() and capacity(), which is a power of
+/// two.
+template <typename derived_t, typename T> class spsc_queue_common_t
+{
+    [[nodiscard]] constexpr spsc_indices_t& indices() const noexcept
+    {
+        return static_cast<const derived_t*>(this)->indices();
+    }
+
+    [[nodiscard]] constexpr T& slot(size_t index) const noexcept
+    {
+        const size_t mask = static_cast<const derived_t*>(this)->capacity() - 1;
+        return static_cast<const derived_t*>(this)->slots()[index & mask].value;
+    }
+
+    [[nodiscard]] constexpr size_t capacity() const noexcept
+    {
+        return static_cast<const derived_t*>(this)->capacity();
+    }
+
+  protected:
+    /// Destroy whatever is left in the queue. Only called when no other
+    /// thread is using it.
+    constexpr void destroy_items() noexcept
+    {
+        if constexpr (!stdc::is_trivially_destructible_v<T>) {
+            spsc_indices_t& indices = this->indices();
+            const size_t tail = indices.tail.load(memory_order::relaxed);
+            for (size_t i = indices.head.load(memory_order::relaxed); i != tail;
+                 ++i)
+                this->slot(i).~T();
+        }
+    }
+
+  public:
+    /// Construct an item at the back of the queue, or return
+    /// push_error::full. Only one thread, the producer, may push.
+    template <typename... args_t>
+        requires ok::is_std_constructible_c<T, args_t...>
+    [[nodiscard]] constexpr status<push_error>
+    try_push(args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        spsc_indices_t& indices = this->indices();
+        const size_t tail = indices.tail.load(memory_order::relaxed);
+        if (tail - indices.cached_head == this->capacity()) {
+            indices.cached_head = indices.head.load(memory_order::acquire);
+            if (tail - indices.cached_head == this->capacity())
+                return push_error::full;
+        }
+        stdc::construct_at(ok::addressof(this->slot(tail)),
+                           stdc::forward<args_t>(args)...);
+        indices.tail.store(tail + 1, memory_order::release);
+        return push_error::success;
+    }
+
+    /// Copy as many items from the front of the slice as there is room for,
+    /// and return how many that was. The consumer sees them all at once.
+    /// Only the producer may push.
+    constexpr size_t push_batch(slice<const T> items) OKAYLIB_NOEXCEPT
+    {
+        static_assert(stdc::is_copy_constructible_v<T>,
+                      "push_batch copies items into the queue.");
+        spsc_indices_t& indices = this->indices();
+        const size_t tail = indices.tail.load(memory_order::relaxed);
+        size_t free = this->capacity() - (tail - indices.cached_head);
+        if (free < items.size()) {
+            indices.cached_head = indices.head.load(memory_order::acquire);
+            free = this->capacity() - (tail - indices.cached_head);
+        }
+        const size_t count = ok::min(free, items.size());
+        for (size_t i = 0; i < count; ++i) {
+            stdc::construct_at(ok::addressof(this->slot(tail + i)),
+                               items.unchecked_access(i));
+        }
+        if (count != 0)
+            indices.tail.store(tail + count, memory_order::release);
+        return count;
+    }
+
+    /// Take the item at the front of the queue, or return nothing if it is
+    /// empty. Only one thread, the consumer, may pop.
+    [[nodiscard]] constexpr opt<T> try_pop() OKAYLIB_NOEXCEPT
+    {
+        spsc_indices_t& indices = this->indices();
+        const size_t head = indices.head.load(memory_order::relaxed);
+        if (head == indices.cached_tail) {
+            indices.cached_tail = indices.tail.load(memory_order::acquire);
+            if (head == indices.cached_tail)
+                return {};
+        }
+        T& item = this->slot(head);
+        opt<T> out(stdc::move(item));
+        if constexpr (!stdc::is_trivially_destructible_v<T>)
+            item.~T();
+        indices.head.store(head + 1, memory_order::release);
+        return out;
+    }
+
+    /// Move up to output.size() items out of the queue, assigning them to
+    /// the front of output, and return how many that was. The slots are
+    /// given back to the producer all at once. Only the consumer may pop.
+    constexpr size_t pop_batch(slice<T> output) OKAYLIB_NOEXCEPT
+    {
+        static_assert(stdc::is_move_assignable_v<T>,
+                      "pop_batch move assigns items out of the queue.");
+        spsc_indices_t& indices = this->indices();
+        const size_t head = indices.head.load(memory_order::relaxed);
+        size_t available = indices.cached_tail - head;
+        if (available < output.size()) {
+            indices.cached_tail = indices.tail.load(memory_order::acquire);
+            available = indices.cached_tail - head;
+        }
+        const size_t count = ok::min(available, output.size());
+        for (size_t i = 0; i < count; ++i) {
+            T& item = this->slot(head + i);
+            output.unchecked_access(i) = stdc::move(item);
+            if constexpr (!stdc::is_trivially_destructible_v<T>)
+                item.~T();
+        }
+        if (count != 0)
+            indices.head.store(head + count, memory_order::release);
+        return count;
+    }
+
+    /// The number of items in the queue. Only exact when neither the
+    /// producer nor the consumer is in the middle of an operation.
+    [[nodiscard]] constexpr size_t size_approx() const noexcept
+    {
+        spsc_indices_t& indices = this->indices();
+        const size_t head = indices.head.load(memory_order::acquire);
+        return indices.tail.load(memory_order::acquire) - head;
+    }
+};
+
+/// The operations shared by the fixed size and allocated MPMC queues.
+/// derived_t provides indices(), slots() and capacity(), which is a power of
+/// two and at least two.
+template <typename derived_t, typename T> class mpmc_queue_common_t
+{
+    [[nodiscard]] constexpr mpmc_indices_t& indices() const noexcept
+    {
+        return static_cast<const derived_t*>(this)->indices();
+    }
+
+    [[nodiscard]] constexpr mpmc_slot_t<T>& slot(size_t position) const noexcept
+    {
+        const size_t mask = static_cast<const derived_t*>(this)->capacity() - 1;
+        return static_cast<const derived_t*>(this)->slots()[position & mask];
+    }
+
+  protected:
+    /// Every slot starts out free for the push at its own position.
+    constexpr void init_slots() noexcept
+    {
+        const size_t capacity = static_cast<derived_t*>(this)->capacity();
+        mpmc_slot_t<T>* slots = static_cast<derived_t*>(this)->slots();
+        for (size_t i = 0; i < capacity; ++i)
+            slots[i].sequence.store(i, memory_order::relaxed);
+    }
+
+    /// Destroy whatever is left in the queue. Only called when no other
+    /// thread is using it.
+    constexpr void destroy_items() noexcept
+    {
+        if constexpr (!stdc::is_trivially_destructible_v<T>) {
+            while (this->try_pop()) {
+            }
+        }
+    }
+
+  public:
+    /// Construct an item at the back of the queue, or return
+    /// push_error::full. Any number of threads may push at once.
+    template <typename... args_t>
+        requires ok::is_std_constructible_c<T, args_t...>
+    [[nodiscard]] constexpr status<push_error>
+    try_push(args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        ok::atomic_t<size_t>& enqueue_pos = this->indices().enqueue_pos;
+        size_t position = enqueue_pos.load(memory_order::relaxed);
+        mpmc_slot_t<T>* slot;
+        while (true) {
+            slot = ok::addressof(this->slot(position));
+            const size_t sequence = slot->sequence.load(memory_order::acquire);
+            const int64_t diff = int64_t(sequence) - int64_t(position);
+            if (diff == 0) {
+                // the slot is free for this position, try to claim it. on
+                // failure position is updated to the latest one
+                if (enqueue_pos.compare_exchange_weak(position, position + 1,
+                                                      memory_order::relaxed,
+                                                      memory_order::relaxed))
+                    break;
+            } else if (diff < 0) {
+                // the slot still holds the item from one lap ago
+                return push_error::full;
+            } else {
+                // another producer claimed this position already
+                position = enqueue_pos.load(memory_order::relaxed);
+            }
+        }
+        stdc::construct_at(ok::addressof(slot->storage.value),
+                           stdc::forward<args_t>(args)...);
+        slot->sequence.store(position + 1, memory_order::release);
+        return push_error::success;
+    }
+
+    /// Take the item at the front of the queue, or return nothing if it is
+    /// empty. Any number of threads may pop at once.
+    [[nodiscard]] constexpr opt<T> try_pop() OKAYLIB_NOEXCEPT
+    {
+        ok::atomic_t<size_t>& dequeue_pos = this->indices().dequeue_pos;
+        size_t position = dequeue_pos.load(memory_order::relaxed);
+        mpmc_slot_t<T>* slot;
+        while (true) {
+            slot = ok::addressof(this->slot(position));
+            const size_t sequence = slot->sequence.load(memory_order::acquire);
+            const int64_t diff = int64_t(sequence) - int64_t(position + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(position, position + 1,
+                                                      memory_order::relaxed,
+                                                      memory_order::relaxed))
+                    break;
+            } else if (diff < 0) {
+                // nothing has been pushed to this position yet
+                return {};
+            } else {
+                position = dequeue_pos.load(memory_order::relaxed);
+            }
+        }
+        T& item = slot->storage.value;
+        opt<T> out(stdc::move(item));
+        if constexpr (!stdc::is_trivially_destructible_v<T>)
+            item.~T();
+        // free the slot for the push one lap from now
+        const size_t capacity = static_cast<const derived_t*>(this)->capacity();
+        slot->sequence.store(position + capacity, memory_order::release);
+        return out;
+    }
+
+    /// The number of items in the queue. Only exact when no thread is in the
+    /// middle of an operation.
+    [[nodiscard]] constexpr size_t size_approx() const noexcept
+    {
+        const size_t dequeue_pos =
+            this->indices().dequeue_pos.load(memory_order::acquire);
+        const size_t enqueue_pos =
+            this->indices().enqueue_pos.load(memory_order::acquire);
+        return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+    }
+};
+} // namespace detail
+} // namespace bounded_queue
+
+/// A bounded lock-free queue for exactly one producer thread and one consumer
+/// thread, with room for capacity items stored inline. Pushing and popping
+/// never allocate or wait on the other thread.
+///
+/// The producer and consumer each keep a cached copy of the other's index,
+/// and only reload the real one (and so only touch the other thread's cache
+/// line) when the cached copy says the queue is full or empty. push_batch()
+/// and pop_batch() move many items for the cost of one index update.
+template <typename T, size_t capacity_v>
+class spsc_queue_t
+    : public bounded_queue::detail::spsc_queue_common_t<
+          spsc_queue_t<T, capacity_v>, T>
+{
+    static_assert(!stdc::is_reference_c<T>,
+                  "spsc_queue_t cannot store references.");
+    static_assert(ok::is_power_of_two(capacity_v),
+                  "The capacity of a spsc_queue_t must be a power of two.");
+    friend class bounded_queue::detail::spsc_queue_common_t<spsc_queue_t, T>;
+
+    mutable bounded_queue::detail::spsc_indices_t m_indices;
+    mutable ok::detail::uninitialized_storage_t<T> m_slots[capacity_v];
+
+    [[nodiscard]] constexpr bounded_queue::detail::spsc_indices_t&
+    indices() const noexcept
+    {
+        return m_indices;
+    }
+
+    [[nodiscard]] constexpr ok::detail::uninitialized_storage_t<T>*
+    slots() const noexcept
+    {
+        return m_slots;
+    }
+
+  public:
+    constexpr spsc_queue_t() = default;
+
+    spsc_queue_t(const spsc_queue_t&) = delete;
+    spsc_queue_t& operator=(const spsc_queue_t&) = delete;
+    spsc_queue_t(spsc_queue_t&&) = delete;
+    spsc_queue_t& operator=(spsc_queue_t&&) = delete;
+
+    constexpr ~spsc_queue_t() { this->destroy_items(); }
+
+    [[nodiscard]] constexpr size_t capacity() const noexcept
+    {
+        return capacity_v;
+    }
+};
+
+/// The same as spsc_queue_t, but with a capacity chosen at runtime and the
+/// indices and slots coming from an allocator. Moving or destroying it must
+/// not happen while other threads are using it.
+template <typename T, allocator_c backing_allocator_t = ok::allocator_t>
+class allocated_spsc_queue_t
+    : public bounded_queue::detail::spsc_queue_common_t<
+          allocated_spsc_queue_t<T, backing_allocator_t>, T>
+{
+    static_assert(!stdc::is_reference_c<T>,
+                  "allocated_spsc_queue_t cannot store references.");
+    friend class bounded_queue::detail::spsc_queue_common_t<
+        allocated_spsc_queue_t, T>;
+    friend struct allocated_spsc_queue::detail::with_capacity_t<T>;
+
+    struct members_t
+    {
+        void* block;
+        // the slots come right after the indices, in the same allocation
+        bounded_queue::detail::spsc_indices_t* indices;
+        size_t capacity;
+        backing_allocator_t* allocator;
+    } m;
+
+    [[nodiscard]] constexpr bounded_queue::detail::spsc_indices_t&
+    indices() const noexcept
+    {
+        return *m.indices;
+    }
+
+    [[nodiscard]] constexpr ok::detail::uninitialized_storage_t<T>*
+    slots() const noexcept
+    {
+        return reinterpret_cast<ok::detail::uninitialized_storage_t<T>*>(
+            m.indices + 1);
+    }
+
+  public:
+    [[nodiscard]] constexpr size_t capacity() const noexcept
+    {
+        return m.capacity;
+    }
+
+    constexpr allocated_spsc_queue_t(allocated_spsc_queue_t&& other) noexcept
+        : m(other.m)
+    {
+        other.m.block = nullptr;
+    }
+
+    constexpr allocated_spsc_queue_t&
+    operator=(allocated_spsc_queue_t&& other) noexcept
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = other.m;
+        other.m.block = nullptr;
+        return *this;
+    }
+
+    allocated_spsc_queue_t(const allocated_spsc_queue_t&) = delete;
+    allocated_spsc_queue_t& operator=(const allocated_spsc_queue_t&) = delete;
+
+    constexpr ~allocated_spsc_queue_t() { destroy(); }
+
+  private:
+    constexpr void destroy() noexcept
+    {
+        if (!m.block)
+            return;
+        this->destroy_items();
+        m.allocator->deallocate(m.block);
+    }
+
+  public:
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    constexpr allocated_spsc_queue_t(members_t&& members) noexcept
+        : m(stdc::forward<members_t>(members))
+    {
+    }
+};
+
+/// A bounded lock-free queue which any number of threads can push to and pop
+/// from at once, with room for capacity items stored inline. Based on Dmitry
+/// Vyukov's bounded MPMC queue: every slot has a sequence number saying
+/// whether it is free or full and for which lap around the ring, so a push
+/// or pop is one compare exchange on the shared position plus one store to
+/// the slot, and threads working on different slots do not wait for each
+/// other.
+template <typename T, size_t capacity_v>
+class mpmc_queue_t : public bounded_queue::detail::mpmc_queue_common_t<
+                         mpmc_queue_t<T, capacity_v>, T>
+{
+    static_assert(!stdc::is_reference_c<T>,
+                  "mpmc_queue_t cannot store references.");
+    static_assert(ok::is_power_of_two(capacity_v) && capacity_v >= 2,
+                  "The capacity of a mpmc_queue_t must be a power of two, and "
+                  "at least two.");
+    friend class bounded_queue::detail::mpmc_queue_common_t<mpmc_queue_t, T>;
+
+    using slot_t = bounded_queue::detail::mpmc_slot_t<T>;
+
+    mutable bounded_queue::detail::mpmc_indices_t m_indices;
+    alignas(bounded_queue::detail::cache_line_size) mutable slot_t
+        m_slots[capacity_v];
+
+    [[nodiscard]] constexpr bounded_queue::detail::mpmc_indices_t&
+    indices() const noexcept
+    {
+        return m_indices;
+    }
+
+    [[nodiscard]] constexpr slot_t* slots() const noexcept { return m_slots; }
+
+  public:
+    constexpr mpmc_queue_t() noexcept { this->init_slots(); }
+
+    mpmc_queue_t(const mpmc_queue_t&) = delete;
+    mpmc_queue_t& operator=(const mpmc_queue_t&) = delete;
+    mpmc_queue_t(mpmc_queue_t&&) = delete;
+    mpmc_queue_t& operator=(mpmc_queue_t&&) = delete;
+
+    constexpr ~mpmc_queue_t() { this->destroy_items(); }
+
+    [[nodiscard]] constexpr size_t capacity() const noexcept
+    {
+        return capacity_v;
+    }
+};
+
+/// The same as mpmc_queue_t, but with a capacity chosen at runtime and the
+/// positions and slots coming from an allocator. Moving or destroying it
+/// must not happen while other threads are using it.
+template <typename T, allocator_c backing_allocator_t = ok::allocator_t>
+class allocated_mpmc_queue_t
+    : public bounded_queue::detail::mpmc_queue_common_t<
+          allocated_mpmc_queue_t<T, backing_allocator_t>, T>
+{
+    static_assert(!stdc::is_reference_c<T>,
+                  "allocated_mpmc_queue_t cannot store references.");
+    friend class bounded_queue::detail::mpmc_queue_common_t<
+        allocated_mpmc_queue_t, T>;
+    friend struct allocated_mpmc_queue::detail::with_capacity_t<T>;
+
+    using slot_t = bounded_queue::detail::mpmc_slot_t<T>;
+
+    struct members_t
+    {
+        void* block;
+        // the slots come right after the positions, in the same allocation
+        bounded_queue::detail::mpmc_indices_t* indices;
+        size_t capacity;
+        backing_allocator_t* allocator;
+    } m;
+
+    [[nodiscard]] constexpr bounded_queue::detail::mpmc_indices_t&
+    indices() const noexcept
+    {
+        return *m.indices;
+    }
+
+    [[nodiscard]] constexpr slot_t* slots() const noexcept
+    {
+        return reinterpret_cast<slot_t*>(m.indices + 1);
+    }
+
+  public:
+    [[nodiscard]] constexpr size_t capacity() const noexcept
+    {
+        return m.capacity;
+    }
+
+    constexpr allocated_mpmc_queue_t(allocated_mpmc_queue_t&& other) noexcept
+        : m(other.m)
+    {
+        other.m.block = nullptr;
+    }
+
+    constexpr allocated_mpmc_queue_t&
+    operator=(allocated_mpmc_queue_t&& other) noexcept
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = other.m;
+        other.m.block = nullptr;
+        return *this;
+    }
+
+    allocated_mpmc_queue_t(const allocated_mpmc_queue_t&) = delete;
+    allocated_mpmc_queue_t& operator=(const allocated_mpmc_queue_t&) = delete;
+
+    constexpr ~allocated_mpmc_queue_t() { destroy(); }
+
+  private:
+    constexpr void destroy() noexcept
+    {
+        if (!m.block)
+            return;
+        this->destroy_items();
+        m.allocator->deallocate(m.block);
+    }
+
+  public:
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    constexpr allocated_mpmc_queue_t(members_t&& members) noexcept
+        : m(stdc::forward<members_t>(members))
+    {
+    }
+};
+
+namespace bounded_queue::detail {
+/// Round capacity up to a power of two which is at least minimum. Returns zero
+/// if the queue would be too big to allocate, either because the rounding
+/// overflows or because the size in bytes does.
+template <typename indices_t, typename slot_t>
+[[nodiscard]] constexpr size_t rounded_capacity(size_t capacity,
+                                                size_t minimum) noexcept
+{
+    constexpr size_t max_slots =
+        (~size_t(0) - sizeof(indices_t) - cache_line_size) / sizeof(slot_t);
+    if (capacity > max_slots) [[unlikely]]
+        return 0;
+    size_t rounded = minimum;
+    while (rounded < capacity) {
+        if (rounded > max_slots / 2) [[unlikely]]
+            return 0;
+        rounded *= 2;
+    }
+    return rounded;
+}
+
+/// Allocate indices_t followed by capacity slots, with the indices starting
+/// on a cache line. Returns the block to deallocate later, and the indices.
+/// The capacity must come from rounded_capacity(), so the size cannot
+/// overflow.
+template <typename indices_t, typename slot_t,
+          allocator_c backing_allocator_t>
+[[nodiscard]] constexpr alloc::error
+allocate_queue(backing_allocator_t& allocator, size_t capacity,
+               void*& out_block, indices_t*& out_indices) OKAYLIB_NOEXCEPT
+{
+    static_assert(sizeof(indices_t) % alignof(slot_t) == 0);
+    auto allocation = allocator.allocate(alloc::request_t{
+        .num_bytes =
+            sizeof(indices_t) + capacity * sizeof(slot_t) + cache_line_size,
+        .leave_nonzeroed = true,
+    });
+    if (!allocation.is_success()) [[unlikely]]
+        return allocation.status();
+
+    uint8_t* const block =
+        allocation.unwrap().unchecked_address_of_first_item();
+    uint8_t* const bytes =
+        block + (runtime_round_up_to_multiple_of(cache_line_size,
+                                                 uintptr_t(block)) -
+                 uintptr_t(block));
+    out_block = block;
+    out_indices = stdc::construct_at(reinterpret_cast<indices_t*>(bytes));
+    return alloc::error::success;
+}
+} // namespace bounded_queue::detail
+
+namespace allocated_spsc_queue {
+namespace detail {
+template <typename T> struct with_capacity_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::allocated_spsc_queue_t<T, ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               size_t capacity) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, capacity);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::allocated_spsc_queue_t<T, backing_allocator_t>& output,
+                     backing_allocator_t& allocator,
+                     size_t capacity) const OKAYLIB_NOEXCEPT
+    {
+        using output_t = ok::allocated_spsc_queue_t<T, backing_allocator_t>;
+        using indices_t = bounded_queue::detail::spsc_indices_t;
+        using slot_t = ok::detail::uninitialized_storage_t<T>;
+
+        const size_t rounded =
+            bounded_queue::detail::rounded_capacity<indices_t, slot_t>(
+                capacity, 1);
+        if (rounded == 0) [[unlikely]]
+            return alloc::error::unsupported;
+
+        void* block;
+        indices_t* indices;
+        const alloc::error error =
+            bounded_queue::detail::allocate_queue<indices_t, slot_t>(
+                allocator, rounded, block, indices);
+        if (error != alloc::error::success) [[unlikely]]
+            return error;
+
+        stdc::construct_at(ok::addressof(output),
+                           typename output_t::members_t{
+                               .block = block,
+                               .indices = indices,
+                               .capacity = rounded,
+                               .allocator = ok::addressof(allocator),
+                           });
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Allocate an empty SPSC queue with room for at least capacity items,
+/// rounded up to a power of two. Errors with unsupported if that many items
+/// could never fit in memory.
+/// allocated_spsc_queue::with_capacity<T>(allocator, capacity)
+template <typename T>
+inline constexpr detail::with_capacity_t<T> with_capacity;
+} // namespace allocated_spsc_queue
+
+namespace allocated_mpmc_queue {
+namespace detail {
+template <typename T> struct with_capacity_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::allocated_mpmc_queue_t<T, ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               size_t capacity) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, capacity);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::allocated_mpmc_queue_t<T, backing_allocator_t>& output,
+                     backing_allocator_t& allocator,
+                     size_t capacity) const OKAYLIB_NOEXCEPT
+    {
+        using output_t = ok::allocated_mpmc_queue_t<T, backing_allocator_t>;
+        using indices_t = bounded_queue::detail::mpmc_indices_t;
+        using slot_t = bounded_queue::detail::mpmc_slot_t<T>;
+
+        // a queue of one slot cannot tell a full slot from a free one
+        const size_t rounded =
+            bounded_queue::detail::rounded_capacity<indices_t, slot_t>(
+                capacity, 2);
+        if (rounded == 0) [[unlikely]]
+            return alloc::error::unsupported;
+
+        void* block;
+        indices_t* indices;
+        const alloc::error error =
+            bounded_queue::detail::allocate_queue<indices_t, slot_t>(
+                allocator, rounded, block, indices);
+        if (error != alloc::error::success) [[unlikely]]
+            return error;
+
+        slot_t* const slots = reinterpret_cast<slot_t*>(indices + 1);
+        for (size_t i = 0; i < rounded; ++i)
+            stdc::construct_at(slots + i);
+
+        stdc::construct_at(ok::addressof(output),
+                           typename output_t::members_t{
+                               .block = block,
+                               .indices = indices,
+                               .capacity = rounded,
+                               .allocator = ok::addressof(allocator),
+                           });
+        output.init_slots();
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Allocate an empty MPMC queue with room for at least capacity items,
+/// rounded up to a power of two and to at least two. Errors with unsupported
+/// if that many items could never fit in memory.
+/// allocated_mpmc_queue::with_capacity<T>(allocator, capacity)
+template <typename T>
+inline constexpr detail::with_capacity_t<T> with_capacity;
+} // namespace allocated_mpmc_queue
+} // namespace ok
+
+#endif
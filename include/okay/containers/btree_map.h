@@ -0,0 +1,1087 @@
+#ifndef __OKAYLIB_CONTAINERS_BTREE_MAP_H__
+#define __OKAYLIB_CONTAINERS_BTREE_MAP_H__
+
+#include "okay/algorithm/binary_search.h"
+#include "okay/allocators/allocator.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/iterables/iterables.h"
+#include "okay/math/ordering.h"
+#include "okay/math/rounding.h"
+#include "okay/opt.h"
+#include "okay/tuple.h"
+#include <cstring>
+
+namespace ok {
+namespace btree_map {
+/// How big nodes are by default: eight cache lines. Searching a node touches
+/// memory which the hardware prefetcher brings in together, and a few dozen
+/// small keys fit in each one, so the tree stays shallow.
+inline constexpr size_t default_node_bytes = 512;
+
+namespace detail {
+template <typename key_t, typename value_t> struct from_sorted_t;
+
+/// Fixed size blocks handed out from chunks of the backing allocator, with
+/// freed blocks kept in a free list for reuse. The same idea as
+/// block_allocator_t, except that it grows by adding chunks instead of
+/// growing in place, so it works on top of any allocator. Chunks are only
+/// given back when the pool is released.
+template <size_t block_size, size_t block_align> class node_pool_t
+{
+    struct free_block_t
+    {
+        free_block_t* next;
+    };
+
+    struct chunk_t
+    {
+        chunk_t* next;
+    };
+
+    static constexpr size_t alignment =
+        ok::max(ok::max(block_align, alignof(free_block_t)), alignof(chunk_t));
+    static constexpr size_t stride = round_up_to_multiple_of<alignment>(
+        ok::max(block_size, sizeof(free_block_t)));
+    static constexpr size_t header_size =
+        round_up_to_multiple_of<alignment>(sizeof(chunk_t));
+    static constexpr size_t max_blocks_per_chunk = 256;
+
+    free_block_t* m_free_head = nullptr;
+    chunk_t* m_chunks = nullptr;
+    size_t m_num_free = 0;
+    size_t m_next_chunk_blocks = 4;
+
+    template <typename backing_allocator_t>
+    [[nodiscard]] alloc::error
+    add_chunk(backing_allocator_t& allocator,
+              size_t num_blocks) OKAYLIB_NOEXCEPT
+    {
+        auto allocation = allocator.allocate(alloc::request_t{
+            .num_bytes = header_size + num_blocks * stride,
+            .alignment = alignment,
+            .leave_nonzeroed = true,
+        });
+        if (!allocation.is_success()) [[unlikely]]
+            return allocation.status();
+        uint8_t* const bytes =
+            allocation.unwrap().unchecked_address_of_first_item();
+        auto* const chunk = reinterpret_cast<chunk_t*>(bytes);
+        chunk->next = m_chunks;
+        m_chunks = chunk;
+        // pushed backwards so that blocks are handed out in address order
+        for (size_t i = num_blocks; i-- > 0;) {
+            auto* const block = reinterpret_cast<free_block_t*>(
+                bytes + header_size + i * stride);
+            block->next = m_free_head;
+            m_free_head = block;
+        }
+        m_num_free += num_blocks;
+        return alloc::error::success;
+    }
+
+  public:
+    /// Returns nullptr if the backing allocator is out of memory.
+    template <typename backing_allocator_t>
+    [[nodiscard]] void* allocate(backing_allocator_t& allocator)
+        OKAYLIB_NOEXCEPT
+    {
+        if (!m_free_head) [[unlikely]] {
+            auto status = this->add_chunk(allocator, m_next_chunk_blocks);
+            if (!ok::is_success(status))
+                return nullptr;
+            m_next_chunk_blocks =
+                ok::min(m_next_chunk_blocks * 2, max_blocks_per_chunk);
+        }
+        free_block_t* const block = m_free_head;
+        m_free_head = block->next;
+        --m_num_free;
+        return block;
+    }
+
+    void deallocate(void* block) noexcept
+    {
+        auto* const free_block = static_cast<free_block_t*>(block);
+        free_block->next = m_free_head;
+        m_free_head = free_block;
+        ++m_num_free;
+    }
+
+    /// Make sure that the next num_blocks allocations succeed, with at most
+    /// one call to the backing allocator.
+    template <typename backing_allocator_t>
+    [[nodiscard]] alloc::error
+    reserve(backing_allocator_t& allocator,
+            size_t num_blocks) OKAYLIB_NOEXCEPT
+    {
+        if (num_blocks <= m_num_free)
+            return alloc::error::success;
+        return this->add_chunk(allocator, num_blocks - m_num_free);
+    }
+
+    /// Give every chunk back to the allocator. Nothing allocated from the
+    /// pool may be used afterwards.
+    template <typename backing_allocator_t>
+    void release(backing_allocator_t& allocator) noexcept
+    {
+        while (chunk_t* const chunk = m_chunks) {
+            m_chunks = chunk->next;
+            allocator.deallocate(chunk);
+        }
+        *this = node_pool_t{};
+    }
+};
+} // namespace detail
+} // namespace btree_map
+
+/// An ordered map, stored as a B+ tree. Each node holds many keys in a
+/// contiguous array, so a lookup takes a handful of cache misses instead of
+/// one per level of a binary tree, and iterating in order walks along a
+/// linked list of leaves. Nodes are target_node_bytes big, and come out of a
+/// pool which takes memory from the allocator in chunks.
+///
+/// Keys are ordered with operator<=>. Lookups are heterogeneous: anything
+/// which can be compared with the key using <=> can be used to find it.
+/// Within a node, integer keys are searched by counting how many keys are
+/// smaller, which has no branches and which compilers turn into vector
+/// compares. Other keys use a branchless binary search.
+///
+/// Keys are copied into the interior nodes, so they must be copy
+/// constructible. Inserting into or removing from the map invalidates
+/// references to its items.
+template <typename key_t, typename value_t,
+          allocator_c backing_allocator_t = ok::allocator_t,
+          size_t target_node_bytes = btree_map::default_node_bytes>
+class btree_map_t
+{
+    static_assert(!stdc::is_reference_c<key_t> &&
+                      !stdc::is_reference_c<value_t>,
+                  "btree_map_t cannot store references, use pointers "
+                  "instead.");
+    static_assert(stdc::is_copy_constructible_v<key_t>,
+                  "btree_map_t copies keys into its interior nodes, so they "
+                  "must be copy constructible.");
+    static_assert(ok::detail::default_searchable_c<key_t, key_t>,
+                  "btree_map_t keys must be ordered with operator<=>.");
+    static_assert(target_node_bytes >= 64,
+                  "btree_map_t nodes must be at least a cache line.");
+
+  public:
+    static constexpr size_t leaf_capacity =
+        ok::max(size_t(4), (target_node_bytes - 16) /
+                               (sizeof(key_t) + sizeof(value_t)));
+    static constexpr size_t internal_capacity =
+        ok::max(size_t(4), (target_node_bytes - 16) /
+                               (sizeof(key_t) + sizeof(void*)));
+
+  private:
+    // the fewest items (or keys, for internal nodes) a node other than the
+    // root can have. two nodes at the minimum, plus the key between them,
+    // must fit in one node for merging to work
+    static constexpr size_t leaf_min = leaf_capacity / 2;
+    static constexpr size_t internal_min = (internal_capacity - 1) / 2;
+    // more than enough for any number of items which fits in memory
+    static constexpr size_t max_height = 64;
+
+    struct leaf_t
+    {
+        leaf_t* next;
+        uint32_t count;
+        alignas(key_t) uint8_t key_bytes[sizeof(key_t) * leaf_capacity];
+        alignas(value_t) uint8_t value_bytes[sizeof(value_t) * leaf_capacity];
+
+        [[nodiscard]] key_t* keys() noexcept
+        {
+            return reinterpret_cast<key_t*>(key_bytes);
+        }
+        [[nodiscard]] value_t* values() noexcept
+        {
+            return reinterpret_cast<value_t*>(value_bytes);
+        }
+    };
+
+    /// Child i holds the keys which are at least keys()[i - 1] and less than
+    /// keys()[i].
+    struct internal_t
+    {
+        // there is one more child than this
+        uint32_t count;
+        alignas(key_t) uint8_t key_bytes[sizeof(key_t) * internal_capacity];
+        void* children[internal_capacity + 1];
+
+        [[nodiscard]] key_t* keys() noexcept
+        {
+            return reinterpret_cast<key_t*>(key_bytes);
+        }
+    };
+
+    using pool_t = btree_map::detail::node_pool_t<
+        ok::max(sizeof(leaf_t), sizeof(internal_t)),
+        ok::max(alignof(leaf_t), alignof(internal_t))>;
+
+    struct members_t
+    {
+        // nullptr when the map is empty
+        void* root;
+        // how many levels of internal nodes there are above the leaves
+        size_t height;
+        size_t size;
+        pool_t pool;
+        backing_allocator_t* allocator;
+    } m;
+
+    struct position_t
+    {
+        leaf_t* leaf;
+        size_t index;
+    };
+
+    template <bool is_const> struct cursor_t
+    {
+        using container_t =
+            stdc::conditional_t<is_const, const btree_map_t, btree_map_t>;
+        using value_type = ok::tuple<
+            const key_t&,
+            stdc::conditional_t<is_const, const value_t&, value_t&>>;
+
+        position_t position;
+        position_t end;
+
+        [[nodiscard]] constexpr opt<value_type>
+        next(container_t&) OKAYLIB_NOEXCEPT
+        {
+            if (position.leaf == end.leaf && position.index == end.index)
+                return nullopt;
+            leaf_t* const leaf = position.leaf;
+            const size_t index = position.index;
+            if (++position.index == leaf->count)
+                position = {leaf->next, 0};
+            return value_type(leaf->keys()[index], leaf->values()[index]);
+        }
+    };
+
+    template <typename lookup_t>
+    [[nodiscard]] static constexpr bool is_counting_search() noexcept
+    {
+        return stdc::is_integral_v<key_t> && stdc::is_same_v<key_t, lookup_t>;
+    }
+
+    /// How many of the keys are less than key, or less than or equal to it if
+    /// or_equal is true.
+    template <bool or_equal, typename lookup_t>
+    [[nodiscard]] static size_t count_less(const key_t* keys, size_t count,
+                                           const lookup_t& key) OKAYLIB_NOEXCEPT
+    {
+        if constexpr (is_counting_search<lookup_t>()) {
+            size_t out = 0;
+            for (size_t i = 0; i < count; ++i) {
+                if constexpr (or_equal)
+                    out += keys[i] <= key;
+                else
+                    out += keys[i] < key;
+            }
+            return out;
+        } else {
+            return ok::detail::partition_point(
+                keys, count, [&](const key_t& item) {
+                    if constexpr (or_equal)
+                        return (item <=> key) <= 0;
+                    else
+                        return (item <=> key) < 0;
+                });
+        }
+    }
+
+    /// Move count items from source to dest, which may overlap.
+    template <typename T>
+    static void relocate(T* dest, T* source, size_t count) noexcept
+    {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            ::memmove((void*)dest, (void*)source, count * sizeof(T));
+        } else if (dest < source) {
+            for (size_t i = 0; i < count; ++i) {
+                stdc::construct_at(dest + i, stdc::move(source[i]));
+                source[i].~T();
+            }
+        } else {
+            for (size_t i = count; i-- > 0;) {
+                stdc::construct_at(dest + i, stdc::move(source[i]));
+                source[i].~T();
+            }
+        }
+    }
+
+    template <typename key_arg_t>
+    static void replace_key(key_t& key, key_arg_t&& replacement) noexcept
+    {
+        key.~key_t();
+        stdc::construct_at(ok::addressof(key),
+                           stdc::forward<key_arg_t>(replacement));
+    }
+
+    [[nodiscard]] static size_t count_of(void* node, size_t level) noexcept
+    {
+        return level == 0 ? static_cast<leaf_t*>(node)->count
+                          : static_cast<internal_t*>(node)->count;
+    }
+
+    [[nodiscard]] static bool is_full(void* node, size_t level) noexcept
+    {
+        return count_of(node, level) ==
+               (level == 0 ? leaf_capacity : internal_capacity);
+    }
+
+    [[nodiscard]] leaf_t* allocate_leaf() OKAYLIB_NOEXCEPT
+    {
+        auto* const leaf =
+            static_cast<leaf_t*>(m.pool.allocate(*m.allocator));
+        if (leaf) [[likely]] {
+            leaf->next = nullptr;
+            leaf->count = 0;
+        }
+        return leaf;
+    }
+
+    [[nodiscard]] internal_t* allocate_internal() OKAYLIB_NOEXCEPT
+    {
+        auto* const internal =
+            static_cast<internal_t*>(m.pool.allocate(*m.allocator));
+        if (internal) [[likely]]
+            internal->count = 0;
+        return internal;
+    }
+
+    template <typename lookup_t>
+    [[nodiscard]] leaf_t* find_leaf(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        void* node = m.root;
+        for (size_t level = m.height; level > 0; --level) {
+            auto* const internal = static_cast<internal_t*>(node);
+            node = internal->children[count_less<true>(
+                internal->keys(), internal->count, key)];
+        }
+        return static_cast<leaf_t*>(node);
+    }
+
+    template <typename lookup_t>
+    [[nodiscard]] value_t* find(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        leaf_t* const leaf = this->find_leaf(key);
+        if (!leaf)
+            return nullptr;
+        const size_t index = count_less<false>(leaf->keys(), leaf->count, key);
+        if (index == leaf->count || (leaf->keys()[index] <=> key) != 0)
+            return nullptr;
+        return leaf->values() + index;
+    }
+
+    [[nodiscard]] position_t first_position() const noexcept
+    {
+        void* node = m.root;
+        for (size_t level = m.height; level > 0; --level)
+            node = static_cast<internal_t*>(node)->children[0];
+        return {static_cast<leaf_t*>(node), 0};
+    }
+
+    /// The position of the first item which is not less than key.
+    template <typename lookup_t>
+    [[nodiscard]] position_t
+    lower_bound_position(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        leaf_t* const leaf = this->find_leaf(key);
+        if (!leaf)
+            return {nullptr, 0};
+        const size_t index = count_less<false>(leaf->keys(), leaf->count, key);
+        // separators guarantee that everything in the next leaf is greater
+        if (index == leaf->count)
+            return {leaf->next, 0};
+        return {leaf, index};
+    }
+
+    template <bool is_const, typename lower_t, typename upper_t>
+    [[nodiscard]] cursor_t<is_const>
+    range_cursor(const lower_t& lower, const upper_t& upper) const
+        OKAYLIB_NOEXCEPT
+    {
+        position_t begin = this->lower_bound_position(lower);
+        const position_t end = this->lower_bound_position(upper);
+        // a range which is backwards is empty
+        if (begin.leaf && end.leaf &&
+            !(begin.leaf->keys()[begin.index] < end.leaf->keys()[end.index]))
+            begin = end;
+        return {begin, end};
+    }
+
+    /// Split the full child at index in two, putting the new node and the
+    /// key between them in parent, which must not be full. Returns false if
+    /// out of memory.
+    [[nodiscard]] bool split_child(internal_t* parent, size_t index,
+                                   size_t child_level) OKAYLIB_NOEXCEPT
+    {
+        void* sibling;
+        if (child_level == 0) {
+            auto* const leaf = static_cast<leaf_t*>(parent->children[index]);
+            leaf_t* const right = this->allocate_leaf();
+            if (!right) [[unlikely]]
+                return false;
+            const size_t half = leaf->count / 2;
+            right->count = leaf->count - half;
+            relocate(right->keys(), leaf->keys() + half, right->count);
+            relocate(right->values(), leaf->values() + half, right->count);
+            leaf->count = half;
+            right->next = leaf->next;
+            leaf->next = right;
+            this->insert_separator(parent, index, right->keys()[0]);
+            sibling = right;
+        } else {
+            auto* const internal =
+                static_cast<internal_t*>(parent->children[index]);
+            internal_t* const right = this->allocate_internal();
+            if (!right) [[unlikely]]
+                return false;
+            // the middle key moves up to the parent
+            const size_t middle = internal->count / 2;
+            right->count = internal->count - middle - 1;
+            relocate(right->keys(), internal->keys() + middle + 1,
+                     right->count);
+            ::memcpy(right->children, internal->children + middle + 1,
+                     (right->count + 1) * sizeof(void*));
+            internal->count = middle;
+            key_t& separator = internal->keys()[middle];
+            this->insert_separator(parent, index, stdc::move(separator));
+            separator.~key_t();
+            sibling = right;
+        }
+        parent->children[index + 1] = sibling;
+        return true;
+    }
+
+    /// Put a key at index in parent, making room for a child after it.
+    template <typename key_arg_t>
+    static void insert_separator(internal_t* parent, size_t index,
+                                 key_arg_t&& separator) noexcept
+    {
+        relocate(parent->keys() + index + 1, parent->keys() + index,
+                 parent->count - index);
+        ::memmove(parent->children + index + 2, parent->children + index + 1,
+                  (parent->count - index) * sizeof(void*));
+        stdc::construct_at(parent->keys() + index,
+                           stdc::forward<key_arg_t>(separator));
+        ++parent->count;
+    }
+
+    /// Remove the key at index in parent, and the child after it.
+    static void erase_separator(internal_t* parent, size_t index) noexcept
+    {
+        parent->keys()[index].~key_t();
+        relocate(parent->keys() + index, parent->keys() + index + 1,
+                 parent->count - index - 1);
+        ::memmove(parent->children + index + 1, parent->children + index + 2,
+                  (parent->count - index - 1) * sizeof(void*));
+        --parent->count;
+    }
+
+    /// Insert a key which is known not to be in the map. Full nodes are split
+    /// on the way down, so that there is always room in the parent for a
+    /// split. If allocation fails partway through, the tree is still valid.
+    template <typename key_arg_t, typename... args_t>
+    [[nodiscard]] res<value_t&, alloc::error>
+    insert_new(key_arg_t&& key, args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        if (!m.root) {
+            leaf_t* const leaf = this->allocate_leaf();
+            if (!leaf) [[unlikely]]
+                return alloc::error::oom;
+            m.root = leaf;
+        }
+        if (is_full(m.root, m.height)) {
+            internal_t* const root = this->allocate_internal();
+            if (!root) [[unlikely]]
+                return alloc::error::oom;
+            root->children[0] = m.root;
+            if (!this->split_child(root, 0, m.height)) [[unlikely]] {
+                m.pool.deallocate(root);
+                return alloc::error::oom;
+            }
+            m.root = root;
+            ++m.height;
+        }
+
+        void* node = m.root;
+        for (size_t level = m.height; level > 0; --level) {
+            auto* const parent = static_cast<internal_t*>(node);
+            size_t index = count_less<true>(parent->keys(), parent->count, key);
+            if (is_full(parent->children[index], level - 1)) {
+                if (!this->split_child(parent, index, level - 1)) [[unlikely]]
+                    return alloc::error::oom;
+                if ((parent->keys()[index] <=> key) <= 0)
+                    ++index;
+            }
+            node = parent->children[index];
+        }
+
+        auto* const leaf = static_cast<leaf_t*>(node);
+        const size_t index = count_less<false>(leaf->keys(), leaf->count, key);
+        relocate(leaf->keys() + index + 1, leaf->keys() + index,
+                 leaf->count - index);
+        relocate(leaf->values() + index + 1, leaf->values() + index,
+                 leaf->count - index);
+        stdc::construct_at(leaf->keys() + index, stdc::forward<key_arg_t>(key));
+        stdc::construct_at(leaf->values() + index,
+                           stdc::forward<args_t>(args)...);
+        ++leaf->count;
+        ++m.size;
+        return leaf->values()[index];
+    }
+
+    /// Give the child at index more than the minimum number of items, by
+    /// taking one from a sibling or by merging with one. Returns the index of
+    /// the child which now holds everything the child at index held.
+    size_t refill_child(internal_t* parent, size_t index,
+                        size_t child_level) noexcept
+    {
+        const size_t minimum = child_level == 0 ? leaf_min : internal_min;
+        if (index > 0 &&
+            count_of(parent->children[index - 1], child_level) > minimum) {
+            this->borrow_from_left(parent, index, child_level);
+            return index;
+        }
+        if (index < parent->count &&
+            count_of(parent->children[index + 1], child_level) > minimum) {
+            this->borrow_from_right(parent, index, child_level);
+            return index;
+        }
+        if (index > 0) {
+            this->merge_children(parent, index - 1, child_level);
+            return index - 1;
+        }
+        this->merge_children(parent, index, child_level);
+        return index;
+    }
+
+    void borrow_from_left(internal_t* parent, size_t index,
+                          size_t child_level) noexcept
+    {
+        key_t& separator = parent->keys()[index - 1];
+        if (child_level == 0) {
+            auto* const left =
+                static_cast<leaf_t*>(parent->children[index - 1]);
+            auto* const child = static_cast<leaf_t*>(parent->children[index]);
+            relocate(child->keys() + 1, child->keys(), child->count);
+            relocate(child->values() + 1, child->values(), child->count);
+            --left->count;
+            relocate(child->keys(), left->keys() + left->count, 1);
+            relocate(child->values(), left->values() + left->count, 1);
+            ++child->count;
+            replace_key(separator, child->keys()[0]);
+        } else {
+            auto* const left =
+                static_cast<internal_t*>(parent->children[index - 1]);
+            auto* const child =
+                static_cast<internal_t*>(parent->children[index]);
+            relocate(child->keys() + 1, child->keys(), child->count);
+            ::memmove(child->children + 1, child->children,
+                      (child->count + 1) * sizeof(void*));
+            // the separator comes down, and the left sibling's last key goes
+            // up in its place
+            stdc::construct_at(child->keys(), stdc::move(separator));
+            child->children[0] = left->children[left->count];
+            --left->count;
+            replace_key(separator, stdc::move(left->keys()[left->count]));
+            left->keys()[left->count].~key_t();
+            ++child->count;
+        }
+    }
+
+    void borrow_from_right(internal_t* parent, size_t index,
+                           size_t child_level) noexcept
+    {
+        key_t& separator = parent->keys()[index];
+        if (child_level == 0) {
+            auto* const child = static_cast<leaf_t*>(parent->children[index]);
+            auto* const right =
+                static_cast<leaf_t*>(parent->children[index + 1]);
+            relocate(child->keys() + child->count, right->keys(), 1);
+            relocate(child->values() + child->count, right->values(), 1);
+            ++child->count;
+            --right->count;
+            relocate(right->keys(), right->keys() + 1, right->count);
+            relocate(right->values(), right->values() + 1, right->count);
+            replace_key(separator, right->keys()[0]);
+        } else {
+            auto* const child =
+                static_cast<internal_t*>(parent->children[index]);
+            auto* const right =
+                static_cast<internal_t*>(parent->children[index + 1]);
+            stdc::construct_at(child->keys() + child->count,
+                               stdc::move(separator));
+            child->children[child->count + 1] = right->children[0];
+            ++child->count;
+            replace_key(separator, stdc::move(right->keys()[0]));
+            right->keys()[0].~key_t();
+            --right->count;
+            relocate(right->keys(), right->keys() + 1, right->count);
+            ::memmove(right->children, right->children + 1,
+                      (right->count + 1) * sizeof(void*));
+        }
+    }
+
+    /// Move everything in the child after index into the child at index.
+    void merge_children(internal_t* parent, size_t index,
+                        size_t child_level) noexcept
+    {
+        if (child_level == 0) {
+            auto* const left = static_cast<leaf_t*>(parent->children[index]);
+            auto* const right =
+                static_cast<leaf_t*>(parent->children[index + 1]);
+            relocate(left->keys() + left->count, right->keys(), right->count);
+            relocate(left->values() + left->count, right->values(),
+                     right->count);
+            left->count += right->count;
+            left->next = right->next;
+            m.pool.deallocate(right);
+        } else {
+            auto* const left =
+                static_cast<internal_t*>(parent->children[index]);
+            auto* const right =
+                static_cast<internal_t*>(parent->children[index + 1]);
+            stdc::construct_at(left->keys() + left->count,
+                               stdc::move(parent->keys()[index]));
+            relocate(left->keys() + left->count + 1, right->keys(),
+                     right->count);
+            ::memcpy(left->children + left->count + 1, right->children,
+                     (right->count + 1) * sizeof(void*));
+            left->count += right->count + 1;
+            m.pool.deallocate(right);
+        }
+        erase_separator(parent, index);
+    }
+
+    void destroy_subtree(void* node, size_t level) noexcept
+    {
+        if (level == 0) {
+            auto* const leaf = static_cast<leaf_t*>(node);
+            for (size_t i = 0; i < leaf->count; ++i) {
+                leaf->keys()[i].~key_t();
+                leaf->values()[i].~value_t();
+            }
+        } else {
+            auto* const internal = static_cast<internal_t*>(node);
+            for (size_t i = 0; i < internal->count; ++i)
+                internal->keys()[i].~key_t();
+            for (size_t i = 0; i <= internal->count; ++i)
+                this->destroy_subtree(internal->children[i], level - 1);
+        }
+        m.pool.deallocate(node);
+    }
+
+    void destroy() noexcept
+    {
+        if (!m.allocator)
+            return;
+        this->clear();
+        m.pool.release(*m.allocator);
+    }
+
+    /// Where load_sorted is up to on each level of the tree.
+    struct loader_t
+    {
+        size_t num_items;
+        size_t height;
+        size_t nodes_on_level[max_height + 1];
+        size_t num_finished[max_height + 1];
+        // the internal node being filled on each level
+        internal_t* filling[max_height + 1];
+        // the smallest key under the node being filled on each level
+        const key_t* lowest[max_height + 1];
+
+        /// How many items or children the nth node on a level gets. They
+        /// are spread evenly, so every node is at least half full.
+        [[nodiscard]] size_t share_of(size_t level, size_t nth) const noexcept
+        {
+            const size_t total =
+                level == 0 ? num_items : nodes_on_level[level - 1];
+            const size_t nodes = nodes_on_level[level];
+            return total / nodes + (nth < total % nodes);
+        }
+    };
+
+    /// Hand a node which load_sorted has filled to its parent, and finish the
+    /// parent too if that was its last child.
+    void finish_node(loader_t& loader, size_t level, void* node,
+                     const key_t& lowest_key) OKAYLIB_NOEXCEPT
+    {
+        ++loader.num_finished[level];
+        if (level == loader.height) {
+            m.root = node;
+            return;
+        }
+        const size_t parent_level = level + 1;
+        internal_t*& parent = loader.filling[parent_level];
+        if (!parent) {
+            // the pool has been reserved, so this cannot fail
+            parent = this->allocate_internal();
+            parent->children[0] = node;
+            loader.lowest[parent_level] = ok::addressof(lowest_key);
+        } else {
+            stdc::construct_at(parent->keys() + parent->count, lowest_key);
+            parent->children[++parent->count] = node;
+        }
+        if (parent->count + 1 ==
+            loader.share_of(parent_level,
+                            loader.num_finished[parent_level])) {
+            internal_t* const finished = parent;
+            parent = nullptr;
+            this->finish_node(loader, parent_level, finished,
+                              *loader.lowest[parent_level]);
+        }
+    }
+
+    /// Fill an empty map from num_items (key, value) tuples in strictly
+    /// increasing order of key, in one pass and one allocation. The number of
+    /// nodes on every level is worked out up front.
+    template <typename iterator_t>
+    [[nodiscard]] alloc::error load_sorted(iterator_t& iterator,
+                                           size_t num_items) OKAYLIB_NOEXCEPT
+    {
+        if (num_items == 0)
+            return alloc::error::success;
+
+        loader_t loader{.num_items = num_items, .height = 0};
+        loader.nodes_on_level[0] =
+            (num_items + leaf_capacity - 1) / leaf_capacity;
+        size_t total_nodes = loader.nodes_on_level[0];
+        while (loader.nodes_on_level[loader.height] > 1) {
+            const size_t children = loader.nodes_on_level[loader.height];
+            ++loader.height;
+            loader.nodes_on_level[loader.height] =
+                (children + internal_capacity) / (internal_capacity + 1);
+            total_nodes += loader.nodes_on_level[loader.height];
+        }
+        for (size_t level = 0; level <= loader.height; ++level) {
+            loader.num_finished[level] = 0;
+            loader.filling[level] = nullptr;
+        }
+        if (auto status = m.pool.reserve(*m.allocator, total_nodes);
+            !ok::is_success(status)) [[unlikely]]
+            return status;
+
+        const key_t* previous_key = nullptr;
+        leaf_t* previous_leaf = nullptr;
+        for (size_t nth = 0; nth < loader.nodes_on_level[0]; ++nth) {
+            leaf_t* const leaf = this->allocate_leaf();
+            const size_t share = loader.share_of(0, nth);
+            for (size_t i = 0; i < share; ++i) {
+                auto item = iterator.next();
+                if (!item) [[unlikely]] {
+                    __ok_abort("Iterator given to btree_map::from_sorted "
+                               "ended before reaching its size.");
+                }
+                stdc::construct_at(
+                    leaf->keys() + i,
+                    ok::get<0>(stdc::move(item.ref_unchecked())));
+                if (previous_key && !(*previous_key < leaf->keys()[i]))
+                    [[unlikely]] {
+                    __ok_abort("Keys given to btree_map::from_sorted are not "
+                               "in strictly increasing order.");
+                }
+                stdc::construct_at(
+                    leaf->values() + i,
+                    ok::get<1>(stdc::move(item.ref_unchecked())));
+                leaf->count = i + 1;
+                previous_key = leaf->keys() + i;
+            }
+            if (previous_leaf)
+                previous_leaf->next = leaf;
+            previous_leaf = leaf;
+            m.size += share;
+            this->finish_node(loader, 0, leaf, leaf->keys()[0]);
+        }
+        m.height = loader.height;
+        return alloc::error::success;
+    }
+
+  public:
+    using key_type = key_t;
+    using mapped_type = value_t;
+
+    template <typename, typename>
+    friend struct btree_map::detail::from_sorted_t;
+
+    explicit btree_map_t(backing_allocator_t& allocator) OKAYLIB_NOEXCEPT
+        : m(members_t{
+              .root = nullptr,
+              .height = 0,
+              .size = 0,
+              .pool = {},
+              .allocator = ok::addressof(allocator),
+          })
+    {
+    }
+
+    btree_map_t(btree_map_t&& other) OKAYLIB_NOEXCEPT : m(stdc::move(other.m))
+    {
+        other.m.allocator = nullptr;
+    }
+
+    btree_map_t& operator=(btree_map_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = stdc::move(other.m);
+        other.m.allocator = nullptr;
+        return *this;
+    }
+
+    btree_map_t(const btree_map_t&) = delete;
+    btree_map_t& operator=(const btree_map_t&) = delete;
+
+    ~btree_map_t() { this->destroy(); }
+
+    [[nodiscard]] constexpr size_t size() const noexcept { return m.size; }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return m.size == 0;
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] bool contains(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        return this->find(key) != nullptr;
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] opt<value_t&> get(const lookup_t& key) & OKAYLIB_NOEXCEPT
+    {
+        value_t* const value = this->find(key);
+        if (!value)
+            return nullopt;
+        return *value;
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] opt<const value_t&>
+    get(const lookup_t& key) const& OKAYLIB_NOEXCEPT
+    {
+        const value_t* const value = this->find(key);
+        if (!value)
+            return nullopt;
+        return *value;
+    }
+
+    /// Get the value of a key, constructing it from args if the key is not in
+    /// the map yet. If the key is already there, args are unused.
+    template <typename key_arg_t, typename... args_t>
+        requires(ok::detail::default_searchable_c<key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&> &&
+                 stdc::is_constructible_v<value_t, args_t && ...>)
+    [[nodiscard]] res<value_t&, alloc::error>
+    get_or_insert(key_arg_t&& key, args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        if (value_t* const value = this->find(key))
+            return *value;
+        return this->insert_new(stdc::forward<key_arg_t>(key),
+                                stdc::forward<args_t>(args)...);
+    }
+
+    /// Put a value in the map, replacing any value the key already had.
+    template <typename key_arg_t, typename value_arg_t>
+        requires(ok::detail::default_searchable_c<key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&> &&
+                 stdc::is_constructible_v<value_t, value_arg_t &&> &&
+                 stdc::is_assignable_v<value_t&, value_arg_t &&>)
+    [[nodiscard]] res<value_t&, alloc::error>
+    insert(key_arg_t&& key, value_arg_t&& value) OKAYLIB_NOEXCEPT
+    {
+        if (value_t* const existing = this->find(key)) {
+            *existing = stdc::forward<value_arg_t>(value);
+            return *existing;
+        }
+        return this->insert_new(stdc::forward<key_arg_t>(key),
+                                stdc::forward<value_arg_t>(value));
+    }
+
+    /// Returns whether the key was in the map. Nodes which would become less
+    /// than half full are topped up on the way down, so removal never has to
+    /// go back up the tree.
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    bool remove(const lookup_t& key) OKAYLIB_NOEXCEPT
+    {
+        if (!m.root)
+            return false;
+        void* node = m.root;
+        for (size_t level = m.height; level > 0; --level) {
+            auto* const parent = static_cast<internal_t*>(node);
+            size_t index = count_less<true>(parent->keys(), parent->count, key);
+            const size_t minimum = level == 1 ? leaf_min : internal_min;
+            if (count_of(parent->children[index], level - 1) <= minimum)
+                index = this->refill_child(parent, index, level - 1);
+            node = parent->children[index];
+            // a merge can take the root's last key, leaving one child
+            if (parent == m.root && parent->count == 0) {
+                m.root = node;
+                --m.height;
+                m.pool.deallocate(parent);
+            }
+        }
+
+        auto* const leaf = static_cast<leaf_t*>(node);
+        const size_t index = count_less<false>(leaf->keys(), leaf->count, key);
+        if (index == leaf->count || (leaf->keys()[index] <=> key) != 0)
+            return false;
+        leaf->keys()[index].~key_t();
+        leaf->values()[index].~value_t();
+        relocate(leaf->keys() + index, leaf->keys() + index + 1,
+                 leaf->count - index - 1);
+        relocate(leaf->values() + index, leaf->values() + index + 1,
+                 leaf->count - index - 1);
+        --leaf->count;
+        --m.size;
+        if (m.size == 0) {
+            m.pool.deallocate(leaf);
+            m.root = nullptr;
+        }
+        return true;
+    }
+
+    /// Remove every item. The memory of the nodes is kept for reuse.
+    void clear() noexcept
+    {
+        if (m.root)
+            this->destroy_subtree(m.root, m.height);
+        m.root = nullptr;
+        m.height = 0;
+        m.size = 0;
+    }
+
+    /// Iterate over (key, value) tuples in increasing order of key.
+    [[nodiscard]] constexpr auto iter() & OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<btree_map_t, cursor_t<false>>{
+            *this, cursor_t<false>{this->first_position(), {nullptr, 0}}};
+    }
+
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<const btree_map_t, cursor_t<true>>{
+            *this, cursor_t<true>{this->first_position(), {nullptr, 0}}};
+    }
+
+    constexpr auto iter() const&& = delete;
+
+    /// Iterate over the items with keys which are not less than lower and
+    /// are less than upper, in increasing order.
+    template <typename lower_t, typename upper_t>
+        requires(ok::detail::default_searchable_c<key_t, lower_t> &&
+                 ok::detail::default_searchable_c<key_t, upper_t>)
+    [[nodiscard]] constexpr auto
+    iter_between(const lower_t& lower, const upper_t& upper) & OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<btree_map_t, cursor_t<false>>{
+            *this, this->template range_cursor<false>(lower, upper)};
+    }
+
+    template <typename lower_t, typename upper_t>
+        requires(ok::detail::default_searchable_c<key_t, lower_t> &&
+                 ok::detail::default_searchable_c<key_t, upper_t>)
+    [[nodiscard]] constexpr auto
+    iter_between(const lower_t& lower,
+                 const upper_t& upper) const& OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<const btree_map_t, cursor_t<true>>{
+            *this, this->template range_cursor<true>(lower, upper)};
+    }
+
+    template <typename lower_t, typename upper_t>
+    constexpr auto iter_between(const lower_t&, const upper_t&) const&& =
+        delete;
+
+    /// Iterate over the items with keys which are not less than lower, in
+    /// increasing order.
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr auto
+    iter_from(const lookup_t& lower) & OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<btree_map_t, cursor_t<false>>{
+            *this, cursor_t<false>{this->lower_bound_position(lower),
+                                   {nullptr, 0}}};
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr auto
+    iter_from(const lookup_t& lower) const& OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<const btree_map_t, cursor_t<true>>{
+            *this, cursor_t<true>{this->lower_bound_position(lower),
+                                  {nullptr, 0}}};
+    }
+
+    template <typename lookup_t>
+    constexpr auto iter_from(const lookup_t&) const&& = delete;
+};
+
+namespace btree_map {
+namespace detail {
+template <typename key_t, typename value_t> struct from_sorted_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::btree_map_t<key_t, value_t,
+                        ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t, iterator_c input_iterator_t>
+        requires ok::detail::sized_iterator_c<input_iterator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               input_iterator_t&& iterator) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator,
+                        stdc::forward<input_iterator_t>(iterator));
+    }
+
+    template <allocator_c backing_allocator_t, iterator_c input_iterator_t>
+        requires ok::detail::sized_iterator_c<input_iterator_t>
+    [[nodiscard]] alloc::error
+    make_into_uninit(ok::btree_map_t<key_t, value_t, backing_allocator_t>&
+                         output,
+                     backing_allocator_t& allocator,
+                     input_iterator_t&& iterator) const OKAYLIB_NOEXCEPT
+    {
+        ok::btree_map_t<key_t, value_t, backing_allocator_t> map(allocator);
+        auto status = map.load_sorted(iterator, iterator.size());
+        if (!ok::is_success(status)) [[unlikely]]
+            return status;
+        stdc::construct_at(ok::addressof(output), stdc::move(map));
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Make a map from a sized iterator of (key, value) tuples which are in
+/// strictly increasing order of key, in linear time and with one allocation.
+/// Aborts if the keys are out of order.
+/// btree_map::from_sorted<key_t, value_t>(allocator, iterator)
+template <typename key_t, typename value_t>
+inline constexpr detail::from_sorted_t<key_t, value_t> from_sorted;
+} // namespace btree_map
+
+template <typename key_t, typename value_t, typename backing_allocator_t,
+          size_t target_node_bytes>
+struct is_trivially_relocatable<
+    btree_map_t<key_t, value_t, backing_allocator_t, target_node_bytes>>
+    : stdc::true_type
+{};
+} // namespace ok
+
+#endif
@@ -0,0 +1,736 @@
+#ifndef __OKAYLIB_CONTAINERS_CONCURRENT_HASHMAP_H__
+#define __OKAYLIB_CONTAINERS_CONCURRENT_HASHMAP_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/containers/atomic_bit_array.h"
+#include "okay/detail/no_unique_addr.h"
+#include "okay/error.h"
+#include "okay/hash.h"
+#include "okay/math/rounding.h"
+#include "okay/opt.h"
+#include "okay/platform/atomic.h"
+#include "okay/smart_pointers/arc.h"
+
+namespace ok {
+
+namespace concurrent_hashmap {
+struct empty_options_t
+{
+    // rounded up to a power of two. writers only block each other when they
+    // write to the same shard
+    size_t num_shards = 64;
+    // how many reader_t handles can exist at once
+    size_t max_readers = 64;
+};
+
+namespace detail {
+template <typename key_t, typename value_t, typename hasher_t> struct empty_t;
+
+inline constexpr size_t cache_line_size = 64;
+// a shard tries to free what it has retired every time it has this many
+inline constexpr size_t reclaim_threshold = 64;
+
+/// A counter on a cache line of its own, so that readers writing their own
+/// epoch never touch a line another thread is reading.
+struct alignas(cache_line_size) epoch_line_t
+{
+    ok::atomic_t<uint64_t> epoch;
+};
+
+/// Something which has been unlinked from a map, but which readers who
+/// started before the unlink may still be looking at.
+struct retired_t
+{
+    enum class kind_t : uint8_t
+    {
+        node,
+        table,
+    };
+
+    retired_t* next;
+    // the global epoch when this was unlinked
+    uint64_t epoch;
+    kind_t kind;
+};
+} // namespace detail
+} // namespace concurrent_hashmap
+
+/// A hash map for lookup tables which are read by many threads and written to
+/// rarely. Values are stored in ro_arc_t, so lookups can hand out shared
+/// ownership of them.
+///
+/// Keys are split between shards by hash. Each shard is an open addressing
+/// table of atomic pointers to immutable nodes, and has a lock which writers
+/// take. Readers take no locks and never write to memory which another thread
+/// reads: they find nodes with plain atomic loads and announce which epoch
+/// they started reading in on a cache line of their own. Unlinked nodes and
+/// outgrown tables are only freed once every reader which could have seen
+/// them has finished (epoch based reclamation).
+///
+/// Reading happens through reader_t handles, which each thread gets once from
+/// reader() and keeps. Moving or destroying the map must not happen while any
+/// other thread is using it.
+template <typename key_t, typename value_t,
+          allocator_c backing_allocator_t = ok::allocator_t,
+          typename hasher_t = ok::hasher_t>
+class concurrent_hashmap_t
+{
+  public:
+    using arc_t = ro_arc_t<value_t, backing_allocator_t>;
+
+  private:
+    using epoch_line_t = concurrent_hashmap::detail::epoch_line_t;
+    using retired_t = concurrent_hashmap::detail::retired_t;
+    static constexpr size_t cache_line_size =
+        concurrent_hashmap::detail::cache_line_size;
+
+    struct node_t : retired_t
+    {
+        uint64_t hash;
+        key_t key;
+        arc_t value;
+
+        template <typename key_arg_t>
+        node_t(uint64_t h, key_arg_t&& key_arg, arc_t&& arc) OKAYLIB_NOEXCEPT
+            : retired_t{nullptr, 0, retired_t::kind_t::node},
+              hash(h),
+              key(stdc::forward<key_arg_t>(key_arg)),
+              value(stdc::move(arc))
+        {
+        }
+    };
+
+    /// A table's slots come right after it in the same allocation. A slot is
+    /// null if it has never been used, so a probe can stop there.
+    struct table_t : retired_t
+    {
+        size_t capacity;
+
+        [[nodiscard]] ok::atomic_t<node_t*>* slots() noexcept
+        {
+            return reinterpret_cast<ok::atomic_t<node_t*>*>(this + 1);
+        }
+    };
+
+    struct alignas(cache_line_size) shard_t
+    {
+        // the only thing readers look at
+        ok::atomic_t<table_t*> table;
+
+        alignas(cache_line_size) ok::atomic_t<uint32_t> lock;
+        ok::atomic_t<size_t> size;
+        // full slots plus removed ones
+        size_t used;
+        retired_t* retired;
+        size_t num_retired;
+    };
+
+    struct members_t
+    {
+        // the allocation the epochs and shards are in, which the allocator
+        // may not have aligned to a cache line
+        void* block;
+        // the global epoch, then one for each reader
+        epoch_line_t* epochs;
+        shard_t* shards;
+        size_t shard_mask;
+        size_t max_readers;
+        allocated_atomic_bit_array_t<backing_allocator_t> claimed_readers;
+        backing_allocator_t* allocator;
+        OKAYLIB_NO_UNIQUE_ADDR hasher_t hasher;
+    } m;
+
+    /// Marks a removed slot. Never dereferenced.
+    [[nodiscard]] static node_t* tombstone() noexcept
+    {
+        return reinterpret_cast<node_t*>(uintptr_t(1));
+    }
+
+    [[nodiscard]] ok::atomic_t<uint64_t>& global_epoch() const noexcept
+    {
+        return m.epochs[0].epoch;
+    }
+
+    [[nodiscard]] shard_t& shard_for(uint64_t hash) const noexcept
+    {
+        // the table index uses the low bits
+        return m.shards[(hash >> 40) & m.shard_mask];
+    }
+
+    template <typename lookup_t>
+    [[nodiscard]] static node_t* find_in(table_t* table, const lookup_t& key,
+                                         uint64_t hash) OKAYLIB_NOEXCEPT
+    {
+        ok::atomic_t<node_t*>* const slots = table->slots();
+        const size_t mask = table->capacity - 1;
+        // linear probing: tables are at most half full, and neighbouring
+        // slots share a cache line
+        for (size_t index = hash & mask;; index = (index + 1) & mask) {
+            node_t* const node = slots[index].load(memory_order::acquire);
+            if (!node)
+                return nullptr;
+            if (node != tombstone() && node->hash == hash && node->key == key)
+                return node;
+        }
+    }
+
+    /// Index of the first unused or removed slot along a hash's probe.
+    [[nodiscard]] static size_t find_free_slot(table_t* table,
+                                               uint64_t hash) noexcept
+    {
+        ok::atomic_t<node_t*>* const slots = table->slots();
+        const size_t mask = table->capacity - 1;
+        size_t index = hash & mask;
+        for (;; index = (index + 1) & mask) {
+            node_t* const node = slots[index].load(memory_order::relaxed);
+            if (!node || node == tombstone())
+                return index;
+        }
+    }
+
+    [[nodiscard]] table_t* allocate_table(size_t capacity) OKAYLIB_NOEXCEPT
+    {
+        auto allocation = m.allocator->allocate(alloc::request_t{
+            .num_bytes =
+                sizeof(table_t) + capacity * sizeof(ok::atomic_t<node_t*>),
+            .alignment = alignof(table_t),
+            .leave_nonzeroed = true,
+        });
+        if (!allocation.is_success()) [[unlikely]]
+            return nullptr;
+        auto* table = reinterpret_cast<table_t*>(
+            allocation.unwrap().unchecked_address_of_first_item());
+        stdc::construct_at(table);
+        table->kind = retired_t::kind_t::table;
+        table->capacity = capacity;
+        for (size_t i = 0; i < capacity; ++i) {
+            stdc::construct_at(table->slots() + i);
+            table->slots()[i].store(nullptr, memory_order::relaxed);
+        }
+        return table;
+    }
+
+    void free_node(node_t* node) noexcept
+    {
+        node->~node_t();
+        m.allocator->deallocate(node);
+    }
+
+    void free_retired(retired_t* retired) noexcept
+    {
+        if (retired->kind == retired_t::kind_t::node)
+            this->free_node(static_cast<node_t*>(retired));
+        else
+            m.allocator->deallocate(retired);
+    }
+
+    /// The earliest epoch any reader is still reading in.
+    [[nodiscard]] uint64_t oldest_pinned_epoch() const noexcept
+    {
+        uint64_t oldest = ~uint64_t(0);
+        for (size_t i = 0; i < m.max_readers; ++i) {
+            const uint64_t epoch = m.epochs[i + 1].epoch.load();
+            if (epoch != 0 && epoch < oldest)
+                oldest = epoch;
+        }
+        return oldest;
+    }
+
+    /// Free everything in a shard's retired list which no reader can be
+    /// looking at anymore. The shard must be locked.
+    void reclaim(shard_t& shard) noexcept
+    {
+        // pairs with the fence in reader_t::pin(). the unlinks are stores and
+        // reading the epochs is loads, which only a full fence keeps in order.
+        // with it, either a reader's epoch is seen here or the reader sees
+        // the unlink
+        ok::atomic_thread_fence(memory_order::seq_cst);
+        const uint64_t oldest = this->oldest_pinned_epoch();
+        retired_t** link = &shard.retired;
+        while (retired_t* retired = *link) {
+            // readers pinned at the epoch the unlink happened in, or before,
+            // may have loaded the pointer
+            if (retired->epoch < oldest) {
+                *link = retired->next;
+                --shard.num_retired;
+                this->free_retired(retired);
+            } else {
+                link = &retired->next;
+            }
+        }
+    }
+
+    /// Hand something which was just unlinked over to be freed once no reader
+    /// can see it. The shard must be locked.
+    void retire(shard_t& shard, retired_t* retired) noexcept
+    {
+        // readers who pin after this increment cannot find the thing anymore
+        retired->epoch = this->global_epoch().fetch_add(1);
+        retired->next = shard.retired;
+        shard.retired = retired;
+        using concurrent_hashmap::detail::reclaim_threshold;
+        if (++shard.num_retired >= reclaim_threshold)
+            this->reclaim(shard);
+    }
+
+    void lock(shard_t& shard) noexcept
+    {
+        while (shard.lock.exchange(1, memory_order::acquire) != 0) {
+            while (shard.lock.load(memory_order::relaxed) != 0)
+                ok::spin_loop_pause();
+        }
+    }
+
+    void unlock(shard_t& shard) noexcept
+    {
+        shard.lock.store(0, memory_order::release);
+    }
+
+    /// Make sure there is room for one more item in the shard's table, by
+    /// copying its nodes into a new table if it is more than half used. The
+    /// shard must be locked.
+    [[nodiscard]] status<alloc::error>
+    make_room(shard_t& shard) OKAYLIB_NOEXCEPT
+    {
+        table_t* const old = shard.table.load(memory_order::relaxed);
+        if (old && (shard.used + 1) * 2 <= old->capacity)
+            return alloc::error::success;
+
+        const size_t size = shard.size.load(memory_order::relaxed);
+        size_t capacity = 16;
+        // afterwards the table is at most a quarter full, so it does not need
+        // to grow again immediately
+        while (capacity < (size + 1) * 4)
+            capacity *= 2;
+        table_t* const table = this->allocate_table(capacity);
+        if (!table) [[unlikely]]
+            return alloc::error::oom;
+
+        if (old) {
+            for (size_t i = 0; i < old->capacity; ++i) {
+                node_t* const node =
+                    old->slots()[i].load(memory_order::relaxed);
+                if (!node || node == tombstone())
+                    continue;
+                table->slots()[find_free_slot(table, node->hash)].store(
+                    node, memory_order::relaxed);
+            }
+        }
+        // readers who load the new table see all of its slots
+        shard.table.store(table, memory_order::release);
+        shard.used = size;
+        if (old)
+            this->retire(shard, old);
+        return alloc::error::success;
+    }
+
+    void destroy() noexcept
+    {
+        if (!m.block)
+            return;
+        for (size_t i = 0; i <= m.shard_mask; ++i) {
+            shard_t& shard = m.shards[i];
+            while (retired_t* retired = shard.retired) {
+                shard.retired = retired->next;
+                this->free_retired(retired);
+            }
+            table_t* const table = shard.table.load(memory_order::relaxed);
+            if (!table)
+                continue;
+            for (size_t j = 0; j < table->capacity; ++j) {
+                node_t* const node =
+                    table->slots()[j].load(memory_order::relaxed);
+                if (node && node != tombstone())
+                    this->free_node(node);
+            }
+            m.allocator->deallocate(table);
+        }
+        m.allocator->deallocate(m.block);
+    }
+
+  public:
+    friend struct concurrent_hashmap::detail::empty_t<key_t, value_t,
+                                                      hasher_t>;
+
+    /// A thread's way of reading from the map. Each thread which reads should
+    /// get one from reader() and keep it. It must not outlive the map.
+    class reader_t
+    {
+        friend class concurrent_hashmap_t;
+
+        const concurrent_hashmap_t* m_map;
+        size_t m_index;
+        // how many lookups are in progress, so that a visitor can do more
+        // lookups with the same reader
+        mutable size_t m_pin_depth = 0;
+
+        constexpr reader_t(const concurrent_hashmap_t& map,
+                           size_t index) noexcept
+            : m_map(ok::addressof(map)), m_index(index)
+        {
+        }
+
+        [[nodiscard]] ok::atomic_t<uint64_t>& record() const noexcept
+        {
+            return m_map->m.epochs[m_index + 1].epoch;
+        }
+
+        /// Announce that this reader may be looking at anything reachable
+        /// from the map right now. Nested pins keep the outermost epoch.
+        void pin() const noexcept
+        {
+            if (m_pin_depth++ != 0)
+                return;
+            // acquire: if this sees the epoch a writer bumped after unlinking
+            // something, then it also sees the unlink
+            record().store(m_map->global_epoch().load(memory_order::acquire),
+                           memory_order::relaxed);
+            // nothing may be read from the map until the epoch is visible to
+            // writers. that is a store followed by loads, which only a full
+            // fence keeps in order. pairs with the fence in reclaim()
+            ok::atomic_thread_fence(memory_order::seq_cst);
+        }
+
+        void unpin() const noexcept
+        {
+            __ok_internal_assert(m_pin_depth != 0);
+            if (--m_pin_depth == 0)
+                record().store(0, memory_order::release);
+        }
+
+        template <typename lookup_t>
+        [[nodiscard]] const node_t* find(const lookup_t& key,
+                                         uint64_t hash) const OKAYLIB_NOEXCEPT
+        {
+            table_t* const table =
+                m_map->shard_for(hash).table.load(memory_order::acquire);
+            if (!table)
+                return nullptr;
+            return find_in(table, key, hash);
+        }
+
+      public:
+        reader_t(const reader_t&) = delete;
+        reader_t& operator=(const reader_t&) = delete;
+
+        constexpr reader_t(reader_t&& other) noexcept
+            : m_map(other.m_map), m_index(other.m_index)
+        {
+            other.m_map = nullptr;
+        }
+
+        reader_t& operator=(reader_t&&) = delete;
+
+        ~reader_t()
+        {
+            if (m_map) {
+                const_cast<concurrent_hashmap_t*>(m_map)
+                    ->m.claimed_readers.test_and_clear(m_index,
+                                                       memory_order::release);
+            }
+        }
+
+        template <typename lookup_t>
+            requires hash_lookup_c<hasher_t, key_t, lookup_t>
+        [[nodiscard]] bool contains(const lookup_t& key) const OKAYLIB_NOEXCEPT
+        {
+            this->pin();
+            const bool found = this->find(key, m_map->m.hasher(key));
+            this->unpin();
+            return found;
+        }
+
+        /// Get shared ownership of the value of a key. Unlike the rest of the
+        /// lookup, this writes to the value's reference count.
+        template <typename lookup_t>
+            requires hash_lookup_c<hasher_t, key_t, lookup_t>
+        [[nodiscard]] opt<arc_t> get(const lookup_t& key) const OKAYLIB_NOEXCEPT
+        {
+            this->pin();
+            const node_t* const node = this->find(key, m_map->m.hasher(key));
+            opt<arc_t> out;
+            if (node)
+                out = node->value.duplicate();
+            this->unpin();
+            return out;
+        }
+
+        /// Call visitor with a const reference to the value of a key, without
+        /// writing anything shared. The value stays alive until visitor
+        /// returns, even if the key is removed meanwhile. The visitor may do
+        /// more lookups with this reader. Returns whether the key was found.
+        template <typename lookup_t, typename visitor_t>
+            requires(hash_lookup_c<hasher_t, key_t, lookup_t> &&
+                     is_std_invocable_c<visitor_t&&, const value_t&>)
+        bool visit(const lookup_t& key,
+                   visitor_t&& visitor) const OKAYLIB_NOEXCEPT
+        {
+            this->pin();
+            const node_t* const node = this->find(key, m_map->m.hasher(key));
+            if (node)
+                stdc::forward<visitor_t>(visitor)(node->value.deref());
+            this->unpin();
+            return node != nullptr;
+        }
+    };
+
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    concurrent_hashmap_t(members_t&& members) noexcept
+        : m(stdc::move(members))
+    {
+    }
+
+    /// Not thread safe.
+    concurrent_hashmap_t(concurrent_hashmap_t&& other) noexcept
+        : m(stdc::move(other.m))
+    {
+        other.m.block = nullptr;
+    }
+
+    concurrent_hashmap_t& operator=(concurrent_hashmap_t&&) = delete;
+    concurrent_hashmap_t(const concurrent_hashmap_t&) = delete;
+    concurrent_hashmap_t& operator=(const concurrent_hashmap_t&) = delete;
+
+    ~concurrent_hashmap_t() { this->destroy(); }
+
+    /// Get a handle for reading, or null if max_readers of them exist already.
+    [[nodiscard]] opt<reader_t> reader() const OKAYLIB_NOEXCEPT
+    {
+        auto& claimed =
+            const_cast<concurrent_hashmap_t*>(this)->m.claimed_readers;
+        const opt<size_t> index = claimed.find_and_claim_first_unset(
+            0, memory_order::acquire);
+        if (!index)
+            return nullopt;
+        return reader_t(*this, index.ref_unchecked());
+    }
+
+    /// The number of items. Only exact if no writes are happening at the same
+    /// time.
+    [[nodiscard]] size_t size() const noexcept
+    {
+        size_t total = 0;
+        for (size_t i = 0; i <= m.shard_mask; ++i)
+            total += m.shards[i].size.load(memory_order::relaxed);
+        return total;
+    }
+
+    /// Put an already shared value in the map, replacing the value the key
+    /// had if any. Readers still holding the old value keep it alive. If
+    /// allocation fails, the map is unchanged and the arc is not moved from,
+    /// so the caller still owns it.
+    template <typename key_arg_t>
+        requires(hash_lookup_c<hasher_t, key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&>)
+    [[nodiscard]] status<alloc::error>
+    insert_arc(key_arg_t&& key, arc_t&& value) OKAYLIB_NOEXCEPT
+    {
+        const uint64_t hash = m.hasher(key);
+        auto allocation = m.allocator->allocate(alloc::request_t{
+            .num_bytes = sizeof(node_t),
+            .alignment = alignof(node_t),
+            .leave_nonzeroed = true,
+        });
+        if (!allocation.is_success()) [[unlikely]]
+            return allocation.status();
+        auto* const node = reinterpret_cast<node_t*>(
+            allocation.unwrap().unchecked_address_of_first_item());
+
+        shard_t& shard = this->shard_for(hash);
+        this->lock(shard);
+        table_t* table = shard.table.load(memory_order::relaxed);
+        if (node_t* const old = table ? find_in(table, key, hash) : nullptr) {
+            stdc::construct_at(node, hash, stdc::forward<key_arg_t>(key),
+                               stdc::move(value));
+            const size_t index = find_index_of(table, old);
+            table->slots()[index].store(node, memory_order::release);
+            this->retire(shard, old);
+            this->unlock(shard);
+            return alloc::error::success;
+        }
+
+        if (auto status = this->make_room(shard); !status.is_success())
+            [[unlikely]] {
+            this->unlock(shard);
+            m.allocator->deallocate(node);
+            return status;
+        }
+        stdc::construct_at(node, hash, stdc::forward<key_arg_t>(key),
+                           stdc::move(value));
+        table = shard.table.load(memory_order::relaxed);
+        ok::atomic_t<node_t*>& slot =
+            table->slots()[find_free_slot(table, hash)];
+        shard.used += slot.load(memory_order::relaxed) == nullptr;
+        slot.store(node, memory_order::release);
+        shard.size.store(shard.size.load(memory_order::relaxed) + 1,
+                         memory_order::relaxed);
+        this->unlock(shard);
+        return alloc::error::success;
+    }
+
+    /// Make a new shared value from args and put it in the map, replacing the
+    /// value the key had if any.
+    template <typename key_arg_t, typename... args_t>
+        requires(hash_lookup_c<hasher_t, key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&> &&
+                 stdc::is_constructible_v<value_t, args_t && ...>)
+    [[nodiscard]] status<alloc::error>
+    insert(key_arg_t&& key, args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        status<alloc::error> status = alloc::error::success;
+        auto unique =
+            unique_rw_arc_t<value_t, backing_allocator_t>::make::with(
+                status, *m.allocator, stdc::forward<args_t>(args)...);
+        if (!status.is_success()) [[unlikely]]
+            return status;
+        return this->insert_arc(stdc::forward<key_arg_t>(key),
+                                unique.demote_to_readonly());
+    }
+
+    /// Returns whether the key was in the map. Readers still looking at the
+    /// value keep it alive.
+    template <typename lookup_t>
+        requires hash_lookup_c<hasher_t, key_t, lookup_t>
+    bool remove(const lookup_t& key) OKAYLIB_NOEXCEPT
+    {
+        const uint64_t hash = m.hasher(key);
+        shard_t& shard = this->shard_for(hash);
+        this->lock(shard);
+        table_t* const table = shard.table.load(memory_order::relaxed);
+        node_t* const node = table ? find_in(table, key, hash) : nullptr;
+        if (node) {
+            // the slot cannot become empty: probes for other keys may need to
+            // go past it
+            table->slots()[find_index_of(table, node)].store(
+                tombstone(), memory_order::release);
+            shard.size.store(shard.size.load(memory_order::relaxed) - 1,
+                             memory_order::relaxed);
+            this->retire(shard, node);
+        }
+        this->unlock(shard);
+        return node != nullptr;
+    }
+
+    /// Free whatever has been removed and is no longer visible to any reader,
+    /// instead of waiting for enough to build up.
+    void reclaim_now() noexcept
+    {
+        for (size_t i = 0; i <= m.shard_mask; ++i) {
+            this->lock(m.shards[i]);
+            this->reclaim(m.shards[i]);
+            this->unlock(m.shards[i]);
+        }
+    }
+
+  private:
+    [[nodiscard]] static size_t find_index_of(table_t* table,
+                                              const node_t* node) noexcept
+    {
+        const size_t mask = table->capacity - 1;
+        size_t index = node->hash & mask;
+        while (table->slots()[index].load(memory_order::relaxed) != node)
+            index = (index + 1) & mask;
+        return index;
+    }
+};
+
+namespace concurrent_hashmap {
+namespace detail {
+template <typename key_t, typename value_t, typename hasher_t> struct empty_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::concurrent_hashmap_t<key_t, value_t,
+                                 ok::remove_cvref_t<backing_allocator_t>,
+                                 hasher_t>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               const empty_options_t& options = {}) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, options);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] alloc::error
+    make_into_uninit(ok::concurrent_hashmap_t<key_t, value_t,
+                                              backing_allocator_t, hasher_t>&
+                         output,
+                     backing_allocator_t& allocator,
+                     const empty_options_t& options) const OKAYLIB_NOEXCEPT
+    {
+        using map_t = ok::concurrent_hashmap_t<key_t, value_t,
+                                               backing_allocator_t, hasher_t>;
+        using shard_t = typename map_t::shard_t;
+
+        size_t num_shards = 1;
+        while (num_shards < options.num_shards)
+            num_shards *= 2;
+
+        auto claimed = allocated_atomic_bit_array::zeroed(
+            allocator, options.max_readers);
+        if (!claimed.is_success()) [[unlikely]]
+            return claimed.status();
+
+        const size_t epochs_bytes =
+            (options.max_readers + 1) * sizeof(epoch_line_t);
+        auto allocation = allocator.allocate(alloc::request_t{
+            .num_bytes =
+                epochs_bytes + num_shards * sizeof(shard_t) + cache_line_size,
+            .leave_nonzeroed = true,
+        });
+        if (!allocation.is_success()) [[unlikely]]
+            return allocation.status();
+
+        uint8_t* const block =
+            allocation.unwrap().unchecked_address_of_first_item();
+        uint8_t* const bytes =
+            block + (runtime_round_up_to_multiple_of(cache_line_size,
+                                                     uintptr_t(block)) -
+                     uintptr_t(block));
+        auto* const epochs = reinterpret_cast<epoch_line_t*>(bytes);
+        for (size_t i = 0; i <= options.max_readers; ++i) {
+            stdc::construct_at(epochs + i);
+            // readers store zero while they are not reading, so epochs start
+            // at one
+            epochs[i].epoch.store(i == 0 ? 1 : 0, memory_order::relaxed);
+        }
+        auto* const shards = reinterpret_cast<shard_t*>(bytes + epochs_bytes);
+        for (size_t i = 0; i < num_shards; ++i) {
+            stdc::construct_at(shards + i);
+            shards[i].table.store(nullptr, memory_order::relaxed);
+            shards[i].lock.store(0, memory_order::relaxed);
+            shards[i].size.store(0, memory_order::relaxed);
+            shards[i].used = 0;
+            shards[i].retired = nullptr;
+            shards[i].num_retired = 0;
+        }
+
+        stdc::construct_at(ok::addressof(output),
+                           typename map_t::members_t{
+                               .block = block,
+                               .epochs = epochs,
+                               .shards = shards,
+                               .shard_mask = num_shards - 1,
+                               .max_readers = options.max_readers,
+                               .claimed_readers =
+                                   stdc::move(claimed.unwrap()),
+                               .allocator = ok::addressof(allocator),
+                               .hasher = hasher_t{},
+                           });
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+template <typename key_t, typename value_t, typename hasher_t = ok::hasher_t>
+inline constexpr detail::empty_t<key_t, value_t, hasher_t> empty;
+} // namespace concurrent_hashmap
+} // namespace ok
+
+#endif
@@ -0,0 +1,437 @@
+#ifndef __OKAYLIB_CONTAINERS_CONCURRENT_SEGMENTED_LIST_H__
+#define __OKAYLIB_CONTAINERS_CONCURRENT_SEGMENTED_LIST_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/containers/segmented_list.h"
+#include "okay/error.h"
+#include "okay/iterables/iterables.h"
+#include "okay/platform/atomic.h"
+
+namespace ok {
+
+namespace concurrent_segmented_list {
+namespace detail {
+template <typename T, size_t first_block_size> struct empty_t;
+}
+} // namespace concurrent_segmented_list
+
+/// An append-only list which any number of threads can append() to and read
+/// from at the same time, without locks. Like segmented_list_t, items never
+/// move once they are appended, so a reference to an item stays valid for the
+/// lifetime of the list.
+///
+/// An append claims an index, constructs the item in place, and then marks
+/// that slot as ready. size() is a watermark: every item below it is ready, so
+/// readers can scan [0, size()) without synchronizing with the writers. An item
+/// which has been appended but is waiting for an earlier slot to become ready
+/// is not included in size() yet.
+///
+/// The backing allocator gets called from whichever thread needs a new block,
+/// so it must be safe to use from multiple threads at once (c_allocator_t is).
+/// Moving or destroying the list must not happen concurrently with anything
+/// else.
+template <typename T, allocator_c backing_allocator_t = ok::allocator_t,
+          size_t first_block_size = 1>
+class concurrent_segmented_list_t
+{
+  public:
+    static_assert(!stdc::is_reference_v<T>,
+                  "Cannot create a concurrent segmented list of references.");
+    static_assert(!is_const_c<T>,
+                  "Attempt to create a concurrent segmented list with const "
+                  "objects, which is not possible.");
+    static_assert(ok::is_power_of_two(first_block_size),
+                  "The first block of a concurrent segmented list must hold a "
+                  "power of two number of items.");
+
+    using value_type = T;
+
+    template <typename, size_t>
+    friend struct ok::concurrent_segmented_list::detail::empty_t;
+
+    /// The number of items which have finished being appended, and which are
+    /// all visible to the calling thread.
+    [[nodiscard]] constexpr size_t size() const noexcept
+    {
+        return m_committed.load(memory_order::acquire);
+    }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return this->size() == 0;
+    }
+
+    [[nodiscard]] constexpr const T&
+    operator[](size_t index) const& OKAYLIB_NOEXCEPT
+    {
+        return (*const_cast<concurrent_segmented_list_t*>(this))[index];
+    }
+
+    [[nodiscard]] constexpr T& operator[](size_t index) & OKAYLIB_NOEXCEPT
+    {
+        if (index >= this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access to concurrent_segmented_list_t");
+        }
+
+        return unchecked_access(index);
+    }
+
+    /// Iterates over the items which were committed when iter() was called.
+    [[nodiscard]] constexpr auto iter() & OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<concurrent_segmented_list_t,
+                                        cursor_t<false>>{
+            *this, cursor_t<false>{this->size()}};
+    }
+
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<const concurrent_segmented_list_t,
+                                        cursor_t<true>>{
+            *this, cursor_t<true>{this->size()}};
+    }
+
+    /// Construct an item at the end of the list. Safe to call from any number
+    /// of threads at once. Returns an error only if a new block was needed and
+    /// could not be allocated, in which case no index was claimed.
+    template <typename... args_t>
+    [[nodiscard]] constexpr ok::alloc::result_t<T&>
+    append(args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        static_assert(is_infallible_constructible_c<T, args_t...>,
+                      "Cannot append to a concurrent_segmented_list_t with "
+                      "arguments that may fail to construct the item.");
+        using namespace segmented_list::detail;
+
+        // only claim an index once the block for it exists, so that a failed
+        // allocation never leaves behind a slot which will not be filled
+        size_t idx = m_reserved.load(memory_order::relaxed);
+        T* block;
+        size_t offset;
+        while (true) {
+            auto [block_idx, offset_in_block] =
+                get_block_index_and_offset(idx, first_block_exponent);
+            block = m_blocks[block_idx].load(memory_order::acquire);
+            if (!block) [[unlikely]] {
+                if (auto status = this->install_block(block_idx);
+                    !status.is_success()) [[unlikely]]
+                    return status;
+                idx = m_reserved.load(memory_order::relaxed);
+                continue;
+            }
+            offset = offset_in_block;
+            if (m_reserved.compare_exchange_weak(idx, idx + 1,
+                                                 memory_order::relaxed,
+                                                 memory_order::relaxed))
+                break;
+        }
+
+        T& item = block[offset];
+        ok::make_into_uninitialized<T>(item, stdc::forward<args_t>(args)...);
+        this->publish(idx, block, offset);
+        return item;
+    }
+
+    /// Allocate blocks up front so that appends up to this many items never
+    /// allocate. Safe to call concurrently with append().
+    [[nodiscard]] constexpr status<alloc::error>
+    ensure_total_capacity_is_at_least(size_t total_spots) OKAYLIB_NOEXCEPT
+    {
+        using namespace segmented_list::detail;
+        const size_t blocks_needed =
+            num_blocks_needed_for_spots(total_spots, first_block_exponent);
+        for (size_t i = 0; i < blocks_needed; ++i) {
+            if (m_blocks[i].load(memory_order::acquire))
+                continue;
+            if (auto status = this->install_block(i); !status.is_success())
+                [[unlikely]]
+                return status;
+        }
+        return alloc::error::success;
+    }
+
+    /// Not threadsafe: nothing else may be using either list during a move.
+    constexpr concurrent_segmented_list_t(
+        concurrent_segmented_list_t&& other) noexcept
+        : m_allocator(other.m_allocator)
+    {
+        m_reserved.store(other.m_reserved.exchange(0, memory_order::relaxed),
+                         memory_order::relaxed);
+        m_committed.store(other.m_committed.exchange(0, memory_order::relaxed),
+                          memory_order::relaxed);
+        for (size_t i = 0; i < max_blocks; ++i) {
+            m_blocks[i].store(
+                other.m_blocks[i].exchange(nullptr, memory_order::relaxed),
+                memory_order::relaxed);
+        }
+    }
+
+    concurrent_segmented_list_t&
+    operator=(concurrent_segmented_list_t&&) = delete;
+    concurrent_segmented_list_t(const concurrent_segmented_list_t&) = delete;
+    concurrent_segmented_list_t&
+    operator=(const concurrent_segmented_list_t&) = delete;
+
+    constexpr ~concurrent_segmented_list_t() { destroy(); }
+
+  private:
+    struct members_t
+    {
+        backing_allocator_t* allocator;
+    };
+
+    static constexpr size_t first_block_exponent =
+        log2_uint(first_block_size);
+
+    static constexpr size_t max_blocks =
+        sizeof(size_t) * 8 - first_block_exponent;
+
+    using ready_flag_t = ok::atomic_t<uint8_t>;
+
+    /// Each block is the items, followed by one ready flag per item.
+    [[nodiscard]] static constexpr size_t
+    block_bytes(size_t block_idx) noexcept
+    {
+        return segmented_list::detail::size_of_block_at(block_idx,
+                                                        first_block_exponent) *
+               (sizeof(T) + sizeof(ready_flag_t));
+    }
+
+    [[nodiscard]] static constexpr ready_flag_t*
+    ready_flags_of(T* block, size_t block_idx) noexcept
+    {
+        return reinterpret_cast<ready_flag_t*>(
+            block + segmented_list::detail::size_of_block_at(
+                        block_idx, first_block_exponent));
+    }
+
+    /// Allocate a block and try to install it. If another thread installed one
+    /// first, the new allocation is freed and theirs is used.
+    [[nodiscard]] constexpr status<alloc::error>
+    install_block(size_t block_idx) OKAYLIB_NOEXCEPT
+    {
+        if (block_idx >= max_blocks) [[unlikely]]
+            return alloc::error::oom;
+
+        auto allocation = m_allocator->allocate(alloc::request_t{
+            .num_bytes = block_bytes(block_idx),
+            .alignment = ok::max(alignof(T), alignof(ready_flag_t)),
+            .leave_nonzeroed = true,
+        });
+        if (!allocation.is_success()) [[unlikely]]
+            return allocation.status();
+
+        T* new_block = reinterpret_cast<T*>(
+            allocation.unwrap().unchecked_address_of_first_item());
+        ready_flag_t* flags = ready_flags_of(new_block, block_idx);
+        const size_t num_flags = segmented_list::detail::size_of_block_at(
+            block_idx, first_block_exponent);
+        for (size_t i = 0; i < num_flags; ++i) {
+            stdc::construct_at(flags + i);
+            flags[i].store(0, memory_order::relaxed);
+        }
+
+        T* expected = nullptr;
+        if (!m_blocks[block_idx].compare_exchange_strong(
+                expected, new_block, memory_order::acq_rel,
+                memory_order::acquire)) {
+            m_allocator->deallocate(new_block);
+        }
+        return alloc::error::success;
+    }
+
+    /// Mark a slot as ready, then move the committed watermark forward past
+    /// as many consecutive ready slots as possible. Whichever thread fills in
+    /// the lowest unready slot ends up advancing the watermark over the slots
+    /// which finished before it, so nobody waits on anyone else.
+    constexpr void publish(size_t idx, T* block, size_t offset) noexcept
+    {
+        using namespace segmented_list::detail;
+        const size_t block_idx =
+            log2_uint((idx >> first_block_exponent) + 1);
+        // seq_cst, to pair with the watermark load below. either this thread
+        // sees the watermark reach idx, or the thread which moved it there
+        // sees this flag.
+        ready_flags_of(block, block_idx)[offset].store(1,
+                                                       memory_order::seq_cst);
+
+        size_t committed = m_committed.load(memory_order::seq_cst);
+        while (true) {
+            auto [next_block_idx, next_offset] =
+                get_block_index_and_offset(committed, first_block_exponent);
+            T* next_block =
+                m_blocks[next_block_idx].load(memory_order::acquire);
+            if (!next_block)
+                return;
+            if (!ready_flags_of(next_block, next_block_idx)[next_offset].load(
+                    memory_order::seq_cst))
+                return;
+            // on failure, committed is reloaded and the loop tries again from
+            // wherever another thread got to
+            m_committed.compare_exchange_weak(committed, committed + 1,
+                                              memory_order::seq_cst,
+                                              memory_order::seq_cst);
+        }
+    }
+
+    [[nodiscard]] constexpr T& unchecked_access(size_t index) OKAYLIB_NOEXCEPT
+    {
+        auto [block, offset] =
+            segmented_list::detail::get_block_index_and_offset(
+                index, first_block_exponent);
+        return m_blocks[block].load(memory_order::relaxed)[offset];
+    }
+
+    constexpr void destroy() noexcept
+    {
+        using namespace segmented_list::detail;
+        const size_t num_items = m_reserved.load(memory_order::acquire);
+        for (size_t b = 0; b < max_blocks; ++b) {
+            T* block = m_blocks[b].load(memory_order::acquire);
+            if (!block)
+                break;
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                const size_t first =
+                    index_of_first_item_in_block(b, first_block_exponent);
+                const size_t block_size =
+                    size_of_block_at(b, first_block_exponent);
+                for (size_t i = 0; i < block_size && first + i < num_items;
+                     ++i) {
+                    block[i].~T();
+                }
+            }
+            m_allocator->deallocate(block);
+        }
+    }
+
+    /// Cursor over a snapshot of the list: the size is fixed when the iterator
+    /// is created, and moving forward by one does not recompute the block.
+    template <bool is_const> struct cursor_t
+    {
+      private:
+        size_t m_size;
+        size_t m_index = 0;
+        size_t m_block = 0;
+        size_t m_offset_in_block = 0;
+        size_t m_block_size = first_block_size;
+
+      public:
+        constexpr explicit cursor_t(size_t size) : m_size(size) {}
+
+        using value_type = stdc::conditional_t<is_const, const T&, T&>;
+        using container_t =
+            stdc::conditional_t<is_const, const concurrent_segmented_list_t,
+                                concurrent_segmented_list_t>;
+
+        [[nodiscard]] constexpr size_t
+        size(const concurrent_segmented_list_t&) const
+        {
+            return m_size;
+        }
+
+        [[nodiscard]] constexpr size_t
+        index(const concurrent_segmented_list_t&) const
+        {
+            return m_index;
+        }
+
+        constexpr void offset(const concurrent_segmented_list_t&,
+                              int64_t offset_amount)
+        {
+            if (offset_amount == 1) [[likely]] {
+                ++m_index;
+                if (++m_offset_in_block == m_block_size) {
+                    ++m_block;
+                    m_offset_in_block = 0;
+                    m_block_size *= 2;
+                }
+                return;
+            }
+
+            m_index += offset_amount;
+            auto [block, offset_in_block] =
+                segmented_list::detail::get_block_index_and_offset(
+                    m_index, first_block_exponent);
+            m_block = block;
+            m_offset_in_block = offset_in_block;
+            m_block_size = segmented_list::detail::size_of_block_at(
+                block, first_block_exponent);
+        }
+
+        [[nodiscard]] constexpr value_type access(container_t& list)
+        {
+            __ok_assert(m_index < m_size,
+                        "Out of bounds iteration into "
+                        "concurrent_segmented_list_t");
+            return list.m_blocks[m_block].load(
+                memory_order::relaxed)[m_offset_in_block];
+        }
+    };
+
+    // next index to be handed out by append()
+    ok::atomic_t<size_t> m_reserved;
+    // every index below this one is constructed and ready
+    ok::atomic_t<size_t> m_committed;
+    backing_allocator_t* m_allocator;
+    // a block is never replaced once installed
+    ok::atomic_t<T*> m_blocks[max_blocks];
+
+  public:
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    constexpr concurrent_segmented_list_t(members_t&& members) noexcept
+        : m_allocator(members.allocator)
+    {
+        m_reserved.store(0, memory_order::relaxed);
+        m_committed.store(0, memory_order::relaxed);
+        for (auto& block : m_blocks)
+            block.store(nullptr, memory_order::relaxed);
+    }
+};
+
+namespace concurrent_segmented_list {
+namespace detail {
+template <typename T, size_t first_block_size> struct empty_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::concurrent_segmented_list_t<T,
+                                        ok::remove_cvref_t<backing_allocator_t>,
+                                        first_block_size>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::concurrent_segmented_list_t<T, backing_allocator_t,
+                                                     first_block_size>& output,
+                     backing_allocator_t& allocator) const OKAYLIB_NOEXCEPT
+    {
+        using output_t = ok::concurrent_segmented_list_t<T, backing_allocator_t,
+                                                         first_block_size>;
+        stdc::construct_at(ok::addressof(output),
+                           typename output_t::members_t{
+                               .allocator = ok::addressof(allocator),
+                           });
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+template <typename T, size_t first_block_size = 1>
+inline constexpr concurrent_segmented_list::detail::empty_t<T,
+                                                            first_block_size>
+    empty;
+
+} // namespace concurrent_segmented_list
+} // namespace ok
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef __OKAYLIB_CONTAINERS_EYTZINGER_INDEX_H__
+#define __OKAYLIB_CONTAINERS_EYTZINGER_INDEX_H__
+
+#include "okay/algorithm/binary_search.h"
+#include "okay/allocators/allocator.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/math/math.h"
+#include "okay/opt.h"
+#include "okay/slice.h"
+
+namespace ok {
+
+namespace eytzinger_index::detail {
+struct copy_items_from_sorted_t;
+
+/// Hint that memory at address will be read soon. Does nothing if the compiler
+/// has no way to ask for that. Takes an integer so that callers can prefetch
+/// past the end of an allocation without doing pointer arithmetic.
+inline void prefetch_for_read(uintptr_t address) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(reinterpret_cast<const void*>(address), 0, 3);
+#else
+    (void)address;
+#endif
+}
+} // namespace eytzinger_index::detail
+
+/// A read-only copy of a sorted slice, laid out for fast searching. The items
+/// are stored in breadth first order of the implicit binary search tree (the
+/// "Eytzinger layout"): the root is at index 1 and the children of the item at
+/// k are at 2k and 2k + 1.
+///
+/// A binary search over a sorted slice jumps around the whole table, so for
+/// big tables nearly every step is a cache miss. In this layout, the first
+/// few levels of the tree share a handful of cache lines, and the descendants
+/// of an item a few levels down are next to each other, so each step can
+/// prefetch the cache line which will be needed several steps later.
+///
+/// Searches return the item found rather than its position in the original
+/// sorted order. To look up associated data, store it alongside the key and
+/// search with a comparator which only looks at the key.
+template <typename T, allocator_c backing_allocator_t = ok::allocator_t>
+class eytzinger_index_t
+{
+  public:
+    static_assert(!stdc::is_reference_v<T>,
+                  "Cannot create an eytzinger index of references.");
+    static_assert(!is_const_c<T>,
+                  "Attempt to create an eytzinger index of const items, use a "
+                  "nonconst type instead (the index is always read-only).");
+
+    using value_type = T;
+
+    friend struct ok::eytzinger_index::detail::copy_items_from_sorted_t;
+
+    [[nodiscard]] constexpr size_t size() const noexcept { return m.size; }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return m.size == 0;
+    }
+
+    /// The first item which is not less than value, if there is one.
+    template <typename value_t>
+        requires ok::detail::default_searchable_c<T, value_t>
+    [[nodiscard]] constexpr opt<const T&>
+    lower_bound(const value_t& value) const OKAYLIB_NOEXCEPT
+    {
+        return this->lower_bound(value,
+                                 ok::detail::default_search_compare_t{});
+    }
+
+    template <typename value_t, typename compare_t>
+        requires ok::detail::search_compare_c<T, value_t, compare_t>
+    [[nodiscard]] constexpr opt<const T&>
+    lower_bound(const value_t& value,
+                const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        return this->search([&](const T& item) {
+            return compare(item, value) < 0;
+        });
+    }
+
+    /// The first item which is greater than value, if there is one.
+    template <typename value_t>
+        requires ok::detail::default_searchable_c<T, value_t>
+    [[nodiscard]] constexpr opt<const T&>
+    upper_bound(const value_t& value) const OKAYLIB_NOEXCEPT
+    {
+        return this->upper_bound(value,
+                                 ok::detail::default_search_compare_t{});
+    }
+
+    template <typename value_t, typename compare_t>
+        requires ok::detail::search_compare_c<T, value_t, compare_t>
+    [[nodiscard]] constexpr opt<const T&>
+    upper_bound(const value_t& value,
+                const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        return this->search([&](const T& item) {
+            return compare(item, value) <= 0;
+        });
+    }
+
+    /// An item equal to value, if there is one.
+    template <typename value_t>
+        requires ok::detail::default_searchable_c<T, value_t>
+    [[nodiscard]] constexpr opt<const T&>
+    find(const value_t& value) const OKAYLIB_NOEXCEPT
+    {
+        return this->find(value, ok::detail::default_search_compare_t{});
+    }
+
+    template <typename value_t, typename compare_t>
+        requires ok::detail::search_compare_c<T, value_t, compare_t>
+    [[nodiscard]] constexpr opt<const T&>
+    find(const value_t& value, const compare_t& compare) const OKAYLIB_NOEXCEPT
+    {
+        opt<const T&> found = this->lower_bound(value, compare);
+        if (found && compare(found.ref_unchecked(), value) == 0)
+            return found;
+        return nullopt;
+    }
+
+    template <typename value_t>
+        requires ok::detail::default_searchable_c<T, value_t>
+    [[nodiscard]] constexpr bool
+    contains(const value_t& value) const OKAYLIB_NOEXCEPT
+    {
+        return this->find(value).has_value();
+    }
+
+    constexpr eytzinger_index_t(eytzinger_index_t&& other) OKAYLIB_NOEXCEPT
+        : m(other.m)
+    {
+        other.m.allocation = nullptr;
+        other.m.items = nullptr;
+        other.m.size = 0;
+    }
+
+    constexpr eytzinger_index_t&
+    operator=(eytzinger_index_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = other.m;
+        other.m.allocation = nullptr;
+        other.m.items = nullptr;
+        other.m.size = 0;
+        return *this;
+    }
+
+    eytzinger_index_t(const eytzinger_index_t&) = delete;
+    eytzinger_index_t& operator=(const eytzinger_index_t&) = delete;
+
+    constexpr ~eytzinger_index_t() { destroy(); }
+
+  private:
+    static constexpr size_t cacheline_size = 64;
+
+    // how many levels down the tree to prefetch. the 2^levels descendants of
+    // an item that far down share one cache line
+    static constexpr size_t prefetch_levels =
+        sizeof(T) * 2 > cacheline_size ? 1
+                                       : log2_uint(cacheline_size / sizeof(T));
+
+    /// Walk down the tree, going right whenever the item is before the point
+    /// being searched for. Returns the last item where the search went left.
+    template <typename is_before_t>
+    [[nodiscard]] constexpr opt<const T&>
+    search(const is_before_t& is_before) const OKAYLIB_NOEXCEPT
+    {
+        const uintptr_t base = uintptr_t(m.items);
+        size_t k = 1;
+        while (k <= m.size) {
+            eytzinger_index::detail::prefetch_for_read(
+                base + (k << prefetch_levels) * sizeof(T));
+            k = 2 * k + size_t(is_before(m.items[k]));
+        }
+        // the bits of k are the turns taken, ending with a left turn and then
+        // any number of right turns. undo the right turns and the left turn.
+        k >>= ok::count_trailing_zeros(~k) + 1;
+        if (k == 0)
+            return nullopt;
+        return m.items[k];
+    }
+
+    /// Fill the subtree at k with items from sorted, in order, starting at
+    /// index next. Returns the index after the last item used.
+    constexpr size_t fill(const T* sorted, size_t next, size_t k) noexcept
+    {
+        if (k > m.size)
+            return next;
+        next = this->fill(sorted, next, 2 * k);
+        stdc::construct_at(m.items + k, sorted[next]);
+        return this->fill(sorted, next + 1, 2 * k + 1);
+    }
+
+    constexpr void destroy() noexcept
+    {
+        if (!m.allocation)
+            return;
+        if constexpr (!stdc::is_trivially_destructible_v<T>) {
+            for (size_t k = 1; k <= m.size; ++k)
+                m.items[k].~T();
+        }
+        m.allocator->deallocate(m.allocation);
+    }
+
+    struct members_t
+    {
+        void* allocation;
+        // the root is items[1], and items[0] is never constructed. aligned so
+        // that items[0] starts a cache line
+        T* items;
+        size_t size;
+        backing_allocator_t* allocator;
+    } m;
+
+  public:
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    constexpr eytzinger_index_t(members_t&& members) OKAYLIB_NOEXCEPT
+        : m(stdc::forward<members_t>(members))
+    {
+    }
+};
+
+namespace eytzinger_index {
+namespace detail {
+struct copy_items_from_sorted_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename input_slice_t>
+    using associated_type = ok::eytzinger_index_t<
+        stdc::remove_cv_t<
+            typename stdc::remove_cvref_t<input_slice_t>::value_type>,
+        ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t, typename T>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               slice<T> sorted) const OKAYLIB_NOEXCEPT
+        requires stdc::is_copy_constructible_v<stdc::remove_cv_t<T>>
+    {
+        return ok::make(*this, allocator, sorted);
+    }
+
+    template <allocator_c backing_allocator_t, typename T>
+    [[nodiscard]] constexpr alloc::error make_into_uninit(
+        ok::eytzinger_index_t<stdc::remove_cv_t<T>, backing_allocator_t>&
+            output,
+        backing_allocator_t& allocator, slice<T> sorted) const OKAYLIB_NOEXCEPT
+    {
+        using value_t = stdc::remove_cv_t<T>;
+        using output_t = ok::eytzinger_index_t<value_t, backing_allocator_t>;
+        constexpr size_t cacheline_size = output_t::cacheline_size;
+
+        if (sorted.is_empty()) {
+            stdc::construct_at(ok::addressof(output),
+                               typename output_t::members_t{
+                                   .allocation = nullptr,
+                                   .items = nullptr,
+                                   .size = 0,
+                                   .allocator = ok::addressof(allocator),
+                               });
+            return alloc::error::success;
+        }
+
+        // room for the unused slot 0 and for aligning slot 0 to a cache line
+        auto res = allocator.allocate(alloc::request_t{
+            .num_bytes = sizeof(value_t) * (sorted.size() + 1) + cacheline_size,
+            .alignment = alignof(value_t),
+            .leave_nonzeroed = true,
+        });
+        if (!res.is_success()) [[unlikely]]
+            return res.status();
+
+        uint8_t* const allocation =
+            res.unwrap().unchecked_address_of_first_item();
+        const uintptr_t misalignment = uintptr_t(allocation) % cacheline_size;
+        uint8_t* const aligned =
+            allocation + (misalignment ? cacheline_size - misalignment : 0);
+
+        stdc::construct_at(ok::addressof(output),
+                           typename output_t::members_t{
+                               .allocation = allocation,
+                               .items = reinterpret_cast<value_t*>(aligned),
+                               .size = sorted.size(),
+                               .allocator = ok::addressof(allocator),
+                           });
+
+        const value_t* const sorted_items =
+            sorted.unchecked_address_of_first_item();
+        if constexpr (ok::detail::default_searchable_c<value_t, value_t>) {
+            for (size_t i = 1; i < sorted.size(); ++i) {
+                __ok_assert((sorted_items[i] <=> sorted_items[i - 1]) >= 0,
+                            "Items given to "
+                            "eytzinger_index::copy_items_from_sorted are not "
+                            "sorted.");
+            }
+        }
+
+        [[maybe_unused]] const size_t used = output.fill(sorted_items, 0, 1);
+        __ok_internal_assert(used == sorted.size());
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Build an index from a slice which is already sorted. The items are copied.
+inline constexpr detail::copy_items_from_sorted_t copy_items_from_sorted;
+} // namespace eytzinger_index
+
+template <typename T, typename backing_allocator_t>
+struct is_trivially_relocatable<eytzinger_index_t<T, backing_allocator_t>>
+    : stdc::true_type
+{};
+} // namespace ok
+
+#endif
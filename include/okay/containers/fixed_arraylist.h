@@ -4,6 +4,7 @@
 #include "okay/containers/array.h"
 #include "okay/defer.h"
 #include "okay/detail/template_util/uninitialized_storage.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
 
 namespace ok {
 
@@ -42,6 +43,7 @@ template <typename T, size_t max_elems>
 class fixed_arraylist_nontrivial_destruction_t
     : protected fixed_arraylist_members_t<T, max_elems>
 {
+  protected:
     ~fixed_arraylist_nontrivial_destruction_t() { this->destroy(); }
 };
 } // namespace detail
@@ -54,8 +56,12 @@ class fixed_arraylist_t
           detail::fixed_arraylist_members_t<T, max_elems>,
           detail::fixed_arraylist_nontrivial_destruction_t<T, max_elems>>
 {
+    using members_t = detail::fixed_arraylist_members_t<T, max_elems>;
 
   public:
+    using members_t::data;
+    using members_t::size;
+
     // initialize fixed_arraylist_t with an array_t for nice syntax
     template <size_t num_elems_in_initializer>
         requires(num_elems_in_initializer <= max_elems)
@@ -78,11 +84,15 @@ class fixed_arraylist_t
         OKAYLIB_NOEXCEPT
     {
         this->set_spots_occupied(other.size());
-        if constexpr (stdc::is_trivially_copyable_v<T>) {
-            ::memcpy(this->data(), other.data(), other.size() * sizeof(T));
+        if constexpr (is_trivially_relocatable_v<T>) {
+            ::memcpy((void*)this->data(), (void*)other.data(),
+                     other.size() * sizeof(T));
         } else {
             for (size_t i = 0; i < other.size(); ++i) {
                 new (this->data() + i) T(stdc::move(other.data()[i]));
+                if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                    other.data()[i].~T();
+                }
             }
         }
         other.set_spots_occupied(0);
@@ -120,7 +130,6 @@ class fixed_arraylist_t
     {
         using make_result_type = decltype(ok::make_into_uninitialized<T>(
             stdc::declval<T&>(), stdc::forward<args_t>(args)...));
-        using enum_t = typename make_result_type::enum_type;
 
         constexpr bool make_returns_status = !stdc::is_void_v<make_result_type>;
 
@@ -131,7 +140,7 @@ class fixed_arraylist_t
         if (this->size() == max_elems) [[unlikely]] {
             if constexpr (make_returns_status) {
                 static_assert(detail::is_instance_c<make_result_type, status>);
-                return enum_t::no_value;
+                return make_result_type::enum_type::no_value;
             } else {
                 return false;
             }
@@ -140,8 +149,9 @@ class fixed_arraylist_t
 
         if (idx < this->size()) {
             // move all other items towards the back of the arraylist
-            if constexpr (stdc::is_trivially_copyable_v<T>) {
-                ::memmove(this->data() + idx + 1, this->data() + idx,
+            if constexpr (is_trivially_relocatable_v<T>) {
+                ::memmove((void*)(this->data() + idx + 1),
+                          (void*)(this->data() + idx),
                           (this->size() - idx) * sizeof(T));
             } else {
                 for (size_t i = this->size(); i > idx; --i) {
@@ -166,8 +176,9 @@ class fixed_arraylist_t
                 // move all other items BACK to where they were before (this is
                 // supposed to be the cold path and it only invokes nonfailing
                 // operations so it should be fine to do this)
-                if constexpr (stdc::is_trivially_copyable_v<T>) {
-                    ::memmove(this->data() + idx, this->data() + idx + 1,
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    ::memmove((void*)(this->data() + idx),
+                              (void*)(this->data() + idx + 1),
                               (this->size() - idx) * sizeof(T));
                 } else {
                     for (size_t i = idx; i < this->size(); ++i) {
@@ -192,25 +203,34 @@ class fixed_arraylist_t
             __ok_abort("Out of bounds access in fixed_arraylist_t::remove()");
         }
 
+        T& removed = this->data()[idx];
         // moved out at index
-        T out(stdc::move(this->data()[idx]));
+        T out(stdc::move(removed));
 
         defer decrement([this] { this->set_spots_occupied(this->size() - 1); });
 
         // if no need to move anything (popping last)
         if (idx == this->size() - 1) {
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                removed.~T();
+            }
             return out;
         }
 
-        if constexpr (stdc::is_trivially_copyable_v<T>) {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                removed.~T();
+            }
             const size_t idxplusone = idx + 1;
-            ::memmove(this->data() + idx, this->data() + idxplusone,
+            ::memmove((void*)(this->data() + idx),
+                      (void*)(this->data() + idxplusone),
                       (this->size() - idxplusone) * sizeof(T));
         } else {
-            for (size_t i = this->size() - 1; i > idx; --i) {
-                auto* target = this->data() + (i - 1);
-                auto* source = this->data() + (i);
-                new (ok::addressof(target)) T(stdc::move(*source));
+            for (size_t i = idx; i < this->size() - 1; ++i) {
+                this->data()[i] = stdc::move(this->data()[i + 1]);
+            }
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                this->data()[this->size() - 1].~T();
             }
         }
         return out;
@@ -228,12 +248,24 @@ class fixed_arraylist_t
 
         defer decrement([this] { this->set_spots_occupied(this->size() - 1); });
 
+        if constexpr (!stdc::is_trivially_destructible_v<T>) {
+            target.~T();
+        }
+
         if (idx == this->size() - 1) {
             return out;
         }
 
-        new (ok::addressof(target))
-            T(stdc::move(this->data()[this->size() - 1]));
+        T& last = this->data()[this->size() - 1];
+        if constexpr (is_trivially_relocatable_v<T>) {
+            ::memcpy((void*)ok::addressof(target), (void*)ok::addressof(last),
+                     sizeof(T));
+        } else {
+            new (ok::addressof(target)) T(stdc::move(last));
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                last.~T();
+            }
+        }
 
         return out;
     }
@@ -318,6 +350,11 @@ class fixed_arraylist_t
         return raw_slice(*this->data(), this->size());
     }
 };
+
+template <typename T, size_t max_elems>
+struct is_trivially_relocatable<fixed_arraylist_t<T, max_elems>>
+    : stdc::bool_constant<is_trivially_relocatable_v<T>>
+{};
 } // namespace ok
 
 #endif
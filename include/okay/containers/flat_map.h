@@ -0,0 +1,472 @@
+#ifndef __OKAYLIB_CONTAINERS_FLAT_MAP_H__
+#define __OKAYLIB_CONTAINERS_FLAT_MAP_H__
+
+#include "okay/algorithm/binary_search.h"
+#include "okay/algorithm/sort.h"
+#include "okay/allocators/allocator.h"
+#include "okay/containers/arraylist.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/iterables/iterables.h"
+#include "okay/opt.h"
+#include "okay/tuple.h"
+
+namespace ok {
+namespace flat_map {
+namespace detail {
+template <typename key_t, typename value_t> struct from_unsorted_t;
+} // namespace detail
+} // namespace flat_map
+
+/// An ordered map stored as two sorted arraylists, one of keys and one of
+/// values. Lookups are a branchless binary search over the keys alone, so
+/// more of them fit in each cache line than if they were interleaved with
+/// the values. For maps which are built once and then mostly read, this is
+/// faster and smaller than any tree or hash map.
+///
+/// Inserting or removing one item moves all the items after it, so it is
+/// O(n). To add many items at once, use insert_iterator(), which sorts them
+/// and merges them in, in one pass.
+///
+/// Keys are ordered with operator<=>. Lookups are heterogeneous: anything
+/// which can be compared with the key using <=> can be used to find it.
+/// Inserting into or removing from the map invalidates references to its
+/// items.
+template <typename key_t, typename value_t,
+          allocator_c backing_allocator_t = ok::allocator_t>
+class flat_map_t
+{
+    static_assert(!stdc::is_reference_c<key_t> &&
+                      !stdc::is_reference_c<value_t>,
+                  "flat_map_t cannot store references, use pointers "
+                  "instead.");
+    static_assert(ok::detail::default_searchable_c<key_t, key_t>,
+                  "flat_map_t keys must be ordered with operator<=>.");
+    static_assert(stdc::is_move_constructible_v<key_t> &&
+                      stdc::is_move_assignable_v<key_t> &&
+                      stdc::is_move_constructible_v<value_t> &&
+                      stdc::is_move_assignable_v<value_t>,
+                  "flat_map_t sorts its items when inserting many at once, "
+                  "so keys and values must be move constructible and move "
+                  "assignable.");
+
+    using keys_t = arraylist_t<key_t, backing_allocator_t>;
+    using values_t = arraylist_t<value_t, backing_allocator_t>;
+
+    /// Where items being inserted in bulk are sorted before being merged in.
+    struct entry_t
+    {
+        key_t key;
+        value_t value;
+    };
+
+    struct members_t
+    {
+        keys_t keys;
+        values_t values;
+    } m;
+
+    static constexpr size_t not_found = size_t(-1);
+
+    template <typename T>
+    [[nodiscard]] static constexpr slice<T>
+    items_between(slice<T> items, size_t start, size_t end) OKAYLIB_NOEXCEPT
+    {
+        if (start == end)
+            return make_null_slice<T>();
+        return items.subslice({.start = start, .length = end - start});
+    }
+
+    template <typename lookup_t>
+    [[nodiscard]] constexpr size_t
+    find_index(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        const slice<const key_t> keys = this->keys();
+        const size_t index = ok::lower_bound(keys, key);
+        if (index == keys.size() || (keys.unchecked_access(index) <=> key) != 0)
+            return not_found;
+        return index;
+    }
+
+    /// Inserts at index, which must be where key belongs. Both lists make room
+    /// first, so that a failed allocation leaves them the same length.
+    template <typename key_arg_t, typename... args_t>
+    [[nodiscard]] constexpr res<value_t&, alloc::error>
+    insert_new_at(size_t index, key_arg_t&& key,
+                  args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        if (auto status = m.keys.ensure_additional_capacity();
+            !status.is_success()) [[unlikely]]
+            return status;
+        if (auto status = m.values.ensure_additional_capacity();
+            !status.is_success()) [[unlikely]]
+            return status;
+        const auto key_status =
+            m.keys.insert_at(index, stdc::forward<key_arg_t>(key));
+        const auto value_status =
+            m.values.insert_at(index, stdc::forward<args_t>(args)...);
+        __ok_internal_assert(key_status.is_success() &&
+                             value_status.is_success());
+        return m.values.items().unchecked_access(index);
+    }
+
+  public:
+    using key_type = key_t;
+    using mapped_type = value_t;
+
+    template <typename, typename>
+    friend struct flat_map::detail::from_unsorted_t;
+
+    explicit flat_map_t(backing_allocator_t& allocator) OKAYLIB_NOEXCEPT
+        : m(members_t{
+              .keys = arraylist::empty<key_t>(allocator),
+              .values = arraylist::empty<value_t>(allocator),
+          })
+    {
+    }
+
+    flat_map_t(flat_map_t&&) = default;
+    flat_map_t& operator=(flat_map_t&&) = default;
+
+    flat_map_t(const flat_map_t&) = delete;
+    flat_map_t& operator=(const flat_map_t&) = delete;
+
+    [[nodiscard]] constexpr size_t size() const noexcept
+    {
+        return m.keys.size();
+    }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return m.keys.is_empty();
+    }
+
+    /// Make room for num_items in total without reallocating.
+    [[nodiscard]] constexpr status<alloc::error>
+    reserve(size_t num_items) OKAYLIB_NOEXCEPT
+    {
+        if (auto status = m.keys.reserve_exact(num_items);
+            !status.is_success()) [[unlikely]]
+            return status;
+        return m.values.reserve_exact(num_items);
+    }
+
+    /// The keys, in increasing order.
+    [[nodiscard]] constexpr slice<const key_t> keys() const OKAYLIB_NOEXCEPT
+    {
+        return m.keys.items();
+    }
+
+    /// The values, in the same order as their keys.
+    [[nodiscard]] constexpr slice<value_t> values() & OKAYLIB_NOEXCEPT
+    {
+        return m.values.items();
+    }
+
+    [[nodiscard]] constexpr slice<const value_t>
+    values() const& OKAYLIB_NOEXCEPT
+    {
+        return m.values.items();
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr bool
+    contains(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        return this->find_index(key) != not_found;
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr opt<value_t&>
+    get(const lookup_t& key) & OKAYLIB_NOEXCEPT
+    {
+        const size_t index = this->find_index(key);
+        if (index == not_found)
+            return nullopt;
+        return m.values.items().unchecked_access(index);
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr opt<const value_t&>
+    get(const lookup_t& key) const& OKAYLIB_NOEXCEPT
+    {
+        const size_t index = this->find_index(key);
+        if (index == not_found)
+            return nullopt;
+        return m.values.items().unchecked_access(index);
+    }
+
+    /// Get the value of a key, constructing it from args if the key is not in
+    /// the map yet. If the key is already there, args are unused.
+    template <typename key_arg_t, typename... args_t>
+        requires(ok::detail::default_searchable_c<key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&> &&
+                 stdc::is_constructible_v<value_t, args_t && ...>)
+    [[nodiscard]] constexpr res<value_t&, alloc::error>
+    get_or_insert(key_arg_t&& key, args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        const slice<const key_t> keys = this->keys();
+        const size_t index = ok::lower_bound(keys, key);
+        if (index != keys.size() && (keys.unchecked_access(index) <=> key) == 0)
+            return m.values.items().unchecked_access(index);
+        return this->insert_new_at(index, stdc::forward<key_arg_t>(key),
+                                   stdc::forward<args_t>(args)...);
+    }
+
+    /// Put a value in the map, replacing any value the key already had.
+    template <typename key_arg_t, typename value_arg_t>
+        requires(ok::detail::default_searchable_c<key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&> &&
+                 stdc::is_constructible_v<value_t, value_arg_t &&> &&
+                 stdc::is_assignable_v<value_t&, value_arg_t &&>)
+    [[nodiscard]] constexpr res<value_t&, alloc::error>
+    insert(key_arg_t&& key, value_arg_t&& value) OKAYLIB_NOEXCEPT
+    {
+        const slice<const key_t> keys = this->keys();
+        const size_t index = ok::lower_bound(keys, key);
+        if (index != keys.size() &&
+            (keys.unchecked_access(index) <=> key) == 0) {
+            value_t& existing = m.values.items().unchecked_access(index);
+            existing = stdc::forward<value_arg_t>(value);
+            return existing;
+        }
+        return this->insert_new_at(index, stdc::forward<key_arg_t>(key),
+                                   stdc::forward<value_arg_t>(value));
+    }
+
+    /// Insert every (key, value) tuple from an iterator, replacing the values
+    /// of keys which are already in the map. If a key comes up more than
+    /// once, the last value wins, the same as calling insert() for each one.
+    /// The new items are sorted and then merged with the old ones in one
+    /// pass, so this is O(n + m log m) instead of O(n * m). If an allocation
+    /// fails, the map is left unchanged.
+    template <iterator_c iterator_t>
+    [[nodiscard]] constexpr status<alloc::error>
+    insert_iterator(iterator_t&& iterator) OKAYLIB_NOEXCEPT
+    {
+        static_assert(!ok::detail::infinite_iterator_c<iterator_t>,
+                      "Cannot insert an infinite iterator into a flat_map_t.");
+        backing_allocator_t& allocator = m.keys.allocator();
+
+        arraylist_t<entry_t, backing_allocator_t> incoming =
+            arraylist::empty<entry_t>(allocator);
+        if constexpr (ok::detail::sized_iterator_c<iterator_t>) {
+            if (auto status = incoming.reserve_exact(iterator.size());
+                !status.is_success()) [[unlikely]]
+                return status;
+        }
+        while (auto item = iterator.next()) {
+            auto status = incoming.append(
+                ok::get<0>(stdc::move(item.ref_unchecked())),
+                ok::get<1>(stdc::move(item.ref_unchecked())));
+            if (!status.is_success()) [[unlikely]]
+                return status;
+        }
+        if (incoming.is_empty())
+            return alloc::error::success;
+
+        // stable, so that the last of several equal keys is still last
+        if (auto status = ok::stable_sort(allocator, incoming.items(),
+                                          [](const entry_t& lhs,
+                                             const entry_t& rhs) {
+                                              return lhs.key <=> rhs.key;
+                                          });
+            !status.is_success()) [[unlikely]]
+            return status;
+
+        const size_t most = m.keys.size() + incoming.size();
+        auto merged_keys =
+            arraylist::spots_preallocated<key_t>(allocator, most);
+        if (!merged_keys.is_success()) [[unlikely]]
+            return merged_keys.status();
+        auto merged_values =
+            arraylist::spots_preallocated<value_t>(allocator, most);
+        if (!merged_values.is_success()) [[unlikely]]
+            return merged_values.status();
+        keys_t& keys = merged_keys.unwrap();
+        values_t& values = merged_values.unwrap();
+
+        // nothing can fail from here on
+        const slice<key_t> old_keys = m.keys.items();
+        const slice<value_t> old_values = m.values.items();
+        const slice<entry_t> sorted = incoming.items();
+        size_t old_index = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            entry_t& entry = sorted.unchecked_access(i);
+            if (i + 1 < sorted.size() &&
+                !(entry.key < sorted.unchecked_access(i + 1).key))
+                continue;
+            while (old_index < old_keys.size() &&
+                   old_keys.unchecked_access(old_index) < entry.key) {
+                keys.append_assume_capacity(
+                    stdc::move(old_keys.unchecked_access(old_index)));
+                values.append_assume_capacity(
+                    stdc::move(old_values.unchecked_access(old_index)));
+                ++old_index;
+            }
+            // an old item with the same key is replaced
+            if (old_index < old_keys.size() &&
+                !(entry.key < old_keys.unchecked_access(old_index)))
+                ++old_index;
+            keys.append_assume_capacity(stdc::move(entry.key));
+            values.append_assume_capacity(stdc::move(entry.value));
+        }
+        for (; old_index < old_keys.size(); ++old_index) {
+            keys.append_assume_capacity(
+                stdc::move(old_keys.unchecked_access(old_index)));
+            values.append_assume_capacity(
+                stdc::move(old_values.unchecked_access(old_index)));
+        }
+
+        m.keys = stdc::move(keys);
+        m.values = stdc::move(values);
+        return alloc::error::success;
+    }
+
+    /// Returns whether the key was in the map.
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    constexpr bool remove(const lookup_t& key) OKAYLIB_NOEXCEPT
+    {
+        const size_t index = this->find_index(key);
+        if (index == not_found)
+            return false;
+        m.keys.remove(index);
+        m.values.remove(index);
+        return true;
+    }
+
+    /// Remove every item, keeping the allocations.
+    constexpr void clear() OKAYLIB_NOEXCEPT
+    {
+        m.keys.clear();
+        m.values.clear();
+    }
+
+    /// Iterate over (key, value) tuples in increasing order of key. The
+    /// iterator is arraylike, so it can be indexed and reversed.
+    [[nodiscard]] constexpr auto iter() & OKAYLIB_NOEXCEPT
+    {
+        return ok::zip(this->keys(), this->values());
+    }
+
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ok::zip(this->keys(), this->values());
+    }
+
+    constexpr auto iter() const&& = delete;
+
+    /// Iterate over the items with keys which are not less than lower and
+    /// are less than upper, in increasing order.
+    template <typename lower_t, typename upper_t>
+        requires(ok::detail::default_searchable_c<key_t, lower_t> &&
+                 ok::detail::default_searchable_c<key_t, upper_t>)
+    [[nodiscard]] constexpr auto
+    iter_between(const lower_t& lower, const upper_t& upper) & OKAYLIB_NOEXCEPT
+    {
+        const size_t start = ok::lower_bound(this->keys(), lower);
+        const size_t end = ok::max(start, ok::lower_bound(this->keys(), upper));
+        return ok::zip(items_between(this->keys(), start, end),
+                       items_between(this->values(), start, end));
+    }
+
+    template <typename lower_t, typename upper_t>
+        requires(ok::detail::default_searchable_c<key_t, lower_t> &&
+                 ok::detail::default_searchable_c<key_t, upper_t>)
+    [[nodiscard]] constexpr auto
+    iter_between(const lower_t& lower,
+                 const upper_t& upper) const& OKAYLIB_NOEXCEPT
+    {
+        const size_t start = ok::lower_bound(this->keys(), lower);
+        const size_t end = ok::max(start, ok::lower_bound(this->keys(), upper));
+        return ok::zip(items_between(this->keys(), start, end),
+                       items_between(this->values(), start, end));
+    }
+
+    template <typename lower_t, typename upper_t>
+    constexpr auto iter_between(const lower_t&, const upper_t&) const&& =
+        delete;
+
+    /// Iterate over the items with keys which are not less than lower, in
+    /// increasing order.
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr auto
+    iter_from(const lookup_t& lower) & OKAYLIB_NOEXCEPT
+    {
+        const size_t start = ok::lower_bound(this->keys(), lower);
+        return ok::zip(items_between(this->keys(), start, this->size()),
+                       items_between(this->values(), start, this->size()));
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr auto
+    iter_from(const lookup_t& lower) const& OKAYLIB_NOEXCEPT
+    {
+        const size_t start = ok::lower_bound(this->keys(), lower);
+        return ok::zip(items_between(this->keys(), start, this->size()),
+                       items_between(this->values(), start, this->size()));
+    }
+
+    template <typename lookup_t>
+    constexpr auto iter_from(const lookup_t&) const&& = delete;
+};
+
+namespace flat_map {
+namespace detail {
+template <typename key_t, typename value_t> struct from_unsorted_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::flat_map_t<key_t, value_t,
+                       ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t, iterator_c input_iterator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               input_iterator_t&& iterator) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator,
+                        stdc::forward<input_iterator_t>(iterator));
+    }
+
+    template <allocator_c backing_allocator_t, iterator_c input_iterator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::flat_map_t<key_t, value_t, backing_allocator_t>&
+                         output,
+                     backing_allocator_t& allocator,
+                     input_iterator_t&& iterator) const OKAYLIB_NOEXCEPT
+    {
+        ok::flat_map_t<key_t, value_t, backing_allocator_t> map(allocator);
+        auto status =
+            map.insert_iterator(stdc::forward<input_iterator_t>(iterator));
+        if (!status.is_success()) [[unlikely]]
+            return status.as_enum();
+        stdc::construct_at(ok::addressof(output), stdc::move(map));
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Make a map from an iterator of (key, value) tuples in any order. The items
+/// are sorted, and if a key comes up more than once, the last value wins.
+/// flat_map::from_unsorted<key_t, value_t>(allocator, iterator)
+template <typename key_t, typename value_t>
+inline constexpr detail::from_unsorted_t<key_t, value_t> from_unsorted;
+} // namespace flat_map
+
+template <typename key_t, typename value_t, typename backing_allocator_t>
+struct is_trivially_relocatable<flat_map_t<key_t, value_t, backing_allocator_t>>
+    : stdc::true_type
+{};
+} // namespace ok
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef __OKAYLIB_CONTAINERS_FLAT_SET_H__
+#define __OKAYLIB_CONTAINERS_FLAT_SET_H__
+
+#include "okay/algorithm/binary_search.h"
+#include "okay/algorithm/sort.h"
+#include "okay/allocators/allocator.h"
+#include "okay/containers/arraylist.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/iterables/iterables.h"
+
+namespace ok {
+namespace flat_set {
+namespace detail {
+template <typename key_t> struct from_unsorted_t;
+} // namespace detail
+} // namespace flat_set
+
+/// An ordered set stored as a sorted arraylist. Lookups are a branchless
+/// binary search, and iterating is a walk over contiguous memory. See
+/// flat_map_t, which this is the keys-only version of.
+///
+/// Inserting or removing one item moves all the items after it, so it is
+/// O(n). To add many items at once, use insert_iterator(), which sorts them
+/// and merges them in, in one pass.
+///
+/// Keys are ordered with operator<=>. Lookups are heterogeneous: anything
+/// which can be compared with the key using <=> can be used to find it.
+template <typename key_t, allocator_c backing_allocator_t = ok::allocator_t>
+class flat_set_t
+{
+    static_assert(!stdc::is_reference_c<key_t>,
+                  "flat_set_t cannot store references, use pointers instead.");
+    static_assert(ok::detail::default_searchable_c<key_t, key_t>,
+                  "flat_set_t keys must be ordered with operator<=>.");
+    static_assert(stdc::is_move_constructible_v<key_t> &&
+                      stdc::is_move_assignable_v<key_t>,
+                  "flat_set_t sorts its keys when inserting many at once, so "
+                  "they must be move constructible and move assignable.");
+
+    using keys_t = arraylist_t<key_t, backing_allocator_t>;
+
+    struct members_t
+    {
+        keys_t keys;
+    } m;
+
+  public:
+    using key_type = key_t;
+    using value_type = key_t;
+
+    template <typename>
+    friend struct flat_set::detail::from_unsorted_t;
+
+    explicit flat_set_t(backing_allocator_t& allocator) OKAYLIB_NOEXCEPT
+        : m(members_t{.keys = arraylist::empty<key_t>(allocator)})
+    {
+    }
+
+    flat_set_t(flat_set_t&&) = default;
+    flat_set_t& operator=(flat_set_t&&) = default;
+
+    flat_set_t(const flat_set_t&) = delete;
+    flat_set_t& operator=(const flat_set_t&) = delete;
+
+    [[nodiscard]] constexpr size_t size() const noexcept
+    {
+        return m.keys.size();
+    }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return m.keys.is_empty();
+    }
+
+    /// Make room for num_items in total without reallocating.
+    [[nodiscard]] constexpr status<alloc::error>
+    reserve(size_t num_items) OKAYLIB_NOEXCEPT
+    {
+        return m.keys.reserve_exact(num_items);
+    }
+
+    /// The keys, in increasing order.
+    [[nodiscard]] constexpr slice<const key_t> items() const OKAYLIB_NOEXCEPT
+    {
+        return m.keys.items();
+    }
+
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    [[nodiscard]] constexpr bool
+    contains(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        const slice<const key_t> keys = this->items();
+        const size_t index = ok::lower_bound(keys, key);
+        return index != keys.size() &&
+               (keys.unchecked_access(index) <=> key) == 0;
+    }
+
+    /// Returns true if the key was added, or false if it was already there.
+    template <typename key_arg_t>
+        requires(ok::detail::default_searchable_c<key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&>)
+    [[nodiscard]] constexpr res<bool, alloc::error>
+    insert(key_arg_t&& key) OKAYLIB_NOEXCEPT
+    {
+        const slice<const key_t> keys = this->items();
+        const size_t index = ok::lower_bound(keys, key);
+        if (index != keys.size() && (keys.unchecked_access(index) <=> key) == 0)
+            return false;
+        if (auto status =
+                m.keys.insert_at(index, stdc::forward<key_arg_t>(key));
+            !status.is_success()) [[unlikely]]
+            return status;
+        return true;
+    }
+
+    /// Insert every key from an iterator. The new keys are sorted and then
+    /// merged with the old ones in one pass, so this is O(n + m log m)
+    /// instead of O(n * m). If an allocation fails, the set is left
+    /// unchanged.
+    template <iterator_c iterator_t>
+    [[nodiscard]] constexpr status<alloc::error>
+    insert_iterator(iterator_t&& iterator) OKAYLIB_NOEXCEPT
+    {
+        static_assert(!ok::detail::infinite_iterator_c<iterator_t>,
+                      "Cannot insert an infinite iterator into a flat_set_t.");
+        backing_allocator_t& allocator = m.keys.allocator();
+
+        keys_t incoming = arraylist::empty<key_t>(allocator);
+        if constexpr (ok::detail::sized_iterator_c<iterator_t>) {
+            if (auto status = incoming.reserve_exact(iterator.size());
+                !status.is_success()) [[unlikely]]
+                return status;
+        }
+        while (auto item = iterator.next()) {
+            auto status = incoming.append(stdc::move(item.ref_unchecked()));
+            if (!status.is_success()) [[unlikely]]
+                return status;
+        }
+        if (incoming.is_empty())
+            return alloc::error::success;
+        ok::sort(incoming.items());
+
+        auto merged = arraylist::spots_preallocated<key_t>(
+            allocator, m.keys.size() + incoming.size());
+        if (!merged.is_success()) [[unlikely]]
+            return merged.status();
+        keys_t& keys = merged.unwrap();
+
+        // nothing can fail from here on. equal keys are kept once, and the
+        // ones already in the set win
+        const slice<key_t> old_keys = m.keys.items();
+        const slice<key_t> sorted = incoming.items();
+        size_t old_index = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            key_t& key = sorted.unchecked_access(i);
+            if (i != 0 && !(sorted.unchecked_access(i - 1) < key))
+                continue;
+            while (old_index < old_keys.size() &&
+                   old_keys.unchecked_access(old_index) < key) {
+                keys.append_assume_capacity(
+                    stdc::move(old_keys.unchecked_access(old_index)));
+                ++old_index;
+            }
+            if (old_index < old_keys.size() &&
+                !(key < old_keys.unchecked_access(old_index)))
+                continue;
+            keys.append_assume_capacity(stdc::move(key));
+        }
+        for (; old_index < old_keys.size(); ++old_index) {
+            keys.append_assume_capacity(
+                stdc::move(old_keys.unchecked_access(old_index)));
+        }
+
+        m.keys = stdc::move(keys);
+        return alloc::error::success;
+    }
+
+    /// Returns whether the key was in the set.
+    template <typename lookup_t>
+        requires ok::detail::default_searchable_c<key_t, lookup_t>
+    constexpr bool remove(const lookup_t& key) OKAYLIB_NOEXCEPT
+    {
+        const slice<const key_t> keys = this->items();
+        const size_t index = ok::lower_bound(keys, key);
+        if (index == keys.size() || (keys.unchecked_access(index) <=> key) != 0)
+            return false;
+        m.keys.remove(index);
+        return true;
+    }
+
+    /// Remove every key, keeping the allocation.
+    constexpr void clear() OKAYLIB_NOEXCEPT { m.keys.clear(); }
+
+    /// Iterate over the keys in increasing order. The iterator is arraylike,
+    /// so it can be indexed and reversed.
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ok::iter(this->items());
+    }
+
+    constexpr auto iter() const&& = delete;
+};
+
+namespace flat_set {
+namespace detail {
+template <typename key_t> struct from_unsorted_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::flat_set_t<key_t, ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t, iterator_c input_iterator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               input_iterator_t&& iterator) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator,
+                        stdc::forward<input_iterator_t>(iterator));
+    }
+
+    template <allocator_c backing_allocator_t, iterator_c input_iterator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::flat_set_t<key_t, backing_allocator_t>& output,
+                     backing_allocator_t& allocator,
+                     input_iterator_t&& iterator) const OKAYLIB_NOEXCEPT
+    {
+        ok::flat_set_t<key_t, backing_allocator_t> set(allocator);
+        auto status =
+            set.insert_iterator(stdc::forward<input_iterator_t>(iterator));
+        if (!status.is_success()) [[unlikely]]
+            return status.as_enum();
+        stdc::construct_at(ok::addressof(output), stdc::move(set));
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Make a set from an iterator of keys in any order. The keys are sorted, and
+/// duplicates are dropped.
+/// flat_set::from_unsorted<key_t>(allocator, iterator)
+template <typename key_t>
+inline constexpr detail::from_unsorted_t<key_t> from_unsorted;
+} // namespace flat_set
+
+template <typename key_t, typename backing_allocator_t>
+struct is_trivially_relocatable<flat_set_t<key_t, backing_allocator_t>>
+    : stdc::true_type
+{};
+} // namespace ok
+
+#endif
@@ -0,0 +1,655 @@
+#ifndef __OKAYLIB_CONTAINERS_HASHMAP_H__
+#define __OKAYLIB_CONTAINERS_HASHMAP_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/detail/no_unique_addr.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/hash.h"
+#include "okay/iterables/iterables.h"
+#include "okay/math/math.h"
+#include "okay/math/rounding.h"
+#include "okay/opt.h"
+#include "okay/tuple.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ok {
+
+namespace hashmap::detail {
+/// Every slot of a table has a control byte: the low 7 bits of the hash of
+/// its key when it is full, or one of these when it is not. Both have the top
+/// bit on, so a slot is full exactly when its control byte is nonnegative.
+using ctrl_t = int8_t;
+inline constexpr ctrl_t ctrl_empty = -128;
+/// A slot which used to be full. Lookups have to keep probing past it.
+inline constexpr ctrl_t ctrl_deleted = -2;
+
+/// The slots of one group which matched some condition, with 1 << shift bits
+/// per slot of which only the highest may be on.
+template <typename bits_t, size_t shift> struct match_mask_t
+{
+    bits_t bits;
+
+    constexpr explicit operator bool() const noexcept { return bits != 0; }
+
+    [[nodiscard]] constexpr size_t lowest() const noexcept
+    {
+        return size_t(ok::count_trailing_zeros(bits)) >> shift;
+    }
+
+    constexpr void remove_lowest() noexcept { bits &= bits - 1; }
+};
+
+/// Eight control bytes at a time in a normal register, for platforms without
+/// SSE2 or NEON. Right after a real match, match() may also report a slot
+/// whose byte differs from h2 only in its lowest bit. That costs an extra key
+/// comparison but is otherwise harmless.
+struct portable_group_t
+{
+    static constexpr size_t width = 8;
+    using mask_t = match_mask_t<uint64_t, 3>;
+
+    static constexpr uint64_t lsbs = 0x0101010101010101ULL;
+    static constexpr uint64_t msbs = 0x8080808080808080ULL;
+
+    uint64_t ctrl;
+
+    [[nodiscard]] static portable_group_t load(const ctrl_t* group) noexcept
+    {
+        uint64_t ctrl;
+        ::memcpy(&ctrl, group, sizeof(ctrl));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        ctrl = __builtin_bswap64(ctrl);
+#endif
+        return {ctrl};
+    }
+
+    [[nodiscard]] constexpr mask_t match(uint8_t h2) const noexcept
+    {
+        const uint64_t zero_where_equal = ctrl ^ (lsbs * h2);
+        return {(zero_where_equal - lsbs) & ~zero_where_equal & msbs};
+    }
+
+    [[nodiscard]] constexpr mask_t match_empty() const noexcept
+    {
+        // empty is the only control byte with its top bit on and its second
+        // lowest bit off
+        return {ctrl & ~(ctrl << 6) & msbs};
+    }
+
+    [[nodiscard]] constexpr mask_t match_empty_or_deleted() const noexcept
+    {
+        return {ctrl & msbs};
+    }
+
+    [[nodiscard]] constexpr mask_t match_full() const noexcept
+    {
+        return {~ctrl & msbs};
+    }
+};
+
+#if defined(__SSE2__)
+struct sse2_group_t
+{
+    static constexpr size_t width = 16;
+    using mask_t = match_mask_t<uint32_t, 0>;
+
+    __m128i ctrl;
+
+    [[nodiscard]] static sse2_group_t load(const ctrl_t* group) noexcept
+    {
+        // groups start at multiples of 16 from a 16 byte aligned allocation
+        return {_mm_load_si128(reinterpret_cast<const __m128i*>(group))};
+    }
+
+    [[nodiscard]] mask_t match(uint8_t h2) const noexcept
+    {
+        return {uint32_t(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(char(h2)), ctrl)))};
+    }
+
+    [[nodiscard]] mask_t match_empty() const noexcept
+    {
+        return {uint32_t(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), ctrl)))};
+    }
+
+    [[nodiscard]] mask_t match_empty_or_deleted() const noexcept
+    {
+        return {uint32_t(_mm_movemask_epi8(ctrl))};
+    }
+
+    [[nodiscard]] mask_t match_full() const noexcept
+    {
+        return {uint32_t(_mm_movemask_epi8(ctrl)) ^ 0xffffU};
+    }
+};
+#elif defined(__ARM_NEON)
+struct neon_group_t
+{
+    static constexpr size_t width = 16;
+    using mask_t = match_mask_t<uint64_t, 2>;
+
+    int8x16_t ctrl;
+
+    [[nodiscard]] static neon_group_t load(const ctrl_t* group) noexcept
+    {
+        return {vld1q_s8(group)};
+    }
+
+    /// NEON has no movemask, so narrow each byte of the comparison to a
+    /// nibble and keep the top bit of each nibble.
+    [[nodiscard]] static mask_t to_mask(uint8x16_t matches) noexcept
+    {
+        const uint8x8_t nibbles =
+            vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+        return {vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) &
+                0x8888888888888888ULL};
+    }
+
+    [[nodiscard]] mask_t match(uint8_t h2) const noexcept
+    {
+        return to_mask(vceqq_s8(ctrl, vdupq_n_s8(int8_t(h2))));
+    }
+
+    [[nodiscard]] mask_t match_empty() const noexcept
+    {
+        return to_mask(vceqq_s8(ctrl, vdupq_n_s8(ctrl_empty)));
+    }
+
+    // these compare against a zero vector instead of using vcltzq_s8 and
+    // vcgezq_s8, which only exist on aarch64 and not on 32 bit arm
+    [[nodiscard]] mask_t match_empty_or_deleted() const noexcept
+    {
+        return to_mask(vcltq_s8(ctrl, vdupq_n_s8(0)));
+    }
+
+    [[nodiscard]] mask_t match_full() const noexcept
+    {
+        return to_mask(vcgeq_s8(ctrl, vdupq_n_s8(0)));
+    }
+};
+#endif
+
+#if defined(__SSE2__)
+using group_t = sse2_group_t;
+#elif defined(__ARM_NEON)
+using group_t = neon_group_t;
+#else
+using group_t = portable_group_t;
+#endif
+
+/// What tables with no allocation point at, so that lookups into them need no
+/// special case. It is never written to: inserting always allocates first.
+alignas(16) inline constexpr ctrl_t empty_group[16] = {
+    ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+    ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+    ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+};
+static_assert(group_t::width <= sizeof(empty_group));
+
+/// At most 7/8ths of the slots are used before the table grows, so probing
+/// always finds an empty slot eventually.
+[[nodiscard]] constexpr size_t growth_limit(size_t capacity) noexcept
+{
+    return capacity - capacity / 8;
+}
+
+/// The number of slots needed to hold num_items without growing.
+[[nodiscard]] constexpr size_t slots_needed_for(size_t num_items) noexcept
+{
+    size_t slots = group_t::width;
+    while (growth_limit(slots) < num_items)
+        slots *= 2;
+    return slots;
+}
+} // namespace hashmap::detail
+
+/// A hash map which stores its keys and values inline in one allocation, in
+/// the style of Swiss tables. Each slot has a one byte tag holding 7 bits of
+/// its key's hash, and lookups compare a whole group of tags at once (16 with
+/// SSE2 or NEON, 8 otherwise) so that keys are only compared when their tags
+/// match. Groups are probed quadratically.
+///
+/// Lookups are heterogeneous: anything which the hasher hashes the same way
+/// as the key, and which can be compared with the key using ==, can be used
+/// to find it. For example, ascii_view keys can be looked up with string
+/// literals. Custom hashers must spread their bits well, since both the low
+/// and high bits of the hash are used.
+///
+/// Inserting into the map invalidates references to its items when it grows.
+template <typename key_t, typename value_t,
+          allocator_c backing_allocator_t = ok::allocator_t,
+          typename hasher_t = ok::hasher_t>
+class hashmap_t
+{
+    static_assert(!stdc::is_reference_c<key_t> &&
+                      !stdc::is_reference_c<value_t>,
+                  "hashmap_t cannot store references, use pointers instead.");
+
+    using group_t = hashmap::detail::group_t;
+    using ctrl_t = hashmap::detail::ctrl_t;
+
+    struct slot_t
+    {
+        key_t key;
+        value_t value;
+
+        template <typename key_arg_t, typename... args_t>
+        constexpr slot_t(key_arg_t&& key_arg, args_t&&... args)
+            : key(stdc::forward<key_arg_t>(key_arg)),
+              value(stdc::forward<args_t>(args)...)
+        {
+        }
+    };
+
+    static constexpr bool slots_are_trivially_relocatable =
+        is_trivially_relocatable_v<key_t> &&
+        is_trivially_relocatable_v<value_t>;
+
+    static constexpr size_t not_found = size_t(-1);
+
+    struct members_t
+    {
+        ctrl_t* ctrl;
+        slot_t* slots;
+        // zero while pointing at the shared empty group
+        size_t capacity;
+        size_t group_mask;
+        size_t size;
+        // how many more empty slots can be filled before growing
+        size_t growth_left;
+        backing_allocator_t* allocator;
+        OKAYLIB_NO_UNIQUE_ADDR hasher_t hasher;
+    } m;
+
+    template <bool is_const> struct cursor_t
+    {
+        using container_t =
+            stdc::conditional_t<is_const, const hashmap_t, hashmap_t>;
+        using value_type = ok::tuple<
+            const key_t&,
+            stdc::conditional_t<is_const, const value_t&, value_t&>>;
+
+        size_t index = 0;
+
+        [[nodiscard]] constexpr opt<value_type>
+        next(container_t& map) OKAYLIB_NOEXCEPT
+        {
+            while (index < map.m.capacity) {
+                const size_t current = index++;
+                if (map.m.ctrl[current] >= 0) {
+                    slot_t& slot = map.m.slots[current];
+                    return value_type(slot.key, slot.value);
+                }
+            }
+            return nullopt;
+        }
+    };
+
+    [[nodiscard]] static constexpr ctrl_t h2_of(uint64_t hash) noexcept
+    {
+        return ctrl_t(hash & 0x7f);
+    }
+
+    /// The first slot along the probe sequence of a hash which is empty or
+    /// deleted.
+    [[nodiscard]] static size_t
+    find_insert_index(const ctrl_t* ctrl, size_t group_mask,
+                      uint64_t hash) OKAYLIB_NOEXCEPT
+    {
+        size_t group = (hash >> 7) & group_mask;
+        for (size_t step = 1;; ++step) {
+            const auto available =
+                group_t::load(ctrl + group * group_t::width)
+                    .match_empty_or_deleted();
+            if (available) [[likely]]
+                return group * group_t::width + available.lowest();
+            group = (group + step) & group_mask;
+        }
+    }
+
+    template <typename lookup_t>
+    [[nodiscard]] size_t find_index(const lookup_t& key,
+                                    uint64_t hash) const OKAYLIB_NOEXCEPT
+    {
+        const uint8_t h2 = uint8_t(h2_of(hash));
+        size_t group = (hash >> 7) & m.group_mask;
+        for (size_t step = 1;; ++step) {
+            const group_t tags = group_t::load(m.ctrl + group * group_t::width);
+            for (auto matches = tags.match(h2); matches;
+                 matches.remove_lowest()) {
+                const size_t index =
+                    group * group_t::width + matches.lowest();
+                if (m.slots[index].key == key) [[likely]]
+                    return index;
+            }
+            // if this group has room, an insertion of the key would have
+            // stopped here
+            if (tags.match_empty()) [[likely]]
+                return not_found;
+            group = (group + step) & m.group_mask;
+        }
+    }
+
+    constexpr void destroy_slots() noexcept
+    {
+        if constexpr (!stdc::is_trivially_destructible_v<slot_t>) {
+            for (size_t i = 0; i < m.capacity; ++i) {
+                if (m.ctrl[i] >= 0)
+                    m.slots[i].~slot_t();
+            }
+        }
+    }
+
+    constexpr void destroy() noexcept
+    {
+        if (m.capacity == 0)
+            return;
+        this->destroy_slots();
+        m.allocator->deallocate(m.ctrl);
+    }
+
+    constexpr void reset_to_empty_group() noexcept
+    {
+        m.ctrl = const_cast<ctrl_t*>(hashmap::detail::empty_group);
+        m.slots = nullptr;
+        m.capacity = 0;
+        m.group_mask = 0;
+        m.size = 0;
+        m.growth_left = 0;
+    }
+
+    /// Move every item into a new allocation with new_capacity slots. This
+    /// also clears out deleted slots.
+    [[nodiscard]] status<alloc::error>
+    rehash(size_t new_capacity) OKAYLIB_NOEXCEPT
+    {
+        __ok_internal_assert(new_capacity % group_t::width == 0);
+        __ok_internal_assert(hashmap::detail::growth_limit(new_capacity) >=
+                             m.size);
+        const size_t slots_offset =
+            runtime_round_up_to_multiple_of(alignof(slot_t), new_capacity);
+        auto allocation = m.allocator->allocate(alloc::request_t{
+            .num_bytes = slots_offset + new_capacity * sizeof(slot_t),
+            .alignment = alignof(slot_t) > 16 ? alignof(slot_t) : 16,
+            .leave_nonzeroed = true,
+        });
+        if (!allocation.is_success()) [[unlikely]]
+            return allocation.status();
+
+        uint8_t* const bytes =
+            allocation.unwrap().unchecked_address_of_first_item();
+        auto* const new_ctrl = reinterpret_cast<ctrl_t*>(bytes);
+        auto* const new_slots = reinterpret_cast<slot_t*>(bytes + slots_offset);
+        const size_t new_group_mask = new_capacity / group_t::width - 1;
+        ::memset(new_ctrl, uint8_t(hashmap::detail::ctrl_empty), new_capacity);
+
+        for (size_t i = 0; i < m.capacity; ++i) {
+            if (m.ctrl[i] < 0)
+                continue;
+            slot_t& slot = m.slots[i];
+            const uint64_t hash = m.hasher(slot.key);
+            const size_t index =
+                find_insert_index(new_ctrl, new_group_mask, hash);
+            new_ctrl[index] = h2_of(hash);
+            if constexpr (slots_are_trivially_relocatable) {
+                ::memcpy((void*)(new_slots + index), (void*)ok::addressof(slot),
+                         sizeof(slot_t));
+            } else {
+                stdc::construct_at(new_slots + index, stdc::move(slot));
+                slot.~slot_t();
+            }
+        }
+
+        if (m.capacity != 0)
+            m.allocator->deallocate(m.ctrl);
+        m.ctrl = new_ctrl;
+        m.slots = new_slots;
+        m.capacity = new_capacity;
+        m.group_mask = new_group_mask;
+        m.growth_left = hashmap::detail::growth_limit(new_capacity) - m.size;
+        return alloc::error::success;
+    }
+
+    /// Make room for one more item, either by clearing out deleted slots if
+    /// they are taking up a lot of the table, or by doubling its size.
+    [[nodiscard]] status<alloc::error> grow() OKAYLIB_NOEXCEPT
+    {
+        if (m.capacity == 0)
+            return this->rehash(group_t::width);
+        if (m.size <= hashmap::detail::growth_limit(m.capacity) / 2)
+            return this->rehash(m.capacity);
+        return this->rehash(m.capacity * 2);
+    }
+
+    /// Find the slot of a key, or prepare an empty one for it.
+    template <typename key_arg_t>
+    [[nodiscard]] status<alloc::error>
+    find_or_prepare_insert(const key_arg_t& key, size_t& index,
+                           bool& is_new) OKAYLIB_NOEXCEPT
+    {
+        const uint64_t hash = m.hasher(key);
+        index = this->find_index(key, hash);
+        if (index != not_found) {
+            is_new = false;
+            return alloc::error::success;
+        }
+
+        index = find_insert_index(m.ctrl, m.group_mask, hash);
+        // deleted slots can be reused without using up any growth
+        if (m.growth_left == 0 &&
+            m.ctrl[index] == hashmap::detail::ctrl_empty) [[unlikely]] {
+            auto status = this->grow();
+            if (!status.is_success()) [[unlikely]]
+                return status;
+            index = find_insert_index(m.ctrl, m.group_mask, hash);
+        }
+        m.growth_left -= m.ctrl[index] == hashmap::detail::ctrl_empty;
+        m.ctrl[index] = h2_of(hash);
+        ++m.size;
+        is_new = true;
+        return alloc::error::success;
+    }
+
+    void erase_at(size_t index) noexcept
+    {
+        m.slots[index].~slot_t();
+        --m.size;
+        // if the group still has an empty slot, no probe sequence has ever
+        // gone past it, so the slot can be made empty instead of deleted
+        const size_t group_start = index & ~(group_t::width - 1);
+        if (group_t::load(m.ctrl + group_start).match_empty()) {
+            m.ctrl[index] = hashmap::detail::ctrl_empty;
+            ++m.growth_left;
+        } else {
+            m.ctrl[index] = hashmap::detail::ctrl_deleted;
+        }
+    }
+
+  public:
+    using key_type = key_t;
+    using mapped_type = value_t;
+
+    explicit hashmap_t(backing_allocator_t& allocator,
+                       hasher_t hasher = {}) OKAYLIB_NOEXCEPT
+        : m(members_t{
+              .ctrl = const_cast<ctrl_t*>(hashmap::detail::empty_group),
+              .slots = nullptr,
+              .capacity = 0,
+              .group_mask = 0,
+              .size = 0,
+              .growth_left = 0,
+              .allocator = ok::addressof(allocator),
+              .hasher = stdc::move(hasher),
+          })
+    {
+    }
+
+    hashmap_t(hashmap_t&& other) OKAYLIB_NOEXCEPT : m(stdc::move(other.m))
+    {
+        other.reset_to_empty_group();
+    }
+
+    hashmap_t& operator=(hashmap_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = stdc::move(other.m);
+        other.reset_to_empty_group();
+        return *this;
+    }
+
+    hashmap_t(const hashmap_t&) = delete;
+    hashmap_t& operator=(const hashmap_t&) = delete;
+
+    ~hashmap_t() { this->destroy(); }
+
+    [[nodiscard]] constexpr size_t size() const noexcept { return m.size; }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return m.size == 0;
+    }
+
+    /// How many items the map can hold before it next allocates.
+    [[nodiscard]] constexpr size_t capacity() const noexcept
+    {
+        return m.size + m.growth_left;
+    }
+
+    /// Make sure that the map can hold num_items items without allocating.
+    [[nodiscard]] status<alloc::error>
+    reserve(size_t num_items) OKAYLIB_NOEXCEPT
+    {
+        if (num_items <= this->capacity())
+            return alloc::error::success;
+        return this->rehash(hashmap::detail::slots_needed_for(num_items));
+    }
+
+    template <typename lookup_t>
+        requires hash_lookup_c<hasher_t, key_t, lookup_t>
+    [[nodiscard]] bool contains(const lookup_t& key) const OKAYLIB_NOEXCEPT
+    {
+        return this->find_index(key, m.hasher(key)) != not_found;
+    }
+
+    template <typename lookup_t>
+        requires hash_lookup_c<hasher_t, key_t, lookup_t>
+    [[nodiscard]] opt<value_t&> get(const lookup_t& key) & OKAYLIB_NOEXCEPT
+    {
+        const size_t index = this->find_index(key, m.hasher(key));
+        if (index == not_found)
+            return nullopt;
+        return m.slots[index].value;
+    }
+
+    template <typename lookup_t>
+        requires hash_lookup_c<hasher_t, key_t, lookup_t>
+    [[nodiscard]] opt<const value_t&>
+    get(const lookup_t& key) const& OKAYLIB_NOEXCEPT
+    {
+        const size_t index = this->find_index(key, m.hasher(key));
+        if (index == not_found)
+            return nullopt;
+        return m.slots[index].value;
+    }
+
+    /// Get the value of a key, constructing it from args if the key is not in
+    /// the map yet. If the key is already there, args are unused.
+    template <typename key_arg_t, typename... args_t>
+        requires(hash_lookup_c<hasher_t, key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&> &&
+                 stdc::is_constructible_v<value_t, args_t && ...>)
+    [[nodiscard]] res<value_t&, alloc::error>
+    get_or_insert(key_arg_t&& key, args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        size_t index;
+        bool is_new;
+        auto status = this->find_or_prepare_insert(key, index, is_new);
+        if (!status.is_success()) [[unlikely]]
+            return status;
+        if (is_new) {
+            stdc::construct_at(m.slots + index, stdc::forward<key_arg_t>(key),
+                               stdc::forward<args_t>(args)...);
+        }
+        return m.slots[index].value;
+    }
+
+    /// Put a value in the map, replacing any value the key already had.
+    template <typename key_arg_t, typename value_arg_t>
+        requires(hash_lookup_c<hasher_t, key_t, key_arg_t> &&
+                 stdc::is_constructible_v<key_t, key_arg_t &&> &&
+                 stdc::is_constructible_v<value_t, value_arg_t &&> &&
+                 stdc::is_assignable_v<value_t&, value_arg_t &&>)
+    [[nodiscard]] res<value_t&, alloc::error>
+    insert(key_arg_t&& key, value_arg_t&& value) OKAYLIB_NOEXCEPT
+    {
+        size_t index;
+        bool is_new;
+        auto status = this->find_or_prepare_insert(key, index, is_new);
+        if (!status.is_success()) [[unlikely]]
+            return status;
+        if (is_new) {
+            stdc::construct_at(m.slots + index, stdc::forward<key_arg_t>(key),
+                               stdc::forward<value_arg_t>(value));
+        } else {
+            m.slots[index].value = stdc::forward<value_arg_t>(value);
+        }
+        return m.slots[index].value;
+    }
+
+    /// Returns whether the key was in the map.
+    template <typename lookup_t>
+        requires hash_lookup_c<hasher_t, key_t, lookup_t>
+    bool remove(const lookup_t& key) OKAYLIB_NOEXCEPT
+    {
+        const size_t index = this->find_index(key, m.hasher(key));
+        if (index == not_found)
+            return false;
+        this->erase_at(index);
+        return true;
+    }
+
+    /// Remove every item, keeping the allocation.
+    void clear() noexcept
+    {
+        if (m.capacity == 0)
+            return;
+        this->destroy_slots();
+        ::memset(m.ctrl, uint8_t(hashmap::detail::ctrl_empty), m.capacity);
+        m.size = 0;
+        m.growth_left = hashmap::detail::growth_limit(m.capacity);
+    }
+
+    /// Iterate over (key, value) tuples in no particular order.
+    [[nodiscard]] constexpr auto iter() & OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<hashmap_t, cursor_t<false>>{*this,
+                                                          cursor_t<false>{}};
+    }
+
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<const hashmap_t, cursor_t<true>>{
+            *this, cursor_t<true>{}};
+    }
+
+    constexpr auto iter() const&& = delete;
+};
+
+template <typename key_t, typename value_t, typename backing_allocator_t,
+          typename hasher_t>
+struct is_trivially_relocatable<
+    hashmap_t<key_t, value_t, backing_allocator_t, hasher_t>>
+    : stdc::bool_constant<is_trivially_relocatable_v<hasher_t>>
+{};
+} // namespace ok
+
+#endif
@@ -0,0 +1,378 @@
+#ifndef __OKAYLIB_CONTAINERS_RANK_SELECT_INDEX_H__
+#define __OKAYLIB_CONTAINERS_RANK_SELECT_INDEX_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/math/math.h"
+#include "okay/opt.h"
+#include "okay/slice.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace ok {
+
+namespace rank_select_index::detail {
+struct for_bits_t;
+
+/// The index of the bit which is on and has n bits which are on before it.
+/// There must be more than n bits on in word.
+[[nodiscard]] constexpr size_t select_in_word(uint64_t word,
+                                              size_t n) OKAYLIB_NOEXCEPT
+{
+    __ok_internal_assert(n < size_t(ok::popcount(word)));
+#if defined(__BMI2__)
+    if (!stdc::is_constant_evaluated())
+        return ok::count_trailing_zeros(_pdep_u64(uint64_t(1) << n, word));
+#endif
+    // narrow down to a byte, then step through the bits in it
+    size_t position = 0;
+    for (size_t width = 32; width >= 8; width /= 2) {
+        const size_t low =
+            ok::popcount(word & ((uint64_t(1) << width) - 1));
+        if (n >= low) {
+            n -= low;
+            word >>= width;
+            position += width;
+        }
+    }
+    for (; n != 0; --n)
+        word &= word - 1;
+    return position + ok::count_trailing_zeros(word);
+}
+} // namespace rank_select_index::detail
+
+/// A succinct index over a bit slice which answers rank (how many bits are on
+/// before an index) and select (where is the nth bit which is on) queries
+/// without scanning the bits. It costs 64 bits for every 2048 bits indexed,
+/// about 3% of the size of the bits.
+///
+/// The index does not own the bits, it only refers to them. They must outlive
+/// the index, and must not be changed after the index is built.
+///
+/// Layout: for every block of 2048 bits, one 64 bit entry holds the number of
+/// bits on before the block (counted from the start of its 2^32 bit "big
+/// block", so that it fits in 32 bits) and the popcounts of the first three of
+/// its four 512 bit sub-blocks, in 10 bits each. A rank query reads one entry
+/// and at most eight words of bits. Select queries binary search the entries
+/// between two samples, which record the block containing every 16384th bit
+/// which is on, then do the same as rank.
+template <allocator_c backing_allocator_t = ok::allocator_t>
+class rank_select_index_t
+{
+  public:
+    friend struct ok::rank_select_index::detail::for_bits_t;
+
+    /// The bits which are indexed.
+    [[nodiscard]] constexpr const const_bit_slice_t& bits() const noexcept
+    {
+        return m.bits;
+    }
+
+    /// The number of bits which are on.
+    [[nodiscard]] constexpr size_t count_ones() const noexcept
+    {
+        return m.num_ones;
+    }
+
+    /// The number of bits which are on in [0, idx). idx may be the size of the
+    /// bits, in which case this is count_ones().
+    [[nodiscard]] constexpr size_t rank1(size_t idx) const OKAYLIB_NOEXCEPT
+    {
+        if (idx > m.bits.size()) [[unlikely]] {
+            __ok_abort("Out of bounds access in rank_select_index_t::rank1.");
+        }
+        if (idx == m.bits.size())
+            return m.num_ones;
+
+        const uint64_t entry = m.blocks[idx / block_bits];
+        size_t rank = m.big_blocks[big_block_of(idx)] +
+                      size_t(uint32_t(entry));
+
+        // add up the counts of the sub-blocks before idx, without branching
+        const size_t sub_block = (idx % block_bits) / sub_block_bits;
+        const uint64_t counts_before =
+            (entry >> 32) & ((uint64_t(1) << (10 * sub_block)) - 1);
+        rank += sub_block_count(counts_before << 32, 0) +
+                sub_block_count(counts_before << 32, 1) +
+                sub_block_count(counts_before << 32, 2);
+
+        size_t word_start = idx - idx % sub_block_bits;
+        for (; word_start + 64 <= idx; word_start += 64)
+            rank += ok::popcount(m.bits.get_word(word_start));
+        if (word_start < idx) {
+            const uint64_t before_idx =
+                (uint64_t(1) << (idx - word_start)) - 1;
+            rank += ok::popcount(m.bits.get_word(word_start) & before_idx);
+        }
+        return rank;
+    }
+
+    /// The number of bits which are off in [0, idx).
+    [[nodiscard]] constexpr size_t rank0(size_t idx) const OKAYLIB_NOEXCEPT
+    {
+        return idx - this->rank1(idx);
+    }
+
+    /// The index of the bit which is on and has n bits which are on before it,
+    /// or null if there are not that many bits on. rank1(select1(n)) == n.
+    [[nodiscard]] constexpr opt<size_t>
+    select1(size_t n) const OKAYLIB_NOEXCEPT
+    {
+        if (n >= m.num_ones)
+            return nullopt;
+
+        // the last block with at most n bits on before it, which is between the
+        // blocks containing the samples either side of it
+        const size_t sample = n / select_sample_rate;
+        size_t block = m.select_samples[sample];
+        size_t num_blocks = sample + 1 < m.num_select_samples
+                                ? m.select_samples[sample + 1] + 1 - block
+                                : m.num_blocks - block;
+        while (num_blocks > 1) {
+            const size_t half = num_blocks / 2;
+            block = this->ones_before_block(block + half) <= n ? block + half
+                                                               : block;
+            num_blocks -= half;
+        }
+
+        const uint64_t entry = m.blocks[block];
+        size_t remaining = n - this->ones_before_block(block);
+        size_t position = block * block_bits;
+        for (size_t i = 0; i < sub_blocks_per_entry; ++i) {
+            const size_t count = sub_block_count(entry, i);
+            if (remaining < count)
+                break;
+            remaining -= count;
+            position += sub_block_bits;
+        }
+
+        while (true) {
+            const uint64_t word = m.bits.get_word(position);
+            const size_t count = ok::popcount(word);
+            if (remaining < count) {
+                return position +
+                       rank_select_index::detail::select_in_word(word,
+                                                                 remaining);
+            }
+            remaining -= count;
+            position += 64;
+            __ok_internal_assert(position < m.bits.size());
+        }
+    }
+
+    constexpr rank_select_index_t(rank_select_index_t&& other) OKAYLIB_NOEXCEPT
+        : m(other.m)
+    {
+        other.m.allocation = nullptr;
+        other.m.num_blocks = 0;
+    }
+
+    constexpr rank_select_index_t&
+    operator=(rank_select_index_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = other.m;
+        other.m.allocation = nullptr;
+        other.m.num_blocks = 0;
+        return *this;
+    }
+
+    rank_select_index_t(const rank_select_index_t&) = delete;
+    rank_select_index_t& operator=(const rank_select_index_t&) = delete;
+
+    constexpr ~rank_select_index_t() { destroy(); }
+
+  private:
+    static constexpr size_t block_bits = 2048;
+    static constexpr size_t sub_block_bits = 512;
+    // the last sub-block's count is implied by the next entry, so not stored
+    static constexpr size_t sub_blocks_per_entry = 3;
+    static constexpr size_t big_block_bits_log2 = 32;
+    static constexpr size_t select_sample_rate = 16384;
+
+    // shifts by big_block_bits_log2 are done in 64 bits, since that is the
+    // whole width of size_t on 32 bit targets
+    [[nodiscard]] static constexpr size_t big_block_of(size_t bit) noexcept
+    {
+        return size_t(uint64_t(bit) >> big_block_bits_log2);
+    }
+
+    [[nodiscard]] static constexpr size_t
+    sub_block_count(uint64_t entry, size_t sub_block) noexcept
+    {
+        return size_t(entry >> (32 + 10 * sub_block)) & 1023;
+    }
+
+    [[nodiscard]] constexpr size_t
+    ones_before_block(size_t block) const noexcept
+    {
+        return m.big_blocks[big_block_of(block * block_bits)] +
+               size_t(uint32_t(m.blocks[block]));
+    }
+
+    constexpr void destroy() noexcept
+    {
+        if (m.allocation)
+            m.allocator->deallocate(m.allocation);
+    }
+
+    struct members_t
+    {
+        const_bit_slice_t bits;
+        void* allocation;
+        // one entry for every 2048 bits, see the layout described above
+        const uint64_t* blocks;
+        // number of bits on before each 2^32 bit big block
+        const uint64_t* big_blocks;
+        // the block containing every select_sample_rate'th bit which is on
+        const uint64_t* select_samples;
+        size_t num_blocks;
+        size_t num_select_samples;
+        size_t num_ones;
+        backing_allocator_t* allocator;
+    } m;
+
+  public:
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    constexpr rank_select_index_t(members_t&& members) OKAYLIB_NOEXCEPT
+        : m(stdc::forward<members_t>(members))
+    {
+    }
+};
+
+namespace rank_select_index {
+namespace detail {
+struct for_bits_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::rank_select_index_t<ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               const const_bit_slice_t& bits) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, bits);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::rank_select_index_t<backing_allocator_t>& output,
+                     backing_allocator_t& allocator,
+                     const const_bit_slice_t& bits) const OKAYLIB_NOEXCEPT
+    {
+        using output_t = ok::rank_select_index_t<backing_allocator_t>;
+        constexpr size_t block_bits = output_t::block_bits;
+        constexpr size_t sub_block_bits = output_t::sub_block_bits;
+        constexpr uint64_t big_block_bits = uint64_t(1)
+                                            << output_t::big_block_bits_log2;
+        constexpr size_t select_sample_rate = output_t::select_sample_rate;
+
+        if (bits.is_empty()) {
+            stdc::construct_at(ok::addressof(output),
+                               typename output_t::members_t{
+                                   .bits = bits,
+                                   .allocation = nullptr,
+                                   .blocks = nullptr,
+                                   .big_blocks = nullptr,
+                                   .select_samples = nullptr,
+                                   .num_blocks = 0,
+                                   .num_select_samples = 0,
+                                   .num_ones = 0,
+                                   .allocator = ok::addressof(allocator),
+                               });
+            return alloc::error::success;
+        }
+
+        const size_t num_blocks =
+            round_up_to_multiple_of<block_bits>(bits.size()) / block_bits;
+        const size_t num_big_blocks =
+            output_t::big_block_of(bits.size() - 1) + 1;
+        // an extra pass over the bits, to know how many samples to make room
+        // for. counting is cheap next to the cache misses building the index
+        const size_t num_select_samples =
+            round_up_to_multiple_of<select_sample_rate>(bits.popcount()) /
+            select_sample_rate;
+
+        auto res = allocator.allocate(alloc::request_t{
+            .num_bytes = sizeof(uint64_t) *
+                         (num_blocks + num_big_blocks + num_select_samples),
+            .alignment = alignof(uint64_t),
+            .leave_nonzeroed = true,
+        });
+        if (!res.is_success()) [[unlikely]]
+            return res.status();
+
+        uint64_t* const blocks = reinterpret_cast<uint64_t*>(
+            res.unwrap().unchecked_address_of_first_item());
+        uint64_t* const big_blocks = blocks + num_blocks;
+        uint64_t* const select_samples = big_blocks + num_big_blocks;
+
+        size_t num_ones = 0;
+        size_t next_sample = 0;
+        for (size_t block = 0; block < num_blocks; ++block) {
+            const size_t block_start = block * block_bits;
+            const size_t big_block = output_t::big_block_of(block_start);
+            if (uint64_t(block_start) % big_block_bits == 0)
+                big_blocks[big_block] = num_ones;
+
+            uint64_t entry = num_ones - big_blocks[big_block];
+            for (size_t sub_block = 0; sub_block < block_bits / sub_block_bits;
+                 ++sub_block) {
+                const size_t sub_block_start =
+                    block_start + sub_block * sub_block_bits;
+                size_t count = 0;
+                for (size_t i = sub_block_start;
+                     i < sub_block_start + sub_block_bits && i < bits.size();
+                     i += 64) {
+                    count += ok::popcount(bits.get_word(i));
+                }
+                if (sub_block < output_t::sub_blocks_per_entry)
+                    entry |= uint64_t(count) << (32 + 10 * sub_block);
+                num_ones += count;
+            }
+            blocks[block] = entry;
+
+            for (; next_sample * select_sample_rate < num_ones; ++next_sample)
+                select_samples[next_sample] = block;
+        }
+        __ok_internal_assert(next_sample == num_select_samples);
+
+        stdc::construct_at(ok::addressof(output),
+                           typename output_t::members_t{
+                               .bits = bits,
+                               .allocation = blocks,
+                               .blocks = blocks,
+                               .big_blocks = big_blocks,
+                               .select_samples = select_samples,
+                               .num_blocks = num_blocks,
+                               .num_select_samples = num_select_samples,
+                               .num_ones = num_ones,
+                               .allocator = ok::addressof(allocator),
+                           });
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Build a rank/select index over some bits, which must outlive the index.
+inline constexpr detail::for_bits_t for_bits;
+} // namespace rank_select_index
+
+template <typename backing_allocator_t>
+struct is_trivially_relocatable<rank_select_index_t<backing_allocator_t>>
+    : stdc::true_type
+{};
+} // namespace ok
+
+#endif
@@ -0,0 +1,516 @@
+#ifndef __OKAYLIB_CONTAINERS_RING_DEQUE_H__
+#define __OKAYLIB_CONTAINERS_RING_DEQUE_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/iterables/iterables.h"
+#include "okay/math/math.h"
+#include "okay/math/ordering.h"
+#include "okay/opt.h"
+#include <cstring>
+
+namespace ok {
+
+namespace ring_deque {
+namespace detail {
+template <typename T> struct empty_t;
+template <typename T> struct spots_preallocated_t;
+} // namespace detail
+
+/// The items of a deque as two contiguous runs. See ring_deque_t::as_slices()
+template <typename T> struct slices_t
+{
+    slice<T> first;
+    slice<T> second;
+};
+} // namespace ring_deque
+
+/// A double ended queue stored in one ring buffer, with O(1) pushing and
+/// popping at both ends. The capacity is always a power of two, so the
+/// buffer position of an item is (head + index) & (capacity - 1) and indexing
+/// never divides.
+///
+/// The items are in at most two contiguous runs, which as_slices() gives out
+/// for bulk reads and writes. When the buffer fills up it doubles: if the
+/// items do not wrap around the end of the buffer, they stay where they are
+/// (and if the allocator can grow the buffer in place, nothing moves at
+/// all). Otherwise only the shorter of the two runs is moved.
+template <typename T, allocator_c backing_allocator_t = ok::allocator_t>
+class ring_deque_t
+{
+    static_assert(!stdc::is_reference_c<T>,
+                  "ring_deque_t cannot store references.");
+    static_assert(!is_const_c<T>,
+                  "Attempt to create a ring_deque_t with const objects, which "
+                  "is not possible. Remove the const, and consider passing a "
+                  "const reference to the deque instead.");
+    static_assert(stdc::is_move_constructible_v<T>,
+                  "Items of a ring_deque_t must be move constructible, "
+                  "otherwise they cannot be moved when the buffer grows.");
+
+    struct members_t
+    {
+        T* items;
+        // zero or a power of two
+        size_t capacity;
+        // buffer position of the first item
+        size_t head;
+        size_t size;
+        backing_allocator_t* allocator;
+    };
+    members_t m;
+
+    template <bool is_const> struct cursor_t
+    {
+      private:
+        size_t m_index = 0;
+
+      public:
+        constexpr cursor_t() = default;
+
+        using value_type = stdc::conditional_t<is_const, const T&, T&>;
+        using container_t =
+            stdc::conditional_t<is_const, const ring_deque_t, ring_deque_t>;
+
+        [[nodiscard]] constexpr size_t size(const ring_deque_t& deque) const
+        {
+            return deque.size();
+        }
+
+        [[nodiscard]] constexpr size_t index(const ring_deque_t&) const
+        {
+            return m_index;
+        }
+
+        constexpr void offset(const ring_deque_t&, int64_t offset_amount)
+        {
+            m_index += offset_amount;
+        }
+
+        [[nodiscard]] constexpr value_type access(container_t& deque)
+        {
+            __ok_assert(m_index < deque.size(),
+                        "Out of bounds iteration into ring_deque_t");
+            return deque.unchecked_access(m_index);
+        }
+    };
+
+    [[nodiscard]] constexpr size_t mask() const noexcept
+    {
+        return m.capacity - 1;
+    }
+
+    [[nodiscard]] constexpr T& unchecked_access(size_t index) const noexcept
+    {
+        return m.items[(m.head + index) & this->mask()];
+    }
+
+    /// Move count items into uninitialized memory which does not overlap
+    /// with them, leaving the memory they were in uninitialized.
+    static constexpr void relocate(T* dest, T* src, size_t count) noexcept
+    {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (count != 0)
+                ::memcpy((void*)dest, (void*)src, count * sizeof(T));
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                stdc::construct_at(dest + i, stdc::move(src[i]));
+                if constexpr (!stdc::is_trivially_destructible_v<T>)
+                    src[i].~T();
+            }
+        }
+    }
+
+    [[nodiscard]] constexpr status<alloc::error>
+    first_allocation(size_t capacity) OKAYLIB_NOEXCEPT
+    {
+        auto res = m.allocator->allocate(alloc::request_t{
+            .num_bytes = capacity * sizeof(T),
+            .alignment = alignof(T),
+            .leave_nonzeroed = true,
+        });
+        if (!res.is_success()) [[unlikely]]
+            return res.status();
+        m.items = reinterpret_cast<T*>(
+            res.unwrap().unchecked_address_of_first_item());
+        m.capacity = capacity;
+        m.head = 0;
+        return alloc::error::success;
+    }
+
+    /// Grow to new_capacity, which is a power of two bigger than the current
+    /// capacity. Items which do not wrap keep their buffer positions.
+    [[nodiscard]] constexpr status<alloc::error>
+    grow(size_t new_capacity) OKAYLIB_NOEXCEPT
+    {
+        using namespace alloc;
+        __ok_internal_assert(ok::is_power_of_two(new_capacity) &&
+                             new_capacity > m.capacity);
+        if (m.capacity == 0)
+            return this->first_allocation(new_capacity);
+
+        const size_t old_capacity = m.capacity;
+        const reallocate_request_t request{
+            .memory = reinterpret_as_bytes(raw_slice(*m.items, old_capacity)),
+            .new_size_bytes = new_capacity * sizeof(T),
+            .flags = realloc_flags::leave_nonzeroed,
+        };
+
+        if constexpr (is_trivially_relocatable_v<T>) {
+            // the allocator copies the whole buffer if it has to move it, so
+            // every item keeps its position
+            result_t<bytes_t> res = m.allocator->reallocate(request);
+            if (!res.is_success()) [[unlikely]]
+                return res.status();
+            m.items = reinterpret_cast<T*>(
+                res.unwrap().unchecked_address_of_first_item());
+        } else {
+            reallocate_request_t in_place = request;
+            in_place.flags =
+                in_place.flags | realloc_flags::in_place_orelse_fail;
+            result_t<potentially_in_place_reallocation_t> res =
+                reallocate_in_place_orelse_keep_old_nocopy(*m.allocator,
+                                                           in_place);
+            if (!res.is_success()) [[unlikely]]
+                return res.status();
+
+            auto& reallocation = res.unwrap();
+            if (!reallocation.was_in_place) {
+                // moving anyways, so straighten the items out while at it
+                T* const dest = reinterpret_cast<T*>(
+                    reallocation.memory.unchecked_address_of_first_item());
+                const size_t first_run =
+                    ok::min(m.size, old_capacity - m.head);
+                relocate(dest, m.items + m.head, first_run);
+                relocate(dest + first_run, m.items, m.size - first_run);
+                m.allocator->deallocate(m.items);
+                m.items = dest;
+                m.capacity = new_capacity;
+                m.head = 0;
+                return alloc::error::success;
+            }
+        }
+        m.capacity = new_capacity;
+
+        // the items are where they were in a buffer of old_capacity. if they
+        // wrapped around its end, move whichever run is shorter so that they
+        // are in order in the bigger buffer
+        if (m.head + m.size > old_capacity) {
+            const size_t first_run = old_capacity - m.head;
+            const size_t wrapped = m.size - first_run;
+            if (wrapped <= first_run) {
+                relocate(m.items + old_capacity, m.items, wrapped);
+            } else {
+                const size_t new_head = new_capacity - first_run;
+                relocate(m.items + new_head, m.items + m.head, first_run);
+                m.head = new_head;
+            }
+        }
+        return alloc::error::success;
+    }
+
+    [[nodiscard]] constexpr status<alloc::error>
+    ensure_room_for_one() OKAYLIB_NOEXCEPT
+    {
+        if (m.size < m.capacity) [[likely]]
+            return alloc::error::success;
+        return this->grow(m.capacity == 0 ? 4 : m.capacity * 2);
+    }
+
+    constexpr void destroy() noexcept
+    {
+        if (m.capacity == 0)
+            return;
+        this->clear();
+        m.allocator->deallocate(m.items);
+    }
+
+  public:
+    using value_type = T;
+
+    // this constructor should only be called by private implementations-
+    // members_t is private
+    constexpr ring_deque_t(members_t&& members) OKAYLIB_NOEXCEPT
+        : m(stdc::forward<members_t>(members))
+    {
+    }
+
+    friend struct ring_deque::detail::empty_t<T>;
+    friend struct ring_deque::detail::spots_preallocated_t<T>;
+
+    constexpr ring_deque_t(ring_deque_t&& other) OKAYLIB_NOEXCEPT : m(other.m)
+    {
+        other.m.items = nullptr;
+        other.m.capacity = 0;
+        other.m.head = 0;
+        other.m.size = 0;
+    }
+
+    constexpr ring_deque_t& operator=(ring_deque_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m = other.m;
+        other.m.items = nullptr;
+        other.m.capacity = 0;
+        other.m.head = 0;
+        other.m.size = 0;
+        return *this;
+    }
+
+    ring_deque_t(const ring_deque_t&) = delete;
+    ring_deque_t& operator=(const ring_deque_t&) = delete;
+
+    constexpr ~ring_deque_t() { this->destroy(); }
+
+    [[nodiscard]] constexpr size_t size() const noexcept { return m.size; }
+
+    [[nodiscard]] constexpr size_t capacity() const noexcept
+    {
+        return m.capacity;
+    }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return m.size == 0;
+    }
+
+    [[nodiscard]] constexpr T& operator[](size_t index) & OKAYLIB_NOEXCEPT
+    {
+        if (index >= m.size) [[unlikely]] {
+            __ok_abort("Out of bounds access to ok::ring_deque_t");
+        }
+        return this->unchecked_access(index);
+    }
+
+    [[nodiscard]] constexpr const T&
+    operator[](size_t index) const& OKAYLIB_NOEXCEPT
+    {
+        return (*const_cast<ring_deque_t*>(this))[index];
+    }
+
+    constexpr T& first() & OKAYLIB_NOEXCEPT
+    {
+        if (this->is_empty()) [[unlikely]] {
+            __ok_abort("Attempt to get first() item from empty ring_deque_t.");
+        }
+        return this->unchecked_access(0);
+    }
+
+    constexpr const T& first() const& OKAYLIB_NOEXCEPT
+    {
+        return const_cast<ring_deque_t*>(this)->first();
+    }
+
+    constexpr T& last() & OKAYLIB_NOEXCEPT
+    {
+        if (this->is_empty()) [[unlikely]] {
+            __ok_abort("Attempt to get last() item from empty ring_deque_t.");
+        }
+        return this->unchecked_access(m.size - 1);
+    }
+
+    constexpr const T& last() const& OKAYLIB_NOEXCEPT
+    {
+        return const_cast<ring_deque_t*>(this)->last();
+    }
+
+    /// Make the capacity at least num_items, rounded up to a power of two.
+    /// Does nothing if there is already enough capacity.
+    [[nodiscard]] constexpr status<alloc::error>
+    reserve(size_t num_items) OKAYLIB_NOEXCEPT
+    {
+        if (num_items <= m.capacity)
+            return alloc::error::success;
+        return this->grow(two_to_the_power_of(log2_uint_ceil(num_items)));
+    }
+
+    template <typename... args_t>
+        requires is_infallible_constructible_c<T, args_t...>
+    [[nodiscard]] constexpr alloc::result_t<T&>
+    push_back(args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        if (auto status = this->ensure_room_for_one(); !status.is_success())
+            [[unlikely]]
+            return status;
+        T& item = this->unchecked_access(m.size);
+        ok::make_into_uninitialized<T>(item, stdc::forward<args_t>(args)...);
+        ++m.size;
+        return item;
+    }
+
+    template <typename... args_t>
+        requires is_infallible_constructible_c<T, args_t...>
+    [[nodiscard]] constexpr alloc::result_t<T&>
+    push_front(args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        if (auto status = this->ensure_room_for_one(); !status.is_success())
+            [[unlikely]]
+            return status;
+        const size_t head = (m.head - 1) & this->mask();
+        ok::make_into_uninitialized<T>(m.items[head],
+                                       stdc::forward<args_t>(args)...);
+        m.head = head;
+        ++m.size;
+        return m.items[head];
+    }
+
+    constexpr opt<T> pop_front() OKAYLIB_NOEXCEPT
+    {
+        if (this->is_empty())
+            return {};
+        T& item = m.items[m.head];
+        opt<T> out(stdc::move(item));
+        if constexpr (!stdc::is_trivially_destructible_v<T>)
+            item.~T();
+        m.head = (m.head + 1) & this->mask();
+        --m.size;
+        return out;
+    }
+
+    constexpr opt<T> pop_back() OKAYLIB_NOEXCEPT
+    {
+        if (this->is_empty())
+            return {};
+        T& item = this->unchecked_access(m.size - 1);
+        opt<T> out(stdc::move(item));
+        if constexpr (!stdc::is_trivially_destructible_v<T>)
+            item.~T();
+        --m.size;
+        return out;
+    }
+
+    /// Remove every item, keeping the buffer.
+    constexpr void clear() OKAYLIB_NOEXCEPT
+    {
+        if constexpr (!stdc::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < m.size; ++i)
+                this->unchecked_access(i).~T();
+        }
+        m.head = 0;
+        m.size = 0;
+    }
+
+    /// The items in order, as two contiguous runs: the first from the front
+    /// of the deque up to the end of the buffer, and the second, which is
+    /// empty unless the items wrap around, from the start of the buffer.
+    [[nodiscard]] constexpr ring_deque::slices_t<T>
+    as_slices() & OKAYLIB_NOEXCEPT
+    {
+        const size_t first_run = ok::min(m.size, m.capacity - m.head);
+        const size_t wrapped = m.size - first_run;
+        return {
+            .first = first_run == 0 ? make_null_slice<T>()
+                                    : raw_slice(m.items[m.head], first_run),
+            .second = wrapped == 0 ? make_null_slice<T>()
+                                   : raw_slice(*m.items, wrapped),
+        };
+    }
+
+    [[nodiscard]] constexpr ring_deque::slices_t<const T>
+    as_slices() const& OKAYLIB_NOEXCEPT
+    {
+        auto [first, second] = const_cast<ring_deque_t*>(this)->as_slices();
+        return {.first = first, .second = second};
+    }
+
+    /// Iterate from front to back. The iterator is arraylike, so it can be
+    /// indexed and reversed.
+    [[nodiscard]] constexpr auto iter() & OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<ring_deque_t, cursor_t<false>>{
+            *this, cursor_t<false>{}};
+    }
+
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<const ring_deque_t, cursor_t<true>>{
+            *this, cursor_t<true>{}};
+    }
+
+    [[nodiscard]] constexpr auto iter() && OKAYLIB_NOEXCEPT
+    {
+        return owning_arraylike_iterator_t<ring_deque_t, cursor_t<false>>{
+            stdc::move(*this), cursor_t<false>{}};
+    }
+};
+
+namespace ring_deque {
+namespace detail {
+template <typename T> struct empty_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make;
+
+    template <typename backing_allocator_arg_t>
+    using associated_type =
+        ring_deque_t<T, stdc::remove_cvref_t<backing_allocator_arg_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr ring_deque_t<T, backing_allocator_t>
+    operator()(backing_allocator_t& allocator) const noexcept
+    {
+        return typename ring_deque_t<T, backing_allocator_t>::members_t{
+            .items = nullptr,
+            .capacity = 0,
+            .head = 0,
+            .size = 0,
+            .allocator = ok::addressof(allocator),
+        };
+    }
+};
+
+template <typename T> struct spots_preallocated_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::ring_deque_t<T, ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               size_t num_spots_preallocated) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, num_spots_preallocated);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::ring_deque_t<T, backing_allocator_t>& output,
+                     backing_allocator_t& allocator,
+                     size_t num_spots_preallocated) const OKAYLIB_NOEXCEPT
+    {
+        ok::ring_deque_t<T, backing_allocator_t> deque =
+            empty_t<T>{}(allocator);
+        auto status = deque.reserve(num_spots_preallocated);
+        if (!status.is_success()) [[unlikely]]
+            return status.as_enum();
+        stdc::construct_at(ok::addressof(output), stdc::move(deque));
+        return alloc::error::success;
+    }
+};
+} // namespace detail
+
+/// Make a deque which does not allocate until the first push.
+/// ring_deque::empty<T>(allocator)
+template <typename T> inline constexpr detail::empty_t<T> empty;
+
+/// Make a deque with room for at least num_spots_preallocated items, rounded
+/// up to a power of two.
+/// ring_deque::spots_preallocated<T>(allocator, num_spots_preallocated)
+template <typename T>
+inline constexpr detail::spots_preallocated_t<T> spots_preallocated;
+} // namespace ring_deque
+
+template <typename T, typename backing_allocator_t>
+struct is_trivially_relocatable<ring_deque_t<T, backing_allocator_t>>
+    : stdc::true_type
+{};
+} // namespace ok
+
+#endif
@@ -0,0 +1,1606 @@
+#ifndef __OKAYLIB_CONTAINERS_ROARING_BITMAP_H__
+#define __OKAYLIB_CONTAINERS_ROARING_BITMAP_H__
+
+#include "okay/algorithm/binary_search.h"
+#include "okay/allocators/allocator.h"
+#include "okay/containers/arraylist.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/iterables/iterables.h"
+#include "okay/math/math.h"
+#include "okay/opt.h"
+#include "okay/slice.h"
+
+// bitmap containers are stored in 64 bit words but scanned as bytes through
+// bit slices, which only agree on the order of the bits on little endian
+// targets
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "okay/containers/roaring_bitmap.h requires a little endian target"
+#endif
+
+namespace ok {
+
+namespace roaring_bitmap {
+enum class deserialize_error : uint8_t
+{
+    success,
+    // the allocator could not provide memory for the containers
+    alloc_failure,
+    // the bytes were not written by roaring_bitmap_t::serialize_into()
+    malformed,
+};
+
+namespace detail {
+struct copy_t;
+struct deserialize_t;
+
+// containers with more values than this are stored as bitmaps
+inline constexpr uint32_t max_array_size = 4096;
+inline constexpr uint32_t bitmap_words = 65536 / 64;
+// past this many runs, a run container is bigger than a bitmap
+inline constexpr uint32_t max_useful_runs = 2048;
+inline constexpr uint32_t serialized_magic = 0x42524b4f; // "OKRB"
+
+enum class kind_t : uint8_t
+{
+    array,
+    bitmap,
+    run,
+};
+
+/// An inclusive range of values.
+struct run_t
+{
+    uint16_t first;
+    uint16_t last;
+};
+
+/// Holds the values which share the same upper 16 bits, in whichever
+/// representation is smallest for them. Does not own its memory: the
+/// roaring_bitmap_t it is in frees it.
+struct container_t
+{
+    // sorted values for arrays, 1024 words for bitmaps, or sorted runs which
+    // do not overlap or touch
+    void* data;
+    // number of values in an array or runs in a run container. unused for
+    // bitmaps
+    uint32_t size;
+    // number of values, words or runs which data has room for
+    uint32_t capacity;
+    uint32_t cardinality;
+    uint16_t key;
+    kind_t kind;
+
+    [[nodiscard]] constexpr uint16_t* values() const noexcept
+    {
+        return static_cast<uint16_t*>(data);
+    }
+
+    [[nodiscard]] constexpr uint64_t* words() const noexcept
+    {
+        return static_cast<uint64_t*>(data);
+    }
+
+    [[nodiscard]] constexpr run_t* runs() const noexcept
+    {
+        return static_cast<run_t*>(data);
+    }
+
+    [[nodiscard]] const_bit_slice_t bits() const OKAYLIB_NOEXCEPT
+    {
+        return raw_bit_slice(
+            raw_slice(*static_cast<const uint8_t*>(data), bitmap_words * 8),
+            bitmap_words * 64, 0);
+    }
+};
+
+[[nodiscard]] constexpr size_t item_bytes(kind_t kind) noexcept
+{
+    switch (kind) {
+    case kind_t::array:
+        return sizeof(uint16_t);
+    case kind_t::bitmap:
+        return sizeof(uint64_t);
+    case kind_t::run:
+        return sizeof(run_t);
+    }
+    return 0;
+}
+
+[[nodiscard]] constexpr uint32_t run_length(const run_t& run) noexcept
+{
+    return uint32_t(run.last) - uint32_t(run.first) + 1;
+}
+
+/// Index of the first value in an array container which is not less than low.
+[[nodiscard]] constexpr uint32_t lower_bound(const uint16_t* values,
+                                             uint32_t size,
+                                             uint16_t low) OKAYLIB_NOEXCEPT
+{
+    return uint32_t(ok::detail::partition_point(
+        values, size, [low](uint16_t value) { return value < low; }));
+}
+
+/// Index of the first run which starts after low.
+[[nodiscard]] constexpr uint32_t runs_upper_bound(const run_t* runs,
+                                                  uint32_t size,
+                                                  uint16_t low) OKAYLIB_NOEXCEPT
+{
+    return uint32_t(ok::detail::partition_point(
+        runs, size, [low](const run_t& run) { return run.first <= low; }));
+}
+
+[[nodiscard]] constexpr bool contains(const container_t& container,
+                                      uint16_t low) OKAYLIB_NOEXCEPT
+{
+    switch (container.kind) {
+    case kind_t::array: {
+        const uint32_t idx =
+            lower_bound(container.values(), container.size, low);
+        return idx < container.size && container.values()[idx] == low;
+    }
+    case kind_t::bitmap:
+        return (container.words()[low / 64] >> (low % 64)) & 1;
+    case kind_t::run: {
+        const uint32_t idx =
+            runs_upper_bound(container.runs(), container.size, low);
+        return idx != 0 && container.runs()[idx - 1].last >= low;
+    }
+    }
+    return false;
+}
+
+/// Turn the bits [first, last] of a bitmap on or off, returning how many of
+/// them changed.
+template <bool turn_on>
+constexpr uint32_t update_range(uint64_t* words, uint32_t first,
+                                uint32_t last) OKAYLIB_NOEXCEPT
+{
+    const auto update = [words](uint32_t word, uint64_t mask) -> uint32_t {
+        const uint64_t changed = turn_on ? ~words[word] & mask
+                                         : words[word] & mask;
+        words[word] ^= changed;
+        return uint32_t(ok::popcount(changed));
+    };
+    const uint32_t first_word = first / 64;
+    const uint32_t last_word = last / 64;
+    const uint64_t first_mask = ~uint64_t(0) << (first % 64);
+    const uint64_t last_mask = ~uint64_t(0) >> (63 - last % 64);
+    if (first_word == last_word)
+        return update(first_word, first_mask & last_mask);
+
+    uint32_t changed = update(first_word, first_mask);
+    for (uint32_t word = first_word + 1; word < last_word; ++word)
+        changed += update(word, ~uint64_t(0));
+    return changed + update(last_word, last_mask);
+}
+
+template <typename allocator_t>
+[[nodiscard]] constexpr alloc::result_t<container_t>
+make_container(allocator_t& allocator, kind_t kind, uint16_t key,
+               uint32_t capacity) OKAYLIB_NOEXCEPT
+{
+    __ok_internal_assert(capacity != 0);
+    auto res = allocator.allocate(alloc::request_t{
+        .num_bytes = capacity * item_bytes(kind),
+        .alignment = alignof(uint64_t),
+        // bitmaps start out with every bit off
+        .leave_nonzeroed = kind != kind_t::bitmap,
+    });
+    if (!res.is_success()) [[unlikely]]
+        return res.status();
+
+    bytes_t& bytes = res.unwrap();
+    return container_t{
+        .data = bytes.unchecked_address_of_first_item(),
+        .size = 0,
+        .capacity = uint32_t(bytes.size() / item_bytes(kind)),
+        .cardinality = 0,
+        .key = key,
+        .kind = kind,
+    };
+}
+
+/// Make room for at least capacity values or runs, growing geometrically.
+template <typename allocator_t>
+[[nodiscard]] constexpr status<alloc::error>
+reserve(allocator_t& allocator, container_t& container,
+        uint32_t capacity) OKAYLIB_NOEXCEPT
+{
+    __ok_internal_assert(container.kind != kind_t::bitmap);
+    if (capacity <= container.capacity)
+        return alloc::error::success;
+
+    const size_t bytes = item_bytes(container.kind);
+    uint32_t preferred = container.capacity * 2;
+    if (container.kind == kind_t::array && preferred > max_array_size)
+        preferred = max_array_size;
+
+    auto res = allocator.reallocate(alloc::reallocate_request_t{
+        .memory = raw_slice(*static_cast<uint8_t*>(container.data),
+                            container.capacity * bytes),
+        .new_size_bytes = capacity * bytes,
+        .preferred_size_bytes = preferred > capacity ? preferred * bytes : 0,
+        .alignment = alignof(uint64_t),
+        .flags = alloc::realloc_flags::leave_nonzeroed,
+    });
+    if (!res.is_success()) [[unlikely]]
+        return res.status();
+
+    bytes_t& reallocated = res.unwrap();
+    container.data = reallocated.unchecked_address_of_first_item();
+    container.capacity = uint32_t(reallocated.size() / bytes);
+    return alloc::error::success;
+}
+
+template <typename allocator_t>
+constexpr void replace(allocator_t& allocator, container_t& container,
+                       const container_t& replacement) OKAYLIB_NOEXCEPT
+{
+    __ok_internal_assert(container.key == replacement.key);
+    allocator.deallocate(container.data);
+    container = replacement;
+}
+
+template <typename allocator_t>
+[[nodiscard]] constexpr alloc::result_t<container_t>
+clone(allocator_t& allocator, const container_t& source) OKAYLIB_NOEXCEPT
+{
+    const uint32_t count =
+        source.kind == kind_t::bitmap ? bitmap_words : source.size;
+    auto res = make_container(allocator, source.kind, source.key, count);
+    if (!res.is_success()) [[unlikely]]
+        return res;
+    container_t& out = res.unwrap();
+    ::memcpy(out.data, source.data, count * item_bytes(source.kind));
+    out.size = source.size;
+    out.cardinality = source.cardinality;
+    return res;
+}
+
+/// A new bitmap container holding the same values as source.
+template <typename allocator_t>
+[[nodiscard]] constexpr alloc::result_t<container_t>
+to_bitmap(allocator_t& allocator, const container_t& source) OKAYLIB_NOEXCEPT
+{
+    auto res =
+        make_container(allocator, kind_t::bitmap, source.key, bitmap_words);
+    if (!res.is_success()) [[unlikely]]
+        return res;
+    container_t& out = res.unwrap();
+    uint64_t* const words = out.words();
+    switch (source.kind) {
+    case kind_t::array:
+        for (uint32_t i = 0; i < source.size; ++i) {
+            const uint16_t low = source.values()[i];
+            words[low / 64] |= uint64_t(1) << (low % 64);
+        }
+        break;
+    case kind_t::bitmap:
+        ::memcpy(words, source.words(), bitmap_words * sizeof(uint64_t));
+        break;
+    case kind_t::run:
+        for (uint32_t i = 0; i < source.size; ++i) {
+            update_range<true>(words, source.runs()[i].first,
+                               source.runs()[i].last);
+        }
+        break;
+    }
+    out.cardinality = source.cardinality;
+    return res;
+}
+
+/// Turn a bitmap with few enough values into an array, and a run container
+/// with too many runs into a bitmap or array. If allocating the new
+/// representation fails, the old one is kept, since it is still correct.
+template <typename allocator_t>
+constexpr void settle(allocator_t& allocator,
+                      container_t& container) OKAYLIB_NOEXCEPT
+{
+    if (container.cardinality == 0)
+        return;
+
+    if (container.kind == kind_t::run) {
+        if (container.size <= max_useful_runs)
+            return;
+        auto bitmap = detail::to_bitmap(allocator, container);
+        if (!bitmap.is_success()) [[unlikely]]
+            return;
+        detail::replace(allocator, container, bitmap.unwrap());
+    }
+
+    if (container.kind != kind_t::bitmap ||
+        container.cardinality > max_array_size)
+        return;
+
+    auto res = detail::make_container(allocator, kind_t::array, container.key,
+                                      container.cardinality);
+    if (!res.is_success()) [[unlikely]]
+        return;
+    container_t& array = res.unwrap();
+    for (size_t low : container.bits().iter_set_bits())
+        array.values()[array.size++] = uint16_t(low);
+    array.cardinality = array.size;
+    detail::replace(allocator, container, array);
+}
+
+template <typename allocator_t>
+[[nodiscard]] constexpr status<alloc::error>
+add(allocator_t& allocator, container_t& container,
+    uint16_t low) OKAYLIB_NOEXCEPT
+{
+    switch (container.kind) {
+    case kind_t::array: {
+        uint16_t* values = container.values();
+        const uint32_t idx = lower_bound(values, container.size, low);
+        if (idx < container.size && values[idx] == low)
+            return alloc::error::success;
+
+        if (container.size == max_array_size) {
+            auto bitmap = detail::to_bitmap(allocator, container);
+            if (!bitmap.is_success()) [[unlikely]]
+                return bitmap.status();
+            detail::replace(allocator, container, bitmap.unwrap());
+            return detail::add(allocator, container, low);
+        }
+        if (auto status = detail::reserve(allocator, container,
+                                          container.size + 1);
+            !status.is_success()) [[unlikely]] {
+            return status;
+        }
+        values = container.values();
+        ::memmove(values + idx + 1, values + idx,
+                  (container.size - idx) * sizeof(uint16_t));
+        values[idx] = low;
+        ++container.size;
+        break;
+    }
+    case kind_t::bitmap: {
+        uint64_t& word = container.words()[low / 64];
+        const uint64_t bit = uint64_t(1) << (low % 64);
+        if (word & bit)
+            return alloc::error::success;
+        word |= bit;
+        break;
+    }
+    case kind_t::run: {
+        run_t* runs = container.runs();
+        const uint32_t idx = runs_upper_bound(runs, container.size, low);
+        if (idx != 0 && runs[idx - 1].last >= low)
+            return alloc::error::success;
+
+        const bool joins_previous =
+            idx != 0 && uint32_t(runs[idx - 1].last) + 1 == low;
+        const bool joins_next =
+            idx < container.size && uint32_t(low) + 1 == runs[idx].first;
+        if (joins_previous && joins_next) {
+            runs[idx - 1].last = runs[idx].last;
+            ::memmove(runs + idx, runs + idx + 1,
+                      (container.size - idx - 1) * sizeof(run_t));
+            --container.size;
+        } else if (joins_previous) {
+            runs[idx - 1].last = low;
+        } else if (joins_next) {
+            runs[idx].first = low;
+        } else {
+            if (auto status = detail::reserve(allocator, container,
+                                              container.size + 1);
+                !status.is_success()) [[unlikely]] {
+                return status;
+            }
+            runs = container.runs();
+            ::memmove(runs + idx + 1, runs + idx,
+                      (container.size - idx) * sizeof(run_t));
+            runs[idx] = run_t{.first = low, .last = low};
+            ++container.size;
+        }
+        ++container.cardinality;
+        detail::settle(allocator, container);
+        return alloc::error::success;
+    }
+    }
+    ++container.cardinality;
+    return alloc::error::success;
+}
+
+/// Can only fail when removing from the middle of a run splits it in two.
+template <typename allocator_t>
+[[nodiscard]] constexpr status<alloc::error>
+remove(allocator_t& allocator, container_t& container,
+       uint16_t low) OKAYLIB_NOEXCEPT
+{
+    switch (container.kind) {
+    case kind_t::array: {
+        uint16_t* const values = container.values();
+        const uint32_t idx = lower_bound(values, container.size, low);
+        if (idx == container.size || values[idx] != low)
+            return alloc::error::success;
+        ::memmove(values + idx, values + idx + 1,
+                  (container.size - idx - 1) * sizeof(uint16_t));
+        --container.size;
+        break;
+    }
+    case kind_t::bitmap: {
+        uint64_t& word = container.words()[low / 64];
+        const uint64_t bit = uint64_t(1) << (low % 64);
+        if (!(word & bit))
+            return alloc::error::success;
+        word &= ~bit;
+        break;
+    }
+    case kind_t::run: {
+        run_t* runs = container.runs();
+        const uint32_t idx = runs_upper_bound(runs, container.size, low);
+        if (idx == 0 || runs[idx - 1].last < low)
+            return alloc::error::success;
+
+        const run_t run = runs[idx - 1];
+        if (run.first == run.last) {
+            ::memmove(runs + idx - 1, runs + idx,
+                      (container.size - idx) * sizeof(run_t));
+            --container.size;
+        } else if (low == run.first) {
+            ++runs[idx - 1].first;
+        } else if (low == run.last) {
+            --runs[idx - 1].last;
+        } else {
+            if (auto status = detail::reserve(allocator, container,
+                                              container.size + 1);
+                !status.is_success()) [[unlikely]] {
+                return status;
+            }
+            runs = container.runs();
+            ::memmove(runs + idx + 1, runs + idx,
+                      (container.size - idx) * sizeof(run_t));
+            runs[idx - 1].last = low - 1;
+            runs[idx] = run_t{.first = uint16_t(low + 1), .last = run.last};
+            ++container.size;
+        }
+        break;
+    }
+    }
+    --container.cardinality;
+    detail::settle(allocator, container);
+    return alloc::error::success;
+}
+
+/// The runs which are in either a or b. out needs room for a.size + b.size.
+constexpr uint32_t union_runs(const container_t& a, const container_t& b,
+                              run_t* out) OKAYLIB_NOEXCEPT
+{
+    const run_t* const a_runs = a.runs();
+    const run_t* const b_runs = b.runs();
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t written = 0;
+    const auto take_next = [&]() -> run_t {
+        if (j == b.size || (i < a.size && a_runs[i].first < b_runs[j].first))
+            return a_runs[i++];
+        return b_runs[j++];
+    };
+
+    run_t current = take_next();
+    while (i < a.size || j < b.size) {
+        const run_t next = take_next();
+        if (uint32_t(next.first) <= uint32_t(current.last) + 1) {
+            if (next.last > current.last)
+                current.last = next.last;
+        } else {
+            out[written++] = current;
+            current = next;
+        }
+    }
+    out[written++] = current;
+    return written;
+}
+
+/// The runs which are in both a and b. out needs room for a.size + b.size.
+constexpr uint32_t intersect_runs(const container_t& a, const container_t& b,
+                                  run_t* out) OKAYLIB_NOEXCEPT
+{
+    const run_t* const a_runs = a.runs();
+    const run_t* const b_runs = b.runs();
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t written = 0;
+    while (i < a.size && j < b.size) {
+        const uint16_t first = a_runs[i].first > b_runs[j].first
+                                   ? a_runs[i].first
+                                   : b_runs[j].first;
+        const uint16_t last = a_runs[i].last < b_runs[j].last
+                                  ? a_runs[i].last
+                                  : b_runs[j].last;
+        if (first <= last)
+            out[written++] = run_t{.first = first, .last = last};
+        if (a_runs[i].last < b_runs[j].last)
+            ++i;
+        else
+            ++j;
+    }
+    return written;
+}
+
+/// The runs which are in a but not b. out needs room for a.size + b.size.
+constexpr uint32_t subtract_runs(const container_t& a, const container_t& b,
+                                 run_t* out) OKAYLIB_NOEXCEPT
+{
+    const run_t* const a_runs = a.runs();
+    const run_t* const b_runs = b.runs();
+    uint32_t j = 0;
+    uint32_t written = 0;
+    for (uint32_t i = 0; i < a.size; ++i) {
+        uint32_t start = a_runs[i].first;
+        const uint32_t last = a_runs[i].last;
+        while (j < b.size && b_runs[j].last < start)
+            ++j;
+        // runs of b which reach past this one may cut into the next one too,
+        // so j is not advanced past them
+        for (uint32_t k = j; k < b.size && b_runs[k].first <= last; ++k) {
+            if (b_runs[k].first > start) {
+                out[written++] = run_t{.first = uint16_t(start),
+                                       .last = uint16_t(b_runs[k].first - 1)};
+            }
+            start = uint32_t(b_runs[k].last) + 1;
+            if (start > last)
+                break;
+        }
+        if (start <= last) {
+            out[written++] =
+                run_t{.first = uint16_t(start), .last = uint16_t(last)};
+        }
+    }
+    return written;
+}
+
+/// Keep the values of a sorted array for which keep(value) is true, in place.
+template <typename keep_t>
+constexpr void filter_array(container_t& container,
+                            const keep_t& keep) OKAYLIB_NOEXCEPT
+{
+    uint16_t* const values = container.values();
+    uint32_t written = 0;
+    for (uint32_t i = 0; i < container.size; ++i) {
+        values[written] = values[i];
+        written += keep(values[i]);
+    }
+    container.size = written;
+    container.cardinality = written;
+}
+
+/// Filter an array in place, keeping the values which are (or with
+/// keep_matches false, are not) also in the sorted array b. Walks both
+/// arrays together when they are of similar size, otherwise searches the
+/// bigger one for each value of the smaller.
+template <bool keep_matches>
+constexpr void filter_array_by_array(container_t& a,
+                                     const container_t& b) OKAYLIB_NOEXCEPT
+{
+    const uint16_t* const b_values = b.values();
+    uint32_t j = 0;
+    if (a.size * 32 < b.size) {
+        filter_array(a, [&](uint16_t value) {
+            j += lower_bound(b_values + j, b.size - j, value);
+            return (j < b.size && b_values[j] == value) == keep_matches;
+        });
+    } else {
+        filter_array(a, [&](uint16_t value) {
+            while (j < b.size && b_values[j] < value)
+                ++j;
+            return (j < b.size && b_values[j] == value) == keep_matches;
+        });
+    }
+}
+
+/// Keep the values of an array which are (or are not) in some sorted runs.
+template <bool keep_matches>
+constexpr void filter_array_by_runs(container_t& a,
+                                    const container_t& b) OKAYLIB_NOEXCEPT
+{
+    const run_t* const runs = b.runs();
+    uint32_t j = 0;
+    filter_array(a, [&](uint16_t value) {
+        while (j < b.size && runs[j].last < value)
+            ++j;
+        return (j < b.size && runs[j].first <= value) == keep_matches;
+    });
+}
+
+/// Apply an operation on whole words to a bitmap, recounting it as it goes.
+template <typename combine_t>
+constexpr void combine_words(container_t& a, const container_t& b,
+                             const combine_t& combine) OKAYLIB_NOEXCEPT
+{
+    uint64_t* const a_words = a.words();
+    const uint64_t* const b_words = b.words();
+    uint32_t cardinality = 0;
+    for (uint32_t i = 0; i < bitmap_words; ++i) {
+        a_words[i] = combine(a_words[i], b_words[i]);
+        cardinality += uint32_t(ok::popcount(a_words[i]));
+    }
+    a.cardinality = cardinality;
+}
+
+enum class set_op
+{
+    union_with,
+    intersect_with,
+    subtract,
+};
+
+/// Replace two run containers' combination into a, as a new run container.
+template <set_op op, typename allocator_t>
+[[nodiscard]] constexpr status<alloc::error>
+combine_runs(allocator_t& allocator, container_t& a,
+             const container_t& b) OKAYLIB_NOEXCEPT
+{
+    auto res = detail::make_container(allocator, kind_t::run, a.key,
+                                      a.size + b.size);
+    if (!res.is_success()) [[unlikely]]
+        return res.status();
+    container_t& out = res.unwrap();
+    if constexpr (op == set_op::union_with)
+        out.size = union_runs(a, b, out.runs());
+    else if constexpr (op == set_op::intersect_with)
+        out.size = intersect_runs(a, b, out.runs());
+    else
+        out.size = subtract_runs(a, b, out.runs());
+    for (uint32_t i = 0; i < out.size; ++i)
+        out.cardinality += run_length(out.runs()[i]);
+    detail::replace(allocator, a, out);
+    detail::settle(allocator, a);
+    return alloc::error::success;
+}
+
+/// Combine b into a, which may change representation. If this fails, a is
+/// left as it was.
+template <set_op op, typename allocator_t>
+[[nodiscard]] constexpr status<alloc::error>
+combine(allocator_t& allocator, container_t& a,
+        const container_t& b) OKAYLIB_NOEXCEPT
+{
+    __ok_internal_assert(a.key == b.key);
+    if (a.kind == kind_t::run && b.kind == kind_t::run)
+        return detail::combine_runs<op>(allocator, a, b);
+
+    if constexpr (op != set_op::union_with) {
+        // the result is a subset of a, so arrays can be filtered in place
+        constexpr bool keep_matches = op == set_op::intersect_with;
+        if (a.kind == kind_t::array) {
+            switch (b.kind) {
+            case kind_t::array:
+                detail::filter_array_by_array<keep_matches>(a, b);
+                break;
+            case kind_t::bitmap:
+                detail::filter_array(a, [&b](uint16_t value) {
+                    return detail::contains(b, value) == keep_matches;
+                });
+                break;
+            case kind_t::run:
+                detail::filter_array_by_runs<keep_matches>(a, b);
+                break;
+            }
+            return alloc::error::success;
+        }
+    }
+
+    if constexpr (op == set_op::intersect_with) {
+        // the result is a subset of b, which is at most an array's worth
+        if (b.kind == kind_t::array) {
+            auto res = detail::make_container(allocator, kind_t::array, a.key,
+                                              b.size);
+            if (!res.is_success()) [[unlikely]]
+                return res.status();
+            container_t& out = res.unwrap();
+            for (uint32_t i = 0; i < b.size; ++i) {
+                out.values()[out.size] = b.values()[i];
+                out.size += detail::contains(a, b.values()[i]);
+            }
+            out.cardinality = out.size;
+            detail::replace(allocator, a, out);
+            return alloc::error::success;
+        }
+    }
+
+    if constexpr (op == set_op::union_with) {
+        if (a.kind == kind_t::array && b.kind == kind_t::array &&
+            a.size + b.size <= max_array_size) {
+            // merge from the back, so that no other buffer is needed
+            if (auto status =
+                    detail::reserve(allocator, a, a.size + b.size);
+                !status.is_success()) [[unlikely]] {
+                return status;
+            }
+            uint16_t* const values = a.values();
+            const uint16_t* const b_values = b.values();
+            uint32_t i = a.size;
+            uint32_t j = b.size;
+            uint32_t out = a.size + b.size;
+            while (j != 0) {
+                if (i != 0 && values[i - 1] > b_values[j - 1]) {
+                    values[--out] = values[--i];
+                } else {
+                    i -= i != 0 && values[i - 1] == b_values[j - 1];
+                    values[--out] = b_values[--j];
+                }
+            }
+            // what is left of a is already in place, then there is a gap for
+            // each duplicate before the merged values
+            const uint32_t num_merged = a.size + b.size - out;
+            ::memmove(values + i, values + out,
+                      num_merged * sizeof(uint16_t));
+            a.size = i + num_merged;
+            a.cardinality = a.size;
+            return alloc::error::success;
+        }
+    }
+
+    if (a.kind != kind_t::bitmap) {
+        auto bitmap = detail::to_bitmap(allocator, a);
+        if (!bitmap.is_success()) [[unlikely]]
+            return bitmap.status();
+        detail::replace(allocator, a, bitmap.unwrap());
+    }
+
+    uint64_t* const words = a.words();
+    switch (b.kind) {
+    case kind_t::array:
+        for (uint32_t i = 0; i < b.size; ++i) {
+            const uint16_t low = b.values()[i];
+            const uint64_t bit = uint64_t(1) << (low % 64);
+            // intersecting with an array was handled above
+            if constexpr (op == set_op::union_with) {
+                a.cardinality += !(words[low / 64] & bit);
+                words[low / 64] |= bit;
+            } else if constexpr (op == set_op::subtract) {
+                a.cardinality -= !!(words[low / 64] & bit);
+                words[low / 64] &= ~bit;
+            }
+        }
+        break;
+    case kind_t::bitmap:
+        detail::combine_words(a, b, [](uint64_t lhs, uint64_t rhs) {
+            if constexpr (op == set_op::union_with)
+                return lhs | rhs;
+            else if constexpr (op == set_op::intersect_with)
+                return lhs & rhs;
+            else
+                return lhs & ~rhs;
+        });
+        break;
+    case kind_t::run: {
+        const run_t* const runs = b.runs();
+        if constexpr (op == set_op::intersect_with) {
+            // clear the gaps between the runs
+            uint32_t start = 0;
+            for (uint32_t i = 0; i < b.size; ++i) {
+                if (runs[i].first > start) {
+                    a.cardinality -= detail::update_range<false>(
+                        words, start, runs[i].first - 1);
+                }
+                start = uint32_t(runs[i].last) + 1;
+            }
+            if (start < 65536) {
+                a.cardinality -=
+                    detail::update_range<false>(words, start, 65535);
+            }
+        } else {
+            for (uint32_t i = 0; i < b.size; ++i) {
+                if constexpr (op == set_op::union_with) {
+                    a.cardinality += detail::update_range<true>(
+                        words, runs[i].first, runs[i].last);
+                } else {
+                    a.cardinality -= detail::update_range<false>(
+                        words, runs[i].first, runs[i].last);
+                }
+            }
+        }
+        break;
+    }
+    }
+    detail::settle(allocator, a);
+    return alloc::error::success;
+}
+
+template <typename T>
+constexpr void write_little_endian(uint8_t*& out, T value) noexcept
+{
+    for (size_t i = 0; i < sizeof(T); ++i)
+        *out++ = uint8_t(value >> (8 * i));
+}
+
+template <typename T>
+constexpr T read_little_endian(const uint8_t*& in) noexcept
+{
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        value |= T(*in++) << (8 * i);
+    return value;
+}
+
+// magic number and number of containers
+inline constexpr size_t serialized_header_bytes = 8;
+// key, kind, padding, and size or cardinality
+inline constexpr size_t serialized_container_bytes = 8;
+
+[[nodiscard]] constexpr size_t
+serialized_payload_bytes(kind_t kind, uint32_t size) noexcept
+{
+    return kind == kind_t::bitmap ? bitmap_words * sizeof(uint64_t)
+                                  : size * item_bytes(kind);
+}
+} // namespace detail
+} // namespace roaring_bitmap
+
+/// A compressed set of 32 bit integers. Values are split into chunks of 65536
+/// by their upper 16 bits, and each chunk which has any values is stored in
+/// whichever of three containers suits it:
+///
+/// - an array of sorted 16 bit values, for up to 4096 values
+/// - a bitmap of 65536 bits, for denser chunks
+/// - a list of runs of consecutive values, for clustered chunks. Runs are made
+///   by insert_range() and optimize_runs().
+///
+/// So a sparse set costs about 2 bytes per value and a dense one about 1 bit
+/// per value, and set operations work a container at a time, mostly on whole
+/// words or by merging sorted arrays.
+///
+/// Operations which may allocate return a status. If one fails, the bitmap is
+/// still valid, and the failed operation may have been partially applied.
+template <allocator_c backing_allocator_t = ok::allocator_t>
+class roaring_bitmap_t
+{
+    using container_t = roaring_bitmap::detail::container_t;
+    using kind_t = roaring_bitmap::detail::kind_t;
+    using set_op = roaring_bitmap::detail::set_op;
+
+    struct members_t
+    {
+        // sorted by key, and none of them are empty
+        arraylist_t<container_t, backing_allocator_t> containers;
+    } m;
+
+    struct cursor_t
+    {
+        using value_type = uint32_t;
+
+        size_t container;
+        // the index of the next value of an array, the current run of a run
+        // container, or the current word of a bitmap
+        uint32_t position;
+        // the bits of the current word of a bitmap which have not been
+        // visited yet, or how far into the current run the next value is
+        uint64_t state;
+
+        [[nodiscard]] static constexpr cursor_t
+        at_container(const roaring_bitmap_t& bitmap,
+                     size_t container) OKAYLIB_NOEXCEPT
+        {
+            const slice<const container_t> containers =
+                bitmap.m.containers.items();
+            uint64_t state = 0;
+            if (container < containers.size() &&
+                containers[container].kind == kind_t::bitmap) {
+                state = containers[container].words()[0];
+            }
+            return cursor_t{
+                .container = container,
+                .position = 0,
+                .state = state,
+            };
+        }
+
+        [[nodiscard]] constexpr opt<uint32_t>
+        next(const roaring_bitmap_t& bitmap) OKAYLIB_NOEXCEPT
+        {
+            const slice<const container_t> containers =
+                bitmap.m.containers.items();
+            while (container < containers.size()) {
+                const container_t& current =
+                    containers.unchecked_address_of_first_item()[container];
+                const uint32_t high = uint32_t(current.key) << 16;
+                switch (current.kind) {
+                case kind_t::array:
+                    if (position < current.size)
+                        return high | current.values()[position++];
+                    break;
+                case kind_t::bitmap:
+                    while (state == 0) {
+                        if (++position == roaring_bitmap::detail::bitmap_words)
+                            break;
+                        state = current.words()[position];
+                    }
+                    if (state != 0) {
+                        const uint32_t low =
+                            position * 64 + ok::count_trailing_zeros(state);
+                        // clear the lowest bit which is on
+                        state &= state - 1;
+                        return high | low;
+                    }
+                    break;
+                case kind_t::run:
+                    if (position < current.size) {
+                        const roaring_bitmap::detail::run_t run =
+                            current.runs()[position];
+                        const uint32_t low = run.first + uint32_t(state);
+                        if (low == run.last) {
+                            ++position;
+                            state = 0;
+                        } else {
+                            ++state;
+                        }
+                        return high | low;
+                    }
+                    break;
+                }
+                *this = at_container(bitmap, container + 1);
+            }
+            return nullopt;
+        }
+    };
+
+    [[nodiscard]] constexpr backing_allocator_t& allocator() const noexcept
+    {
+        return m.containers.allocator();
+    }
+
+    /// Index of the container with the given key, or where it would go.
+    [[nodiscard]] constexpr size_t find(uint16_t key) const OKAYLIB_NOEXCEPT
+    {
+        const slice<const container_t> containers = m.containers.items();
+        if (containers.is_empty())
+            return 0;
+        return ok::detail::partition_point(
+            containers.unchecked_address_of_first_item(), containers.size(),
+            [key](const container_t& c) { return c.key < key; });
+    }
+
+    [[nodiscard]] constexpr container_t*
+    container_for(uint16_t key) OKAYLIB_NOEXCEPT
+    {
+        const size_t idx = this->find(key);
+        if (idx == m.containers.size() || m.containers[idx].key != key)
+            return nullptr;
+        return ok::addressof(m.containers[idx]);
+    }
+
+    /// Drop all containers at or after new_size, which must already be freed
+    /// or moved elsewhere.
+    constexpr void truncate(size_t new_size) OKAYLIB_NOEXCEPT
+    {
+        auto status = m.containers.resize_uninitialized(new_size);
+        __ok_internal_assert(status.is_success());
+    }
+
+    constexpr void destroy() OKAYLIB_NOEXCEPT
+    {
+        for (size_t idx = 0; idx < m.containers.size(); ++idx)
+            this->allocator().deallocate(m.containers[idx].data);
+    }
+
+    /// Combine each container of other into the matching one of this, then
+    /// drop any containers which became empty. Only for ops whose result is a
+    /// subset of this.
+    template <set_op op, typename other_allocator_t>
+    [[nodiscard]] constexpr status<alloc::error>
+    narrow(const roaring_bitmap_t<other_allocator_t>& other) OKAYLIB_NOEXCEPT
+    {
+        const slice<const container_t> others = other.m.containers.items();
+        const slice<container_t> containers = m.containers.items();
+        status<alloc::error> result = alloc::error::success;
+        size_t j = 0;
+        size_t kept = 0;
+        for (size_t idx = 0; idx < containers.size(); ++idx) {
+            container_t& container = containers[idx];
+            while (j < others.size() && others[j].key < container.key)
+                ++j;
+            const bool matched =
+                j < others.size() && others[j].key == container.key;
+            if (matched && result.is_success()) {
+                result = roaring_bitmap::detail::combine<op>(
+                    this->allocator(), container, others[j]);
+            } else if (!matched && op == set_op::intersect_with) {
+                container.cardinality = 0;
+            }
+
+            if (container.cardinality == 0) {
+                this->allocator().deallocate(container.data);
+                continue;
+            }
+            containers[kept++] = container;
+        }
+        this->truncate(kept);
+        return result;
+    }
+
+  public:
+    friend struct roaring_bitmap::detail::copy_t;
+    friend struct roaring_bitmap::detail::deserialize_t;
+    template <allocator_c other_allocator_t> friend class ok::roaring_bitmap_t;
+
+    using value_type = uint32_t;
+
+    explicit constexpr roaring_bitmap_t(backing_allocator_t& allocator)
+        OKAYLIB_NOEXCEPT
+        : m(members_t{
+              .containers = arraylist::empty<container_t>(allocator),
+          })
+    {
+    }
+
+    constexpr roaring_bitmap_t(roaring_bitmap_t&& other) OKAYLIB_NOEXCEPT
+        : m(members_t{.containers = stdc::move(other.m.containers)})
+    {
+    }
+
+    constexpr roaring_bitmap_t&
+    operator=(roaring_bitmap_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (this == ok::addressof(other)) [[unlikely]]
+            return *this;
+        this->destroy();
+        m.containers = stdc::move(other.m.containers);
+        return *this;
+    }
+
+    roaring_bitmap_t(const roaring_bitmap_t&) = delete;
+    roaring_bitmap_t& operator=(const roaring_bitmap_t&) = delete;
+
+    constexpr ~roaring_bitmap_t() { destroy(); }
+
+    [[nodiscard]] constexpr bool contains(uint32_t value) const OKAYLIB_NOEXCEPT
+    {
+        const size_t idx = this->find(uint16_t(value >> 16));
+        if (idx == m.containers.size())
+            return false;
+        const container_t& container = m.containers[idx];
+        return container.key == uint16_t(value >> 16) &&
+               roaring_bitmap::detail::contains(container, uint16_t(value));
+    }
+
+    /// The number of values in the set.
+    [[nodiscard]] constexpr uint64_t cardinality() const OKAYLIB_NOEXCEPT
+    {
+        uint64_t total = 0;
+        for (size_t idx = 0; idx < m.containers.size(); ++idx)
+            total += m.containers[idx].cardinality;
+        return total;
+    }
+
+    [[nodiscard]] constexpr bool is_empty() const OKAYLIB_NOEXCEPT
+    {
+        return m.containers.is_empty();
+    }
+
+    [[nodiscard]] constexpr status<alloc::error>
+    insert(uint32_t value) OKAYLIB_NOEXCEPT
+    {
+        const uint16_t key = uint16_t(value >> 16);
+        if (container_t* const container = this->container_for(key))
+            return roaring_bitmap::detail::add(this->allocator(), *container,
+                                               uint16_t(value));
+
+        auto res = roaring_bitmap::detail::make_container(
+            this->allocator(), kind_t::array, key, 4);
+        if (!res.is_success()) [[unlikely]]
+            return res.status();
+        container_t& container = res.unwrap();
+        container.values()[0] = uint16_t(value);
+        container.size = 1;
+        container.cardinality = 1;
+
+        auto status = m.containers.insert_at(this->find(key), container);
+        if (!status.is_success()) [[unlikely]]
+            this->allocator().deallocate(container.data);
+        return status;
+    }
+
+    /// Insert every value in [first, last]. Chunks which the range covers
+    /// completely become a single run, so large ranges are cheap.
+    [[nodiscard]] constexpr status<alloc::error>
+    insert_range(uint32_t first, uint32_t last) OKAYLIB_NOEXCEPT
+    {
+        if (first > last) [[unlikely]] {
+            __ok_abort("roaring_bitmap_t::insert_range given a range whose "
+                       "first value is after its last.");
+        }
+        for (uint32_t key = first >> 16; key <= last >> 16; ++key) {
+            roaring_bitmap::detail::run_t run{
+                .first = key == first >> 16 ? uint16_t(first) : uint16_t(0),
+                .last = key == last >> 16 ? uint16_t(last) : uint16_t(65535),
+            };
+            const container_t range{
+                .data = ok::addressof(run),
+                .size = 1,
+                .capacity = 1,
+                .cardinality = roaring_bitmap::detail::run_length(run),
+                .key = uint16_t(key),
+                .kind = kind_t::run,
+            };
+
+            if (container_t* const container = this->container_for(key)) {
+                auto status =
+                    roaring_bitmap::detail::combine<set_op::union_with>(
+                        this->allocator(), *container, range);
+                if (!status.is_success()) [[unlikely]]
+                    return status;
+                continue;
+            }
+
+            auto res =
+                roaring_bitmap::detail::clone(this->allocator(), range);
+            if (!res.is_success()) [[unlikely]]
+                return res.status();
+            auto status = m.containers.insert_at(this->find(uint16_t(key)),
+                                                 res.unwrap());
+            if (!status.is_success()) [[unlikely]] {
+                this->allocator().deallocate(res.unwrap().data);
+                return status;
+            }
+        }
+        return alloc::error::success;
+    }
+
+    /// Only fails if removing the value splits a run in two and there is no
+    /// room for the extra run.
+    [[nodiscard]] constexpr status<alloc::error>
+    remove(uint32_t value) OKAYLIB_NOEXCEPT
+    {
+        const uint16_t key = uint16_t(value >> 16);
+        container_t* const container = this->container_for(key);
+        if (!container)
+            return alloc::error::success;
+
+        auto status = roaring_bitmap::detail::remove(
+            this->allocator(), *container, uint16_t(value));
+        if (container->cardinality == 0) {
+            this->allocator().deallocate(container->data);
+            m.containers.remove(this->find(key));
+        }
+        return status;
+    }
+
+    constexpr void clear() OKAYLIB_NOEXCEPT
+    {
+        this->destroy();
+        m.containers.clear();
+    }
+
+    /// Add every value in other to this bitmap. If this fails, this bitmap
+    /// holds everything it did before and some of other.
+    template <allocator_c other_allocator_t>
+    [[nodiscard]] constexpr status<alloc::error>
+    union_with(const roaring_bitmap_t<other_allocator_t>& other)
+        OKAYLIB_NOEXCEPT
+    {
+        if (static_cast<const void*>(this) == ok::addressof(other))
+            return alloc::error::success;
+
+        const slice<const container_t> a = m.containers.items();
+        const slice<const container_t> b = other.m.containers.items();
+        if (b.is_empty())
+            return alloc::error::success;
+
+        size_t num_keys = 0;
+        for (size_t i = 0, j = 0; i < a.size() || j < b.size(); ++num_keys) {
+            if (j == b.size() || (i < a.size() && a[i].key < b[j].key)) {
+                ++i;
+            } else if (i == a.size() || b[j].key < a[i].key) {
+                ++j;
+            } else {
+                ++i;
+                ++j;
+            }
+        }
+
+        auto res = arraylist::spots_preallocated<container_t>(
+            this->allocator(), num_keys);
+        if (!res.is_success()) [[unlikely]]
+            return res.status();
+        auto& merged = res.unwrap();
+
+        status<alloc::error> result = alloc::error::success;
+        for (size_t i = 0, j = 0; i < a.size() || j < b.size();) {
+            if (j == b.size() || (i < a.size() && a[i].key < b[j].key)) {
+                merged.append_assume_capacity(a[i++]);
+            } else if (i == a.size() || b[j].key < a[i].key) {
+                if (result.is_success()) {
+                    auto copy = roaring_bitmap::detail::clone(
+                        this->allocator(), b[j]);
+                    if (copy.is_success())
+                        merged.append_assume_capacity(copy.unwrap());
+                    else
+                        result = copy.status();
+                }
+                ++j;
+            } else {
+                container_t container = a[i++];
+                if (result.is_success()) {
+                    result =
+                        roaring_bitmap::detail::combine<set_op::union_with>(
+                            this->allocator(), container, b[j]);
+                }
+                merged.append_assume_capacity(container);
+                ++j;
+            }
+        }
+        // the containers now belong to merged, so this must not free them
+        this->truncate(0);
+        m.containers = stdc::move(merged);
+        return result;
+    }
+
+    /// Remove every value which is not also in other.
+    template <allocator_c other_allocator_t>
+    [[nodiscard]] constexpr status<alloc::error>
+    intersect_with(const roaring_bitmap_t<other_allocator_t>& other)
+        OKAYLIB_NOEXCEPT
+    {
+        if (static_cast<const void*>(this) == ok::addressof(other))
+            return alloc::error::success;
+        return this->narrow<set_op::intersect_with>(other);
+    }
+
+    /// Remove every value which is in other.
+    template <allocator_c other_allocator_t>
+    [[nodiscard]] constexpr status<alloc::error>
+    subtract(const roaring_bitmap_t<other_allocator_t>& other)
+        OKAYLIB_NOEXCEPT
+    {
+        if (static_cast<const void*>(this) == ok::addressof(other)) {
+            this->clear();
+            return alloc::error::success;
+        }
+        return this->narrow<set_op::subtract>(other);
+    }
+
+    /// Convert each container into a run container if that would make it
+    /// smaller, and run containers which are not the smallest back. Worth
+    /// calling on bitmaps with long stretches of consecutive values before
+    /// keeping them around or serializing them.
+    [[nodiscard]] constexpr status<alloc::error>
+    optimize_runs() OKAYLIB_NOEXCEPT
+    {
+        using namespace roaring_bitmap::detail;
+        for (size_t idx = 0; idx < m.containers.size(); ++idx) {
+            container_t& container = m.containers[idx];
+            uint32_t num_runs = 0;
+            switch (container.kind) {
+            case kind_t::array:
+                for (uint32_t i = 0; i < container.size; ++i) {
+                    num_runs += i == 0 || container.values()[i - 1] + 1 !=
+                                              container.values()[i];
+                }
+                break;
+            case kind_t::bitmap: {
+                // a run starts at every bit which is on and has the bit
+                // before it off
+                uint64_t previous_top_bit = 0;
+                for (uint32_t i = 0; i < bitmap_words; ++i) {
+                    const uint64_t word = container.words()[i];
+                    num_runs += uint32_t(ok::popcount(
+                        word & ~((word << 1) | previous_top_bit)));
+                    previous_top_bit = word >> 63;
+                }
+                break;
+            }
+            case kind_t::run:
+                num_runs = container.size;
+                break;
+            }
+
+            const size_t current_bytes =
+                container.kind == kind_t::bitmap
+                    ? bitmap_words * sizeof(uint64_t)
+                    : container.cardinality * sizeof(uint16_t);
+            if (container.kind == kind_t::run) {
+                // settle picks between a bitmap and an array, only when the
+                // runs are bigger than both
+                const size_t other_bytes =
+                    container.cardinality <= max_array_size
+                        ? container.cardinality * sizeof(uint16_t)
+                        : bitmap_words * sizeof(uint64_t);
+                if (num_runs * sizeof(run_t) <= other_bytes)
+                    continue;
+                auto bitmap = to_bitmap(this->allocator(), container);
+                if (!bitmap.is_success()) [[unlikely]]
+                    return bitmap.status();
+                replace(this->allocator(), container, bitmap.unwrap());
+                settle(this->allocator(), container);
+                continue;
+            }
+            if (num_runs * sizeof(run_t) >= current_bytes)
+                continue;
+
+            auto res = make_container(this->allocator(), kind_t::run,
+                                      container.key, num_runs);
+            if (!res.is_success()) [[unlikely]]
+                return res.status();
+            container_t& out = res.unwrap();
+            const auto visit = [&out](uint32_t low) {
+                run_t* const runs = out.runs();
+                if (out.size != 0 &&
+                    uint32_t(runs[out.size - 1].last) + 1 == low) {
+                    runs[out.size - 1].last = uint16_t(low);
+                } else {
+                    runs[out.size++] =
+                        run_t{.first = uint16_t(low), .last = uint16_t(low)};
+                }
+            };
+            if (container.kind == kind_t::array) {
+                for (uint32_t i = 0; i < container.size; ++i)
+                    visit(container.values()[i]);
+            } else {
+                for (size_t low : container.bits().iter_set_bits())
+                    visit(uint32_t(low));
+            }
+            __ok_internal_assert(out.size == num_runs);
+            out.cardinality = container.cardinality;
+            replace(this->allocator(), container, out);
+        }
+        return alloc::error::success;
+    }
+
+    /// The number of bytes serialize_into() will write.
+    [[nodiscard]] constexpr size_t serialized_size() const OKAYLIB_NOEXCEPT
+    {
+        using namespace roaring_bitmap::detail;
+        size_t bytes = serialized_header_bytes;
+        for (size_t idx = 0; idx < m.containers.size(); ++idx) {
+            const container_t& container = m.containers[idx];
+            bytes += serialized_container_bytes +
+                     serialized_payload_bytes(container.kind, container.size);
+        }
+        return bytes;
+    }
+
+    /// Write the bitmap into a flat buffer of at least serialized_size()
+    /// bytes, which can be loaded back with roaring_bitmap::deserialize. The
+    /// format is little endian regardless of the platform. Returns the number
+    /// of bytes written.
+    ///
+    /// Format: the magic number "OKRB" and the number of containers as 32 bit
+    /// integers, then for each container its key (16 bits), kind (8 bits: 0
+    /// array, 1 bitmap, 2 runs), 8 bits of padding, and the number of values
+    /// (for arrays and bitmaps) or runs (32 bits). Then each container's
+    /// contents, in order: 16 bit values, 1024 64 bit words, or pairs of 16
+    /// bit first and last values.
+    constexpr size_t serialize_into(bytes_t buffer) const OKAYLIB_NOEXCEPT
+    {
+        using namespace roaring_bitmap::detail;
+        const size_t size = this->serialized_size();
+        if (buffer.size() < size) [[unlikely]] {
+            __ok_abort("Buffer passed to roaring_bitmap_t::serialize_into() is "
+                       "smaller than serialized_size().");
+        }
+
+        uint8_t* out = buffer.unchecked_address_of_first_item();
+        write_little_endian(out, serialized_magic);
+        write_little_endian(out, uint32_t(m.containers.size()));
+        for (size_t idx = 0; idx < m.containers.size(); ++idx) {
+            const container_t& container = m.containers[idx];
+            write_little_endian(out, container.key);
+            write_little_endian(out, uint8_t(container.kind));
+            write_little_endian(out, uint8_t(0));
+            write_little_endian(out, container.kind == kind_t::bitmap
+                                         ? container.cardinality
+                                         : container.size);
+        }
+        for (size_t idx = 0; idx < m.containers.size(); ++idx) {
+            const container_t& container = m.containers[idx];
+            switch (container.kind) {
+            case kind_t::array:
+                for (uint32_t i = 0; i < container.size; ++i)
+                    write_little_endian(out, container.values()[i]);
+                break;
+            case kind_t::bitmap:
+                for (uint32_t i = 0; i < bitmap_words; ++i)
+                    write_little_endian(out, container.words()[i]);
+                break;
+            case kind_t::run:
+                for (uint32_t i = 0; i < container.size; ++i) {
+                    write_little_endian(out, container.runs()[i].first);
+                    write_little_endian(out, container.runs()[i].last);
+                }
+                break;
+            }
+        }
+        __ok_internal_assert(out ==
+                             buffer.unchecked_address_of_first_item() + size);
+        return size;
+    }
+
+    /// Iterate over the values in increasing order.
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ref_iterator_t<const roaring_bitmap_t, cursor_t>{
+            *this, cursor_t::at_container(*this, 0)};
+    }
+
+    constexpr auto iter() const&& = delete;
+};
+
+namespace roaring_bitmap {
+namespace detail {
+struct copy_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::roaring_bitmap_t<ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t,
+              allocator_c other_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               const roaring_bitmap_t<other_allocator_t>& other) const
+        OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, other);
+    }
+
+    template <allocator_c backing_allocator_t,
+              allocator_c other_allocator_t>
+    [[nodiscard]] constexpr alloc::error
+    make_into_uninit(ok::roaring_bitmap_t<backing_allocator_t>& output,
+                     backing_allocator_t& allocator,
+                     const roaring_bitmap_t<other_allocator_t>& other) const
+        OKAYLIB_NOEXCEPT
+    {
+        ok::roaring_bitmap_t<backing_allocator_t> copy(allocator);
+        const auto containers = other.m.containers.items();
+        if (auto status = copy.m.containers.reserve_exact(containers.size());
+            !status.is_success()) [[unlikely]] {
+            return status.as_enum();
+        }
+        for (size_t idx = 0; idx < containers.size(); ++idx) {
+            auto res = detail::clone(allocator, containers[idx]);
+            if (!res.is_success()) [[unlikely]]
+                return res.status().as_enum();
+            copy.m.containers.append_assume_capacity(res.unwrap());
+        }
+        stdc::construct_at(ok::addressof(output), stdc::move(copy));
+        return alloc::error::success;
+    }
+};
+
+struct deserialize_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make_into_uninit;
+
+    template <typename backing_allocator_t, typename...>
+    using associated_type =
+        ok::roaring_bitmap_t<ok::remove_cvref_t<backing_allocator_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr auto
+    operator()(backing_allocator_t& allocator,
+               slice<const uint8_t> bytes) const OKAYLIB_NOEXCEPT
+    {
+        return ok::make(*this, allocator, bytes);
+    }
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr deserialize_error
+    make_into_uninit(ok::roaring_bitmap_t<backing_allocator_t>& output,
+                     backing_allocator_t& allocator,
+                     slice<const uint8_t> bytes) const OKAYLIB_NOEXCEPT
+    {
+        if (bytes.size() < serialized_header_bytes)
+            return deserialize_error::malformed;
+        const uint8_t* in = bytes.unchecked_address_of_first_item();
+        const uint8_t* const end = in + bytes.size();
+        if (read_little_endian<uint32_t>(in) != serialized_magic)
+            return deserialize_error::malformed;
+        const uint32_t num_containers = read_little_endian<uint32_t>(in);
+        if (num_containers > 65536 ||
+            size_t(end - in) < num_containers * serialized_container_bytes)
+            return deserialize_error::malformed;
+
+        ok::roaring_bitmap_t<backing_allocator_t> out(allocator);
+        if (!out.m.containers.reserve_exact(num_containers).is_success())
+            [[unlikely]] {
+            return deserialize_error::alloc_failure;
+        }
+
+        const uint8_t* payload =
+            in + num_containers * serialized_container_bytes;
+        for (uint32_t i = 0; i < num_containers; ++i) {
+            const uint16_t key = read_little_endian<uint16_t>(in);
+            const uint8_t kind_byte = read_little_endian<uint8_t>(in);
+            in += 1; // padding
+            const uint32_t size = read_little_endian<uint32_t>(in);
+
+            if (kind_byte > uint8_t(kind_t::run))
+                return deserialize_error::malformed;
+            const kind_t kind = kind_t(kind_byte);
+            const bool key_in_order =
+                out.m.containers.is_empty() ||
+                out.m.containers[out.m.containers.size() - 1].key < key;
+            const uint32_t max_size =
+                kind == kind_t::array ? max_array_size
+                : kind == kind_t::run ? 32768
+                                      : 65536;
+            if (!key_in_order || size == 0 || size > max_size ||
+                size_t(end - payload) < serialized_payload_bytes(kind, size))
+                return deserialize_error::malformed;
+
+            auto res = detail::make_container(
+                allocator, kind, key,
+                kind == kind_t::bitmap ? bitmap_words : size);
+            if (!res.is_success()) [[unlikely]]
+                return deserialize_error::alloc_failure;
+            // in the list straight away, so that it is freed on any error
+            container_t& container =
+                out.m.containers.append_assume_capacity(res.unwrap());
+
+            bool valid = true;
+            switch (kind) {
+            case kind_t::array:
+                for (uint32_t j = 0; j < size; ++j) {
+                    const uint16_t value =
+                        read_little_endian<uint16_t>(payload);
+                    valid &= j == 0 || container.values()[j - 1] < value;
+                    container.values()[j] = value;
+                }
+                container.size = size;
+                container.cardinality = size;
+                break;
+            case kind_t::bitmap:
+                for (uint32_t j = 0; j < bitmap_words; ++j) {
+                    container.words()[j] =
+                        read_little_endian<uint64_t>(payload);
+                    container.cardinality +=
+                        uint32_t(ok::popcount(container.words()[j]));
+                }
+                valid = container.cardinality == size;
+                break;
+            case kind_t::run:
+                for (uint32_t j = 0; j < size; ++j) {
+                    const run_t run{
+                        .first = read_little_endian<uint16_t>(payload),
+                        .last = read_little_endian<uint16_t>(payload),
+                    };
+                    // runs must be in order, and not touch
+                    valid &= run.first <= run.last &&
+                             (j == 0 || uint32_t(container.runs()[j - 1].last) +
+                                                1 <
+                                            run.first);
+                    container.runs()[j] = run;
+                    container.cardinality += run_length(run);
+                }
+                container.size = size;
+                break;
+            }
+            if (!valid)
+                return deserialize_error::malformed;
+        }
+        if (payload != end)
+            return deserialize_error::malformed;
+
+        stdc::construct_at(ok::addressof(output), stdc::move(out));
+        return deserialize_error::success;
+    }
+};
+} // namespace detail
+
+/// Make a copy of a roaring bitmap, using a different allocator or the same
+/// one.
+inline constexpr detail::copy_t copy;
+
+/// Load a bitmap from the bytes written by roaring_bitmap_t::serialize_into().
+/// Errors with deserialize_error::malformed if the bytes are not a valid
+/// bitmap, instead of trusting them.
+inline constexpr detail::deserialize_t deserialize;
+} // namespace roaring_bitmap
+
+template <typename backing_allocator_t>
+struct is_trivially_relocatable<roaring_bitmap_t<backing_allocator_t>>
+    : stdc::true_type
+{};
+} // namespace ok
+
+#endif
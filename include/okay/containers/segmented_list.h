@@ -3,6 +3,7 @@
 
 #include "okay/allocators/allocator.h"
 #include "okay/defer.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
 #include "okay/error.h"
 #include "okay/iterables/iterables.h"
 #include "okay/math/math.h"
@@ -17,33 +18,55 @@ namespace ok {
 
 namespace segmented_list {
 namespace detail {
-template <typename T> struct empty_t;
+template <typename T, size_t first_block_size> struct empty_t;
 struct copy_items_from_iterator_t;
+
+// All of these take the log2 of the size of the first block. Block i holds
+// first_block_size * 2^i items, so the math is the same as for a first block of
+// one item, just shifted.
+
 [[nodiscard]] constexpr size_t
-num_blocks_needed_for_spots(size_t num_spots) noexcept
+num_blocks_needed_for_spots(size_t num_spots,
+                            size_t first_block_exponent = 0) noexcept
 {
-    return log2_uint_ceil(num_spots + 1);
+    // round up to a whole number of first blocks
+    const size_t first_block_size = two_to_the_power_of(first_block_exponent);
+    return log2_uint_ceil(
+        ((num_spots + first_block_size - 1) >> first_block_exponent) + 1);
 }
 
 [[nodiscard]] constexpr size_t
-get_num_spots_for_blocks(const size_t num_blocks) noexcept
+get_num_spots_for_blocks(const size_t num_blocks,
+                         size_t first_block_exponent = 0) noexcept
 {
-    return two_to_the_power_of(num_blocks) - 1;
+    return (two_to_the_power_of(num_blocks) - 1) << first_block_exponent;
 }
 
 /// Returns a tuple of the index of the block this item belongs to in the
 /// blocklist, and the sub-index of that item within the block (its
 /// offset within the block)
 [[nodiscard]] constexpr ok::tuple<size_t, size_t>
-get_block_index_and_offset(const size_t idx) noexcept
+get_block_index_and_offset(const size_t idx,
+                           size_t first_block_exponent = 0) noexcept
 {
-    const auto blockidx = log2_uint(idx + 1);
-    return ok::tuple{blockidx, idx - (two_to_the_power_of(blockidx) - 1)};
+    const size_t first_block_size = two_to_the_power_of(first_block_exponent);
+    const size_t blockidx = log2_uint((idx >> first_block_exponent) + 1);
+    return ok::tuple{blockidx,
+                     idx + first_block_size - (first_block_size << blockidx)};
 }
 
-[[nodiscard]] constexpr size_t size_of_block_at(size_t idx) OKAYLIB_NOEXCEPT
+[[nodiscard]] constexpr size_t
+size_of_block_at(size_t idx, size_t first_block_exponent = 0) OKAYLIB_NOEXCEPT
 {
-    return two_to_the_power_of(idx);
+    return two_to_the_power_of(idx + first_block_exponent);
+}
+
+/// The index of the first item in the given block
+[[nodiscard]] constexpr size_t
+index_of_first_item_in_block(size_t block_idx,
+                             size_t first_block_exponent = 0) OKAYLIB_NOEXCEPT
+{
+    return (two_to_the_power_of(block_idx) - 1) << first_block_exponent;
 }
 
 static_assert(size_of_block_at(0) == 1);
@@ -69,10 +92,38 @@ static_assert(get_block_index_and_offset(4) == ok::tuple{2, 1});
 static_assert(get_block_index_and_offset(5) == ok::tuple{2, 2});
 static_assert(get_block_index_and_offset(6) == ok::tuple{2, 3});
 static_assert(get_block_index_and_offset(7) == ok::tuple{3, 0});
+static_assert(index_of_first_item_in_block(0) == 0);
+static_assert(index_of_first_item_in_block(1) == 1);
+static_assert(index_of_first_item_in_block(3) == 7);
+// first block of 64 items: blocks of 64, 128, 256...
+static_assert(size_of_block_at(1, 6) == 128);
+static_assert(num_blocks_needed_for_spots(1, 6) == 1);
+static_assert(num_blocks_needed_for_spots(64, 6) == 1);
+static_assert(num_blocks_needed_for_spots(65, 6) == 2);
+static_assert(num_blocks_needed_for_spots(192, 6) == 2);
+static_assert(num_blocks_needed_for_spots(193, 6) == 3);
+static_assert(get_num_spots_for_blocks(3, 6) == 448);
+static_assert(get_block_index_and_offset(63, 6) == ok::tuple{0, 63});
+static_assert(get_block_index_and_offset(64, 6) == ok::tuple{1, 0});
+static_assert(get_block_index_and_offset(191, 6) == ok::tuple{1, 127});
+static_assert(get_block_index_and_offset(192, 6) == ok::tuple{2, 0});
+static_assert(index_of_first_item_in_block(2, 6) == 192);
 } // namespace detail
+
+/// A first block size which fills one 64 byte cache line with items of type
+/// T (rounded down to a power of two, and at least one item).
+template <typename T>
+inline constexpr size_t cache_line_first_block_size =
+    sizeof(T) >= 64 ? 1 : two_to_the_power_of(log2_uint(64 / sizeof(T)));
 } // namespace segmented_list
 
-template <typename T, allocator_c backing_allocator_t = ok::allocator_t>
+/// A list whose items never move once they are appended. Items are stored in
+/// blocks which double in size, the first of which holds first_block_size
+/// items (must be a power of two). Lists which are usually small but which
+/// should not do an allocation per append while small can use a bigger first
+/// block, for example segmented_list::cache_line_first_block_size<T>.
+template <typename T, allocator_c backing_allocator_t = ok::allocator_t,
+          size_t first_block_size = 1>
 class segmented_list_t
 {
   public:
@@ -84,27 +135,23 @@ class segmented_list_t
         "which is not possible. Remove the const, and pass a const reference "
         "to the segmented list of mutable objects instead.");
 
+    static_assert(ok::is_power_of_two(first_block_size),
+                  "The first block of a segmented list must hold a power of "
+                  "two number of items.");
+
     using value_type = T;
 
-    template <typename U> friend struct ok::segmented_list::detail::empty_t;
+    template <typename, size_t>
+    friend struct ok::segmented_list::detail::empty_t;
     friend struct ok::segmented_list::detail::copy_items_from_iterator_t;
 
     [[nodiscard]] constexpr size_t capacity() const noexcept
     {
-        using namespace segmented_list::detail;
-        if (!m.blocklist) {
-            return 0;
-        }
-
-        return get_num_spots_for_blocks(m.blocklist->num_blocks);
+        return segmented_list::detail::get_num_spots_for_blocks(
+            m.num_blocks, first_block_exponent);
     }
 
-    [[nodiscard]] constexpr size_t size() const noexcept
-    {
-        // if no blocklist, size is zero, otherwise it is m.size
-        // (enables encoding other info in size when blocklist is null)
-        return bool(m.blocklist) * m.size;
-    }
+    [[nodiscard]] constexpr size_t size() const noexcept { return m.size; }
 
     [[nodiscard]] constexpr bool is_empty() const OKAYLIB_NOEXCEPT
     {
@@ -133,10 +180,97 @@ class segmented_list_t
         return unchecked_access(index);
     }
 
+    /// The number of blocks which contain at least one item.
+    [[nodiscard]] constexpr size_t num_occupied_blocks() const OKAYLIB_NOEXCEPT
+    {
+        return segmented_list::detail::num_blocks_needed_for_spots(
+            this->size(), first_block_exponent);
+    }
+
+    /// Get the items in one block as a contiguous slice. Only the occupied
+    /// part of the last block is included.
+    [[nodiscard]] constexpr slice<T>
+    block(size_t block_idx) & OKAYLIB_NOEXCEPT
+    {
+        using namespace segmented_list::detail;
+        if (block_idx >= this->num_occupied_blocks()) [[unlikely]] {
+            __ok_abort("Out of bounds access to block of segmented_list_t");
+        }
+        const size_t first =
+            index_of_first_item_in_block(block_idx, first_block_exponent);
+        const size_t block_size =
+            size_of_block_at(block_idx, first_block_exponent);
+        const size_t remaining = this->size() - first;
+        return raw_slice(*m.blocks[block_idx],
+                         remaining < block_size ? remaining : block_size);
+    }
+
+    [[nodiscard]] constexpr slice<const T>
+    block(size_t block_idx) const& OKAYLIB_NOEXCEPT
+    {
+        return const_cast<segmented_list_t*>(this)->block(block_idx);
+    }
+
+    /// Iterate over the occupied blocks, each one as a slice. Algorithms that
+    /// touch every item (copying, filling, summing, searching) can run a plain
+    /// loop over each slice instead of paying for indexing per item.
+    [[nodiscard]] constexpr auto blocks() & OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<segmented_list_t,
+                                        block_cursor_t<false>>{
+            *this, block_cursor_t<false>{}};
+    }
+
+    [[nodiscard]] constexpr auto blocks() const& OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<const segmented_list_t,
+                                        block_cursor_t<true>>{
+            *this, block_cursor_t<true>{}};
+    }
+
+    /// Element iteration walks block by block, so moving to the next item is
+    /// an increment instead of a log2.
+    [[nodiscard]] constexpr auto iter() & OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<segmented_list_t, cursor_t<false>>{
+            *this, cursor_t<false>{}};
+    }
+
+    [[nodiscard]] constexpr auto iter() const& OKAYLIB_NOEXCEPT
+    {
+        return ref_arraylike_iterator_t<const segmented_list_t,
+                                        cursor_t<true>>{*this,
+                                                        cursor_t<true>{}};
+    }
+
+    [[nodiscard]] constexpr auto iter() && OKAYLIB_NOEXCEPT
+    {
+        return owning_arraylike_iterator_t<segmented_list_t, cursor_t<false>>{
+            stdc::move(*this), cursor_t<false>{}};
+    }
+
+    /// Copy-assign the given value to every item in the list.
+    constexpr void fill(const T& value) OKAYLIB_NOEXCEPT
+        requires stdc::is_copy_assignable_v<T>
+    {
+        for (size_t b = 0; b < this->num_occupied_blocks(); ++b) {
+            const slice<T> items = this->block(b);
+            T* const start = items.unchecked_address_of_first_item();
+            for (size_t i = 0; i < items.size(); ++i)
+                start[i] = value;
+        }
+    }
+
     constexpr segmented_list_t(segmented_list_t&& other) noexcept
-        : m(stdc::move(other.m))
     {
-        other.m.blocklist = nullptr;
+        m.init(*other.m.allocator);
+        // only copy the block pointers in use, not the whole blocklist
+        for (size_t i = 0; i < other.m.num_blocks; ++i)
+            m.blocks[i] = other.m.blocks[i];
+        m.num_blocks = other.m.num_blocks;
+        m.size = other.m.size;
+        other.m.num_blocks = 0;
+        other.m.size = 0;
     }
 
     constexpr segmented_list_t&
@@ -172,8 +306,7 @@ class segmented_list_t
         __ok_internal_assert(size <= capacity);
 
         // TODO: we can predict how many blocks we need here and allocate them
-        // in 1-2 allocations (an extra one may be needed to reallocate the
-        // blocklist as well)
+        // in one allocation
         while (size + additional_allocated_spots > this->capacity()) {
             if (auto status = this->new_block(); !ok::is_success(status))
                 [[unlikely]] {
@@ -190,24 +323,15 @@ class segmented_list_t
             return;
         }
         if constexpr (!stdc::is_trivially_destructible_v<T>) {
-
-            size_t block_size = 1; // first block always 1 big
-            size_t visited = 0;
-            for (size_t block_idx = 0; block_idx < m.blocklist->num_blocks;
-                 ++block_idx) {
-                for (size_t i = 0; i < block_size && visited < this->size();
-                     ++i) {
-                    m.blocklist->blocks[block_idx][i].~T();
-                    ++visited;
-                }
-                block_size *= 2;
+            for (size_t b = 0; b < this->num_occupied_blocks(); ++b) {
+                const slice<T> items = this->block(b);
+                T* const start = items.unchecked_address_of_first_item();
+                for (size_t i = 0; i < items.size(); ++i)
+                    start[i].~T();
             }
         }
 
-        // if no blocklist, then m.size is encoding the number of blocklist
-        // pointers to allocate and needs to be preserved between calls to
-        // clear()
-        __ok_internal_assert(m.blocklist);
+        // blocks stay allocated for reuse
         m.size = 0;
     }
 
@@ -226,7 +350,19 @@ class segmented_list_t
         // early out if you're popping the last item
         if (idx == this->size() - 1) {
             if constexpr (!stdc::is_trivially_destructible_v<T>) {
-                removal_target->~T();
+                removal_target.~T();
+            }
+            return out;
+        }
+
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                removal_target.~T();
+            }
+            for (size_t i = idx; i < size() - 1; ++i) {
+                ::memcpy((void*)ok::addressof(this->unchecked_access(i)),
+                         (void*)ok::addressof(this->unchecked_access(i + 1)),
+                         sizeof(T));
             }
             return out;
         }
@@ -290,8 +426,7 @@ class segmented_list_t
             __ok_abort(
                 "Attempt to get first() item from empty segmented_list_t.");
         }
-        __ok_internal_assert(m.blocklist);
-        return m.blocklist->blocks[0][0];
+        return m.blocks[0][0];
     }
 
     constexpr const T& first() const& OKAYLIB_NOEXCEPT
@@ -303,28 +438,9 @@ class segmented_list_t
     [[nodiscard]] constexpr ok::alloc::result_t<T&>
     insert_at(const size_t idx, args_t&&... args) OKAYLIB_NOEXCEPT
     {
-        if (!m.blocklist) [[unlikely]] {
-            if (ok::status status = initialize_blocklist();
-                !status.is_success()) [[unlikely]] {
-                return status;
-            }
-            if (ok::status status = new_block(); !status.is_success())
-                [[unlikely]] {
-                return status;
-            }
-        }
-        __ok_internal_assert(m.blocklist);
         __ok_assert(idx <= this->size(),
                     "out of bounds access in segmented_list_t<T>::insert_at");
         if (this->size() == this->capacity()) {
-            if (ok::status status =
-                    ensure_additional_blocklist_capacity_is_at_least_one();
-                !status.is_success()) [[unlikely]] {
-                return status;
-            }
-            __ok_internal_assert(m.blocklist && (m.blocklist->capacity >
-                                                 m.blocklist->num_blocks));
-
             if (auto status = this->new_block(); !status.is_success()) {
                 [[unlikely]] return status;
             }
@@ -340,14 +456,22 @@ class segmented_list_t
             ++m.size;
             return new_item;
         } else {
-            // TODO: use memmove here for trivially copyable types
-
+            // items are not contiguous across blocks, so relocate them one at
+            // a time. trivially relocatable items are just copied bytewise.
             T* existing_item = nullptr;
             for (size_t i = this->size(); i > idx; --i) {
                 existing_item = ok::addressof(this->unchecked_access(i - 1));
                 T& nonexisting_item = this->unchecked_access(i);
-                stdc::construct_at(ok::addressof(nonexisting_item),
-                                   stdc::move(*existing_item));
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    ::memcpy((void*)ok::addressof(nonexisting_item),
+                             (void*)existing_item, sizeof(T));
+                } else {
+                    stdc::construct_at(ok::addressof(nonexisting_item),
+                                       stdc::move(*existing_item));
+                    if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                        existing_item->~T();
+                    }
+                }
             }
 
             __ok_internal_assert(existing_item);
@@ -385,62 +509,46 @@ class segmented_list_t
     //                   "Cannot append an infinite range.");
     // }
 
+    constexpr ~segmented_list_t() { destroy(); }
+
   private:
-    struct blocklist_t
-    {
-        size_t num_blocks;
-        size_t capacity;
-        T* blocks[];
+    static constexpr size_t first_block_exponent =
+        log2_uint(first_block_size);
 
-        constexpr T* get_block(size_t idx) OKAYLIB_NOEXCEPT
-        {
-            __ok_internal_assert(idx < num_blocks);
-            return this->blocks[idx];
-        }
-
-        constexpr const T* get_block(size_t idx) const OKAYLIB_NOEXCEPT
-        {
-            __ok_internal_assert(idx < num_blocks);
-            return this->blocks[idx];
-        }
-    };
+    // enough blocks to hold as many items as a size_t can count, so the
+    // blocklist never has to be reallocated. at most 64 pointers.
+    static constexpr size_t max_blocks =
+        sizeof(size_t) * 8 - first_block_exponent;
 
     constexpr void destroy()
     {
         using namespace segmented_list::detail;
-        if (!m.blocklist)
-            return;
-
         size_t visited = 0;
-        for (size_t i = 0; i < m.blocklist->num_blocks; ++i) {
+        for (size_t i = 0; i < m.num_blocks; ++i) {
             if constexpr (!stdc::is_trivially_destructible_v<T>) {
-                auto items =
-                    ok::raw_slice(*m.blocklist->blocks[i], size_of_block_at(i));
+                auto items = ok::raw_slice(
+                    *m.blocks[i], size_of_block_at(i, first_block_exponent));
 
                 for (size_t j = 0; j < items.size() && visited < this->size();
                      ++j) {
                     items[j].~T();
                     ++visited;
                 }
-                m.allocator->deallocate(
-                    items.unchecked_address_of_first_item());
-            } else {
-                m.allocator->deallocate(m.blocklist->blocks[i]);
             }
+            m.allocator->deallocate(m.blocks[i]);
         }
-
-        m.allocator->deallocate(m.blocklist);
     }
 
     [[nodiscard]] constexpr status<alloc::error> new_block() OKAYLIB_NOEXCEPT
     {
         using namespace segmented_list::detail;
-        const size_t bytes_needed =
-            (m.blocklist ? size_of_block_at(m.blocklist->num_blocks) : 1) *
-            sizeof(T);
+        if (m.num_blocks == max_blocks) [[unlikely]]
+            return alloc::error::oom;
 
         auto new_buffer_result = m.allocator->allocate(alloc::request_t{
-            .num_bytes = bytes_needed,
+            .num_bytes =
+                size_of_block_at(m.num_blocks, first_block_exponent) *
+                sizeof(T),
             .alignment = alignof(T),
             .leave_nonzeroed = true,
         });
@@ -448,130 +556,138 @@ class segmented_list_t
         if (!new_buffer_result.is_success()) [[unlikely]]
             return new_buffer_result.status();
 
-        bytes_t& new_buffer_bytes = new_buffer_result.unwrap();
-        defer free_new_buffer = [&] {
-            m.allocator->deallocate(
-                new_buffer_bytes.unchecked_address_of_first_item());
-        };
-
-        ok::status blocklist_status =
-            ensure_additional_blocklist_capacity_is_at_least_one();
-        if (!ok::is_success(blocklist_status)) [[unlikely]]
-            return blocklist_status;
-
-        __ok_internal_assert(m.blocklist &&
-                             m.blocklist->capacity > m.blocklist->num_blocks);
-
-        free_new_buffer.cancel();
-
-        m.blocklist->blocks[m.blocklist->num_blocks] = reinterpret_cast<T*>(
-            new_buffer_bytes.unchecked_address_of_first_item());
-        m.blocklist->num_blocks++;
-
-        return alloc::error::success;
-    }
+        m.blocks[m.num_blocks] = reinterpret_cast<T*>(
+            new_buffer_result.unwrap().unchecked_address_of_first_item());
+        m.num_blocks++;
 
-    [[nodiscard]] constexpr status<alloc::error>
-    initialize_blocklist() OKAYLIB_NOEXCEPT
-    {
-        __ok_internal_assert(!m.blocklist);
-        auto blocklist_result = m.allocator->allocate(alloc::request_t{
-            .num_bytes = sizeof(blocklist_t) + (sizeof(T*) * m.size),
-            .alignment = alignof(blocklist_t),
-            .leave_nonzeroed = true,
-        });
-
-        if (!blocklist_result.is_success()) [[unlikely]]
-            return blocklist_result.status();
-
-        bytes_t& blocklist_bytes = blocklist_result.unwrap();
-        m.blocklist = reinterpret_cast<blocklist_t*>(
-            blocklist_bytes.unchecked_address_of_first_item());
-
-        m.blocklist->num_blocks = 0;
-        m.blocklist->capacity =
-            (blocklist_bytes.size() - sizeof(blocklist_t)) / sizeof(T*);
-        // m.size used to encode initial number of block pointers to
-        // allocate, now it actually stores number of items in this
-        // segmented list
-        m.size = 0;
-        return alloc::error::success;
-    }
-
-    /// Reallocates the blocklist to have space for at least one more block
-    [[nodiscard]] constexpr status<alloc::error>
-    ensure_additional_blocklist_capacity_is_at_least_one() OKAYLIB_NOEXCEPT
-    {
-        if (!m.blocklist) {
-            if (ok::status status = initialize_blocklist();
-                !status.is_success()) [[unlikely]]
-                return status;
-        } else if (m.blocklist->capacity <= m.blocklist->num_blocks) {
-            auto new_blocklist_result =
-                m.allocator->reallocate(alloc::reallocate_request_t{
-                    .memory = ok::raw_slice<uint8_t>(
-                        *reinterpret_cast<uint8_t*>(m.blocklist),
-                        (m.blocklist->capacity * sizeof(T*)) +
-                            sizeof(blocklist_t)),
-                    .new_size_bytes = sizeof(blocklist_t) +
-                                      (sizeof(T*) * m.blocklist->capacity + 1),
-                    .preferred_size_bytes =
-                        sizeof(blocklist_t) +
-                        (sizeof(T*) * m.blocklist->capacity * 2),
-                });
-
-            if (!new_blocklist_result.is_success()) [[unlikely]]
-                return new_blocklist_result.status();
-
-            bytes_t& blocklist_bytes = new_blocklist_result.unwrap();
-            m.blocklist = reinterpret_cast<blocklist_t*>(
-                blocklist_bytes.unchecked_address_of_first_item());
-            m.blocklist->capacity =
-                (blocklist_bytes.size() - sizeof(blocklist_t)) / sizeof(T*);
-        }
         return alloc::error::success;
     }
 
     [[nodiscard]] constexpr T& unchecked_access(size_t index) & OKAYLIB_NOEXCEPT
     {
         using namespace segmented_list::detail;
-        auto [block, sub_index] = get_block_index_and_offset(index);
-        return m.blocklist->blocks[block][sub_index];
+        auto [block, sub_index] =
+            get_block_index_and_offset(index, first_block_exponent);
+        return m.blocks[block][sub_index];
     }
 
     [[nodiscard]] constexpr const T&
     unchecked_access(size_t index) const& OKAYLIB_NOEXCEPT
     {
         using namespace segmented_list::detail;
-        auto [block, sub_index] = get_block_index_and_offset(index);
-        return m.blocklist->blocks[block][sub_index];
+        auto [block, sub_index] =
+            get_block_index_and_offset(index, first_block_exponent);
+        return m.blocks[block][sub_index];
     }
 
-    [[nodiscard]] constexpr slice<T>
-        get_block_slice(size_t idx) & OKAYLIB_NOEXCEPT
+    /// Cursor which keeps track of which block it is in, and where in that
+    /// block, alongside the index. Stepping forward by one never has to find
+    /// the block again.
+    template <bool is_const> struct cursor_t
     {
-        using namespace segmented_list::detail;
-        __ok_internal_assert(m.blocklist);
-        const size_t block_idx = num_blocks_needed_for_spots(idx + 1);
-        return raw_slice(*m.blocklist->get_block(idx),
-                         size_of_block_at(block_idx));
-    }
+      private:
+        size_t m_index = 0;
+        size_t m_block = 0;
+        size_t m_offset_in_block = 0;
+        size_t m_block_size = first_block_size;
 
-    [[nodiscard]] constexpr slice<const T>
-    get_block_slice(size_t idx) const& OKAYLIB_NOEXCEPT
+      public:
+        constexpr cursor_t() = default;
+
+        using value_type = stdc::conditional_t<is_const, const T&, T&>;
+        using container_t =
+            stdc::conditional_t<is_const, const segmented_list_t,
+                                segmented_list_t>;
+
+        [[nodiscard]] constexpr size_t size(const segmented_list_t& list) const
+        {
+            return list.size();
+        }
+
+        [[nodiscard]] constexpr size_t index(const segmented_list_t&) const
+        {
+            return m_index;
+        }
+
+        constexpr void offset(const segmented_list_t&, int64_t offset_amount)
+        {
+            if (offset_amount == 1) [[likely]] {
+                ++m_index;
+                if (++m_offset_in_block == m_block_size) {
+                    ++m_block;
+                    m_offset_in_block = 0;
+                    m_block_size *= 2;
+                }
+                return;
+            }
+
+            m_index += offset_amount;
+            auto [block, offset_in_block] =
+                segmented_list::detail::get_block_index_and_offset(
+                    m_index, first_block_exponent);
+            m_block = block;
+            m_offset_in_block = offset_in_block;
+            m_block_size = segmented_list::detail::size_of_block_at(
+                block, first_block_exponent);
+        }
+
+        [[nodiscard]] constexpr value_type access(container_t& list)
+        {
+            __ok_assert(m_index < list.size(),
+                        "Out of bounds iteration into segmented_list_t");
+            return list.m.blocks[m_block][m_offset_in_block];
+        }
+    };
+
+    template <bool is_const> struct block_cursor_t
     {
-        using namespace segmented_list::detail;
-        __ok_internal_assert(m.blocklist);
-        const size_t block_idx = num_blocks_needed_for_spots(idx + 1);
-        return raw_slice(*m.blocklist->get_block(idx),
-                         size_of_block_at(block_idx));
-    }
+      private:
+        size_t m_block = 0;
+
+      public:
+        constexpr block_cursor_t() = default;
+
+        using value_type =
+            stdc::conditional_t<is_const, slice<const T>, slice<T>>;
+        using container_t =
+            stdc::conditional_t<is_const, const segmented_list_t,
+                                segmented_list_t>;
+
+        [[nodiscard]] constexpr size_t size(const segmented_list_t& list) const
+        {
+            return list.num_occupied_blocks();
+        }
+
+        [[nodiscard]] constexpr size_t index(const segmented_list_t&) const
+        {
+            return m_block;
+        }
+
+        constexpr void offset(const segmented_list_t&, int64_t offset_amount)
+        {
+            m_block += offset_amount;
+        }
+
+        [[nodiscard]] constexpr value_type access(container_t& list)
+        {
+            return list.block(m_block);
+        }
+    };
 
     struct members_t
     {
-        blocklist_t* blocklist;
         size_t size;
+        size_t num_blocks;
         backing_allocator_t* allocator;
+        // only the first num_blocks pointers are initialized
+        T* blocks[max_blocks];
+
+        constexpr void init(backing_allocator_t& backing) OKAYLIB_NOEXCEPT
+        {
+            size = 0;
+            num_blocks = 0;
+            allocator = ok::addressof(backing);
+        }
     } m;
 };
 
@@ -581,20 +697,21 @@ struct empty_options_t
 {
     size_t expected_max_capacity = 0;
     // if true, the empty constructor will make all the allocations necessary
-    // to hold up to expected_max_capacity elements. If false, it only allocates
-    // enough for the blocklist.
+    // to hold up to expected_max_capacity elements. If false, it does not
+    // allocate.
     bool should_preallocate = false;
 };
 
 namespace detail {
-template <typename T> struct empty_t
+template <typename T, size_t first_block_size> struct empty_t
 {
     static constexpr auto implemented_make_function =
         ok::implemented_make_function::make_into_uninit;
 
     template <typename backing_allocator_t, typename...>
     using associated_type =
-        ok::segmented_list_t<T, ok::remove_cvref_t<backing_allocator_t>>;
+        ok::segmented_list_t<T, ok::remove_cvref_t<backing_allocator_t>,
+                             first_block_size>;
 
     template <allocator_c backing_allocator_t>
     [[nodiscard]] constexpr auto
@@ -606,28 +723,20 @@ template <typename T> struct empty_t
 
     template <allocator_c backing_allocator_t>
     [[nodiscard]] constexpr alloc::error
-    make_into_uninit(ok::segmented_list_t<T, backing_allocator_t>& output,
-                     backing_allocator_t& allocator,
-                     const empty_options_t& options) const OKAYLIB_NOEXCEPT
-    {
-        using M =
-            typename ok::segmented_list_t<T, backing_allocator_t>::members_t;
-
-        // expected_max_capacity + 1 because 4 expected -> log2_uint_ceil(4) ==
-        // 2, but 2 blocks only gives us 3. log2_uint_ceil(16) == 4, but 4
-        // blocks only gives us 15 spots.
-        const size_t blocks_needed =
-            log2_uint_ceil(ok::max(2UL, options.expected_max_capacity + 1));
-
-        output.m = M{
-            .blocklist = nullptr,
-            // when blocklist is nullptr, "size" actually means size of initial
-            // blocklist allocation
-            .size = blocks_needed,
-            .allocator = ok::addressof(allocator),
-        };
+    make_into_uninit(
+        ok::segmented_list_t<T, backing_allocator_t, first_block_size>& output,
+        backing_allocator_t& allocator,
+        const empty_options_t& options) const OKAYLIB_NOEXCEPT
+    {
+        using list_t =
+            ok::segmented_list_t<T, backing_allocator_t, first_block_size>;
+
+        output.m.init(allocator);
 
         if (options.should_preallocate) {
+            const size_t blocks_needed = num_blocks_needed_for_spots(
+                ok::max(size_t(1), options.expected_max_capacity),
+                list_t::first_block_exponent);
             for (size_t i = 0; i < blocks_needed; ++i) {
                 ok::status status = output.new_block();
                 if (!ok::is_success(status)) {
@@ -672,98 +781,74 @@ struct copy_items_from_iterator_t
     {
         using T = stdc::remove_cvref_t<value_type_for<input_iterator_t>>;
 
-        using M =
-            typename ok::segmented_list_t<T, backing_allocator_t>::members_t;
+        const size_t num_items = ok::size(iterator);
+        const size_t num_blocks = num_blocks_needed_for_spots(num_items);
 
-        using blocklist_t =
-            typename ok::segmented_list_t<T, backing_allocator_t>::blocklist_t;
+        output.m.init(allocator);
 
-        const size_t num_initial_blocks = log2_uint_ceil(ok::size(iterator));
-        const size_t num_initial_spots =
-            get_num_spots_for_blocks(num_initial_blocks);
-
-        const size_t blocklist_size_bytes =
-            sizeof(blocklist_t) + (sizeof(T*) * num_initial_blocks);
-
-        const size_t buffer_size_bytes = sizeof(T) * num_initial_spots;
-
-        alloc::result_t<bytes_t> mainbuf_result =
-            allocator.allocate(alloc::request_t{
-                .num_bytes =
-                    blocklist_size_bytes + alignof(T) + buffer_size_bytes,
-                .alignment = alignof(T),
-                .leave_nonzeroed = true,
-            });
-
-        if (!mainbuf_result.is_success()) [[unlikely]]
-            return mainbuf_result.status();
-
-        bytes_t& mainbuf = mainbuf_result.unwrap();
-        defer free_mainbuf([&] {
-            allocator.deallocate(mainbuf.unchecked_address_of_first_item());
-        });
-
-        auto* blocklist = reinterpret_cast<blocklist_t*>(
-            mainbuf.unchecked_address_of_first_item());
-
-        *blocklist = blocklist_t{
-            .num_blocks = 0,
-            .capacity = num_initial_blocks,
-        };
-
-        void* blocklist_end =
-            mainbuf.unchecked_address_of_first_item() + blocklist_size_bytes;
-
-        size_t remaining_space = mainbuf.size() - blocklist_size_bytes;
-
-        const bool aligned = std::align(alignof(T), buffer_size_bytes,
-                                        blocklist_end, remaining_space);
-        __ok_assert(
-            aligned,
-            "Allocator did not return enough space for a segmented list");
-
-        auto itembuf =
-            ok::raw_slice(*static_cast<T*>(blocklist_end), num_initial_spots);
-        __ok_internal_assert(
-            ok_memcontains(.outer = mainbuf,
-                           .inner = reinterpret_as_bytes(itembuf)));
-
-        size_t iter = 0;
-        for (size_t i = 0; i < num_initial_blocks; ++i) {
-            blocklist->blocks[i] = ok::addressof(itembuf[iter]);
-            iter += segmented_list::detail::size_of_block_at(i);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            ok::status status = output.new_block();
+            if (!ok::is_success(status)) [[unlikely]] {
+                output.destroy();
+                return status.as_enum();
+            }
         }
 
-        output.m = M{
-            .blocklist = blocklist,
-            .size = 0,
-            .allocator = ok::addressof(allocator),
-        };
+        if (num_blocks == 0)
+            return alloc::error::success;
 
-        for (auto item : ok::iter(iterator)) {
-            auto stat = output.insert_at(output.size(), stdc::move(item));
-            __ok_internal_assert(ok::is_success(stat));
+        // fill each block front to back, everything is already allocated
+        size_t block_idx = 0;
+        size_t offset_in_block = 0;
+        T* block = output.m.blocks[0];
+        while (auto&& item = iterator.next()) {
+            __ok_assert(output.m.size < num_items,
+                        "Iterator given to segmented_list::"
+                        "copy_items_from_iterator reported the wrong size.");
+            if constexpr (stdc::is_lvalue_reference_v<
+                              value_type_for<input_iterator_t>>) {
+                stdc::construct_at(block + offset_in_block,
+                                   item.ref_unchecked());
+            } else {
+                stdc::construct_at(block + offset_in_block,
+                                   stdc::move(item.ref_unchecked()));
+            }
+            ++output.m.size;
+            if (++offset_in_block == size_of_block_at(block_idx)) {
+                offset_in_block = 0;
+                if (++block_idx < num_blocks)
+                    block = output.m.blocks[block_idx];
+            }
         }
 
-        free_mainbuf.cancel();
         return alloc::error::success;
     };
 };
 } // namespace detail
 
-template <typename T> inline constexpr segmented_list::detail::empty_t<T> empty;
+template <typename T, size_t first_block_size = 1>
+inline constexpr segmented_list::detail::empty_t<T, first_block_size> empty;
 
 inline constexpr segmented_list::detail::copy_items_from_iterator_t
     copy_items_from_iterator;
 
 } // namespace segmented_list
+
+// items live in separately allocated blocks, and never move with the list
+template <typename T, typename backing_allocator_t, size_t first_block_size>
+struct is_trivially_relocatable<
+    segmented_list_t<T, backing_allocator_t, first_block_size>>
+    : stdc::true_type
+{};
 } // namespace ok
 
 #if defined(OKAYLIB_USE_FMT)
-template <typename T, typename backing_allocator_t>
-struct fmt::formatter<ok::segmented_list_t<T, backing_allocator_t>>
+template <typename T, typename backing_allocator_t, size_t first_block_size>
+struct fmt::formatter<
+    ok::segmented_list_t<T, backing_allocator_t, first_block_size>>
 {
-    using formatted_type_t = ok::segmented_list_t<T, backing_allocator_t>;
+    using formatted_type_t =
+        ok::segmented_list_t<T, backing_allocator_t, first_block_size>;
     static_assert(
         fmt::is_formattable<T>::value,
         "Attempt to format a segmented list whose items are not formattable.");
@@ -782,17 +867,10 @@ struct fmt::formatter<ok::segmented_list_t<T, backing_allocator_t>>
         // TODO: use CTTI to include nice type names in print here
         fmt::format_to(ctx.out(), "segmented_list_t: [ ");
 
-        if (segmented_list.m.blocklist) {
-            size_t block_size =
-                ok::two_to_the_power_of(segmented_list.m.initial_size_exponent);
-
-            for (size_t b = 0; b < segmented_list.m.blocklist->num_blocks;
-                 ++b) {
-                T* block = segmented_list.m.blocklist->blocks[b];
-                for (size_t i = 0; i < block_size; ++i) {
-                    fmt::format_to(ctx.out(), "{} ", block[i]);
-                }
-                block_size *= 2;
+        for (size_t b = 0; b < segmented_list.num_occupied_blocks(); ++b) {
+            const ok::slice<const T> items = segmented_list.block(b);
+            for (size_t i = 0; i < items.size(); ++i) {
+                fmt::format_to(ctx.out(), "{} ", items[i]);
             }
         }
 
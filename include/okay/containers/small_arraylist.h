@@ -0,0 +1,542 @@
+#ifndef __OKAYLIB_CONTAINERS_SMALL_ARRAYLIST_H__
+#define __OKAYLIB_CONTAINERS_SMALL_ARRAYLIST_H__
+
+#include "okay/allocators/allocator.h"
+#include "okay/defer.h"
+#include "okay/detail/template_util/uninitialized_storage.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
+#include "okay/error.h"
+#include "okay/iterables/iterables.h"
+
+namespace ok {
+
+namespace small_arraylist {
+namespace detail {
+template <typename T, size_t num_inline_items> struct empty_t;
+} // namespace detail
+} // namespace small_arraylist
+
+/// An arraylist which stores up to num_inline_items items inside of itself,
+/// and only uses its backing allocator once it grows past that. Once spilled,
+/// it behaves like arraylist_t, until shrink_to_reclaim_unused_memory() is
+/// called with few enough items to fit inline again.
+///
+/// Unlike arraylist_t, moving a small_arraylist_t which is storing its items
+/// inline has to move each of the items.
+template <typename T, size_t num_inline_items,
+          allocator_c backing_allocator_t = ok::allocator_t>
+class small_arraylist_t
+{
+    static_assert(num_inline_items > 0,
+                  "Cannot create a small_arraylist_t with zero inline items, "
+                  "use arraylist_t instead.");
+    static_assert(!stdc::is_reference_c<T>,
+                  "small_arraylist_t cannot store references.");
+    static_assert(!stdc::is_void_v<T>,
+                  "cannot create a small arraylist of void.");
+    static_assert(
+        stdc::is_trivially_copyable_v<T> || stdc::is_move_constructible_v<T> ||
+            is_std_constructible_c<T, T&&>,
+        "Type given to small_arraylist_t must be either trivially copyable or "
+        "move constructible, otherwise it cannot move the items when "
+        "reallocating.");
+    static_assert(!is_const_c<T>,
+                  "Attempt to create a small_arraylist_t with const objects, "
+                  "which is not possible. Remove the const, and consider "
+                  "passing a const reference to the arraylist instead.");
+
+    struct members_t
+    {
+        // points to inline_items if the items are stored inline
+        T* items;
+        size_t capacity;
+        size_t size;
+        backing_allocator_t* backing_allocator;
+    };
+    members_t m;
+    ok::detail::uninitialized_storage_t<T> m_inline_items[num_inline_items];
+
+    constexpr explicit small_arraylist_t(
+        backing_allocator_t& backing_allocator) OKAYLIB_NOEXCEPT
+        : m(members_t{
+              .items = inline_items(),
+              .capacity = num_inline_items,
+              .size = 0,
+              .backing_allocator = ok::addressof(backing_allocator),
+          })
+    {
+    }
+
+  public:
+    friend class small_arraylist::detail::empty_t<T, num_inline_items>;
+
+    using value_type = T;
+
+    static constexpr size_t inline_capacity = num_inline_items;
+
+    [[nodiscard]] constexpr size_t size() const OKAYLIB_NOEXCEPT
+    {
+        return m.size;
+    }
+
+    [[nodiscard]] constexpr size_t capacity() const OKAYLIB_NOEXCEPT
+    {
+        return m.capacity;
+    }
+
+    [[nodiscard]] constexpr bool is_empty() const OKAYLIB_NOEXCEPT
+    {
+        return this->size() == 0;
+    }
+
+    /// Whether the items are currently stored inside of this object, as
+    /// opposed to in memory from the backing allocator.
+    [[nodiscard]] constexpr bool is_inline() const OKAYLIB_NOEXCEPT
+    {
+        return m.items == inline_items();
+    }
+
+    [[nodiscard]] constexpr slice<T> items() & OKAYLIB_NOEXCEPT
+    {
+        if (this->size() == 0) {
+            return make_null_slice<T>();
+        }
+        return raw_slice(*m.items, m.size);
+    }
+
+    [[nodiscard]] constexpr slice<const T> items() const& OKAYLIB_NOEXCEPT
+    {
+        return const_cast<small_arraylist_t*>(this)->items();
+    }
+
+    [[nodiscard]] constexpr const T&
+    operator[](size_t index) const& OKAYLIB_NOEXCEPT
+    {
+        if (index >= this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access to ok::small_arraylist_t");
+        }
+        return m.items[index];
+    }
+    [[nodiscard]] constexpr T& operator[](size_t index) & OKAYLIB_NOEXCEPT
+    {
+        if (index >= this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access to ok::small_arraylist_t");
+        }
+        return m.items[index];
+    }
+
+    [[nodiscard]] constexpr backing_allocator_t&
+    allocator() const OKAYLIB_NOEXCEPT
+    {
+        return *m.backing_allocator;
+    }
+
+    small_arraylist_t(const small_arraylist_t&) = delete;
+    small_arraylist_t& operator=(const small_arraylist_t&) = delete;
+
+    constexpr small_arraylist_t(small_arraylist_t&& other) OKAYLIB_NOEXCEPT
+        : m(members_t{
+              .items = inline_items(),
+              .capacity = num_inline_items,
+              .size = 0,
+              .backing_allocator = other.m.backing_allocator,
+          })
+    {
+        take_items_from(other);
+    }
+
+    constexpr small_arraylist_t&
+    operator=(small_arraylist_t&& other) OKAYLIB_NOEXCEPT
+    {
+        if (&other == this) [[unlikely]]
+            return *this;
+        destroy();
+        m = members_t{
+            .items = inline_items(),
+            .capacity = num_inline_items,
+            .size = 0,
+            .backing_allocator = other.m.backing_allocator,
+        };
+        take_items_from(other);
+        return *this;
+    }
+
+    /// If there is not space for another item, reallocate.
+    [[nodiscard]] constexpr status<alloc::error>
+    ensure_additional_capacity() OKAYLIB_NOEXCEPT
+    {
+        if (this->capacity() <= this->size()) [[unlikely]] {
+            // 2x growth rate
+            return this->grow_to_at_least(this->capacity() * 2);
+        }
+        return alloc::error::success;
+    }
+
+    [[nodiscard]] constexpr status<alloc::error>
+    increase_capacity_by_at_least(size_t new_spots) OKAYLIB_NOEXCEPT
+    {
+        if (new_spots == 0) [[unlikely]] {
+            __ok_assert(false, "Attempt to increase capacity by 0.");
+            return alloc::error::unsupported;
+        }
+        return this->grow_to_at_least(this->capacity() + new_spots);
+    }
+
+    /// Returns error describing any potential failure due to allocation, but
+    /// just aborts if called with an out of bound index.
+    template <typename... args_t>
+    [[nodiscard]] constexpr auto insert_at(const size_t idx,
+                                           args_t&&... args) OKAYLIB_NOEXCEPT
+        requires is_inplace_constructible_or_move_makeable_c<T, args_t...>
+    {
+        if (idx > this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access to small_arraylist in insert_at.");
+        }
+
+        {
+            auto status = this->ensure_additional_capacity();
+            if (!status.is_success()) [[unlikely]] {
+                return status;
+            }
+        }
+        __ok_internal_assert(this->capacity() > this->size());
+
+        if (idx < this->size()) {
+            // move all other items towards the back of the arraylist
+            if constexpr (is_trivially_relocatable_v<T>) {
+                ::memmove((void*)(m.items + idx + 1), (void*)(m.items + idx),
+                          (this->size() - idx) * sizeof(T));
+            } else {
+                ok::stdc::construct_at(m.items + this->size(),
+                                       stdc::move(m.items[this->size() - 1]));
+                for (size_t i = this->size() - 1; i > idx; --i) {
+                    m.items[i] = stdc::move(m.items[i - 1]);
+                }
+                if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                    m.items[idx].~T();
+                }
+            }
+        }
+
+        auto& uninit = m.items[idx];
+
+        using enum_t = decltype(ok::make_into_uninitialized<T>(
+            stdc::declval<T&>(), stdc::forward<args_t>(args)...));
+        if constexpr (!stdc::is_void_v<enum_t>) {
+            static_assert(
+                is_convertible_to_c<alloc::error, enum_t>,
+                "In order to use a potentially failing constructor with "
+                "small_arraylist_t::append(), the constructor's enum type must "
+                "define a conversion from alloc::error.");
+            auto result = ok::make_into_uninitialized<T>(
+                uninit, stdc::forward<args_t>(args)...);
+
+            if (result == enum_t::success) [[likely]] {
+                ++m.size;
+            } else {
+                // move all other items back to where they were before
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    ::memmove((void*)(m.items + idx),
+                              (void*)(m.items + idx + 1),
+                              (this->size() - idx) * sizeof(T));
+                } else if (idx < this->size()) {
+                    // the slot at idx was destroyed before the failed
+                    // construction, so it has to be constructed again
+                    // instead of assigned to
+                    ok::stdc::construct_at(m.items + idx,
+                                           stdc::move(m.items[idx + 1]));
+                    for (size_t i = idx + 1; i < this->size(); ++i) {
+                        m.items[i] = stdc::move(m.items[i + 1]);
+                    }
+                    if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                        m.items[this->size()].~T();
+                    }
+                }
+            }
+            return status(enum_t(result));
+        } else {
+            ok::make_into_uninitialized<T>(uninit,
+                                           stdc::forward<args_t>(args)...);
+            ++m.size;
+            return status(alloc::error::success);
+        }
+    }
+
+    template <typename... args_t>
+    [[nodiscard]] constexpr auto append(args_t&&... args) OKAYLIB_NOEXCEPT
+        requires is_inplace_constructible_or_move_makeable_c<T, args_t...>
+    {
+        return insert_at(this->size(), stdc::forward<args_t>(args)...);
+    }
+
+    constexpr T remove(size_t idx) OKAYLIB_NOEXCEPT
+    {
+        if (idx >= this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access in small_arraylist_t::remove()");
+        }
+        T& removed = m.items[idx];
+        T out(stdc::move(removed));
+
+        defer decrement([this] { --m.size; });
+
+        if (idx == this->size() - 1) {
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                removed.~T();
+            }
+            return out;
+        }
+
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                removed.~T();
+            }
+            const size_t idxplusone = idx + 1;
+            ::memmove((void*)(m.items + idx), (void*)(m.items + idxplusone),
+                      (this->size() - idxplusone) * sizeof(T));
+        } else {
+            for (size_t i = idx; i < this->size() - 1; ++i) {
+                m.items[i] = stdc::move(m.items[i + 1]);
+            }
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                m.items[this->size() - 1].~T();
+            }
+        }
+        return out;
+    }
+
+    constexpr T remove_and_swap_last(size_t idx) OKAYLIB_NOEXCEPT
+    {
+        if (idx >= this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access in "
+                       "small_arraylist_t::remove_and_swap_last()");
+        }
+        T& target = m.items[idx];
+        T out(stdc::move(target));
+
+        defer decrement([this] { --m.size; });
+
+        T& last = m.items[this->size() - 1];
+        if (idx != this->size() - 1) {
+            target = stdc::move(last);
+        }
+
+        if constexpr (!stdc::is_trivially_destructible_v<T>) {
+            last.~T();
+        }
+
+        return out;
+    }
+
+    constexpr opt<T> pop_last() OKAYLIB_NOEXCEPT
+    {
+        if (is_empty())
+            return {};
+        return remove(this->size() - 1);
+    }
+
+    constexpr void clear() OKAYLIB_NOEXCEPT
+    {
+        this->call_destructor_on_all_items();
+        m.size = 0;
+    }
+
+    /// Does not reclaim unused memory when shrinking
+    /// If type stored is trivially default constructible, and the default
+    /// constructor is selected, then new memory is zeroed.
+    /// Args `args` must select a nonfailing constructor.
+    template <typename... args_t>
+        requires is_infallible_constructible_c<T, args_t...>
+    [[nodiscard]] constexpr status<alloc::error>
+    resize(size_t new_size, args_t&&... args) OKAYLIB_NOEXCEPT
+    {
+        if (new_size <= this->size()) {
+            if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                for (size_t i = new_size; i < this->size(); ++i) {
+                    m.items[i].~T();
+                }
+            }
+            m.size = new_size;
+            return alloc::error::success;
+        }
+
+        if (this->capacity() < new_size) {
+            auto status = this->grow_to_at_least(new_size);
+            if (!status.is_success()) [[unlikely]]
+                return status;
+        }
+
+        if constexpr (stdc::is_trivially_default_constructible_v<T> &&
+                      sizeof...(args_t) == 0) {
+            ::memset(m.items + this->size(), 0,
+                     (new_size - this->size()) * sizeof(T));
+        } else {
+            for (size_t i = this->size(); i < new_size; ++i) {
+                ok::make_into_uninitialized<T>(m.items[i],
+                                               stdc::forward<args_t>(args)...);
+            }
+        }
+        m.size = new_size;
+        return alloc::error::success;
+    }
+
+    /// If the items have spilled to the backing allocator but would now fit
+    /// inline, move them back inline and free the heap memory.
+    constexpr void shrink_to_reclaim_unused_memory() OKAYLIB_NOEXCEPT
+    {
+        if (this->is_inline() || this->size() > num_inline_items)
+            return;
+
+        T* const heap_items = m.items;
+        relocate_items(heap_items, inline_items(), m.size);
+        m.backing_allocator->deallocate(heap_items);
+        m.items = inline_items();
+        m.capacity = num_inline_items;
+    }
+
+    constexpr ~small_arraylist_t() { destroy(); }
+
+  private:
+    [[nodiscard]] constexpr T* inline_items() OKAYLIB_NOEXCEPT
+    {
+        return reinterpret_cast<T*>(m_inline_items);
+    }
+    [[nodiscard]] constexpr const T* inline_items() const OKAYLIB_NOEXCEPT
+    {
+        return reinterpret_cast<const T*>(m_inline_items);
+    }
+
+    /// Move-construct count items from source into uninitialized dest, and
+    /// destroy the originals. Just a memcpy for trivially relocatable types.
+    static constexpr void relocate_items(T* source, T* dest,
+                                         size_t count) OKAYLIB_NOEXCEPT
+    {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (count != 0)
+                ::memcpy((void*)dest, (void*)source, count * sizeof(T));
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                ok::stdc::construct_at(dest + i, stdc::move(source[i]));
+                if constexpr (!stdc::is_trivially_destructible_v<T>) {
+                    source[i].~T();
+                }
+            }
+        }
+    }
+
+    /// Expects to have no items and to be storing inline.
+    constexpr void take_items_from(small_arraylist_t& other) OKAYLIB_NOEXCEPT
+    {
+        __ok_internal_assert(this->is_inline() && this->size() == 0);
+        if (other.is_inline()) {
+            relocate_items(other.m.items, m.items, other.m.size);
+            m.size = other.m.size;
+        } else {
+            // steal the heap allocation, leave other empty and inline
+            m.items = other.m.items;
+            m.capacity = other.m.capacity;
+            m.size = other.m.size;
+            other.m.items = other.inline_items();
+            other.m.capacity = num_inline_items;
+        }
+        other.m.size = 0;
+    }
+
+    [[nodiscard]] constexpr status<alloc::error>
+    grow_to_at_least(size_t new_capacity) OKAYLIB_NOEXCEPT
+    {
+        __ok_internal_assert(new_capacity > this->capacity());
+
+        if constexpr (is_trivially_relocatable_v<T>) {
+            // let the allocator copy (and maybe expand in place) if we already
+            // have a heap allocation
+            if (!this->is_inline()) {
+                alloc::result_t<bytes_t> res =
+                    m.backing_allocator->reallocate(alloc::reallocate_request_t{
+                        .memory = reinterpret_as_bytes(
+                            raw_slice(*m.items, this->capacity())),
+                        .new_size_bytes = new_capacity * sizeof(T),
+                        .alignment = alignof(T),
+                        .flags = alloc::realloc_flags::leave_nonzeroed,
+                    });
+                if (!res.is_success()) [[unlikely]]
+                    return res.status();
+
+                bytes_t& bytes = res.unwrap();
+                m.items = reinterpret_cast<T*>(
+                    bytes.unchecked_address_of_first_item());
+                m.capacity = bytes.size() / sizeof(T);
+                return alloc::error::success;
+            }
+        }
+
+        alloc::result_t<bytes_t> res =
+            m.backing_allocator->allocate(alloc::request_t{
+                .num_bytes = new_capacity * sizeof(T),
+                .alignment = alignof(T),
+                .leave_nonzeroed = true,
+            });
+        if (!res.is_success()) [[unlikely]]
+            return res.status();
+
+        bytes_t& bytes = res.unwrap();
+        T* const new_items =
+            reinterpret_cast<T*>(bytes.unchecked_address_of_first_item());
+        relocate_items(m.items, new_items, m.size);
+
+        if (!this->is_inline())
+            m.backing_allocator->deallocate(m.items);
+
+        m.items = new_items;
+        m.capacity = bytes.size() / sizeof(T);
+        return alloc::error::success;
+    }
+
+    constexpr void call_destructor_on_all_items() OKAYLIB_NOEXCEPT
+    {
+        if constexpr (!stdc::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < m.size; ++i) {
+                m.items[i].~T();
+            }
+        }
+    }
+
+    constexpr void destroy() OKAYLIB_NOEXCEPT
+    {
+        this->call_destructor_on_all_items();
+        if (!this->is_inline())
+            m.backing_allocator->deallocate(m.items);
+    }
+};
+
+// NOTE: small_arraylist_t is not trivially relocatable, when it stores its
+// items inline it points to itself.
+
+namespace small_arraylist {
+namespace detail {
+template <typename T, size_t num_inline_items> struct empty_t
+{
+    static constexpr auto implemented_make_function =
+        ok::implemented_make_function::make;
+
+    template <typename backing_allocator_arg_t>
+    using associated_type =
+        small_arraylist_t<T, num_inline_items,
+                          stdc::remove_cvref_t<backing_allocator_arg_t>>;
+
+    template <allocator_c backing_allocator_t>
+    [[nodiscard]] constexpr small_arraylist_t<T, num_inline_items,
+                                              backing_allocator_t>
+    operator()(backing_allocator_t& allocator) const noexcept
+    {
+        return small_arraylist_t<T, num_inline_items, backing_allocator_t>(
+            allocator);
+    }
+};
+} // namespace detail
+
+template <typename T, size_t num_inline_items>
+inline constexpr detail::empty_t<T, num_inline_items> empty;
+} // namespace small_arraylist
+} // namespace ok
+
+#endif
@@ -61,7 +61,7 @@ static_assert(ok::stdc::is_same_v<ok::stdc::underlying_type_t<memory_order>,
 namespace detail {
 inline void atomic_thread_fence(memory_order order) noexcept
 {
-    if constexpr (!ok::stdc::is_constant_evaluated()) {
+    if (!ok::stdc::is_constant_evaluated()) {
         __c11_atomic_thread_fence(
             static_cast<memory_order_underlying_t>(order));
     }
@@ -69,7 +69,7 @@ inline void atomic_thread_fence(memory_order order) noexcept
 
 inline void atomic_signal_fence(memory_order order) noexcept
 {
-    if constexpr (!ok::stdc::is_constant_evaluated()) {
+    if (!ok::stdc::is_constant_evaluated()) {
         __c11_atomic_signal_fence(
             static_cast<memory_order_underlying_t>(order));
     }
@@ -81,7 +81,7 @@ template <class T> void atomic_init(atomic_base<T> volatile* a, T val) noexcept
 }
 template <class T> constexpr void atomic_init(atomic_base<T>* a, T val) noexcept
 {
-    if constexpr (ok::stdc::is_constant_evaluated()) {
+    if (ok::stdc::is_constant_evaluated()) {
         a->value = val;
     } else {
         __c11_atomic_init(ok::addressof(a->value), val);
@@ -99,7 +99,7 @@ template <class T>
 constexpr void atomic_store(atomic_base<T>* a, T val,
                             memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         a->value = val;
     } else {
         __c11_atomic_store(ok::addressof(a->value), val,
@@ -117,7 +117,7 @@ T atomic_load(atomic_base<T> const volatile* a, memory_order order) noexcept
 template <class T>
 constexpr T atomic_load(atomic_base<T> const* a, memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         return a->value;
     } else {
         using ptr_type = ok::stdc::remove_const_t<decltype(a->value)>*;
@@ -138,7 +138,7 @@ template <class T>
 constexpr void atomic_load_inplace(atomic_base<T> const* a, T* dest,
                                    memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         *dest = a->value;
     } else {
         using ptr_type = ok::stdc::remove_const_t<decltype(a->value)>*;
@@ -159,7 +159,7 @@ template <class T>
 constexpr T atomic_exchange(atomic_base<T>* a, T value,
                             memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         const auto out = a->value;
         a->value = value;
         return out;
@@ -193,7 +193,7 @@ constexpr bool atomic_compare_exchange_strong(atomic_base<T>* a, T* expected,
                                               T value, memory_order success,
                                               memory_order failure) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         if (a->value == *expected) {
             a->value = value;
             return true;
@@ -224,7 +224,7 @@ constexpr bool atomic_compare_exchange_weak(atomic_base<T>* a, T* expected,
                                             T value, memory_order success,
                                             memory_order failure) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         if (a->value == *expected) {
             a->value = value;
             return true;
@@ -252,7 +252,7 @@ template <class T>
 constexpr T atomic_fetch_add(atomic_base<T>* a, T delta,
                              memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         const auto out = a->value;
         a->value += delta;
         return out;
@@ -275,7 +275,7 @@ template <class T>
 constexpr T* atomic_fetch_add(atomic_base<T*>* a, ptrdiff_t delta,
                               memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         const auto out = a->value;
         a->value += delta;
         return out;
@@ -298,7 +298,7 @@ template <class T>
 constexpr T atomic_fetch_sub(atomic_base<T>* a, T delta,
                              memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         // NOTE: no clue why, but -= operator here is not constant evaluated,
         // gives "subexpression not valid in constant expression". All the other
         // *= operators are fine.
@@ -323,7 +323,7 @@ template <class T>
 constexpr T* atomic_fetch_sub(atomic_base<T*>* a, ptrdiff_t delta,
                               memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         const auto out = a->value;
         a->value -= delta;
         return out;
@@ -346,7 +346,7 @@ template <class T>
 constexpr T atomic_fetch_and(atomic_base<T>* a, T pattern,
                              memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         const auto out = a->value;
         a->value &= pattern;
         return out;
@@ -368,7 +368,7 @@ template <class T>
 constexpr T atomic_fetch_or(atomic_base<T>* a, T pattern,
                             memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         const auto out = a->value;
         a->value |= pattern;
         return out;
@@ -391,7 +391,7 @@ template <class T>
 constexpr T atomic_fetch_xor(atomic_base<T>* a, T pattern,
                              memory_order order) noexcept
 {
-    if constexpr (stdc::is_constant_evaluated()) {
+    if (stdc::is_constant_evaluated()) {
         const auto out = a->value;
         a->value ^= pattern;
         return out;
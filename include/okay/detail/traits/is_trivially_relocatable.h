@@ -0,0 +1,33 @@
+#ifndef __OKAYLIB_DETAIL_TRAITS_IS_TRIVIALLY_RELOCATABLE_H__
+#define __OKAYLIB_DETAIL_TRAITS_IS_TRIVIALLY_RELOCATABLE_H__
+
+#include "okay/detail/type_traits.h"
+
+namespace ok {
+/// A type is trivially relocatable if moving it to a new address and then
+/// destroying the original is the same thing as memcpy-ing it to the new
+/// address and forgetting about the original. That is true of anything which
+/// does not store pointers to itself or register its address somewhere, for
+/// example an arraylist_t (which just points to a heap allocation). Containers
+/// use this to memcpy / memmove / realloc their items instead of moving and
+/// destroying each one.
+///
+/// Trivially copyable types are trivially relocatable. Other types have to opt
+/// in by specializing this template:
+///
+/// template <> struct ok::is_trivially_relocatable<my_type_t> : stdc::true_type {};
+///
+/// References count as trivially relocatable, since wrappers like opt<T&>
+/// store them as pointers.
+template <typename T>
+struct is_trivially_relocatable
+    : stdc::bool_constant<stdc::is_trivially_copyable_v<T> ||
+                          stdc::is_reference_v<T>>
+{};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<stdc::remove_cv_t<T>>::value;
+} // namespace ok
+
+#endif
@@ -870,6 +870,12 @@ res_accessor_t<T, E>::get_result_payload_ref_unchecked(res<T, E>& res) noexcept
 }
 } // namespace detail
 
+template <typename success_t, typename status_t, typename enable_t>
+struct is_trivially_relocatable<res<success_t, status_t, enable_t>>
+    : stdc::bool_constant<is_trivially_relocatable_v<success_t> &&
+                          is_trivially_relocatable_v<status_t>>
+{};
+
 } // namespace ok
 
 #if defined(OKAYLIB_USE_FMT)
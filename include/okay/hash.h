@@ -0,0 +1,188 @@
+#ifndef __OKAYLIB_HASH_H__
+#define __OKAYLIB_HASH_H__
+
+/*
+ * Fast non-cryptographic hashing for hash tables. The results are only
+ * meant to be used within one run of a program: they are allowed to change
+ * between versions and platforms.
+ */
+
+#include "okay/ascii_view.h"
+#include "okay/detail/type_traits.h"
+#include <cstdint>
+#include <cstring>
+
+namespace ok {
+namespace detail {
+// arbitrary odd constants with about half of their bits on
+inline constexpr uint64_t hash_secrets[3] = {
+    0x2d358dccaa6c78a5ULL,
+    0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL,
+};
+
+/// Replace a and b with the low and high halves of their 128 bit product.
+constexpr void multiply_128(uint64_t& a, uint64_t& b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    const __uint128_t product = __uint128_t(a) * b;
+    a = uint64_t(product);
+    b = uint64_t(product >> 64);
+#else
+    const uint64_t a_high = a >> 32, a_low = uint32_t(a);
+    const uint64_t b_high = b >> 32, b_low = uint32_t(b);
+    const uint64_t high = a_high * b_high, low = a_low * b_low;
+    const uint64_t middle_1 = a_high * b_low, middle_2 = a_low * b_high;
+    const uint64_t carry = ((low >> 32) + uint32_t(middle_1) +
+                            uint32_t(middle_2)) >>
+                           32;
+    a = low + (middle_1 << 32) + (middle_2 << 32);
+    b = high + (middle_1 >> 32) + (middle_2 >> 32) + carry;
+#endif
+}
+
+/// Multiply and xor the halves of the result together. Every bit of the
+/// output depends on every bit of the inputs.
+[[nodiscard]] constexpr uint64_t multiply_fold(uint64_t a, uint64_t b) noexcept
+{
+    multiply_128(a, b);
+    return a ^ b;
+}
+
+[[nodiscard]] inline uint64_t read_u64(const uint8_t* bytes) noexcept
+{
+    uint64_t out;
+    ::memcpy(&out, bytes, sizeof(out));
+    return out;
+}
+
+[[nodiscard]] inline uint64_t read_u32(const uint8_t* bytes) noexcept
+{
+    uint32_t out;
+    ::memcpy(&out, bytes, sizeof(out));
+    return out;
+}
+} // namespace detail
+
+/// Hash a 64 bit number. Unlike identity hashing, both the low and high bits
+/// of the result are well distributed.
+[[nodiscard]] constexpr uint64_t hash_integer(uint64_t value,
+                                              uint64_t seed = 0) noexcept
+{
+    return detail::multiply_fold(value ^ seed ^ detail::hash_secrets[0],
+                                 detail::hash_secrets[1]);
+}
+
+/// Hash some bytes, in the style of wyhash: short inputs take a couple of
+/// overlapping reads and one multiply, long ones are consumed 48 bytes at a
+/// time in three independent lanes.
+[[nodiscard]] inline uint64_t hash_bytes(const void* data, size_t num_bytes,
+                                         uint64_t seed = 0) noexcept
+{
+    using detail::hash_secrets, detail::read_u32, detail::read_u64;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    seed ^= detail::multiply_fold(seed ^ hash_secrets[0], hash_secrets[1]) ^
+            num_bytes;
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (num_bytes <= 16) {
+        if (num_bytes >= 4) {
+            // reads overlap so that every byte is covered without branching
+            const size_t quarter = (num_bytes >> 3) << 2;
+            const uint8_t* const last = bytes + num_bytes - 4;
+            a = (read_u32(bytes) << 32) | read_u32(bytes + quarter);
+            b = (read_u32(last) << 32) | read_u32(last - quarter);
+        } else if (num_bytes > 0) {
+            a = (uint64_t(bytes[0]) << 56) |
+                (uint64_t(bytes[num_bytes >> 1]) << 32) | bytes[num_bytes - 1];
+        }
+    } else {
+        size_t remaining = num_bytes;
+        if (remaining > 48) {
+            uint64_t lane_1 = seed;
+            uint64_t lane_2 = seed;
+            do {
+                seed = detail::multiply_fold(read_u64(bytes) ^ hash_secrets[0],
+                                             read_u64(bytes + 8) ^ seed);
+                lane_1 = detail::multiply_fold(
+                    read_u64(bytes + 16) ^ hash_secrets[1],
+                    read_u64(bytes + 24) ^ lane_1);
+                lane_2 = detail::multiply_fold(
+                    read_u64(bytes + 32) ^ hash_secrets[2],
+                    read_u64(bytes + 40) ^ lane_2);
+                bytes += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= lane_1 ^ lane_2;
+        }
+        while (remaining > 16) {
+            seed = detail::multiply_fold(read_u64(bytes) ^ hash_secrets[1],
+                                         read_u64(bytes + 8) ^ seed);
+            bytes += 16;
+            remaining -= 16;
+        }
+        // the last 16 bytes, which may overlap with ones already hashed
+        a = read_u64(bytes + remaining - 16);
+        b = read_u64(bytes + remaining - 8);
+    }
+
+    a ^= hash_secrets[1];
+    b ^= seed;
+    detail::multiply_128(a, b);
+    return detail::multiply_fold(a ^ hash_secrets[0] ^ num_bytes,
+                                 b ^ hash_secrets[1]);
+}
+
+/// The default hash function of okaylib's hash tables. Handles integers,
+/// enums, pointers and ascii_views, and any type with a hash() member function
+/// returning an integer. To hash other types, either give them a hash()
+/// member function or pass a different hasher to the container.
+struct hasher_t
+{
+    template <typename T>
+        requires(stdc::is_integral_v<T> || stdc::is_enum_v<T> ||
+                 stdc::is_pointer_v<T>)
+    [[nodiscard]] constexpr uint64_t operator()(const T& value) const noexcept
+    {
+        if constexpr (stdc::is_pointer_v<T>) {
+            return hash_integer(uint64_t(uintptr_t(value)));
+        } else {
+            return hash_integer(uint64_t(value));
+        }
+    }
+
+    [[nodiscard]] uint64_t operator()(const ascii_view& view) const noexcept
+    {
+        return hash_bytes(view.data(), view.size());
+    }
+
+    /// String literals hash the same as the equivalent ascii_view, so they can
+    /// be used to look up ascii_view keys.
+    template <size_t N>
+    [[nodiscard]] uint64_t operator()(const char (&literal)[N]) const noexcept
+    {
+        return (*this)(ascii_view(literal));
+    }
+
+    template <typename T>
+        requires requires(const T& value) {
+            { value.hash() } -> stdc::convertible_to_c<uint64_t>;
+        }
+    [[nodiscard]] constexpr uint64_t operator()(const T& value) const noexcept
+    {
+        return hash_integer(uint64_t(value.hash()));
+    }
+};
+
+/// Whether a hash table with key_t keys can be searched with a lookup_t: the
+/// hasher gives the same hash for both of them, and they compare with ==.
+template <typename hasher_t, typename key_t, typename lookup_t>
+concept hash_lookup_c = requires(const hasher_t& hasher, const key_t& key,
+                                 const lookup_t& lookup) {
+    { hasher(lookup) } -> stdc::convertible_to_c<uint64_t>;
+    { key == lookup } -> stdc::convertible_to_c<bool>;
+};
+} // namespace ok
+
+#endif
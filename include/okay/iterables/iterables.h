@@ -1583,49 +1583,49 @@ struct get_t<viewed_t, index>
 
 } // namespace adaptor
 
+// the constraints below name T&& instead of decltype(iterable), which is the
+// same type. gcc 12 crashes (internal compiler error in its satisfaction
+// cache) on constraints of a generic lambda which name its parameters.
 inline constexpr auto zip = []<typename T, typename T2, typename... extras_t>(
                                 T&& first, T2&& second, extras_t&&... extras)
-    requires detail::zip_constraints_c<decltype(first), decltype(second),
-                                       decltype(extras)...>
+    requires detail::zip_constraints_c<T&&, T2&&, extras_t&&...>
 {
     return ok::iter(stdc::forward<T>(first))
         .zip(stdc::forward<T2>(second), stdc::forward<extras_t>(extras)...);
 };
 
 inline constexpr auto enumerate = []<typename T>(T&& iterable)
-    requires iterable_c<decltype(iterable)>
+    requires iterable_c<T&&>
 { return ok::iter(stdc::forward<T>(iterable)).enumerate(); };
 
 inline constexpr auto transform =
     []<typename T, typename callable_t>(T&& iterable,
                                         const callable_t& transformer)
-    requires(iterable_c<decltype(iterable)> &&
-             detail::invocable_c<const callable_t,
-                                 value_type_for<decltype(iterable)>>)
+    requires(iterable_c<T&&> &&
+             detail::invocable_c<const callable_t, value_type_for<T&&>>)
 { return ok::iter(stdc::forward<T>(iterable)).transform(transformer); };
 
 inline constexpr auto reverse = []<typename T>(T&& iterable)
-    requires arraylike_iterable_c<decltype(iterable)>
+    requires arraylike_iterable_c<T&&>
 { return ok::iter(stdc::forward<T>(iterable)).reverse(); };
 
 inline constexpr auto flatten = []<typename T>(T&& iterable)
-    requires iterable_c<decltype(iterable)>
+    requires iterable_c<T&&>
 { return ok::iter(stdc::forward<T>(iterable)).flatten(); };
 
 inline constexpr auto drop = []<typename T>(T&& iterable, size_t num_to_drop)
-    requires iterable_c<decltype(iterable)>
+    requires iterable_c<T&&>
 { return ok::iter(stdc::forward<T>(iterable)).drop(num_to_drop); };
 
 inline constexpr auto take_at_most =
     []<typename T>(T&& iterable, size_t max_num_to_take)
-    requires iterable_c<decltype(iterable)>
+    requires iterable_c<T&&>
 { return ok::iter(stdc::forward<T>(iterable)).take_at_most(max_num_to_take); };
 
 inline constexpr auto keep_if = []<typename T, typename predicate_t>(
                                     T&& iterable, const predicate_t& predicate)
-    requires iterable_c<decltype(iterable)> &&
-             adaptor::keep_if_predicate_c<predicate_t,
-                                          iterator_for<decltype(iterable)>>
+    requires iterable_c<T&&> &&
+             adaptor::keep_if_predicate_c<predicate_t, iterator_for<T&&>>
 { return ok::iter(stdc::forward<T>(iterable)).keep_if(predicate); };
 
 namespace detail {
@@ -0,0 +1,146 @@
+#ifndef __OKAYLIB_MATH_FAST_DIVISOR_H__
+#define __OKAYLIB_MATH_FAST_DIVISOR_H__
+
+#include "okay/detail/ok_assert.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace ok {
+
+/// A divisor which is only known at runtime, but which is going to be divided
+/// by many times. The expensive part (finding a reciprocal) is done once, in
+/// the constructor, and then each division is a multiply and a shift. Powers of
+/// two are detected and become just a shift.
+///
+/// This is the unsigned 64-bit algorithm from libdivide.
+class fast_divisor_t
+{
+  public:
+    fast_divisor_t() = delete;
+
+    constexpr explicit fast_divisor_t(uint64_t divisor) OKAYLIB_NOEXCEPT
+        : m_divisor(divisor)
+    {
+        __ok_assert(divisor != 0, "Attempt to create fast_divisor_t of zero.");
+
+        const uint8_t floor_log2 = 63 - uint8_t(__builtin_clzll(divisor));
+        m_shift = floor_log2;
+
+        if ((divisor & (divisor - 1)) == 0)
+            return;
+
+#if defined(__SIZEOF_INT128__)
+        // 2^(64 + floor_log2) / divisor. the quotient fits in 64 bits because
+        // divisor > 2^floor_log2
+        const unsigned __int128 numerator = (unsigned __int128)1
+                                            << (64 + floor_log2);
+        uint64_t proposed_magic = uint64_t(numerator / divisor);
+        const uint64_t remainder = uint64_t(numerator % divisor);
+
+        // if divisor - remainder < 2^floor_log2, the magic number is accurate
+        // enough as-is. otherwise it needs one more bit of precision than
+        // fits, so it ends up being 65 bits and the divide has to do an add
+        if (divisor - remainder >= (uint64_t(1) << floor_log2)) {
+            proposed_magic += proposed_magic;
+            const uint64_t twice_remainder = remainder + remainder;
+            if (twice_remainder >= divisor || twice_remainder < remainder)
+                proposed_magic += 1;
+            m_needs_add = true;
+        }
+        m_magic = proposed_magic + 1;
+#else
+        // no 128 bit multiply, just do regular division
+        m_needs_slow_path = true;
+#endif
+    }
+
+    [[nodiscard]] constexpr uint64_t divisor() const noexcept
+    {
+        return m_divisor;
+    }
+
+    [[nodiscard]] constexpr bool is_power_of_two() const noexcept
+    {
+        return m_magic == 0 && !m_needs_slow_path;
+    }
+
+    [[nodiscard]] constexpr uint64_t divide(uint64_t numerator) const noexcept
+    {
+#if defined(__SIZEOF_INT128__)
+        if (m_magic == 0)
+            return numerator >> m_shift;
+
+        const uint64_t high =
+            uint64_t(((unsigned __int128)m_magic * numerator) >> 64);
+        if (m_needs_add)
+            return (((numerator - high) >> 1) + high) >> m_shift;
+        return high >> m_shift;
+#else
+        if (m_needs_slow_path)
+            return numerator / m_divisor;
+        return numerator >> m_shift;
+#endif
+    }
+
+    /// Equivalent to (numerator / divisor) * divisor
+    [[nodiscard]] constexpr uint64_t
+    round_down_to_multiple(uint64_t numerator) const noexcept
+    {
+        if (is_power_of_two())
+            return numerator & ~(m_divisor - 1);
+        return divide(numerator) * m_divisor;
+    }
+
+  private:
+    uint64_t m_divisor;
+    // zero if the divisor is a power of two
+    uint64_t m_magic = 0;
+    uint8_t m_shift = 0;
+    bool m_needs_add = false;
+    bool m_needs_slow_path = false;
+};
+
+/// Same interface as fast_divisor_t, but for a divisor which is known at
+/// compile time, in which case the compiler already knows how to avoid the
+/// division.
+template <uint64_t compile_time_divisor> class static_divisor_t
+{
+  public:
+    static_assert(compile_time_divisor != 0,
+                  "Attempt to create static_divisor_t of zero.");
+
+    constexpr static_divisor_t() = default;
+
+    // only here for symmetry with fast_divisor_t
+    constexpr explicit static_divisor_t(uint64_t divisor) OKAYLIB_NOEXCEPT
+    {
+        __ok_assert(divisor == compile_time_divisor,
+                    "Attempt to create static_divisor_t with a runtime divisor "
+                    "which does not match the compile time one.");
+    }
+
+    [[nodiscard]] constexpr uint64_t divisor() const noexcept
+    {
+        return compile_time_divisor;
+    }
+
+    [[nodiscard]] constexpr bool is_power_of_two() const noexcept
+    {
+        return (compile_time_divisor & (compile_time_divisor - 1)) == 0;
+    }
+
+    [[nodiscard]] constexpr uint64_t divide(uint64_t numerator) const noexcept
+    {
+        return numerator / compile_time_divisor;
+    }
+
+    [[nodiscard]] constexpr uint64_t
+    round_down_to_multiple(uint64_t numerator) const noexcept
+    {
+        return (numerator / compile_time_divisor) * compile_time_divisor;
+    }
+};
+
+} // namespace ok
+
+#endif
@@ -33,15 +33,17 @@ template <typename T>
 [[nodiscard]] constexpr T log2_uint(T number) OKAYLIB_NOEXCEPT
 {
     __ok_assert(number != 0, "Attempt to call log2_uint with zero.");
-    // TODO: do this and detect x86 and ARM. ARM has clz instruction
-    // uint32_t y;
-    // asm("\tbsr %1, %0\n" : "=r"(y) : "r"(x));
-    // return y;
-
+#if defined(__GNUC__) || defined(__clang__)
+    // one bsr / lzcnt / clz instruction
+    static_assert(sizeof(T) <= sizeof(unsigned long long));
+    return T(sizeof(unsigned long long) * 8 - 1 -
+             __builtin_clzll((unsigned long long)number));
+#else
     T targetlevel = 0;
     while (number >>= 1)
         ++targetlevel;
     return targetlevel;
+#endif
 }
 
 template <typename T>
@@ -54,6 +56,53 @@ template <typename T>
     return log2 + 1;
 }
 
+template <typename T>
+    requires stdc::is_unsigned_v<T>
+[[nodiscard]] constexpr T count_trailing_zeros(T number) OKAYLIB_NOEXCEPT
+{
+    __ok_assert(number != 0, "Attempt to call count_trailing_zeros with zero.");
+#if defined(__GNUC__) || defined(__clang__)
+    static_assert(sizeof(T) <= sizeof(unsigned long long));
+    return T(__builtin_ctzll((unsigned long long)number));
+#else
+    T count = 0;
+    while (!(number & 1)) {
+        number >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/// The number of bits which are set.
+template <typename T>
+    requires stdc::is_unsigned_v<T>
+[[nodiscard]] constexpr T popcount(T number) OKAYLIB_NOEXCEPT
+{
+    static_assert(sizeof(T) <= sizeof(uint64_t));
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__POPCNT__) || !(defined(__x86_64__) || defined(__i386__)))
+    return T(__builtin_popcountll((unsigned long long)number));
+#else
+    // x86 without the popcnt instruction gets a call into libgcc for the
+    // builtin, which is slower than counting all the bits in parallel
+    uint64_t bits = number;
+    bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+    bits = (bits & 0x3333333333333333ULL) +
+           ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return T((bits * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static_assert(popcount(0U) == 0);
+static_assert(popcount(0b1011U) == 3);
+static_assert(popcount(~uint64_t(0)) == 64);
+
+static_assert(count_trailing_zeros(1U) == 0);
+static_assert(count_trailing_zeros(12U) == 2);
+static_assert(count_trailing_zeros(uint64_t(1) << 63) == 63);
+
 static_assert(log2_uint(1U) == 0); // power of zero gives 1
 static_assert(log2_uint(3U) == 1); // power of 1 gives 2
 static_assert(log2_uint_ceil(3U) == 2);
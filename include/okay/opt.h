@@ -10,6 +10,7 @@
 #include "okay/detail/template_util/uninitialized_storage.h"
 #include "okay/detail/traits/cloneable.h"
 #include "okay/detail/traits/mathop_traits.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
 #include "okay/detail/traits/special_member_traits.h"
 #include <cstring> // memcpy
 
@@ -875,6 +876,11 @@ template <stdc::is_lvalue_reference_c payload_t> class opt<payload_t>
 #endif
 };
 
+template <typename payload_t>
+struct is_trivially_relocatable<opt<payload_t>>
+    : stdc::bool_constant<is_trivially_relocatable_v<payload_t>>
+{};
+
 } // namespace ok
 
 #if defined(OKAYLIB_USE_FMT)
@@ -238,6 +238,24 @@ template <atomic_c T> class atomic_t<T>
 
     // TODO: add sync operations, wait and notify_all etc
 };
+
+/// Orders the atomic operations around it, like std::atomic_thread_fence.
+inline void atomic_thread_fence(memory_order order) noexcept
+{
+    detail::atomic_thread_fence(order);
+}
+
+/// Call in the body of a loop which spins waiting on another thread. Lets the
+/// CPU back off for a moment, which saves power and gives the core to its
+/// hyperthread sibling, if it has one.
+inline void spin_loop_pause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && __ARM_ARCH >= 7)
+    __asm__ __volatile__("yield");
+#endif
+}
 } // namespace ok
 
 #endif
@@ -0,0 +1,211 @@
+#ifndef __OKAYLIB_PLATFORM_NUMA_H__
+#define __OKAYLIB_PLATFORM_NUMA_H__
+#include "okay/detail/abort.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// NUMA memory placement, done with raw syscalls so there is no dependency on
+/// libnuma. Everything here is a no-op on machines with only one NUMA node, and
+/// on platforms other than linux.
+namespace ok::numa {
+
+enum class policy_t : uint8_t
+{
+    // do not touch the placement policy, memory goes wherever it is first
+    // touched (or wherever the thread's policy says)
+    system_default,
+    // allocate on the node of the CPU that first touches the memory
+    local,
+    // only allocate on the nodes in the node mask
+    bind,
+    // spread pages round-robin across the nodes in the node mask
+    interleave,
+    // prefer the first node in the node mask, fall back to others
+    preferred,
+};
+
+struct placement_t
+{
+    policy_t policy = policy_t::system_default;
+    // bit N set means node N. only the first 64 nodes are supported.
+    uint64_t node_mask = 0;
+
+    [[nodiscard]] static constexpr placement_t local() noexcept
+    {
+        return {.policy = policy_t::local};
+    }
+
+    [[nodiscard]] static constexpr placement_t bind_to(uint32_t node) noexcept
+    {
+        return {.policy = policy_t::bind, .node_mask = mask_of(node)};
+    }
+
+    [[nodiscard]] static constexpr placement_t prefer(uint32_t node) noexcept
+    {
+        return {.policy = policy_t::preferred, .node_mask = mask_of(node)};
+    }
+
+    [[nodiscard]] static constexpr placement_t
+    interleave_across(uint64_t node_mask) noexcept
+    {
+        return {.policy = policy_t::interleave, .node_mask = node_mask};
+    }
+
+  private:
+    [[nodiscard]] static constexpr uint64_t mask_of(uint32_t node) noexcept
+    {
+        if (node >= 64) [[unlikely]] {
+            __ok_abort("NUMA node index past 63 given to placement_t, only "
+                       "the first 64 nodes are supported.");
+        }
+        return uint64_t(1) << node;
+    }
+};
+
+namespace detail {
+#if defined(__linux__)
+// values of MPOL_* from linux/mempolicy.h
+inline constexpr int mpol_preferred = 1;
+inline constexpr int mpol_bind = 2;
+inline constexpr int mpol_interleave = 3;
+inline constexpr int mpol_local = 4;
+
+inline int to_linux_mode(policy_t policy) noexcept
+{
+    switch (policy) {
+    case policy_t::local:
+        return mpol_local;
+    case policy_t::bind:
+        return mpol_bind;
+    case policy_t::interleave:
+        return mpol_interleave;
+    case policy_t::preferred:
+        return mpol_preferred;
+    case policy_t::system_default:
+        break;
+    }
+    return 0;
+}
+
+/// Parse the "0-3,5" style list in /sys/devices/system/node/online
+inline size_t read_online_node_count() noexcept
+{
+    FILE* file = ::fopen("/sys/devices/system/node/online", "r");
+    if (!file)
+        return 1;
+
+    size_t count = 0;
+    unsigned first = 0;
+    unsigned last = 0;
+    while (::fscanf(file, "%u", &first) == 1) {
+        last = first;
+        int separator = ::fgetc(file);
+        if (separator == '-') {
+            if (::fscanf(file, "%u", &last) != 1)
+                break;
+            separator = ::fgetc(file);
+        }
+        count += last - first + 1;
+        if (separator != ',')
+            break;
+    }
+    ::fclose(file);
+    return count == 0 ? 1 : count;
+}
+
+/// Errors which mean that placement is not available here (kernel built
+/// without NUMA, or a sandbox that forbids the syscall), as opposed to being
+/// a mistake by the caller.
+inline bool is_unsupported_errno(int err) noexcept
+{
+    return err == ENOSYS || err == EPERM;
+}
+#endif
+} // namespace detail
+
+/// The number of NUMA nodes which are online. Always at least 1.
+inline size_t node_count() noexcept
+{
+#if defined(__linux__)
+    static const size_t count = detail::read_online_node_count();
+    return count;
+#else
+    return 1;
+#endif
+}
+
+/// The NUMA node of the CPU the calling thread is currently running on. The
+/// thread may be migrated at any point, so this is only a hint.
+inline uint32_t current_node() noexcept
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+        return 0;
+    return node;
+#else
+    return 0;
+#endif
+}
+
+/// Set the placement policy for a range of pages, with mbind(). Must be done
+/// before the pages are first touched to have any effect. Returns 0 on success,
+/// otherwise an errno.
+inline int64_t apply_placement(void* address, size_t bytes,
+                               const placement_t& placement) noexcept
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    if (placement.policy == policy_t::system_default || node_count() <= 1)
+        return 0;
+
+    const bool uses_mask = placement.policy != policy_t::local;
+    const long result = ::syscall(
+        SYS_mbind, address, bytes, detail::to_linux_mode(placement.policy),
+        uses_mask ? &placement.node_mask : nullptr,
+        uses_mask ? sizeof(placement.node_mask) * 8 + 1 : 0, 0);
+    if (result != 0) {
+        const int err = errno;
+        return detail::is_unsupported_errno(err) ? 0 : err;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+/// Set the default placement policy for all future allocations made by the
+/// calling thread, with set_mempolicy(). Returns 0 on success, otherwise an
+/// errno.
+inline int64_t set_thread_placement(const placement_t& placement) noexcept
+{
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+    if (node_count() <= 1)
+        return 0;
+
+    const bool uses_mask = placement.policy != policy_t::local &&
+                           placement.policy != policy_t::system_default;
+    // MPOL_DEFAULT is zero, which is what to_linux_mode gives system_default
+    const long result = ::syscall(
+        SYS_set_mempolicy, detail::to_linux_mode(placement.policy),
+        uses_mask ? &placement.node_mask : nullptr,
+        uses_mask ? sizeof(placement.node_mask) * 8 + 1 : 0);
+    if (result != 0) {
+        const int err = errno;
+        return detail::is_unsupported_errno(err) ? 0 : err;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+} // namespace ok::numa
+#endif
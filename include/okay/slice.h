@@ -6,8 +6,10 @@
 #include "okay/detail/noexcept.h"
 #include "okay/detail/template_util/uninitialized_storage.h"
 #include "okay/detail/traits/is_instance.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
 #include "okay/detail/traits/is_std_container.h"
 #include "okay/iterables/iterables.h"
+#include "okay/math/math.h"
 #include "okay/math/rounding.h"
 #include <assert.h>
 #include <stdint.h>
@@ -311,6 +313,12 @@ struct null_bit_slice_tag
 {};
 inline static uint8_t dummy_byte = 0;
 inline static uint8_t* const dummy_byte_ptr = &dummy_byte;
+
+/// If the bit slice starts inside of bytes, the index of its first bit counted
+/// from the start of bytes. Otherwise -1. For containers which need to know
+/// whether a bit slice points into their own storage.
+constexpr size_t bit_slice_start_within(const const_bit_slice_t& bits,
+                                        slice<const uint8_t> bytes) noexcept;
 } // namespace detail
 
 class bit
@@ -408,6 +416,10 @@ class const_bit_slice_t
     ok::raw_bit_slice(slice<const uint8_t> bytes, size_t num_bits,
                       uint8_t offset) OKAYLIB_NOEXCEPT;
 
+    friend constexpr size_t
+    detail::bit_slice_start_within(const const_bit_slice_t& bits,
+                                   slice<const uint8_t> bytes) noexcept;
+
     const_bit_slice_t() = delete;
 
     [[nodiscard]] constexpr size_t size() const OKAYLIB_NOEXCEPT
@@ -428,7 +440,7 @@ class const_bit_slice_t
     /// Returns the number of bytes pointed at by this contiguous slice of bits
     [[nodiscard]] constexpr size_t num_bytes_occupied() const OKAYLIB_NOEXCEPT
     {
-        return round_up_to_multiple_of<8>(m.num_bits + m.offset);
+        return round_up_to_multiple_of<8>(m.num_bits + m.offset) / 8;
     }
 
     [[nodiscard]] constexpr bit get_bit(const size_t idx) const OKAYLIB_NOEXCEPT
@@ -446,16 +458,100 @@ class const_bit_slice_t
     [[nodiscard]] constexpr const_bit_slice_t
     subslice(const subslice_options_t& options) const OKAYLIB_NOEXCEPT
     {
-        if (options.start + options.length >= this->size()) {
+        if (options.start + options.length > this->size()) {
             __ok_abort("Out of bounds access in const_bit_slice_t::subslice");
         }
 
-        const size_t first_byte_index = m.offset + options.start;
-        const uint8_t new_offset = first_byte_index % 8UL;
-        return const_bit_slice_t(m.first_byte + first_byte_index,
+        const size_t first_bit_index = m.offset + options.start;
+        const uint8_t new_offset = first_bit_index % 8UL;
+        return const_bit_slice_t(m.first_byte + first_bit_index / 8UL,
                                  options.length, new_offset);
     }
 
+    /// Read the 64 bits starting at idx into a word, with bit idx in the least
+    /// significant position. Bits past the end of the slice are zero.
+    [[nodiscard]] constexpr uint64_t
+    get_word(size_t idx) const OKAYLIB_NOEXCEPT
+    {
+        if (idx >= this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access to const_bit_slice_t::get_word.");
+        }
+        const size_t first_bit = idx + m.offset;
+        const size_t shift = first_bit % 8;
+        const uint8_t* const bytes = m.first_byte + first_bit / 8;
+        const size_t bytes_left = this->num_bytes_occupied() - first_bit / 8;
+
+        // 64 bits starting partway into a byte can touch nine bytes. written
+        // out so that the whole word case compiles down to one load
+        uint64_t low = 0;
+        uint64_t high = 0;
+        if (bytes_left >= 8) {
+            low = uint64_t(bytes[0]) | (uint64_t(bytes[1]) << 8) |
+                  (uint64_t(bytes[2]) << 16) | (uint64_t(bytes[3]) << 24) |
+                  (uint64_t(bytes[4]) << 32) | (uint64_t(bytes[5]) << 40) |
+                  (uint64_t(bytes[6]) << 48) | (uint64_t(bytes[7]) << 56);
+            if (bytes_left > 8)
+                high = bytes[8];
+        } else {
+            for (size_t i = 0; i < bytes_left; ++i)
+                low |= uint64_t(bytes[i]) << (i * 8);
+        }
+
+        uint64_t word = low >> shift;
+        if (shift != 0)
+            word |= high << (64 - shift);
+        const size_t num_valid_bits = this->size() - idx;
+        if (num_valid_bits < 64)
+            word &= (uint64_t(1) << num_valid_bits) - 1;
+        return word;
+    }
+
+    /// The number of bits which are on.
+    [[nodiscard]] constexpr size_t popcount() const OKAYLIB_NOEXCEPT
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < this->size(); i += 64)
+            count += ok::popcount(this->get_word(i));
+        return count;
+    }
+
+    /// The index of the first bit at or after from which is on, if any.
+    [[nodiscard]] constexpr opt<size_t>
+    find_first_set(size_t from = 0) const OKAYLIB_NOEXCEPT
+    {
+        if (from > this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access in "
+                       "const_bit_slice_t::find_first_set.");
+        }
+        for (size_t i = from; i < this->size(); i += 64) {
+            const uint64_t word = this->get_word(i);
+            if (word != 0)
+                return i + ok::count_trailing_zeros(word);
+        }
+        return nullopt;
+    }
+
+    /// The index of the first bit at or after from which is off, if any.
+    [[nodiscard]] constexpr opt<size_t>
+    find_first_unset(size_t from = 0) const OKAYLIB_NOEXCEPT
+    {
+        if (from > this->size()) [[unlikely]] {
+            __ok_abort("Out of bounds access in "
+                       "const_bit_slice_t::find_first_unset.");
+        }
+        for (size_t i = from; i < this->size(); i += 64) {
+            uint64_t word = ~this->get_word(i);
+            // the bits past the end read as zero, don't report them
+            if (const size_t num_valid_bits = this->size() - i;
+                num_valid_bits < 64) {
+                word &= (uint64_t(1) << num_valid_bits) - 1;
+            }
+            if (word != 0)
+                return i + ok::count_trailing_zeros(word);
+        }
+        return nullopt;
+    }
+
     struct cursor_t
     {
       private:
@@ -494,6 +590,43 @@ class const_bit_slice_t
         return ok::owning_arraylike_iterator_t<const_bit_slice_t, cursor_t>{
             const_bit_slice_t(*this), cursor_t{}};
     }
+
+    struct set_bits_cursor_t
+    {
+        using value_type = size_t;
+
+        // index of the bit at the start of word
+        size_t word_start;
+        // the bits of the current word which have not been visited yet
+        uint64_t word;
+
+        constexpr opt<size_t>
+        next(const const_bit_slice_t& iterable) OKAYLIB_NOEXCEPT
+        {
+            while (word == 0) {
+                word_start += 64;
+                if (word_start >= iterable.size())
+                    return nullopt;
+                word = iterable.get_word(word_start);
+            }
+            const size_t out = word_start + ok::count_trailing_zeros(word);
+            // clear the lowest bit which is on
+            word &= word - 1;
+            return out;
+        }
+    };
+
+    /// Iterate over the indices of the bits which are on, in increasing order.
+    /// Skips over a whole word of bits which are off at a time.
+    [[nodiscard]] constexpr auto iter_set_bits() const
+    {
+        return ok::owning_iterator_t<const_bit_slice_t, set_bits_cursor_t>{
+            const_bit_slice_t(*this),
+            set_bits_cursor_t{
+                .word_start = 0,
+                .word = this->is_empty() ? 0 : this->get_word(0),
+            }};
+    }
 };
 
 namespace detail {
@@ -556,14 +689,14 @@ class bit_slice_t : public const_bit_slice_t
     [[nodiscard]] constexpr bit_slice_t
     subslice(const subslice_options_t& options) const OKAYLIB_NOEXCEPT
     {
-        if (options.start + options.length >= this->size()) {
+        if (options.start + options.length > this->size()) {
             __ok_abort("Out of bounds access in bit_slice_t::subslice");
         }
 
-        const size_t first_byte_index = m.offset + options.start;
-        const uint8_t new_offset = first_byte_index % 8UL;
-        return bit_slice_t(m.first_byte + first_byte_index, options.length,
-                           new_offset);
+        const size_t first_bit_index = m.offset + options.start;
+        const uint8_t new_offset = first_bit_index % 8UL;
+        return bit_slice_t(m.first_byte + first_bit_index / 8UL,
+                           options.length, new_offset);
     }
 
     struct write_cursor_t
@@ -669,6 +802,18 @@ constexpr const_bit_slice_t raw_bit_slice(slice<const uint8_t> bytes,
         offset);
 }
 
+constexpr size_t
+detail::bit_slice_start_within(const const_bit_slice_t& bits,
+                               slice<const uint8_t> bytes) noexcept
+{
+    if (bytes.is_empty())
+        return size_t(-1);
+    const uint8_t* const start = bytes.unchecked_address_of_first_item();
+    if (bits.m.first_byte < start || bits.m.first_byte >= start + bytes.size())
+        return size_t(-1);
+    return size_t(bits.m.first_byte - start) * 8 + bits.m.offset;
+}
+
 /// Pointer to an array of items of type viewed_t, which are not initialized.
 /// Not much can be done with this type besides decide how to initialize the
 /// memory.
@@ -804,6 +949,15 @@ template <typename T>
 {
     return raw_slice(item, 1);
 }
+
+template <typename viewed_t>
+struct is_trivially_relocatable<slice<viewed_t>> : stdc::true_type
+{};
+template <> struct is_trivially_relocatable<bit_slice_t> : stdc::true_type
+{};
+template <>
+struct is_trivially_relocatable<const_bit_slice_t> : stdc::true_type
+{};
 } // namespace ok
 
 #if defined(OKAYLIB_USE_FMT)
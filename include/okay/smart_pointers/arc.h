@@ -3,6 +3,7 @@
 
 #include "okay/allocators/allocator.h"
 #include "okay/detail/ok_unreachable.h"
+#include "okay/detail/traits/is_trivially_relocatable.h"
 #include "okay/error.h"
 #include "okay/opt.h"
 #include <atomic>
@@ -812,6 +813,24 @@ into_arc(T&& item, allocator_impl_t& allocator) OKAYLIB_NOEXCEPT
     return out;
 }
 
+// arcs are just a pointer to their payload, which never moves
+template <typename T, typename allocator_impl_t>
+struct is_trivially_relocatable<unique_rw_arc_t<T, allocator_impl_t>>
+    : stdc::true_type
+{};
+template <typename T, typename allocator_impl_t>
+struct is_trivially_relocatable<ro_arc_t<T, allocator_impl_t>>
+    : stdc::true_type
+{};
+template <typename T, typename allocator_impl_t>
+struct is_trivially_relocatable<weak_arc_t<T, allocator_impl_t>>
+    : stdc::true_type
+{};
+template <typename T, typename allocator_impl_t>
+struct is_trivially_relocatable<variant_arc_t<T, allocator_impl_t>>
+    : stdc::true_type
+{};
+
 } // namespace ok
 
 #endif
@@ -6,6 +6,7 @@
 #include "okay/containers/array.h"
 #include "okay/containers/arraylist.h"
 #include "okay/iterables/indices.h"
+#include "testing_types.h"
 
 using namespace ok;
 
@@ -599,6 +600,119 @@ TEST_SUITE("arraylist")
         }
     }
 
+    TEST_CASE("growth policies")
+    {
+        const auto capacities_while_appending = [](auto&& alist) {
+            maybe_undefined_array_t<size_t, 4> capacities = {};
+            size_t count = 0;
+            size_t last_capacity = 0;
+            for (size_t i = 0; count < capacities.size(); ++i) {
+                alist.append(i).or_panic();
+                if (alist.capacity() != last_capacity) {
+                    last_capacity = alist.capacity();
+                    capacities[count++] = last_capacity;
+                }
+            }
+            return capacities;
+        };
+
+        SUBCASE("2x by default")
+        {
+            c_allocator_t backing;
+            REQUIRE_RANGES_EQUAL(
+                capacities_while_appending(arraylist::empty<size_t>(backing)),
+                (maybe_undefined_array_t<size_t, 4>{4, 8, 16, 32}));
+        }
+
+        SUBCASE("1.5x")
+        {
+            c_allocator_t backing;
+            REQUIRE_RANGES_EQUAL(
+                capacities_while_appending(
+                    arraylist::empty<size_t,
+                                     arraylist::growth::one_and_a_half_t>(
+                        backing)),
+                (maybe_undefined_array_t<size_t, 4>{4, 6, 9, 13}));
+        }
+
+        SUBCASE("exponential then linear")
+        {
+            c_allocator_t backing;
+            using policy_t =
+                arraylist::growth::exponential_then_linear_t<64, 32>;
+            REQUIRE_RANGES_EQUAL(
+                capacities_while_appending(
+                    arraylist::empty<size_t, policy_t>(backing)),
+                (maybe_undefined_array_t<size_t, 4>{4, 8, 12, 16}));
+        }
+
+        SUBCASE("first allocation goes through the policy")
+        {
+            struct at_least_a_cacheline_t
+            {
+                static constexpr size_t
+                preferred_capacity_bytes(size_t current_bytes,
+                                         size_t required_bytes) noexcept
+                {
+                    return ok::max(arraylist::growth::doubling_t::
+                                       preferred_capacity_bytes(
+                                           current_bytes, required_bytes),
+                                   size_t(64));
+                }
+            };
+
+            c_allocator_t backing;
+            REQUIRE_RANGES_EQUAL(
+                capacities_while_appending(
+                    arraylist::empty<size_t, at_least_a_cacheline_t>(backing)),
+                (maybe_undefined_array_t<size_t, 4>{8, 16, 32, 64}));
+        }
+
+        SUBCASE("page rounded")
+        {
+            using policy_t = arraylist::growth::page_rounded_t<>;
+            static_assert(policy_t::preferred_capacity_bytes(64, 72) == 128);
+            static_assert(policy_t::preferred_capacity_bytes(4000, 4008) ==
+                          8192);
+            static_assert(policy_t::preferred_capacity_bytes(8192, 9000) ==
+                          16384);
+
+            c_allocator_t backing;
+            arraylist_t alist = arraylist::empty<uint8_t, policy_t>(backing);
+            for (size_t i = 0; i < 5000; ++i)
+                alist.append(uint8_t(i)).or_panic();
+            REQUIRE(alist.capacity() == 8192);
+        }
+
+        SUBCASE("reserve_exact")
+        {
+            c_allocator_t backing;
+            arraylist_t alist = arraylist::empty<int>(backing);
+            REQUIRE(alist.reserve_exact(10).is_success());
+            REQUIRE(alist.capacity() == 10);
+            // already enough space
+            REQUIRE(alist.reserve_exact(5).is_success());
+            REQUIRE(alist.capacity() == 10);
+
+            for (int i = 0; i < 10; ++i)
+                alist.append(i).or_panic();
+            REQUIRE(alist.reserve_exact(11).is_success());
+            REQUIRE(alist.capacity() == 11);
+            REQUIRE_RANGES_EQUAL(alist, indices().take_at_most(10));
+        }
+
+        SUBCASE("capacity comes from what the allocator returned")
+        {
+            // hands out whole pages, so there's extra space after every
+            // allocation
+            reserving_page_allocator_t backing({.pages_reserved = 100});
+            arraylist_t alist = arraylist::empty<int>(backing);
+            alist.append(0).or_panic();
+            REQUIRE(alist.capacity() * sizeof(int) ==
+                    mmap::get_page_size());
+        }
+    }
+
     TEST_CASE("clear()")
     {
         SUBCASE("clearing decreases size to zero")
@@ -1024,6 +1138,81 @@ TEST_SUITE("arraylist")
         }
     }
 
+    TEST_CASE("append_assume_capacity()")
+    {
+        c_allocator_t backing;
+        auto alist = arraylist::empty<int>(backing);
+        REQUIRE(alist.increase_capacity_by_at_least(10).is_success());
+        const size_t capacity = alist.capacity();
+
+        for (int i = 0; i < 10; ++i) {
+            int& appended = alist.append_assume_capacity(i);
+            REQUIRE(appended == i);
+        }
+        REQUIRE(alist.capacity() == capacity);
+        REQUIRE_RANGES_EQUAL(alist, indices().take_at_most(10));
+    }
+
+    TEST_CASE("append_slice()")
+    {
+        SUBCASE("trivially copyable items")
+        {
+            c_allocator_t backing;
+            auto alist = arraylist::empty<int>(backing);
+            maybe_undefined_array_t first = {0, 1, 2, 3};
+            maybe_undefined_array_t second = {4, 5, 6, 7, 8};
+
+            REQUIRE(alist.append_slice(first.items()).is_success());
+            REQUIRE(alist.append_slice(second.items()).is_success());
+            REQUIRE(alist.append_slice(make_null_slice<const int>())
+                        .is_success());
+            REQUIRE_RANGES_EQUAL(alist, indices().take_at_most(9));
+        }
+
+        SUBCASE("appending own items across reallocation")
+        {
+            c_allocator_t backing;
+            auto alist = arraylist::empty<int>(backing);
+            maybe_undefined_array_t initial = {0, 1, 2, 3};
+            REQUIRE(alist.append_slice(initial.items()).is_success());
+            alist.shrink_to_reclaim_unused_memory();
+
+            REQUIRE(alist.append_slice(alist.items()).is_success());
+            REQUIRE_RANGES_EQUAL(
+                alist, (maybe_undefined_array_t{0, 1, 2, 3, 0, 1, 2, 3}));
+        }
+
+        SUBCASE("nontrivial items are copy constructed")
+        {
+            c_allocator_t backing;
+            auto source = arraylist::empty<counter_type>(backing);
+            REQUIRE(source.resize(5).is_success());
+            auto alist = arraylist::empty<counter_type>(backing);
+
+            counter_type::reset_counters();
+            REQUIRE(alist.append_slice(source.items()).is_success());
+            REQUIRE(alist.size() == 5);
+            REQUIRE(counter_type::counters.copy_constructs == 5);
+        }
+    }
+
+    TEST_CASE("resize_uninitialized()")
+    {
+        c_allocator_t backing;
+        auto alist = arraylist::empty<uint8_t>(backing);
+        REQUIRE(alist.resize_uninitialized(100).is_success());
+        REQUIRE(alist.size() == 100);
+        REQUIRE(alist.capacity() >= 100);
+
+        for (size_t i = 0; i < alist.size(); ++i)
+            alist[i] = uint8_t(i);
+
+        REQUIRE(alist.resize_uninitialized(10).is_success());
+        REQUIRE(alist.size() == 10);
+        REQUIRE(alist.capacity() >= 100);
+        REQUIRE_RANGES_EQUAL(alist, indices().take_at_most(10));
+    }
+
     TEST_CASE("increase_capacity_by()")
     {
         SUBCASE("reallocation")
@@ -0,0 +1,162 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/atomic_bit_array.h"
+#include <thread>
+#include <vector>
+
+using namespace ok;
+
+TEST_SUITE("atomic_bit_array_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("set, clear and test bits")
+    {
+        atomic_bit_array_t<100> bits;
+        REQUIRE(bits.size_bits() == 100);
+        REQUIRE(bits.size_words() == 2);
+        REQUIRE(bits.count() == 0);
+
+        REQUIRE(!bits.test_and_set(3));
+        REQUIRE(bits.test_and_set(3));
+        REQUIRE(!bits.test_and_set(99));
+        REQUIRE(bits.test(3));
+        REQUIRE(bits.test(99));
+        REQUIRE(!bits.test(4));
+        REQUIRE(bits.count() == 2);
+        REQUIRE(bits.load_word(1) == uint64_t(1) << 35);
+
+        REQUIRE(bits.test_and_clear(3));
+        REQUIRE(!bits.test_and_clear(3));
+        REQUIRE(!bits.test(3));
+        REQUIRE(bits.count() == 1);
+
+        bits.clear_all();
+        REQUIRE(bits.count() == 0);
+
+        REQUIREABORTS(bits.test_and_set(100));
+        REQUIREABORTS(auto b = bits.test(100));
+        REQUIREABORTS(auto w = bits.load_word(2));
+    }
+
+    TEST_CASE("word operations")
+    {
+        atomic_bit_array_t<70> bits;
+        REQUIRE(bits.fetch_or_word(0, 0b1010) == 0);
+        REQUIRE(bits.fetch_or_word(0, 0b0110) == 0b1010);
+        REQUIRE(bits.load_word(0) == 0b1110);
+        REQUIRE(bits.fetch_and_word(0, 0b0100) == 0b1110);
+        REQUIRE(bits.load_word(0) == 0b0100);
+
+        // bits past the end of the array stay off
+        bits.fetch_or_word(1, ~uint64_t(0));
+        REQUIRE(bits.load_word(1) == 0b111111);
+        REQUIRE(bits.count() == 7);
+        REQUIREABORTS(bits.fetch_or_word(2, 1));
+    }
+
+    TEST_CASE("find_and_claim_first_unset")
+    {
+        atomic_bit_array_t<130> bits;
+        REQUIRE(bits.find_and_claim_first_unset().ref_unchecked() == 0);
+        REQUIRE(bits.find_and_claim_first_unset().ref_unchecked() == 1);
+        REQUIRE(bits.find_and_claim_first_unset(70).ref_unchecked() == 70);
+        REQUIRE(bits.find_and_claim_first_unset(70).ref_unchecked() == 71);
+
+        // wraps around from the hint, including the start of its own word
+        bits.fetch_or_word(2, ~uint64_t(0));
+        bits.fetch_or_word(1, ~uint64_t(0) << 8);
+        bits.fetch_or_word(0, ~uint64_t(0));
+        REQUIRE(bits.find_and_claim_first_unset(129).ref_unchecked() == 64);
+        REQUIRE(bits.find_and_claim_first_unset(100).ref_unchecked() == 65);
+
+        while (bits.find_and_claim_first_unset())
+            ;
+        REQUIRE(bits.count() == 130);
+        REQUIRE(!bits.find_and_claim_first_unset(5));
+
+        bits.test_and_clear(77);
+        REQUIRE(bits.find_and_claim_first_unset(100).ref_unchecked() == 77);
+        REQUIREABORTS(auto slot = bits.find_and_claim_first_unset(130));
+    }
+
+    TEST_CASE("allocated atomic bit array")
+    {
+        auto bits = allocated_atomic_bit_array::zeroed(c_allocator, 1000)
+                        .unwrap();
+        REQUIRE(bits.size_bits() == 1000);
+        REQUIRE(bits.size_words() == 16);
+        REQUIRE(bits.count() == 0);
+        REQUIRE(!bits.test_and_set(999));
+        REQUIREABORTS(bits.test_and_set(1000));
+
+        auto moved = stdc::move(bits);
+        REQUIRE(bits.size_bits() == 0);
+        REQUIRE(moved.test(999));
+
+        auto empty =
+            allocated_atomic_bit_array::zeroed(c_allocator, 0).unwrap();
+        REQUIRE(empty.size_words() == 0);
+        REQUIRE(!empty.find_and_claim_first_unset());
+
+        uint8_t buffer[64];
+        arena_t arena(buffer);
+        REQUIRE(!allocated_atomic_bit_array::zeroed(arena, 4096).is_success());
+    }
+
+    TEST_CASE("threads claim every slot exactly once")
+    {
+        constexpr size_t num_threads = 8;
+        constexpr size_t num_slots = 20000;
+        auto slots =
+            allocated_atomic_bit_array::zeroed(c_allocator, num_slots).unwrap();
+
+        std::vector<std::vector<size_t>> claimed(num_threads);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                const size_t hint = t * num_slots / num_threads;
+                while (auto slot = slots.find_and_claim_first_unset(hint))
+                    claimed[t].push_back(slot.ref_unchecked());
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        std::vector<uint8_t> seen(num_slots, 0);
+        for (const auto& list : claimed)
+            for (size_t slot : list)
+                ++seen[slot];
+        for (size_t i = 0; i < num_slots; ++i)
+            REQUIRE(seen[i] == 1);
+        REQUIRE(slots.count() == num_slots);
+    }
+
+    TEST_CASE("concurrent test_and_set reports each bit once")
+    {
+        constexpr size_t num_threads = 8;
+        atomic_bit_array_t<5000> bits;
+        std::vector<size_t> firsts(num_threads, 0);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                // every thread walks every bit, starting somewhere different
+                for (size_t i = 0; i < bits.size_bits(); ++i) {
+                    const size_t idx = (i + t * 613) % bits.size_bits();
+                    if (!bits.test_and_set(idx, memory_order::acq_rel))
+                        ++firsts[t];
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        size_t total = 0;
+        for (size_t first : firsts)
+            total += first;
+        REQUIRE(total == bits.size_bits());
+        REQUIRE(bits.count() == bits.size_bits());
+    }
+}
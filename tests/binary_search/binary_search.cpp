@@ -0,0 +1,164 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/algorithm/binary_search.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/arraylist.h"
+#include "okay/containers/eytzinger_index.h"
+#include "testing_types.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+struct entry_t
+{
+    int key;
+    const char* name;
+};
+
+template <typename T> slice<const T> slice_of(const std::vector<T>& vector)
+{
+    return raw_slice(*vector.data(), vector.size());
+}
+} // namespace
+
+TEST_SUITE("binary search")
+{
+    TEST_CASE("lower_bound and upper_bound match std")
+    {
+        // lots of duplicates, and gaps between runs
+        for (size_t size = 1; size < 300; size += 7) {
+            std::vector<int> values;
+            for (size_t i = 0; i < size; ++i)
+                values.push_back(int(i / 3) * 2);
+
+            for (int needle = -2; needle < int(size); ++needle) {
+                const size_t expected_lower =
+                    std::lower_bound(values.begin(), values.end(), needle) -
+                    values.begin();
+                const size_t expected_upper =
+                    std::upper_bound(values.begin(), values.end(), needle) -
+                    values.begin();
+                REQUIRE(ok::lower_bound(slice_of(values), needle) ==
+                        expected_lower);
+                REQUIRE(ok::upper_bound(slice_of(values), needle) ==
+                        expected_upper);
+
+                const subslice_options_t range =
+                    ok::equal_range(slice_of(values), needle);
+                REQUIRE(range.start == expected_lower);
+                REQUIRE(range.length == expected_upper - expected_lower);
+            }
+        }
+    }
+
+    TEST_CASE("empty slice")
+    {
+        std::vector<int> values = {1};
+        const slice<const int> empty = slice_of(values).drop(1);
+        REQUIRE(ok::lower_bound(empty, 1) == 0);
+        REQUIRE(ok::upper_bound(empty, 1) == 0);
+        const subslice_options_t range = ok::equal_range(empty, 1);
+        REQUIRE(range.start == 0);
+        REQUIRE(range.length == 0);
+    }
+
+    TEST_CASE("search by key with a comparator")
+    {
+        const std::vector<entry_t> entries = {
+            {1, "one"}, {3, "three"}, {3, "also three"}, {8, "eight"}};
+        const auto by_key = [](const entry_t& entry, int key) {
+            return ok::cmp(entry.key, key);
+        };
+
+        REQUIRE(ok::lower_bound(slice_of(entries), 3, by_key) == 1);
+        REQUIRE(ok::upper_bound(slice_of(entries), 3, by_key) == 3);
+        REQUIRE(ok::lower_bound(slice_of(entries), 9, by_key) == 4);
+        const subslice_options_t threes =
+            ok::equal_range(slice_of(entries), 3, by_key);
+        REQUIRE(threes.start == 1);
+        REQUIRE(threes.length == 2);
+        REQUIRE(slice_of(entries).subslice(threes).last().name ==
+                entries[2].name);
+    }
+
+    TEST_CASE("works on arraylist items")
+    {
+        c_allocator_t c_allocator;
+        arraylist_t list = arraylist::empty<size_t>(c_allocator);
+        for (size_t i = 0; i < 1000; ++i)
+            REQUIRE(list.append(i * 10).is_success());
+        REQUIRE(ok::lower_bound(list.items(), 55UL) == 6);
+        REQUIRE(ok::upper_bound(list.items(), 60UL) == 7);
+    }
+
+    TEST_CASE("constexpr")
+    {
+        constexpr auto search = [] {
+            int values[] = {1, 2, 2, 2, 5, 9};
+            return ok::lower_bound(slice<const int>(values), 2) * 10 +
+                   ok::upper_bound(slice<const int>(values), 2);
+        };
+        static_assert(search() == 14);
+    }
+
+    // run with --no-skip to see timings
+    TEST_CASE("benchmark lookups by table size" * doctest::skip())
+    {
+        c_allocator_t c_allocator;
+        constexpr size_t num_lookups = 4000000;
+
+        for (size_t size : {size_t(1000), size_t(1000000), size_t(100000000)}) {
+            std::vector<uint32_t> table(size);
+            for (size_t i = 0; i < size; ++i)
+                table[i] = uint32_t(i * 3);
+
+            // a fixed pseudo-random sequence of needles, the same for every
+            // search so that they all do the same work
+            std::vector<uint32_t> needles(num_lookups);
+            uint64_t state = 0x9E3779B97F4A7C15ULL;
+            for (uint32_t& needle : needles) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                needle = uint32_t(state % (size * 3));
+            }
+
+            const auto time = [&](auto&& lookup) {
+                uint64_t checksum = 0;
+                const double ms = time_ms([&] {
+                    for (uint32_t needle : needles)
+                        checksum += lookup(needle);
+                });
+                return std::pair{ms * 1e6 / double(num_lookups), checksum};
+            };
+
+            const auto [std_ns, std_sum] = time([&](uint32_t needle) {
+                auto found =
+                    std::lower_bound(table.begin(), table.end(), needle);
+                return found == table.end() ? 0 : *found;
+            });
+            const auto [ok_ns, ok_sum] = time([&](uint32_t needle) {
+                const size_t found = ok::lower_bound(slice_of(table), needle);
+                return found == size ? 0 : table[found];
+            });
+
+            auto index = eytzinger_index::copy_items_from_sorted(
+                             c_allocator, slice_of(table))
+                             .unwrap();
+            const auto [eytzinger_ns, eytzinger_sum] =
+                time([&](uint32_t needle) {
+                    opt<const uint32_t&> found = index.lower_bound(needle);
+                    return found ? found.ref_unchecked() : 0;
+                });
+
+            REQUIRE(std_sum == ok_sum);
+            REQUIRE(std_sum == eytzinger_sum);
+            MESSAGE(size << " items: std::lower_bound " << std_ns
+                         << "ns, ok::lower_bound " << ok_ns
+                         << "ns, eytzinger_index_t " << eytzinger_ns
+                         << "ns per lookup");
+        }
+    }
+}
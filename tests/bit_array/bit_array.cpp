@@ -153,5 +153,23 @@ TEST_SUITE("bit_array containers")
             a.set_all_bits(bit::on());
             REQUIRE(a == bit_array::bit_string("11111111111"));
         }
+
+        SUBCASE("bit_array popcount, find_first and iter_set_bits")
+        {
+            bit_array_t a = bit_array::bit_string("0100100001");
+            REQUIRE(a.popcount() == 3);
+            REQUIRE(a.find_first_set().ref_unchecked() == 1);
+            REQUIRE(a.find_first_set(2).ref_unchecked() == 4);
+            REQUIRE(a.find_first_unset(4).ref_unchecked() == 5);
+
+            size_t sum = 0;
+            for (size_t idx : a.iter_set_bits())
+                sum += idx;
+            REQUIRE(sum == 1 + 4 + 9);
+
+            constexpr auto constant = bit_array::bit_string("0011");
+            static_assert(constant.popcount() == 2);
+            static_assert(constant.find_first_set().ref_unchecked() == 2);
+        }
     }
 }
@@ -4,9 +4,36 @@
 #include "okay/containers/array.h"
 #include "okay/containers/bit_array.h"
 #include "okay/containers/bit_arraylist.h"
+#include <vector>
 
 using namespace ok;
 
+namespace {
+bool matches(const bit_arraylist_t<c_allocator_t>& bits,
+             const std::vector<bool>& expected)
+{
+    if (bits.size_bits() != expected.size())
+        return false;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (bool(bits.get_bit(i)) != expected[i])
+            return false;
+    }
+    return true;
+}
+
+std::vector<bool> pseudo_random_bits(size_t count, uint64_t seed)
+{
+    std::vector<bool> out(count);
+    for (size_t i = 0; i < count; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        out[i] = (seed & 1) != 0;
+    }
+    return out;
+}
+} // namespace
+
 void print_bit_arraylist(const bit_arraylist_t<ok::allocator_t>& bs)
 {
     for (size_t i = 0; i < bs.size_bits(); ++i) {
@@ -325,4 +352,180 @@ TEST_SUITE("bit_arraylist_t")
             REQUIRE(total_on == 3);
         }
     }
+
+    TEST_CASE("word-wide operations")
+    {
+        const auto make_bits = [&](const std::vector<bool>& values) {
+            bit_arraylist_t bits(c_allocator);
+            for (bool value : values)
+                REQUIRE(bits.append(value).is_success());
+            return bits;
+        };
+
+        SUBCASE("insert_at and remove_at across word boundaries")
+        {
+            std::vector<bool> expected = pseudo_random_bits(300, 12345);
+            auto bits = make_bits(expected);
+            REQUIRE(matches(bits, expected));
+
+            for (size_t idx : {0, 1, 63, 64, 65, 127, 128, 200, 301, 302}) {
+                const bool value = idx % 3 == 0;
+                REQUIRE(bits.insert_at(idx, ok::bit(value)).is_success());
+                expected.insert(expected.begin() + idx, value);
+                REQUIRE(matches(bits, expected));
+            }
+
+            for (size_t idx : {0, 63, 64, 128, 250, 304, 100}) {
+                REQUIRE(bool(bits.remove_at(idx)) == expected[idx]);
+                expected.erase(expected.begin() + idx);
+                REQUIRE(matches(bits, expected));
+            }
+
+            while (!bits.is_empty()) {
+                REQUIRE(bool(bits.pop_last().ref_unchecked()) ==
+                        expected.back());
+                expected.pop_back();
+            }
+        }
+
+        SUBCASE("bits past the end stay zeroed")
+        {
+            auto a =
+                bit_arraylist::bit_string(c_allocator, "1111111111").unwrap();
+            auto b =
+                bit_arraylist::bit_string(c_allocator, "111111111").unwrap();
+            a.remove_at(3);
+            REQUIRE(a.memcompare_with(b));
+
+            a.set_all_bits(ok::bit::off());
+            a.set_all_bits(ok::bit::on());
+            REQUIRE(a.memcompare_with(b));
+
+            a.clear();
+            REQUIRE(a.append(true).is_success());
+            REQUIRE(a.size_bits() == 1);
+            REQUIRE(a.get_bit(0));
+            REQUIRE(a.memcompare_with(
+                bit_arraylist::bit_string(c_allocator, "1").unwrap()));
+        }
+
+        SUBCASE("append_bits at every alignment")
+        {
+            const std::vector<bool> source_bits = pseudo_random_bits(200, 99);
+            std::vector<uint8_t> source_bytes(source_bits.size() / 8 + 1);
+            for (size_t i = 0; i < source_bits.size(); ++i) {
+                if (source_bits[i])
+                    source_bytes[i / 8] |= uint8_t(1) << (i % 8);
+            }
+            const slice<const uint8_t> bytes =
+                raw_slice(*source_bytes.data(), source_bytes.size());
+
+            for (size_t existing : {0, 1, 7, 63, 64, 65, 130}) {
+                for (uint8_t offset : {0, 1, 5, 7}) {
+                    for (size_t length : {1, 8, 63, 64, 65, 150}) {
+                        std::vector<bool> expected =
+                            pseudo_random_bits(existing, 7);
+                        auto bits = make_bits(expected);
+
+                        REQUIRE(bits.append_bits(
+                                        raw_bit_slice(bytes, length, offset))
+                                    .is_success());
+                        expected.insert(expected.end(),
+                                        source_bits.begin() + offset,
+                                        source_bits.begin() + offset + length);
+                        REQUIRE(matches(bits, expected));
+                    }
+                }
+            }
+
+            bit_arraylist_t bits(c_allocator);
+            REQUIRE(bits.append_bits(raw_bit_slice(bytes, 0, 0)).is_success());
+            REQUIRE(bits.is_empty());
+        }
+
+        SUBCASE("append_bits from the same arraylist")
+        {
+            for (size_t existing : {1, 63, 64, 130, 1000}) {
+                for (size_t start : {0, 1, 9}) {
+                    if (start >= existing)
+                        continue;
+                    std::vector<bool> expected =
+                        pseudo_random_bits(existing, 3);
+                    auto bits = make_bits(expected);
+                    const size_t length = existing - start;
+
+                    // big enough to need reallocating
+                    REQUIRE(bits.append_bits(bits.items().subslice(
+                                                 {.start = start,
+                                                  .length = length}))
+                                .is_success());
+                    expected.insert(expected.end(), expected.begin() + start,
+                                    expected.begin() + start + length);
+                    REQUIRE(matches(bits, expected));
+                }
+            }
+        }
+
+        SUBCASE("popcount, find_first and iter_set_bits")
+        {
+            auto bits = make_bits(pseudo_random_bits(500, 5));
+            size_t count = 0;
+            opt<size_t> first_set;
+            opt<size_t> first_unset_after_100;
+            for (size_t i = 0; i < bits.size_bits(); ++i) {
+                if (bits.get_bit(i)) {
+                    ++count;
+                    if (!first_set)
+                        first_set = i;
+                } else if (i >= 100 && !first_unset_after_100) {
+                    first_unset_after_100 = i;
+                }
+            }
+            REQUIRE(bits.popcount() == count);
+            const bool same_first_set = bits.find_first_set() == first_set;
+            REQUIRE(same_first_set);
+            const bool same_first_unset =
+                bits.find_first_unset(100) == first_unset_after_100;
+            REQUIRE(same_first_unset);
+
+            size_t visited = 0;
+            for (size_t idx : bits.iter_set_bits()) {
+                REQUIRE(bits.get_bit(idx));
+                ++visited;
+            }
+            REQUIRE(visited == count);
+        }
+
+        SUBCASE("bitwise operators")
+        {
+            const std::vector<bool> lhs_bits = pseudo_random_bits(150, 1);
+            const std::vector<bool> rhs_bits = pseudo_random_bits(150, 2);
+            const auto rhs = make_bits(rhs_bits);
+
+            auto and_bits = make_bits(lhs_bits);
+            auto or_bits = make_bits(lhs_bits);
+            auto xor_bits = make_bits(lhs_bits);
+            and_bits &= rhs;
+            or_bits |= rhs;
+            xor_bits ^= rhs;
+
+            for (size_t i = 0; i < lhs_bits.size(); ++i) {
+                REQUIRE(bool(and_bits.get_bit(i)) ==
+                        (lhs_bits[i] && rhs_bits[i]));
+                REQUIRE(bool(or_bits.get_bit(i)) ==
+                        (lhs_bits[i] || rhs_bits[i]));
+                REQUIRE(bool(xor_bits.get_bit(i)) ==
+                        (lhs_bits[i] != rhs_bits[i]));
+            }
+
+            // works with bit_array_t too, through const_bit_slice_t
+            auto small =
+                bit_arraylist::bit_string(c_allocator, "1100").unwrap();
+            constexpr auto mask = bit_array::bit_string("1010");
+            small ^= mask;
+            REQUIRE_RANGES_EQUAL(small, bit_array::bit_string("0110"));
+
+            REQUIREABORTS(small |= rhs);
+        }
+    }
 }
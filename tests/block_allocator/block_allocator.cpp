@@ -6,6 +6,9 @@
 #include "allocator_tests.h"
 #include "okay/allocators/block_allocator.h"
 #include "okay/allocators/c_allocator.h"
+#include "okay/allocators/reserving_page_allocator.h"
+#include <thread>
+#include <vector>
 
 using namespace ok;
 
@@ -24,4 +27,170 @@ TEST_SUITE("block allocator")
             return ok::opt<block_allocator_t>(std::move(block.unwrap()));
         });
     }
+
+    TEST_CASE("remote free from other threads")
+    {
+        c_allocator_t backing;
+        constexpr size_t num_blocks = 1024;
+        block_allocator_t block =
+            block_allocator::alloc_initial_buf(backing,
+                                               {
+                                                   .num_initial_spots =
+                                                       num_blocks,
+                                                   .num_bytes_per_block = 64,
+                                                   .minimum_alignment = 16,
+                                               })
+                .unwrap();
+
+        std::vector<void*> allocations;
+        for (size_t i = 0; i < num_blocks; ++i) {
+            allocations.push_back(
+                block.allocate({.num_bytes = 64}).unwrap().address_of_first());
+        }
+
+        // every block is now in use, free them all from several other threads
+        constexpr size_t num_threads = 4;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                for (size_t i = t; i < allocations.size(); i += num_threads) {
+                    REQUIRE(block.contains(allocations[i]));
+                    block.deallocate_remote(allocations[i]);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        // all of the remotely freed blocks should be reused, without growing
+        for (size_t i = 0; i < num_blocks; ++i) {
+            void* reallocated =
+                block.allocate({.num_bytes = 64}).unwrap().address_of_first();
+            REQUIRE(block.contains(reallocated));
+        }
+    }
+
+    TEST_CASE("growing keeps track of the new blocks")
+    {
+        reserving_page_allocator_t backing({.pages_reserved = 64});
+        block_allocator_t block =
+            block_allocator::alloc_initial_buf(backing,
+                                               {
+                                                   .num_initial_spots = 4,
+                                                   .num_bytes_per_block = 64,
+                                                   .minimum_alignment = 16,
+                                               })
+                .unwrap();
+
+        // well past the initial four blocks and the rest of the first page
+        constexpr size_t num_blocks = 1024;
+        std::vector<void*> allocations;
+        for (size_t i = 0; i < num_blocks; ++i) {
+            void* allocated =
+                block.allocate({.num_bytes = 64}).unwrap().address_of_first();
+            REQUIRE(block.contains(allocated));
+            allocations.push_back(allocated);
+        }
+
+        // blocks from every growth can be freed by other threads
+        std::thread remote([&] {
+            for (size_t i = 0; i < allocations.size(); i += 2) {
+                REQUIRE(block.contains(allocations[i]));
+                block.deallocate_remote((uint8_t*)allocations[i] + 10);
+            }
+        });
+        for (size_t i = 1; i < allocations.size(); i += 2)
+            block.deallocate(allocations[i]);
+        remote.join();
+
+        for (size_t i = 0; i < num_blocks; ++i) {
+            void* reallocated =
+                block.allocate({.num_bytes = 64}).unwrap().address_of_first();
+            REQUIRE(block.contains(reallocated));
+        }
+    }
+
+    TEST_CASE("remote free of interior pointer frees the whole block")
+    {
+        c_allocator_t backing;
+        block_allocator_t block =
+            block_allocator::alloc_initial_buf(backing,
+                                               {
+                                                   .num_initial_spots = 1,
+                                                   .num_bytes_per_block = 64,
+                                                   .minimum_alignment = 16,
+                                               })
+                .unwrap();
+
+        bytes_t bytes = block.allocate({.num_bytes = 64}).unwrap();
+        block.deallocate_remote(bytes.address_of_first() + 10);
+        bytes_t again = block.allocate({.num_bytes = 64}).unwrap();
+        REQUIRE(again.address_of_first() == bytes.address_of_first());
+    }
+
+    TEST_CASE("static blocksize allocator tests")
+    {
+        c_allocator_t backing;
+        run_allocator_tests_static_and_dynamic_dispatch([&] {
+            auto block = static_block_allocator::alloc_initial_buf<1024>(
+                backing, {
+                             .num_initial_spots = 1024,
+                             .minimum_alignment = 16,
+                         });
+            return ok::opt<static_block_allocator_t<1024>>(
+                std::move(block.unwrap()));
+        });
+    }
+
+    TEST_CASE("freeing interior pointers with non power of two blocksizes")
+    {
+        c_allocator_t backing;
+        constexpr size_t num_blocks = 64;
+        block_allocator_t block =
+            block_allocator::alloc_initial_buf(backing,
+                                               {
+                                                   .num_initial_spots =
+                                                       num_blocks,
+                                                   .num_bytes_per_block = 40,
+                                                   .minimum_alignment = 8,
+                                               })
+                .unwrap();
+        static_block_allocator_t<48> static_block =
+            static_block_allocator::alloc_initial_buf<48>(
+                backing, {
+                             .num_initial_spots = num_blocks,
+                             .num_bytes_per_block = 40,
+                             .minimum_alignment = 16,
+                         })
+                .unwrap();
+        REQUIRE(block.block_size() == 40);
+        REQUIRE(static_block.block_size() == 48);
+
+        std::vector<bytes_t> allocations;
+        std::vector<bytes_t> static_allocations;
+        for (size_t i = 0; i < num_blocks; ++i) {
+            allocations.push_back(
+                block.allocate({.num_bytes = 40, .alignment = 8}).unwrap());
+            static_allocations.push_back(
+                static_block.allocate({.num_bytes = 40}).unwrap());
+        }
+
+        // free each block through a pointer to its last byte, then make sure
+        // the same blocks come back out
+        for (size_t i = 0; i < num_blocks; ++i) {
+            block.deallocate(allocations[i].address_of_first() + 39);
+            static_block.deallocate(static_allocations[i].address_of_first() +
+                                    47);
+        }
+        for (size_t i = num_blocks; i > 0; --i) {
+            REQUIRE(block.allocate({.num_bytes = 40, .alignment = 8})
+                        .unwrap()
+                        .address_of_first() ==
+                    allocations[i - 1].address_of_first());
+            REQUIRE(static_block.allocate({.num_bytes = 40})
+                        .unwrap()
+                        .address_of_first() ==
+                    static_allocations[i - 1].address_of_first());
+        }
+    }
 }
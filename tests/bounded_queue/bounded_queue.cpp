@@ -0,0 +1,468 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/bounded_queue.h"
+#include "testing_types.h"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+std::string long_string(size_t i)
+{
+    // long enough to allocate, so that leaked or double destroyed items are
+    // caught by address sanitizer
+    return std::string("a string which is long enough to allocate ") +
+           std::to_string(i);
+}
+
+/// Fill the queue from a single thread until it is full, then drain it,
+/// a few times so that the indices wrap around the ring.
+template <typename queue_t> void fill_and_drain(queue_t& queue)
+{
+    size_t next_pushed = 0;
+    size_t next_popped = 0;
+    for (size_t round = 0; round < 5; ++round) {
+        // leave some items in, so that the next round starts part way around
+        while (queue.try_push(long_string(next_pushed)).is_success())
+            ++next_pushed;
+        REQUIRE(queue.size_approx() == queue.capacity());
+        REQUIRE(queue.try_push("full").as_enum() ==
+                bounded_queue::push_error::full);
+        for (size_t i = 0; i < queue.capacity() - round % queue.capacity();
+             ++i) {
+            REQUIRE(queue.try_pop().ref_or_panic() ==
+                    long_string(next_popped));
+            ++next_popped;
+        }
+    }
+    while (auto item = queue.try_pop())
+        REQUIRE(item.ref_unchecked() == long_string(next_popped++));
+    REQUIRE(next_popped == next_pushed);
+    REQUIRE(queue.size_approx() == 0);
+}
+
+/// One producer pushes 0 to num_items, partly in batches, while one consumer
+/// checks that they come out in order.
+template <typename queue_t>
+void spsc_across_threads(queue_t& queue, size_t num_items)
+{
+    std::thread producer([&] {
+        size_t batch[7];
+        size_t next = 0;
+        while (next < num_items) {
+            if (next % 3 == 0) {
+                size_t count = ok::min(size_t(7), num_items - next);
+                for (size_t i = 0; i < count; ++i)
+                    batch[i] = next + i;
+                const size_t pushed =
+                    queue.push_batch(slice<const size_t>(raw_slice(
+                        static_cast<const size_t&>(*batch), count)));
+                next += pushed;
+                if (pushed == 0)
+                    std::this_thread::yield();
+            } else if (queue.try_push(next).is_success()) {
+                ++next;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    size_t batch[5];
+    size_t expected = 0;
+    while (expected < num_items) {
+        if (expected % 2 == 0) {
+            const size_t popped = queue.pop_batch(raw_slice(*batch, 5));
+            for (size_t i = 0; i < popped; ++i)
+                REQUIRE(batch[i] == expected++);
+            if (popped == 0)
+                std::this_thread::yield();
+        } else if (auto item = queue.try_pop()) {
+            REQUIRE(item.ref_unchecked() == expected++);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    REQUIRE(!queue.try_pop());
+}
+
+/// Producers push every number below num_producers * items_per_producer
+/// exactly once, and consumers check that each comes out exactly once.
+template <typename queue_t>
+void mpmc_across_threads(queue_t& queue, size_t num_producers,
+                         size_t num_consumers, size_t items_per_producer)
+{
+    const size_t num_items = num_producers * items_per_producer;
+    std::vector<ok::atomic_t<uint32_t>> seen(num_items);
+    ok::atomic_t<size_t> num_popped;
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < num_producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (size_t i = 0; i < items_per_producer; ++i) {
+                const size_t item = p * items_per_producer + i;
+                while (!queue.try_push(item).is_success())
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t c = 0; c < num_consumers; ++c) {
+        threads.emplace_back([&] {
+            while (num_popped.load(memory_order::relaxed) < num_items) {
+                if (auto item = queue.try_pop()) {
+                    seen[item.ref_unchecked()].fetch_add(1);
+                    num_popped.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    REQUIRE(num_popped.load() == num_items);
+    for (size_t i = 0; i < num_items; ++i)
+        REQUIRE(seen[i].load() == 1);
+    REQUIRE(!queue.try_pop());
+}
+
+/// The baseline for the benchmarks: a std::deque behind a mutex.
+template <typename T> class locked_queue_t
+{
+    std::mutex mutex;
+    std::deque<T> items;
+    size_t max_size;
+
+  public:
+    locked_queue_t(size_t capacity) : max_size(capacity) {}
+
+    bool try_push(const T& item)
+    {
+        std::lock_guard lock(mutex);
+        if (items.size() == max_size)
+            return false;
+        items.push_back(item);
+        return true;
+    }
+
+    opt<T> try_pop()
+    {
+        std::lock_guard lock(mutex);
+        if (items.empty())
+            return {};
+        opt<T> out(items.front());
+        items.pop_front();
+        return out;
+    }
+};
+
+template <typename T, typename queue_t> bool push_ok(queue_t& queue, T item)
+{
+    if constexpr (requires { queue.try_push(item).is_success(); })
+        return queue.try_push(item).is_success();
+    else
+        return queue.try_push(item);
+}
+
+/// Milliseconds for producers to push num_items through the queue to
+/// consumers, spinning while it is full or empty.
+template <typename queue_t>
+double throughput_ms(queue_t& queue, size_t num_producers, size_t num_consumers,
+                     size_t num_items)
+{
+    ok::atomic_t<size_t> num_popped;
+    ok::atomic_t<uint64_t> sum;
+    const double ms = time_ms([&] {
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < num_producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (size_t i = p; i < num_items; i += num_producers) {
+                    while (!push_ok<uint64_t>(queue, i))
+                        std::this_thread::yield();
+                }
+            });
+        }
+        for (size_t c = 0; c < num_consumers; ++c) {
+            threads.emplace_back([&] {
+                uint64_t local_sum = 0;
+                while (num_popped.load(memory_order::relaxed) < num_items) {
+                    if (auto item = queue.try_pop()) {
+                        local_sum += item.ref_unchecked();
+                        num_popped.fetch_add(1, memory_order::relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                sum.fetch_add(local_sum);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    });
+    REQUIRE(sum.load() == uint64_t(num_items) * (num_items - 1) / 2);
+    return ms;
+}
+
+/// Average nanoseconds for one item to go to another thread and back,
+/// through a pair of queues.
+template <typename queue_t>
+double round_trip_ns(queue_t& there, queue_t& back, size_t num_round_trips)
+{
+    std::thread echo([&] {
+        for (size_t i = 0; i < num_round_trips; ++i) {
+            opt<uint64_t> item;
+            while (!(item = there.try_pop()))
+                std::this_thread::yield();
+            while (!push_ok<uint64_t>(back, item.ref_unchecked()))
+                std::this_thread::yield();
+        }
+    });
+    const double ms = time_ms([&] {
+        for (size_t i = 0; i < num_round_trips; ++i) {
+            while (!push_ok<uint64_t>(there, i))
+                std::this_thread::yield();
+            opt<uint64_t> item;
+            while (!(item = back.try_pop()))
+                std::this_thread::yield();
+            REQUIRE(item.ref_unchecked() == i);
+        }
+    });
+    echo.join();
+    return ms * 1000000.0 / double(num_round_trips);
+}
+} // namespace
+
+TEST_SUITE("bounded queues")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("spsc_queue_t from one thread")
+    {
+        spsc_queue_t<std::string, 8> fixed;
+        REQUIRE(fixed.capacity() == 8);
+        REQUIRE(!fixed.try_pop());
+        fill_and_drain(fixed);
+
+        auto allocated =
+            allocated_spsc_queue::with_capacity<std::string>(c_allocator, 5)
+                .unwrap();
+        REQUIRE(allocated.capacity() == 8);
+        fill_and_drain(allocated);
+
+        // items still in the queue are destroyed with it
+        REQUIRE(fixed.try_push(long_string(0)).is_success());
+        REQUIRE(allocated.try_push(long_string(0)).is_success());
+    }
+
+    TEST_CASE("spsc batches")
+    {
+        spsc_queue_t<int, 8> queue;
+        int items[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        REQUIRE(queue.push_batch(slice<const int>(items)) == 8);
+        REQUIRE(queue.push_batch(slice<const int>(items)) == 0);
+
+        int out[3] = {};
+        REQUIRE(queue.pop_batch(out) == 3);
+        REQUIRE(out[0] == 0);
+        REQUIRE(out[2] == 2);
+        // room for three more, which wrap around the end of the ring
+        REQUIRE(queue.push_batch(subslice(slice<const int>(items),
+                                          {.start = 8, .length = 2})) == 2);
+        REQUIRE(queue.try_push(10).is_success());
+        REQUIRE(!queue.try_push(11).is_success());
+
+        int rest[10] = {};
+        REQUIRE(queue.pop_batch(rest) == 8);
+        for (int i = 0; i < 8; ++i)
+            REQUIRE(rest[i] == i + 3);
+        REQUIRE(queue.pop_batch(rest) == 0);
+    }
+
+    TEST_CASE("spsc across threads")
+    {
+        spsc_queue_t<size_t, 16> fixed;
+        spsc_across_threads(fixed, 200000);
+
+        auto allocated =
+            allocated_spsc_queue::with_capacity<size_t>(c_allocator, 1)
+                .unwrap();
+        REQUIRE(allocated.capacity() == 1);
+        spsc_across_threads(allocated, 20000);
+    }
+
+    TEST_CASE("mpmc_queue_t from one thread")
+    {
+        mpmc_queue_t<std::string, 4> fixed;
+        REQUIRE(fixed.capacity() == 4);
+        REQUIRE(!fixed.try_pop());
+        fill_and_drain(fixed);
+
+        auto allocated =
+            allocated_mpmc_queue::with_capacity<std::string>(c_allocator, 1)
+                .unwrap();
+        // one slot cannot work, so it is rounded up to two
+        REQUIRE(allocated.capacity() == 2);
+        fill_and_drain(allocated);
+
+        REQUIRE(fixed.try_push(long_string(0)).is_success());
+        REQUIRE(allocated.try_push(long_string(0)).is_success());
+        REQUIRE(allocated.try_push(long_string(1)).is_success());
+    }
+
+    TEST_CASE("mpmc across threads")
+    {
+        mpmc_queue_t<size_t, 64> fixed;
+        mpmc_across_threads(fixed, 4, 4, 20000);
+
+        auto allocated =
+            allocated_mpmc_queue::with_capacity<size_t>(c_allocator, 2)
+                .unwrap();
+        mpmc_across_threads(allocated, 3, 2, 10000);
+        mpmc_across_threads(allocated, 1, 4, 10000);
+    }
+
+    TEST_CASE("moving and allocation failure")
+    {
+        auto queue =
+            allocated_mpmc_queue::with_capacity<std::string>(c_allocator, 4)
+                .unwrap();
+        REQUIRE(queue.try_push("first").is_success());
+        auto moved = stdc::move(queue);
+        REQUIRE(moved.try_pop().ref_or_panic() == "first");
+        REQUIRE(moved.try_push("second").is_success());
+        queue = stdc::move(moved);
+        REQUIRE(queue.try_pop().ref_or_panic() == "second");
+
+        auto spsc =
+            allocated_spsc_queue::with_capacity<std::string>(c_allocator, 4)
+                .unwrap();
+        REQUIRE(spsc.try_push(long_string(1)).is_success());
+        auto moved_spsc = stdc::move(spsc);
+        REQUIRE(moved_spsc.size_approx() == 1);
+
+        uint8_t buffer[512];
+        arena_t arena(buffer);
+        REQUIRE(!allocated_spsc_queue::with_capacity<int>(arena, 1024)
+                     .is_success());
+        REQUIRE(!allocated_mpmc_queue::with_capacity<int>(arena, 1024)
+                     .is_success());
+        auto small =
+            allocated_spsc_queue::with_capacity<int>(arena, 16).unwrap();
+        REQUIRE(small.capacity() == 16);
+
+        // capacities which do not fit in memory, or which cannot be rounded
+        // up to a power of two, are rejected before asking the allocator
+        for (size_t capacity : {~size_t(0), (~size_t(0) >> 1) + 2,
+                                ~size_t(0) / sizeof(int)}) {
+            REQUIRE(
+                allocated_spsc_queue::with_capacity<int>(c_allocator, capacity)
+                    .status()
+                    .as_enum() == alloc::error::unsupported);
+            REQUIRE(
+                allocated_mpmc_queue::with_capacity<int>(c_allocator, capacity)
+                    .status()
+                    .as_enum() == alloc::error::unsupported);
+        }
+        REQUIRE(allocated_spsc_queue::with_capacity<uint8_t>(
+                    c_allocator, (~size_t(0) >> 1) + 2)
+                    .status()
+                    .as_enum() == alloc::error::unsupported);
+    }
+
+    // run with --no-skip to see timings
+    TEST_CASE("benchmark throughput under contention" * doctest::skip())
+    {
+        constexpr size_t num_items = 10000000;
+        constexpr size_t capacity = 1024;
+
+        auto spsc =
+            allocated_spsc_queue::with_capacity<uint64_t>(c_allocator, capacity)
+                .unwrap();
+        auto mpmc =
+            allocated_mpmc_queue::with_capacity<uint64_t>(c_allocator, capacity)
+                .unwrap();
+        locked_queue_t<uint64_t> locked(capacity);
+
+        const double spsc_ms = throughput_ms(spsc, 1, 1, num_items);
+        const double mpmc_1_ms = throughput_ms(mpmc, 1, 1, num_items);
+        const double locked_1_ms = throughput_ms(locked, 1, 1, num_items);
+        MESSAGE("1 producer, 1 consumer, " << num_items << " items: spsc "
+                                           << spsc_ms << "ms, mpmc "
+                                           << mpmc_1_ms << "ms, mutex "
+                                           << locked_1_ms << "ms");
+
+        // batches of 64 at a time, one index update each
+        const double batch_ms = time_ms([&] {
+            std::thread producer([&] {
+                uint64_t batch[64];
+                for (size_t next = 0; next < num_items;) {
+                    const size_t count = ok::min(size_t(64), num_items - next);
+                    for (size_t i = 0; i < count; ++i)
+                        batch[i] = next + i;
+                    const size_t pushed = spsc.push_batch(slice<const uint64_t>(
+                        raw_slice(static_cast<const uint64_t&>(*batch),
+                                  count)));
+                    if (pushed == 0)
+                        std::this_thread::yield();
+                    next += pushed;
+                }
+            });
+            uint64_t batch[64];
+            uint64_t sum = 0;
+            for (size_t popped = 0; popped < num_items;) {
+                const size_t count = spsc.pop_batch(batch);
+                for (size_t i = 0; i < count; ++i)
+                    sum += batch[i];
+                if (count == 0)
+                    std::this_thread::yield();
+                popped += count;
+            }
+            producer.join();
+            REQUIRE(sum == uint64_t(num_items) * (num_items - 1) / 2);
+        });
+        MESSAGE("spsc in batches of 64: " << batch_ms << "ms");
+
+        // half the threads push and half pop
+        const size_t pairs =
+            ok::max(size_t(1), size_t(std::thread::hardware_concurrency() / 2));
+        const double mpmc_n_ms = throughput_ms(mpmc, pairs, pairs, num_items);
+        const double locked_n_ms =
+            throughput_ms(locked, pairs, pairs, num_items);
+        MESSAGE(pairs << " producers, " << pairs << " consumers: mpmc "
+                      << mpmc_n_ms << "ms, mutex " << locked_n_ms << "ms");
+    }
+
+    // run with --no-skip to see timings
+    TEST_CASE("benchmark round trip latency" * doctest::skip())
+    {
+        constexpr size_t num_round_trips = 200000;
+        auto spsc_there =
+            allocated_spsc_queue::with_capacity<uint64_t>(c_allocator, 64)
+                .unwrap();
+        auto spsc_back =
+            allocated_spsc_queue::with_capacity<uint64_t>(c_allocator, 64)
+                .unwrap();
+        mpmc_queue_t<uint64_t, 64> mpmc_there;
+        mpmc_queue_t<uint64_t, 64> mpmc_back;
+        locked_queue_t<uint64_t> locked_there(64);
+        locked_queue_t<uint64_t> locked_back(64);
+
+        const double spsc_ns =
+            round_trip_ns(spsc_there, spsc_back, num_round_trips);
+        const double mpmc_ns =
+            round_trip_ns(mpmc_there, mpmc_back, num_round_trips);
+        const double locked_ns =
+            round_trip_ns(locked_there, locked_back, num_round_trips);
+        MESSAGE("round trip between two threads: spsc "
+                << spsc_ns << "ns, mpmc " << mpmc_ns << "ns, mutex "
+                << locked_ns << "ns");
+    }
+}
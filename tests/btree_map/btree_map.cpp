@@ -0,0 +1,301 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/btree_map.h"
+#include "testing_types.h"
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+/// Counts how many are alive, to check that the map destroys everything it
+/// constructs.
+struct counted_t
+{
+    static inline int64_t alive = 0;
+    int value;
+
+    counted_t(int v) : value(v) { ++alive; }
+    counted_t(const counted_t& other) : value(other.value) { ++alive; }
+    counted_t(counted_t&& other) : value(other.value) { ++alive; }
+    counted_t& operator=(const counted_t&) = default;
+    counted_t& operator=(counted_t&&) = default;
+    ~counted_t() { --alive; }
+
+    friend auto operator<=>(const counted_t& lhs, const counted_t& rhs)
+    {
+        return lhs.value <=> rhs.value;
+    }
+    friend bool operator==(const counted_t&, const counted_t&) = default;
+};
+
+/// A key which owns its characters, and can be looked up with a string_view
+/// without making one.
+struct owned_name_t
+{
+    std::string chars;
+
+    friend auto operator<=>(const owned_name_t& lhs, const owned_name_t& rhs)
+    {
+        return lhs.chars <=> rhs.chars;
+    }
+
+    friend auto operator<=>(const owned_name_t& lhs, std::string_view rhs)
+    {
+        return std::string_view(lhs.chars) <=> rhs;
+    }
+};
+
+template <typename map_t>
+std::vector<int> keys_of(const map_t& map)
+{
+    std::vector<int> out;
+    for (auto [key, value] : map.iter())
+        out.push_back(int(key));
+    return out;
+}
+} // namespace
+
+TEST_SUITE("btree_map_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("matches std::map under random operations")
+    {
+        // small nodes, so that the tree is tall and nodes split and merge
+        // all the time
+        btree_map_t<uint64_t, uint64_t, c_allocator_t, 64> map(c_allocator);
+        std::map<uint64_t, uint64_t> expected;
+        uint64_t state = 88172645463325252ULL;
+
+        for (size_t i = 0; i < 200000; ++i) {
+            const uint64_t random = next_random(state);
+            // a small key space so that keys are often reinserted and removed
+            const uint64_t key = random % 5000;
+            switch ((random >> 32) % 4) {
+            case 0:
+            case 1:
+                REQUIRE(map.insert(key, i).unwrap() == i);
+                expected[key] = i;
+                break;
+            case 2:
+                REQUIRE(map.remove(key) == bool(expected.erase(key)));
+                break;
+            case 3: {
+                opt<uint64_t&> found = map.get(key);
+                auto iter = expected.find(key);
+                REQUIRE(bool(found) == (iter != expected.end()));
+                if (found)
+                    REQUIRE(found.ref_unchecked() == iter->second);
+                break;
+            }
+            }
+            REQUIRE(map.size() == expected.size());
+        }
+
+        auto expected_iter = expected.begin();
+        for (auto [key, value] : map.iter()) {
+            REQUIRE(expected_iter != expected.end());
+            REQUIRE(key == expected_iter->first);
+            REQUIRE(value == expected_iter->second);
+            ++expected_iter;
+        }
+        REQUIRE(expected_iter == expected.end());
+
+        // empty the map entirely, which collapses the tree
+        for (const auto& [key, value] : expected)
+            REQUIRE(map.remove(key));
+        REQUIRE(map.is_empty());
+        REQUIRE(keys_of(map).empty());
+        REQUIRE(map.insert(uint64_t(3), uint64_t(4)).is_success());
+        REQUIRE(map.get(uint64_t(3)).ref_unchecked() == 4);
+    }
+
+    TEST_CASE("get_or_insert, insert, remove and clear")
+    {
+        {
+            btree_map_t<counted_t, counted_t, c_allocator_t, 128> map(
+                c_allocator);
+            REQUIRE(map.is_empty());
+            REQUIRE(!map.contains(counted_t(1)));
+            REQUIRE(!map.remove(counted_t(1)));
+            REQUIRE(!map.get(counted_t(1)));
+
+            REQUIRE(map.get_or_insert(counted_t(1), 10).unwrap().value == 10);
+            // already there, so the argument is unused
+            REQUIRE(map.get_or_insert(counted_t(1), 20).unwrap().value == 10);
+            REQUIRE(map.insert(counted_t(1), counted_t(30)).unwrap().value ==
+                    30);
+            REQUIRE(map.size() == 1);
+
+            // descending order, so that every insert goes at the front
+            for (int i = 999; i >= 2; --i)
+                REQUIRE(map.get_or_insert(counted_t(i), i * 10).is_success());
+            REQUIRE(counted_t::alive >= 999 * 2);
+            for (int i = 2; i < 1000; i += 2)
+                REQUIRE(map.remove(counted_t(i)));
+            REQUIRE(map.size() == 500);
+            for (int i = 1; i < 1000; ++i)
+                REQUIRE(map.contains(counted_t(i)) == (i % 2 == 1));
+
+            // values can be changed while iterating
+            for (auto [key, value] : map.iter())
+                value.value = -key.value;
+            const auto& const_map = map;
+            int previous = 0;
+            for (auto [key, value] : const_map.iter()) {
+                REQUIRE(key.value > previous);
+                REQUIRE(value.value == -key.value);
+                previous = key.value;
+            }
+
+            map.clear();
+            REQUIRE(map.is_empty());
+            REQUIRE(counted_t::alive == 0);
+            REQUIRE(map.get_or_insert(counted_t(5), 5).is_success());
+
+            auto moved = stdc::move(map);
+            REQUIRE(moved.get(counted_t(5)).ref_unchecked().value == 5);
+            moved = btree_map_t<counted_t, counted_t, c_allocator_t, 128>(
+                c_allocator);
+            REQUIRE(counted_t::alive == 0);
+            REQUIRE(moved.insert(counted_t(6), counted_t(6)).is_success());
+        }
+        REQUIRE(counted_t::alive == 0);
+    }
+
+    TEST_CASE("range iteration")
+    {
+        btree_map_t<int, int, c_allocator_t, 64> map(c_allocator);
+        // every third number
+        for (int i = 0; i < 3000; i += 3)
+            REQUIRE(map.insert(i, i).is_success());
+
+        const auto keys_between = [&](int lower, int upper) {
+            std::vector<int> out;
+            for (auto [key, value] : map.iter_between(lower, upper))
+                out.push_back(key);
+            return out;
+        };
+        REQUIRE(keys_between(10, 20) == std::vector<int>{12, 15, 18});
+        REQUIRE(keys_between(9, 18) == std::vector<int>{9, 12, 15});
+        REQUIRE(keys_between(10, 11).empty());
+        REQUIRE(keys_between(20, 10).empty());
+        REQUIRE(keys_between(2990, 5000) == std::vector<int>{2991, 2994, 2997});
+        REQUIRE(keys_between(-100, 4) == std::vector<int>{0, 3});
+        REQUIRE(keys_between(5000, 6000).empty());
+        REQUIRE(keys_between(0, 3000).size() == 1000);
+
+        std::vector<int> from;
+        for (auto [key, value] : map.iter_from(2992))
+            from.push_back(key);
+        REQUIRE(from == std::vector<int>{2994, 2997});
+
+        const auto& const_map = map;
+        int count = 0;
+        for (auto [key, value] : const_map.iter_between(300, 600)) {
+            REQUIRE(key == value);
+            ++count;
+        }
+        REQUIRE(count == 100);
+    }
+
+    TEST_CASE("from_sorted")
+    {
+        for (size_t num_items : {0, 1, 5, 31, 32, 33, 1000, 12345}) {
+            std::vector<int> keys(num_items);
+            std::vector<int> values(num_items);
+            // so that data() is never null
+            keys.reserve(1);
+            values.reserve(1);
+            for (size_t i = 0; i < num_items; ++i) {
+                keys[i] = int(i * 2);
+                values[i] = int(i);
+            }
+            auto map = btree_map::from_sorted<int, int>(
+                           c_allocator,
+                           zip(raw_slice(*keys.data(), keys.size()),
+                               raw_slice(*values.data(), values.size())))
+                           .unwrap();
+            REQUIRE(map.size() == num_items);
+            REQUIRE(keys_of(map) == keys);
+
+            // the loaded tree takes inserts and removals like any other
+            for (size_t i = 0; i < num_items; ++i)
+                REQUIRE(map.get(int(i * 2)).ref_unchecked() == int(i));
+            for (int i = 1; i < int(num_items); i += 4)
+                REQUIRE(map.insert(i, -i).is_success());
+            for (int i = 0; i < int(num_items); i += 6)
+                REQUIRE(map.remove(i));
+            std::vector<int> expected;
+            for (int i = 0; i < int(num_items * 2); ++i) {
+                const bool removed = i % 6 == 0 && i < int(num_items);
+                if ((i % 2 == 0 && i / 2 < int(num_items) && !removed) ||
+                    (i % 4 == 1 && i < int(num_items)))
+                    expected.push_back(i);
+            }
+            REQUIRE(keys_of(map) == expected);
+        }
+
+        int keys[] = {1, 2, 2};
+        int values[] = {0, 0, 0};
+        const auto load_unsorted = [&] {
+            return btree_map::from_sorted<int, int>(c_allocator,
+                                                    zip(keys, values));
+        };
+        REQUIREABORTS(auto map = load_unsorted());
+    }
+
+    TEST_CASE("heterogeneous lookup")
+    {
+        btree_map_t<owned_name_t, int, c_allocator_t> names(c_allocator);
+        REQUIRE(names.insert(owned_name_t{"banana"}, 2).is_success());
+        REQUIRE(names.insert(owned_name_t{"apple"}, 1).is_success());
+        REQUIRE(names.insert(owned_name_t{"cherry"}, 3).is_success());
+        REQUIRE(names.get(std::string_view("apple")).ref_unchecked() == 1);
+        REQUIRE(!names.contains(std::string_view("apricot")));
+
+        std::vector<std::string> between;
+        for (auto [name, value] : names.iter_between(std::string_view("b"),
+                                                     std::string_view("d")))
+            between.push_back(name.chars);
+        REQUIRE(between == std::vector<std::string>{"banana", "cherry"});
+        REQUIRE(names.remove(std::string_view("banana")));
+        REQUIRE(names.size() == 2);
+    }
+
+    TEST_CASE("allocation failure")
+    {
+        uint8_t buffer[4096];
+        arena_t arena(buffer);
+        btree_map_t<int, int, arena_t, 128> map(arena);
+        int inserted = 0;
+        while (map.insert(inserted, inserted).is_success())
+            ++inserted;
+        REQUIRE(inserted > 0);
+        // the failed insert left everything which was there before
+        REQUIRE(map.size() == size_t(inserted));
+        for (int i = 0; i < inserted; ++i)
+            REQUIRE(map.get(i).ref_unchecked() == i);
+        REQUIRE(!map.contains(inserted));
+        // freed nodes are reused without allocating
+        for (int i = 0; i < inserted; ++i)
+            REQUIRE(map.remove(i));
+        for (int i = 0; i < inserted; ++i)
+            REQUIRE(map.insert(-i, i).is_success());
+
+        std::vector<int> keys(100000);
+        for (size_t i = 0; i < keys.size(); ++i)
+            keys[i] = int(i);
+        uint8_t small_buffer[4096];
+        arena_t small_arena(small_buffer);
+        REQUIRE(!btree_map::from_sorted<int, int>(
+                     small_arena, zip(raw_slice(*keys.data(), keys.size()),
+                                      raw_slice(*keys.data(), keys.size())))
+                     .is_success());
+    }
+}
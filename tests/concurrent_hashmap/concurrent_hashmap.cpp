@@ -0,0 +1,252 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/concurrent_hashmap.h"
+#include <thread>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+/// Counts how many are alive, to check that removed values are freed once
+/// nobody is looking at them.
+struct counted_t
+{
+    static inline ok::atomic_t<int64_t> alive;
+    int value;
+
+    counted_t(int v) : value(v) { alive.fetch_add(1); }
+    counted_t(const counted_t& other) : value(other.value)
+    {
+        alive.fetch_add(1);
+    }
+    ~counted_t() { alive.fetch_sub(1); }
+};
+} // namespace
+
+TEST_SUITE("concurrent_hashmap_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("insert, get and remove from one thread")
+    {
+        auto map = concurrent_hashmap::empty<int, int>(
+                       c_allocator, {.num_shards = 5, .max_readers = 4})
+                       .unwrap();
+        auto reader = map.reader().ref_or_panic();
+        REQUIRE(map.size() == 0);
+        REQUIRE(!reader.contains(1));
+        REQUIRE(!reader.get(1));
+        REQUIRE(!map.remove(1));
+
+        for (int i = 0; i < 5000; ++i)
+            REQUIRE(map.insert(i, i * 2).is_success());
+        REQUIRE(map.size() == 5000);
+        for (int i = 0; i < 5000; ++i)
+            REQUIRE(reader.get(i).ref_unchecked().deref() == i * 2);
+
+        // replacing does not change the size
+        REQUIRE(map.insert(7, -7).is_success());
+        REQUIRE(reader.get(7).ref_unchecked().deref() == -7);
+        REQUIRE(map.size() == 5000);
+
+        for (int i = 0; i < 5000; i += 2)
+            REQUIRE(map.remove(i));
+        REQUIRE(map.size() == 2500);
+        for (int i = 0; i < 5000; ++i)
+            REQUIRE(reader.contains(i) == (i % 2 == 1));
+
+        // removed slots get reused
+        for (int round = 0; round < 20; ++round) {
+            for (int i = 0; i < 5000; i += 2)
+                REQUIRE(map.insert(i, round).is_success());
+            for (int i = 0; i < 5000; i += 2)
+                REQUIRE(map.remove(i));
+        }
+        REQUIRE(map.size() == 2500);
+
+        int seen = 0;
+        REQUIRE(reader.visit(9, [&](const int& value) { seen = value; }));
+        REQUIRE(seen == 18);
+        REQUIRE(!reader.visit(10, [&](const int&) { seen = 0; }));
+        REQUIRE(seen == 18);
+    }
+
+    TEST_CASE("heterogeneous lookup")
+    {
+        auto map =
+            concurrent_hashmap::empty<ascii_view, int>(c_allocator).unwrap();
+        auto reader = map.reader().ref_or_panic();
+        REQUIRE(map.insert("apple", 1).is_success());
+        REQUIRE(map.insert(ascii_view("banana"), 2).is_success());
+        REQUIRE(reader.get("apple").ref_unchecked().deref() == 1);
+        REQUIRE(reader.contains(ascii_view("banana")));
+        REQUIRE(!reader.contains("cherry"));
+        REQUIRE(map.remove("apple"));
+        REQUIRE(!reader.contains("apple"));
+    }
+
+    TEST_CASE("values outlive removal while in use")
+    {
+        {
+            auto map =
+                concurrent_hashmap::empty<int, counted_t>(c_allocator).unwrap();
+            auto reader = map.reader().ref_or_panic();
+            REQUIRE(map.insert(1, 10).is_success());
+            REQUIRE(map.insert(2, 20).is_success());
+            REQUIRE(counted_t::alive.load() == 2);
+
+            // an arc keeps its value alive after the key is gone
+            auto one = reader.get(1).ref_or_panic();
+            REQUIRE(map.remove(1));
+            map.reclaim_now();
+            REQUIRE(one.deref().value == 10);
+            REQUIRE(counted_t::alive.load() == 2);
+
+            // so does a reader in the middle of a visit
+            REQUIRE(reader.visit(2, [&](const counted_t& two) {
+                REQUIRE(map.insert(2, 21).is_success());
+                map.reclaim_now();
+                REQUIRE(two.value == 20);
+                REQUIRE(counted_t::alive.load() == 3);
+            }));
+            map.reclaim_now();
+            REQUIRE(counted_t::alive.load() == 2);
+            REQUIRE(reader.get(2).ref_unchecked().deref().value == 21);
+
+            // even if the visitor does more lookups with the same reader
+            REQUIRE(reader.visit(2, [&](const counted_t& two) {
+                REQUIRE(reader.contains(2));
+                REQUIRE(map.insert(2, 22).is_success());
+                REQUIRE(reader.get(2).ref_unchecked().deref().value == 22);
+                map.reclaim_now();
+                REQUIRE(two.value == 21);
+                REQUIRE(counted_t::alive.load() == 3);
+            }));
+            map.reclaim_now();
+            REQUIRE(counted_t::alive.load() == 2);
+
+            {
+                auto dropped = stdc::move(one);
+            }
+            REQUIRE(counted_t::alive.load() == 1);
+
+            // values can be shared between maps
+            auto other =
+                concurrent_hashmap::empty<int, counted_t>(c_allocator).unwrap();
+            REQUIRE(other.insert_arc(5, reader.get(2).ref_or_panic())
+                        .is_success());
+            REQUIRE(counted_t::alive.load() == 1);
+        }
+        REQUIRE(counted_t::alive.load() == 0);
+    }
+
+    TEST_CASE("readers are limited and handed back")
+    {
+        auto map = concurrent_hashmap::empty<int, int>(
+                       c_allocator, {.max_readers = 2})
+                       .unwrap();
+        {
+            auto first = map.reader().ref_or_panic();
+            {
+                auto second = map.reader().ref_or_panic();
+                REQUIRE(!map.reader());
+                auto moved = stdc::move(second);
+                REQUIRE(!map.reader());
+            }
+            REQUIRE(map.reader());
+        }
+
+        // readers must not be alive when the map moves
+        auto moved_map = stdc::move(map);
+        REQUIRE(moved_map.insert(1, 1).is_success());
+        auto reader = moved_map.reader().ref_or_panic();
+        REQUIRE(reader.contains(1));
+    }
+
+    TEST_CASE("allocation failure leaves the map unchanged")
+    {
+        REQUIRE(!concurrent_hashmap::empty<int, int>(
+                     c_allocator, {.max_readers = 0})
+                     .unwrap()
+                     .reader());
+
+        uint8_t buffer[64];
+        arena_t tiny(buffer);
+        REQUIRE(!concurrent_hashmap::empty<int, int>(tiny).is_success());
+
+        uint8_t bigger[1 << 14];
+        arena_t arena(bigger);
+        auto map = concurrent_hashmap::empty<int, int>(
+                       arena, {.num_shards = 1, .max_readers = 1})
+                       .unwrap();
+        auto reader = map.reader().ref_or_panic();
+        int inserted = 0;
+        while (map.insert(inserted, inserted).is_success())
+            ++inserted;
+        REQUIRE(inserted > 0);
+        REQUIRE(map.size() == size_t(inserted));
+        for (int i = 0; i < inserted; ++i)
+            REQUIRE(reader.get(i).ref_unchecked().deref() == i);
+        REQUIRE(!reader.contains(inserted));
+
+        // the caller still owns an arc which failed to go in
+        auto zero = reader.get(0).ref_or_panic();
+        REQUIRE(!map.insert_arc(inserted, stdc::move(zero)).is_success());
+        REQUIRE(zero.deref() == 0);
+        REQUIRE(!reader.contains(inserted));
+    }
+
+    TEST_CASE("readers and writers at once")
+    {
+        constexpr int num_keys = 2000;
+        constexpr size_t num_readers = 6;
+        {
+            auto map = concurrent_hashmap::empty<int, counted_t>(
+                           c_allocator, {.num_shards = 4})
+                           .unwrap();
+            // even keys are always there and hold their own key
+            for (int i = 0; i < num_keys; i += 2)
+                REQUIRE(map.insert(i, i).is_success());
+
+            ok::atomic_t<bool> done;
+            ok::atomic_t<size_t> failures;
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < num_readers; ++t) {
+                threads.emplace_back([&, t] {
+                    auto reader = map.reader().ref_or_panic();
+                    while (!done.load()) {
+                        for (int i = int(t); i < num_keys; ++i) {
+                            if (i % 2 == 0) {
+                                auto value = reader.get(i);
+                                if (!value ||
+                                    value.ref_unchecked().deref().value != i)
+                                    failures.fetch_add(1);
+                            } else {
+                                reader.visit(i, [&](const counted_t& value) {
+                                    if (value.value % num_keys != i)
+                                        failures.fetch_add(1);
+                                });
+                            }
+                        }
+                    }
+                });
+            }
+
+            // odd keys come and go, and hold their key plus a multiple of
+            // num_keys
+            for (int round = 0; round < 50; ++round) {
+                for (int i = 1; i < num_keys; i += 2)
+                    REQUIRE(map.insert(i, i + round * num_keys).is_success());
+                for (int i = 1; i < num_keys; i += 4)
+                    REQUIRE(map.remove(i));
+            }
+            done.store(true);
+            for (auto& thread : threads)
+                thread.join();
+            REQUIRE(failures.load() == 0);
+        }
+        REQUIRE(counted_t::alive.load() == 0);
+    }
+}
@@ -0,0 +1,154 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/concurrent_segmented_list.h"
+#include "okay/iterables/indices.h"
+#include "testing_types.h"
+#include <thread>
+#include <vector>
+
+using namespace ok;
+
+TEST_SUITE("concurrent segmented list")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("single threaded append and read")
+    {
+        concurrent_segmented_list_t list =
+            concurrent_segmented_list::empty<size_t>(c_allocator).unwrap();
+        REQUIRE(list.is_empty());
+        REQUIREABORTS(list[0]);
+
+        for (size_t i = 0; i < 100; ++i) {
+            size_t& item = list.append(i).unwrap();
+            REQUIRE(item == i);
+            REQUIRE(list.size() == i + 1);
+        }
+
+        for (size_t i = 0; i < 100; ++i)
+            REQUIRE(list[i] == i);
+        REQUIRE_RANGES_EQUAL(list, indices().take_at_most(100));
+    }
+
+    TEST_CASE("items do not move when more are appended")
+    {
+        concurrent_segmented_list_t list =
+            concurrent_segmented_list::empty<int, 4>(c_allocator).unwrap();
+        int& first = list.append(1).unwrap();
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE(list.append(i).is_success());
+        REQUIRE(ok::addressof(first) == ok::addressof(list[0]));
+        REQUIRE(first == 1);
+    }
+
+    TEST_CASE("failed allocation does not claim an index")
+    {
+        // space for the first block of 4 ints and their ready flags, but not
+        // the second block
+        alignas(int) uint8_t bytes[32];
+        arena_t arena(bytes);
+        concurrent_segmented_list_t list =
+            concurrent_segmented_list::empty<int, 4>(arena).unwrap();
+
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(list.append(i).is_success());
+        REQUIRE(!list.append(4).is_success());
+        REQUIRE(list.size() == 4);
+        REQUIRE(!list.append(4).is_success());
+        REQUIRE(list.size() == 4);
+    }
+
+    TEST_CASE("destroys items")
+    {
+        counter_type::reset_counters();
+        {
+            concurrent_segmented_list_t list =
+                concurrent_segmented_list::empty<counter_type>(c_allocator)
+                    .unwrap();
+            for (int i = 0; i < 20; ++i)
+                REQUIRE(list.append().is_success());
+
+            concurrent_segmented_list_t moved(stdc::move(list));
+            REQUIRE(list.size() == 0);
+            REQUIRE(moved.size() == 20);
+        }
+        REQUIRE(counter_type::counters.destructs == 20);
+    }
+
+    TEST_CASE("many threads appending")
+    {
+        struct event_t
+        {
+            size_t thread;
+            size_t sequence;
+        };
+
+        concurrent_segmented_list_t list =
+            concurrent_segmented_list::empty<event_t, 16>(c_allocator)
+                .unwrap();
+
+        constexpr size_t num_threads = 8;
+        constexpr size_t per_thread = 20000;
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                for (size_t i = 0; i < per_thread; ++i) {
+                    if (!list.append(event_t{t, i}).is_success())
+                        std::abort();
+                }
+            });
+        }
+
+        // readers scan whatever has been committed while writers are going
+        std::thread reader([&] {
+            size_t last_size = 0;
+            while (last_size < num_threads * per_thread) {
+                size_t seen = 0;
+                for (const event_t& event : iter(list)) {
+                    if (event.thread >= num_threads ||
+                        event.sequence >= per_thread)
+                        std::abort();
+                    ++seen;
+                }
+                if (seen < last_size)
+                    std::abort();
+                last_size = seen;
+            }
+        });
+
+        for (auto& thread : threads)
+            thread.join();
+        reader.join();
+
+        REQUIRE(list.size() == num_threads * per_thread);
+
+        // every event shows up exactly once, and each thread's events are in
+        // the order it appended them
+        std::vector<size_t> next_sequence(num_threads, 0);
+        for (const event_t& event : iter(list)) {
+            REQUIRE(event.sequence == next_sequence[event.thread]);
+            ++next_sequence[event.thread];
+        }
+        for (size_t count : next_sequence)
+            REQUIRE(count == per_thread);
+    }
+
+    TEST_CASE("ensure_total_capacity_is_at_least")
+    {
+        // room for blocks of 4 and 8 ints plus their ready flags, not 16
+        alignas(int) uint8_t bytes[64];
+        arena_t arena(bytes);
+        concurrent_segmented_list_t list =
+            concurrent_segmented_list::empty<int, 4>(arena).unwrap();
+        REQUIRE(list.ensure_total_capacity_is_at_least(12).is_success());
+        REQUIRE(!list.ensure_total_capacity_is_at_least(13).is_success());
+
+        for (int i = 0; i < 12; ++i)
+            REQUIRE(list.append(i).is_success());
+        REQUIRE(list.size() == 12);
+        REQUIRE(!list.append(12).is_success());
+    }
+}
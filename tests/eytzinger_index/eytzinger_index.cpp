@@ -0,0 +1,108 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/eytzinger_index.h"
+#include "testing_types.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+template <typename T> slice<const T> slice_of(const std::vector<T>& vector)
+{
+    return raw_slice(*vector.data(), vector.size());
+}
+} // namespace
+
+TEST_SUITE("eytzinger index")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("searches match std::lower_bound and std::upper_bound")
+    {
+        // every size up to a few full levels, so every shape of last level
+        for (size_t size = 0; size < 70; ++size) {
+            std::vector<int> values;
+            for (size_t i = 0; i < size; ++i)
+                values.push_back(int(i / 2) * 3);
+
+            auto index = eytzinger_index::copy_items_from_sorted(
+                             c_allocator, slice_of(values))
+                             .unwrap();
+            REQUIRE(index.size() == size);
+
+            for (int needle = -1; needle < int(size * 2); ++needle) {
+                const auto lower =
+                    std::lower_bound(values.begin(), values.end(), needle);
+                const auto upper =
+                    std::upper_bound(values.begin(), values.end(), needle);
+
+                opt<const int&> found_lower = index.lower_bound(needle);
+                REQUIRE(found_lower.has_value() == (lower != values.end()));
+                if (found_lower)
+                    REQUIRE(found_lower.ref_unchecked() == *lower);
+
+                opt<const int&> found_upper = index.upper_bound(needle);
+                REQUIRE(found_upper.has_value() == (upper != values.end()));
+                if (found_upper)
+                    REQUIRE(found_upper.ref_unchecked() == *upper);
+
+                REQUIRE(index.contains(needle) == (lower != upper));
+            }
+        }
+    }
+
+    TEST_CASE("find by key")
+    {
+        struct entry_t
+        {
+            int key;
+            int value;
+        };
+        std::vector<entry_t> entries;
+        for (int i = 0; i < 1000; ++i)
+            entries.push_back({i * 2, i});
+
+        auto index = eytzinger_index::copy_items_from_sorted(c_allocator,
+                                                             slice_of(entries))
+                         .unwrap();
+        const auto by_key = [](const entry_t& entry, int key) {
+            return ok::cmp(entry.key, key);
+        };
+
+        REQUIRE(index.find(500, by_key).ref_unchecked().value == 250);
+        REQUIRE(!index.find(501, by_key));
+        REQUIRE(index.lower_bound(501, by_key).ref_unchecked().value == 251);
+        REQUIRE(!index.upper_bound(1998, by_key));
+    }
+
+    TEST_CASE("destroys copied items")
+    {
+        counter_type::reset_counters();
+        {
+            std::vector<counter_type> items(10);
+            counter_type::reset_counters();
+            auto index = eytzinger_index::copy_items_from_sorted(
+                             c_allocator, slice_of(items))
+                             .unwrap();
+            REQUIRE(counter_type::counters.copy_constructs == 10);
+
+            auto moved = stdc::move(index);
+            REQUIRE(index.size() == 0);
+            REQUIRE(moved.size() == 10);
+        }
+        REQUIRE(counter_type::counters.destructs == 20);
+    }
+
+    TEST_CASE("allocation failure")
+    {
+        std::vector<int> values(100, 0);
+        uint8_t bytes[64];
+        arena_t arena(bytes);
+        REQUIRE(
+            !eytzinger_index::copy_items_from_sorted(arena, slice_of(values))
+                 .is_success());
+    }
+}
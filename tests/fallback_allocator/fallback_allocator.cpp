@@ -0,0 +1,140 @@
+#include "test_header.h"
+// test header must be first
+#include "allocator_tests.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/allocators/fallback_allocator.h"
+#include "okay/allocators/page_allocator.h"
+#include "okay/containers/arraylist.h"
+
+using namespace ok;
+
+TEST_SUITE("fallback allocator")
+{
+    TEST_CASE("allocator tests")
+    {
+        c_allocator_t backing;
+        run_allocator_tests_static_and_dynamic_dispatch([&] {
+            return ok::opt<fallback_allocator_t<512>>(ok::in_place, backing);
+        });
+        run_allocator_tests_static_and_dynamic_dispatch([&] {
+            return ok::opt<fallback_allocator_t<8>>(ok::in_place, backing);
+        });
+    }
+
+    TEST_CASE("features include the backing allocator's size hint needs")
+    {
+        using flags = alloc::feature_flags;
+        c_allocator_t c_allocator;
+        fallback_allocator_t<64> over_c(c_allocator);
+        REQUIRE((over_c.features() & flags::can_reclaim));
+        REQUIRE(!(over_c.features() & flags::needs_accurate_sizehint));
+
+        page_allocator_t page_allocator;
+        fallback_allocator_t<64> over_pages(page_allocator);
+        REQUIRE((over_pages.features() & flags::can_reclaim));
+        REQUIRE((over_pages.features() & flags::needs_accurate_sizehint));
+    }
+
+    TEST_CASE("small allocations are served inline")
+    {
+        c_allocator_t c_allocator;
+        memory_resource_counter_wrapper_t backing(c_allocator);
+        fallback_allocator_t<256> fallback(backing);
+
+        bytes_t a = fallback.allocate({.num_bytes = 64}).unwrap();
+        bytes_t b = fallback.allocate({.num_bytes = 64}).unwrap();
+        REQUIRE(fallback.inline_buffer_contains(a.address_of_first()));
+        REQUIRE(fallback.inline_buffer_contains(b.address_of_first()));
+        REQUIRE(backing.bytes_allocated == 0);
+
+        fallback.deallocate(b.address_of_first());
+        fallback.deallocate(a.address_of_first());
+        REQUIRE(fallback.inline_bytes_remaining() == 256);
+    }
+
+    TEST_CASE("allocations spill to the backing allocator")
+    {
+        c_allocator_t c_allocator;
+        memory_resource_counter_wrapper_t backing(c_allocator);
+        fallback_allocator_t<128> fallback(backing);
+
+        bytes_t a = fallback.allocate({.num_bytes = 100}).unwrap();
+        REQUIRE(fallback.inline_buffer_contains(a.address_of_first()));
+
+        bytes_t b = fallback.allocate({.num_bytes = 100}).unwrap();
+        REQUIRE(!fallback.inline_buffer_contains(b.address_of_first()));
+        REQUIRE(backing.bytes_allocated >= 100);
+
+        // freeing both routes correctly by address
+        fallback.deallocate(b.address_of_first());
+        fallback.deallocate(a.address_of_first());
+        REQUIRE(fallback.inline_bytes_remaining() == 128);
+    }
+
+    TEST_CASE("freeing the most recent inline allocation gives back its bytes")
+    {
+        c_allocator_t backing;
+        fallback_allocator_t<256> fallback(backing);
+
+        bytes_t a = fallback.allocate({.num_bytes = 16}).unwrap();
+        const size_t remaining = fallback.inline_bytes_remaining();
+        bytes_t b = fallback.allocate({.num_bytes = 16}).unwrap();
+        REQUIRE(fallback.inline_bytes_remaining() < remaining);
+        fallback.deallocate(b.address_of_first());
+        REQUIRE(fallback.inline_bytes_remaining() == remaining);
+        fallback.deallocate(a.address_of_first());
+    }
+
+    TEST_CASE("reallocate inline then spill")
+    {
+        c_allocator_t backing;
+        fallback_allocator_t<64> fallback(backing);
+
+        bytes_t a = fallback.allocate({.num_bytes = 16}).unwrap();
+        for (size_t i = 0; i < a.size(); ++i)
+            a[i] = i;
+
+        bytes_t grown = fallback
+                            .reallocate({
+                                .memory = a,
+                                .new_size_bytes = 32,
+                            })
+                            .unwrap();
+        REQUIRE(grown.address_of_first() == a.address_of_first());
+
+        bytes_t spilled = fallback
+                              .reallocate({
+                                  .memory = grown,
+                                  .new_size_bytes = 1024,
+                              })
+                              .unwrap();
+        REQUIRE(!fallback.inline_buffer_contains(spilled.address_of_first()));
+        REQUIRE(spilled.size() >= 1024);
+        for (size_t i = 0; i < 16; ++i)
+            REQUIRE(spilled[i] == i);
+        for (size_t i = 16; i < 1024; ++i)
+            REQUIRE(spilled[i] == 0);
+
+        REQUIRE(fallback.inline_bytes_remaining() == 64);
+        fallback.deallocate(spilled.address_of_first());
+    }
+
+    TEST_CASE("arraylist using fallback allocator")
+    {
+        c_allocator_t c_allocator;
+        memory_resource_counter_wrapper_t backing(c_allocator);
+        fallback_allocator_t<sizeof(int) * 16> fallback(backing);
+
+        arraylist_t list = arraylist::empty<int>(fallback);
+        for (int i = 0; i < 8; ++i)
+            list.append(i).or_panic();
+        REQUIRE(backing.bytes_allocated == 0);
+
+        for (int i = 8; i < 100; ++i)
+            list.append(i).or_panic();
+        REQUIRE(backing.bytes_allocated > 0);
+
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(list[i] == i);
+    }
+}
@@ -0,0 +1,51 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/math/fast_divisor.h"
+#include <random>
+
+using namespace ok;
+
+static_assert(fast_divisor_t(7).divide(100) == 14);
+static_assert(fast_divisor_t(64).divide(1000) == 15);
+static_assert(fast_divisor_t(3).round_down_to_multiple(100) == 99);
+static_assert(static_divisor_t<24>().round_down_to_multiple(50) == 48);
+
+TEST_SUITE("fast divisor")
+{
+    TEST_CASE("powers of two are shifts")
+    {
+        for (uint64_t i = 0; i < 64; ++i) {
+            const fast_divisor_t divisor(uint64_t(1) << i);
+            REQUIRE(divisor.is_power_of_two());
+            REQUIRE(divisor.divide(~uint64_t(0)) == ~uint64_t(0) >> i);
+        }
+        REQUIRE(!fast_divisor_t(3).is_power_of_two());
+    }
+
+    TEST_CASE("matches regular division")
+    {
+        std::mt19937_64 rng(0);
+        const auto check = [](uint64_t divisor, uint64_t numerator) {
+            const fast_divisor_t fast(divisor);
+            REQUIRE(fast.divide(numerator) == numerator / divisor);
+            REQUIRE(fast.round_down_to_multiple(numerator) ==
+                    (numerator / divisor) * divisor);
+        };
+
+        for (uint64_t divisor = 1; divisor < 2000; ++divisor) {
+            check(divisor, 0);
+            check(divisor, divisor - 1);
+            check(divisor, divisor);
+            check(divisor, ~uint64_t(0));
+            for (size_t i = 0; i < 16; ++i)
+                check(divisor, rng() >> (rng() % 64));
+        }
+
+        // large divisors, including ones which need the 65 bit magic number
+        for (size_t i = 0; i < 20000; ++i) {
+            const uint64_t divisor = (rng() >> (rng() % 64)) | 1;
+            check(divisor, rng());
+            check(divisor, rng() >> (rng() % 64));
+        }
+    }
+}
@@ -0,0 +1,208 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/flat_map.h"
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+/// Owns its name, so that moving items around in the map is checked by
+/// address sanitizer.
+struct owned_name_t
+{
+    std::string name;
+
+    owned_name_t(const char* n) : name(n) {}
+
+    friend auto operator<=>(const owned_name_t& lhs,
+                            const owned_name_t& rhs) = default;
+    friend bool operator==(const owned_name_t& lhs,
+                           const owned_name_t& rhs) = default;
+
+    friend auto operator<=>(const owned_name_t& lhs, const char* rhs)
+    {
+        return lhs.name <=> std::string_view(rhs);
+    }
+};
+
+/// Returns the same pseudorandom sequence every time.
+struct lcg_t
+{
+    uint64_t state = 0x2545f4914f6cdd1d;
+
+    uint64_t next()
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    }
+};
+
+template <typename map_t>
+void require_same(const map_t& map, const std::map<int, int>& expected)
+{
+    REQUIRE(map.size() == expected.size());
+    auto it = expected.begin();
+    for (const auto& [key, value] : map.iter()) {
+        REQUIRE(key == it->first);
+        REQUIRE(value == it->second);
+        ++it;
+    }
+    REQUIRE(it == expected.end());
+}
+} // namespace
+
+TEST_SUITE("flat_map_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("insert, get and remove")
+    {
+        flat_map_t<int, int> map(c_allocator);
+        REQUIRE(map.is_empty());
+        REQUIRE(!map.contains(1));
+        REQUIRE(!map.get(1));
+        REQUIRE(!map.remove(1));
+        REQUIRE(map.keys().is_empty());
+
+        std::map<int, int> expected;
+        lcg_t random;
+        for (int i = 0; i < 2000; ++i) {
+            const int key = int(random.next() % 1000);
+            REQUIRE(map.insert(key, i).unwrap() == i);
+            expected[key] = i;
+        }
+        require_same(map, expected);
+
+        for (int key = 0; key < 1000; key += 3) {
+            REQUIRE(map.remove(key) == (expected.erase(key) == 1));
+            REQUIRE(!map.contains(key));
+        }
+        require_same(map, expected);
+
+        REQUIRE(map.get_or_insert(1, 5).unwrap() == expected[1]);
+        REQUIRE(map.get_or_insert(-1, 5).unwrap() == 5);
+        expected[-1] = 5;
+        map.get(-1).ref_or_panic() = 6;
+        expected[-1] = 6;
+        require_same(map, expected);
+
+        // keys and values are each contiguous
+        REQUIRE(map.keys().size() == map.values().size());
+        REQUIRE(map.keys().first() == -1);
+        REQUIRE(map.values().first() == 6);
+
+        map.clear();
+        REQUIRE(map.is_empty());
+        REQUIRE(!map.contains(-1));
+    }
+
+    TEST_CASE("owning keys and heterogeneous lookup")
+    {
+        flat_map_t<owned_name_t, int> map(c_allocator);
+        REQUIRE(map.insert(owned_name_t("pear"), 3).is_success());
+        REQUIRE(map.insert(owned_name_t("apple"), 1).is_success());
+        REQUIRE(map.insert(owned_name_t("banana"), 2).is_success());
+        REQUIRE(map.get("apple").ref_or_panic() == 1);
+        REQUIRE(map.contains("pear"));
+        REQUIRE(!map.contains("cherry"));
+        REQUIRE(map.remove("banana"));
+        REQUIRE(map.keys().first().name == "apple");
+        REQUIRE(map.keys().last().name == "pear");
+    }
+
+    TEST_CASE("from_unsorted sorts and keeps the last duplicate")
+    {
+        int keys[] = {5, 1, 9, 1, 5, 3, 5};
+        int values[] = {0, 1, 2, 3, 4, 5, 6};
+        auto map = flat_map::from_unsorted<int, int>(c_allocator,
+                                                     zip(keys, values))
+                       .unwrap();
+        require_same(map, {{1, 3}, {3, 5}, {5, 6}, {9, 2}});
+
+        int none[1] = {};
+        auto empty = flat_map::from_unsorted<int, int>(
+                         c_allocator, zip(raw_slice(*none, 0),
+                                          raw_slice(*none, 0)))
+                         .unwrap();
+        REQUIRE(empty.is_empty());
+    }
+
+    TEST_CASE("insert_iterator merges with the items already there")
+    {
+        std::map<int, int> expected;
+        flat_map_t<int, int> map(c_allocator);
+        lcg_t random;
+        for (int round = 0; round < 20; ++round) {
+            std::vector<int> keys;
+            std::vector<int> values;
+            for (int i = 0; i < 300; ++i) {
+                keys.push_back(int(random.next() % 3000));
+                values.push_back(round * 1000 + i);
+                expected[keys.back()] = values.back();
+            }
+            REQUIRE(map.insert_iterator(
+                           zip(raw_slice(*keys.data(), keys.size()),
+                               raw_slice(*values.data(), values.size())))
+                        .is_success());
+            require_same(map, expected);
+        }
+    }
+
+    TEST_CASE("iterators are arraylike and can be narrowed")
+    {
+        flat_map_t<int, int> map(c_allocator);
+        for (int i = 0; i < 100; i += 10)
+            REQUIRE(map.insert(i, i * 2).is_success());
+
+        auto all = map.iter();
+        static_assert(arraylike_iterable_c<decltype(all)>);
+        REQUIRE(ok::size(all) == 10);
+
+        int previous = 1000;
+        for (const auto& [key, value] : map.iter().reverse()) {
+            REQUIRE(key < previous);
+            REQUIRE(value == key * 2);
+            previous = key;
+        }
+
+        int seen = 0;
+        for (const auto& [key, value] : map.iter_between(15, 45)) {
+            REQUIRE(key == 20 + seen * 10);
+            ++seen;
+        }
+        REQUIRE(seen == 3);
+        REQUIRE(ok::size(map.iter_between(45, 15)) == 0);
+        REQUIRE(ok::size(map.iter_between(200, 300)) == 0);
+        REQUIRE(ok::size(map.iter_from(70)) == 3);
+        REQUIRE(ok::size(map.iter_from(91)) == 0);
+
+        // values can be changed through the iterator
+        for (auto [key, value] : map.iter_from(50))
+            value = -key;
+        REQUIRE(map.get(50).ref_or_panic() == -50);
+        REQUIRE(map.get(40).ref_or_panic() == 80);
+    }
+
+    TEST_CASE("allocation failure leaves the map unchanged")
+    {
+        uint8_t buffer[2048];
+        arena_t arena(buffer);
+        flat_map_t<int, int, arena_t> map(arena);
+        int inserted = 0;
+        while (map.insert(inserted, inserted).is_success())
+            ++inserted;
+        REQUIRE(inserted > 0);
+        REQUIRE(map.keys().size() == map.values().size());
+
+        int keys[] = {-1, -2, -3};
+        REQUIRE(!map.insert_iterator(zip(keys, keys)).is_success());
+        REQUIRE(map.size() == size_t(inserted));
+        for (int i = 0; i < inserted; ++i)
+            REQUIRE(map.get(i).ref_or_panic() == i);
+        REQUIRE(!map.contains(-1));
+    }
+}
@@ -0,0 +1,93 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/flat_set.h"
+#include <iterator>
+#include <set>
+#include <vector>
+
+using namespace ok;
+
+TEST_SUITE("flat_set_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("insert, contains and remove")
+    {
+        flat_set_t<int> set(c_allocator);
+        REQUIRE(set.is_empty());
+        REQUIRE(!set.contains(0));
+        REQUIRE(!set.remove(0));
+
+        REQUIRE(set.insert(3).unwrap());
+        REQUIRE(set.insert(1).unwrap());
+        REQUIRE(!set.insert(3).unwrap());
+        REQUIRE(set.insert(2).unwrap());
+        REQUIRE(set.size() == 3);
+        REQUIRE(set.items().first() == 1);
+        REQUIRE(set.items().last() == 3);
+
+        REQUIRE(set.remove(2));
+        REQUIRE(!set.contains(2));
+        REQUIRE(set.contains(1));
+        REQUIRE(set.contains(3));
+
+        set.clear();
+        REQUIRE(set.is_empty());
+    }
+
+    TEST_CASE("from_unsorted and insert_iterator drop duplicates")
+    {
+        int keys[] = {8, 3, 8, 1, 3, 3, 9};
+        auto set =
+            flat_set::from_unsorted<int>(c_allocator, ok::iter(keys)).unwrap();
+        int expected[] = {1, 3, 8, 9};
+        REQUIRE_RANGES_EQUAL(set.iter(), ok::iter(expected));
+
+        std::set<int> reference(std::begin(keys), std::end(keys));
+        for (int round = 0; round < 10; ++round) {
+            std::vector<int> more;
+            for (int i = 0; i < 100; ++i) {
+                more.push_back((round * 37 + i * 11) % 500);
+                reference.insert(more.back());
+            }
+            REQUIRE(set.insert_iterator(
+                           ok::iter(raw_slice(*more.data(), more.size())))
+                        .is_success());
+            REQUIRE(set.size() == reference.size());
+            auto it = reference.begin();
+            for (int key : set.iter())
+                REQUIRE(key == *it++);
+        }
+    }
+
+    TEST_CASE("iterator is arraylike")
+    {
+        flat_set_t<int> set(c_allocator);
+        for (int i = 10; i > 0; --i)
+            REQUIRE(set.insert(i).is_success());
+        static_assert(arraylike_iterable_c<decltype(set.iter())>);
+        int expected = 10;
+        for (int key : set.iter().reverse())
+            REQUIRE(key == expected--);
+        REQUIRE(expected == 0);
+    }
+
+    TEST_CASE("allocation failure leaves the set unchanged")
+    {
+        uint8_t buffer[1024];
+        arena_t arena(buffer);
+        flat_set_t<int, arena_t> set(arena);
+        int inserted = 0;
+        while (set.insert(inserted).is_success())
+            ++inserted;
+        REQUIRE(inserted > 0);
+
+        int keys[] = {-1, -2, -3};
+        REQUIRE(!set.insert_iterator(ok::iter(keys)).is_success());
+        REQUIRE(set.size() == size_t(inserted));
+        REQUIRE(!set.contains(-1));
+        REQUIRE(set.contains(inserted - 1));
+    }
+}
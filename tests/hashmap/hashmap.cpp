@@ -0,0 +1,288 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/hashmap.h"
+#include "testing_types.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+/// Counts how many are alive, to check that the map destroys everything it
+/// constructs.
+struct counted_t
+{
+    static inline int64_t alive = 0;
+    int value;
+
+    counted_t(int v) : value(v) { ++alive; }
+    counted_t(const counted_t& other) : value(other.value) { ++alive; }
+    counted_t(counted_t&& other) : value(other.value) { ++alive; }
+    counted_t& operator=(const counted_t&) = default;
+    counted_t& operator=(counted_t&&) = default;
+    ~counted_t() { --alive; }
+};
+
+/// A key which owns its characters, and can be looked up with an ascii_view
+/// without making one.
+struct owned_name_t
+{
+    std::string chars;
+
+    [[nodiscard]] ascii_view view() const
+    {
+        return ascii_view::from_raw(chars.data(), chars.size());
+    }
+
+    friend bool operator==(const owned_name_t& lhs, const owned_name_t& rhs)
+    {
+        return lhs.chars == rhs.chars;
+    }
+
+    friend bool operator==(const owned_name_t& lhs, const ascii_view& rhs)
+    {
+        return lhs.view() == rhs;
+    }
+};
+
+struct name_hasher_t
+{
+    uint64_t operator()(const owned_name_t& name) const
+    {
+        return ok::hasher_t{}(name.view());
+    }
+
+    uint64_t operator()(const ascii_view& view) const
+    {
+        return ok::hasher_t{}(view);
+    }
+};
+
+/// Puts every key in the same group, so that probing is always needed.
+struct terrible_hasher_t
+{
+    uint64_t operator()(int key) const { return uint64_t(key % 3); }
+};
+} // namespace
+
+TEST_SUITE("hashmap_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("group matching")
+    {
+        using namespace hashmap::detail;
+        alignas(16) ctrl_t ctrl[16];
+        for (size_t i = 0; i < 16; ++i)
+            ctrl[i] = ctrl_t(i % 3 == 0 ? ctrl_empty : i);
+        ctrl[4] = ctrl_deleted;
+        ctrl[5] = 9;
+
+        const auto slots_of = [](auto mask) {
+            std::vector<size_t> out;
+            for (; mask; mask.remove_lowest())
+                out.push_back(mask.lowest());
+            return out;
+        };
+
+        const auto portable = portable_group_t::load(ctrl);
+        REQUIRE(slots_of(portable.match(9)) == std::vector<size_t>{5});
+        REQUIRE(slots_of(portable.match_empty()) ==
+                std::vector<size_t>{0, 3, 6});
+        REQUIRE(slots_of(portable.match_empty_or_deleted()) ==
+                std::vector<size_t>{0, 3, 4, 6});
+        REQUIRE(slots_of(portable.match_full()) ==
+                std::vector<size_t>{1, 2, 5, 7});
+
+        const auto group = group_t::load(ctrl);
+        REQUIRE(slots_of(group.match(9)) == std::vector<size_t>{5});
+        REQUIRE(slots_of(group.match_empty()).size() ==
+                (group_t::width == 16 ? 6 : 3));
+        REQUIRE(slots_of(group.match_full()).size() ==
+                (group_t::width == 16 ? 9 : 4));
+    }
+
+    TEST_CASE("matches std::unordered_map under random operations")
+    {
+        hashmap_t<uint64_t, uint64_t, c_allocator_t> map(c_allocator);
+        std::unordered_map<uint64_t, uint64_t> expected;
+        uint64_t state = 88172645463325252ULL;
+
+        for (size_t i = 0; i < 200000; ++i) {
+            const uint64_t random = next_random(state);
+            // a small key space so that keys are often reinserted and removed
+            const uint64_t key = random % 5000;
+            switch ((random >> 32) % 4) {
+            case 0:
+            case 1:
+                REQUIRE(map.insert(key, i).unwrap() == i);
+                expected[key] = i;
+                break;
+            case 2:
+                REQUIRE(map.remove(key) == bool(expected.erase(key)));
+                break;
+            case 3: {
+                opt<uint64_t&> found = map.get(key);
+                auto iter = expected.find(key);
+                REQUIRE(bool(found) == (iter != expected.end()));
+                if (found)
+                    REQUIRE(found.ref_unchecked() == iter->second);
+                break;
+            }
+            }
+            REQUIRE(map.size() == expected.size());
+        }
+
+        size_t visited = 0;
+        for (auto [key, value] : map.iter()) {
+            REQUIRE(expected.at(key) == value);
+            ++visited;
+        }
+        REQUIRE(visited == expected.size());
+    }
+
+    TEST_CASE("get_or_insert, insert and remove")
+    {
+        hashmap_t<int, counted_t, c_allocator_t> map(c_allocator);
+        {
+            REQUIRE(map.is_empty());
+            REQUIRE(!map.contains(1));
+            REQUIRE(!map.remove(1));
+            REQUIRE(!map.get(1));
+
+            REQUIRE(map.get_or_insert(1, 10).unwrap().value == 10);
+            // already there, so the argument is unused
+            REQUIRE(map.get_or_insert(1, 20).unwrap().value == 10);
+            REQUIRE(map.insert(1, counted_t(30)).unwrap().value == 30);
+            REQUIRE(map.get(1).ref_unchecked().value == 30);
+            REQUIRE(map.size() == 1);
+
+            for (int i = 2; i < 1000; ++i)
+                REQUIRE(map.get_or_insert(i, i * 10).is_success());
+            REQUIRE(counted_t::alive == 999);
+            for (int i = 2; i < 1000; i += 2)
+                REQUIRE(map.remove(i));
+            REQUIRE(counted_t::alive == 500);
+            REQUIRE(map.size() == 500);
+            for (int i = 1; i < 1000; ++i) {
+                REQUIRE(map.contains(i) == (i == 1 || i % 2 == 1));
+            }
+
+            // values can be changed while iterating
+            for (auto [key, value] : map.iter())
+                value.value = -key;
+            const auto& const_map = map;
+            for (auto [key, value] : const_map.iter())
+                REQUIRE(value.value == -key);
+
+            map.clear();
+            REQUIRE(map.is_empty());
+            REQUIRE(counted_t::alive == 0);
+            REQUIRE(!map.contains(1));
+            REQUIRE(map.get_or_insert(5, 5).is_success());
+        }
+
+        auto moved = stdc::move(map);
+        REQUIRE(map.is_empty());
+        REQUIRE(!map.contains(5));
+        REQUIRE(moved.get(5).ref_unchecked().value == 5);
+        moved = hashmap_t<int, counted_t, c_allocator_t>(c_allocator);
+        REQUIRE(counted_t::alive == 0);
+    }
+
+    TEST_CASE("colliding hashes and deleted slots")
+    {
+        hashmap_t<int, int, c_allocator_t, terrible_hasher_t> map(c_allocator);
+        for (int round = 0; round < 20; ++round) {
+            for (int i = 0; i < 200; ++i)
+                REQUIRE(map.insert(i, i + round).is_success());
+            for (int i = 0; i < 200; ++i)
+                REQUIRE(map.get(i).ref_unchecked() == i + round);
+            for (int i = 0; i < 200; i += 3)
+                REQUIRE(map.remove(i));
+            for (int i = 0; i < 200; ++i)
+                REQUIRE(map.contains(i) == (i % 3 != 0));
+        }
+        // removing and reinserting over and over must not keep growing
+        REQUIRE(map.capacity() < 1024);
+    }
+
+    TEST_CASE("heterogeneous lookup")
+    {
+        hashmap_t<ascii_view, int, c_allocator_t> views(c_allocator);
+        REQUIRE(views.insert("apple", 1).is_success());
+        REQUIRE(views.insert(ascii_view("banana"), 2).is_success());
+        REQUIRE(views.get("apple").ref_unchecked() == 1);
+        REQUIRE(views.contains(ascii_view("banana")));
+        REQUIRE(!views.contains("cherry"));
+
+        hashmap_t<owned_name_t, int, c_allocator_t, name_hasher_t> names(
+            c_allocator);
+        REQUIRE(names.insert(owned_name_t{"a rather long name which is not "
+                                          "stored inline by std::string"},
+                             7)
+                    .is_success());
+        REQUIRE(names
+                    .get(ascii_view("a rather long name which is not "
+                                    "stored inline by std::string"))
+                    .ref_unchecked() == 7);
+        REQUIRE(names.remove(ascii_view("a rather long name which is not "
+                                        "stored inline by std::string")));
+        REQUIRE(names.is_empty());
+    }
+
+    TEST_CASE("default hasher")
+    {
+        const hasher_t hasher;
+        REQUIRE(hasher(ascii_view("hello")) == hasher("hello"));
+        REQUIRE(hasher(ascii_view("hello")) != hasher("hellp"));
+        REQUIRE(hasher(1) != hasher(2));
+        REQUIRE(hasher(uint8_t(1)) == hasher(uint64_t(1)));
+
+        // every length takes a slightly different path
+        std::vector<char> bytes(200);
+        for (size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = char(i * 7);
+        std::vector<uint64_t> hashes;
+        for (size_t length = 0; length <= bytes.size(); ++length) {
+            const uint64_t hash = hash_bytes(bytes.data(), length);
+            for (uint64_t other : hashes)
+                REQUIRE(hash != other);
+            hashes.push_back(hash);
+            // changing the last byte changes the hash
+            if (length > 0) {
+                bytes[length - 1] ^= 1;
+                REQUIRE(hash_bytes(bytes.data(), length) != hash);
+                bytes[length - 1] ^= 1;
+            }
+        }
+    }
+
+    TEST_CASE("reserve and allocation failure")
+    {
+        hashmap_t<int, int, c_allocator_t> map(c_allocator);
+        REQUIRE(map.capacity() == 0);
+        REQUIRE(map.reserve(1000).is_success());
+        const size_t capacity = map.capacity();
+        REQUIRE(capacity >= 1000);
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE(map.insert(i, i).is_success());
+        REQUIRE(map.capacity() == capacity);
+
+        uint8_t buffer[512];
+        arena_t arena(buffer);
+        hashmap_t<int, int, arena_t> small(arena);
+        REQUIRE(!small.reserve(1000).is_success());
+        size_t inserted = 0;
+        while (small.insert(int(inserted), 0).is_success())
+            ++inserted;
+        // the failed insert left everything which was there before
+        REQUIRE(small.size() == inserted);
+        for (size_t i = 0; i < inserted; ++i)
+            REQUIRE(small.contains(int(i)));
+        REQUIRE(!small.contains(int(inserted)));
+    }
+}
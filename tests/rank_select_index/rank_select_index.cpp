@@ -0,0 +1,95 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/rank_select_index.h"
+#include <vector>
+
+using namespace ok;
+
+namespace {
+/// Bytes with roughly one bit in every one_in turned on.
+std::vector<uint8_t> random_bytes(size_t num_bytes, uint64_t one_in)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    std::vector<uint8_t> out(num_bytes);
+    for (size_t i = 0; i < num_bytes * 8; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        if (state % one_in == 0)
+            out[i / 8] |= uint8_t(1) << (i % 8);
+    }
+    return out;
+}
+
+const_bit_slice_t bits_of(const std::vector<uint8_t>& bytes, size_t num_bits,
+                          uint8_t offset = 0)
+{
+    return raw_bit_slice(raw_slice(*bytes.data(), bytes.size()), num_bits,
+                         offset);
+}
+} // namespace
+
+TEST_SUITE("rank_select_index_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("rank and select match a linear scan")
+    {
+        // enough bits on in the dense ones to use several select samples
+        for (uint64_t one_in : {1, 2, 7, 300}) {
+            const std::vector<uint8_t> bytes = random_bytes(12500, one_in);
+            // unaligned and with a partial last block
+            const const_bit_slice_t bits = bits_of(bytes, 99000, 3);
+
+            auto index =
+                rank_select_index::for_bits(c_allocator, bits).unwrap();
+            REQUIRE(index.count_ones() == bits.popcount());
+
+            size_t ones = 0;
+            for (size_t i = 0; i < bits.size(); ++i) {
+                REQUIRE(index.rank1(i) == ones);
+                REQUIRE(index.rank0(i) == i - ones);
+                if (bits.get_bit(i)) {
+                    REQUIRE(index.select1(ones).ref_unchecked() == i);
+                    ++ones;
+                }
+            }
+            REQUIRE(index.rank1(bits.size()) == ones);
+            REQUIRE(!index.select1(ones));
+            REQUIREABORTS(auto rank = index.rank1(bits.size() + 1));
+        }
+    }
+
+    TEST_CASE("empty and all zero bits")
+    {
+        const std::vector<uint8_t> bytes(300, 0);
+
+        auto empty =
+            rank_select_index::for_bits(c_allocator, bits_of(bytes, 0))
+                .unwrap();
+        REQUIRE(empty.count_ones() == 0);
+        REQUIRE(empty.rank1(0) == 0);
+        REQUIRE(!empty.select1(0));
+
+        auto zeroes =
+            rank_select_index::for_bits(c_allocator, bits_of(bytes, 2400))
+                .unwrap();
+        REQUIRE(zeroes.rank1(2399) == 0);
+        REQUIRE(zeroes.rank0(2400) == 2400);
+        REQUIRE(!zeroes.select1(0));
+
+        auto moved = stdc::move(zeroes);
+        REQUIRE(moved.rank0(100) == 100);
+    }
+
+    TEST_CASE("allocation failure")
+    {
+        const std::vector<uint8_t> bytes(4096, 0xff);
+        uint8_t buffer[64];
+        arena_t arena(buffer);
+        REQUIRE(!rank_select_index::for_bits(arena, bits_of(bytes, 32768))
+                     .is_success());
+    }
+}
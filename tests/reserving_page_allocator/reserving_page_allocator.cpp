@@ -1,6 +1,7 @@
 #include "okay/defer.h"
 #include "test_header.h"
 // test header must be first
+#include "okay/allocators/page_allocator.h"
 #include "okay/allocators/reserving_page_allocator.h"
 
 using namespace ok;
@@ -110,4 +111,39 @@ TEST_SUITE("reserving page allocator")
             REQUIRE(!bigmem_reallocate_res.is_success());
         }
     }
+
+    TEST_CASE("numa placement")
+    {
+        REQUIRE(numa::node_count() >= 1);
+        REQUIRE(numa::current_node() < numa::node_count());
+
+        const numa::placement_t placements[] = {
+            numa::placement_t{},
+            numa::placement_t::local(),
+            numa::placement_t::bind_to(numa::current_node()),
+            numa::placement_t::prefer(numa::current_node()),
+            numa::placement_t::interleave_across(
+                (uint64_t(1) << numa::node_count()) - 1),
+        };
+
+        for (const numa::placement_t& placement : placements) {
+            reserving_page_allocator_t ally(
+                {.pages_reserved = 4, .placement = placement});
+            const auto res = ally.allocate({.num_bytes = 1});
+            bytes_t mem = OKAYLIB_REQUIRE_RES_WITH_BACKTRACE(res);
+            defer f = [&] { free_res(ally, mem); };
+            mem[0] = 1;
+
+            page_allocator_t page_ally({.placement = placement});
+            const size_t page_size = mmap::get_page_size();
+            const auto page_res = page_ally.allocate({.num_bytes = page_size});
+            bytes_t page = OKAYLIB_REQUIRE_RES_WITH_BACKTRACE(page_res);
+            page[0] = 1;
+            page_ally.deallocate(page.address_of_first(), page.size());
+        }
+
+        // thread policy can be set and then put back
+        REQUIRE(numa::set_thread_placement(numa::placement_t::local()) == 0);
+        REQUIRE(numa::set_thread_placement({}) == 0);
+    }
 }
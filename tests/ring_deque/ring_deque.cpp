@@ -0,0 +1,218 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/ring_deque.h"
+#include <deque>
+#include <string>
+
+using namespace ok;
+
+namespace {
+/// Returns the same pseudorandom sequence every time.
+struct lcg_t
+{
+    uint64_t state = 0x2545f4914f6cdd1d;
+
+    uint64_t next()
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    }
+};
+
+template <typename deque_t, typename T>
+void require_same(deque_t& deque, const std::deque<T>& expected)
+{
+    REQUIRE(deque.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+        REQUIRE(deque[i] == expected[i]);
+
+    // the two runs together hold every item in order
+    auto [first, second] = deque.as_slices();
+    REQUIRE(first.size() + second.size() == expected.size());
+    REQUIRE((second.is_empty() || first.size() != 0));
+    for (size_t i = 0; i < first.size(); ++i)
+        REQUIRE(first[i] == expected[i]);
+    for (size_t i = 0; i < second.size(); ++i)
+        REQUIRE(second[i] == expected[first.size() + i]);
+}
+
+template <typename T, typename make_t> void push_and_pop(const make_t& make)
+{
+    c_allocator_t c_allocator;
+    auto deque = ring_deque::empty<T>(c_allocator);
+    std::deque<T> expected;
+    lcg_t random;
+    for (int i = 0; i < 20000; ++i) {
+        switch (random.next() % 5) {
+        case 0:
+        case 1:
+            REQUIRE(deque.push_back(make(i)).unwrap() == make(i));
+            expected.push_back(make(i));
+            break;
+        case 2:
+            REQUIRE(deque.push_front(make(i)).unwrap() == make(i));
+            expected.push_front(make(i));
+            break;
+        case 3: {
+            opt<T> popped = deque.pop_front();
+            REQUIRE(bool(popped) == !expected.empty());
+            if (popped) {
+                REQUIRE(popped.ref_unchecked() == expected.front());
+                expected.pop_front();
+            }
+            break;
+        }
+        case 4: {
+            opt<T> popped = deque.pop_back();
+            REQUIRE(bool(popped) == !expected.empty());
+            if (popped) {
+                REQUIRE(popped.ref_unchecked() == expected.back());
+                expected.pop_back();
+            }
+            break;
+        }
+        }
+        if (i % 1000 == 0)
+            require_same(deque, expected);
+    }
+    require_same(deque, expected);
+    REQUIRE(ok::is_power_of_two(deque.capacity()));
+}
+} // namespace
+
+TEST_SUITE("ring_deque_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("push and pop at both ends")
+    {
+        push_and_pop<int>([](int i) { return i; });
+        // strings are not trivially relocatable, so growing moves them one
+        // at a time
+        push_and_pop<std::string>([](int i) {
+            return std::string("a string which is long enough to allocate ") +
+                   std::to_string(i);
+        });
+    }
+
+    TEST_CASE("empty deque")
+    {
+        auto deque = ring_deque::empty<int>(c_allocator);
+        REQUIRE(deque.is_empty());
+        REQUIRE(deque.capacity() == 0);
+        REQUIRE(!deque.pop_front());
+        REQUIRE(!deque.pop_back());
+        REQUIRE(ok::size(deque.iter()) == 0);
+        auto [first, second] = deque.as_slices();
+        REQUIRE(first.is_empty());
+        REQUIRE(second.is_empty());
+        REQUIREABORTS(deque.first());
+        REQUIREABORTS(deque[0]);
+    }
+
+    TEST_CASE("growing keeps the order of wrapped items")
+    {
+        for (size_t popped = 0; popped < 8; ++popped) {
+            auto deque =
+                ring_deque::spots_preallocated<int>(c_allocator, 8).unwrap();
+            REQUIRE(deque.capacity() == 8);
+            std::deque<int> expected;
+            // move the head along, so that the next pushes wrap around
+            for (size_t i = 0; i < popped; ++i)
+                REQUIRE(deque.push_back(-1).is_success());
+            for (size_t i = 0; i < popped; ++i)
+                REQUIRE(deque.pop_front().ref_or_panic() == -1);
+            for (int i = 0; i < 8; ++i) {
+                REQUIRE(deque.push_back(i).is_success());
+                expected.push_back(i);
+            }
+            REQUIRE(deque.capacity() == 8);
+            require_same(deque, expected);
+
+            REQUIRE(deque.push_back(8).is_success());
+            expected.push_back(8);
+            REQUIRE(deque.capacity() == 16);
+            require_same(deque, expected);
+        }
+    }
+
+    TEST_CASE("growing does not move items which do not wrap")
+    {
+        uint8_t buffer[4096];
+        arena_t arena(buffer);
+        auto deque = ring_deque::spots_preallocated<int>(arena, 4).unwrap();
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(deque.push_back(i).is_success());
+        REQUIRE(deque.pop_front().ref_or_panic() == 0);
+        REQUIRE(deque.reserve(64).is_success());
+        REQUIRE(deque.capacity() == 64);
+
+        // the items are still one slot into the buffer: one more fits in
+        // front of them before pushing to the front wraps around
+        REQUIRE(deque.push_front(-1).is_success());
+        REQUIRE(deque.as_slices().second.is_empty());
+        REQUIRE(deque.push_front(-2).is_success());
+        REQUIRE(deque.as_slices().first.size() == 1);
+        REQUIRE(deque.as_slices().second.size() == 4);
+        require_same(deque, std::deque<int>{-2, -1, 1, 2, 3});
+    }
+
+    TEST_CASE("iterator is arraylike")
+    {
+        auto deque = ring_deque::spots_preallocated<int>(c_allocator, 8)
+                         .unwrap();
+        for (int i = 0; i < 5; ++i)
+            REQUIRE(deque.push_back(i).is_success());
+        for (int i = 1; i <= 3; ++i)
+            REQUIRE(deque.push_front(-i).is_success());
+        // -3 -2 -1 0 1 2 3 4, wrapped around the end of the buffer
+        REQUIRE(!deque.as_slices().second.is_empty());
+
+        auto iterator = deque.iter();
+        static_assert(arraylike_iterable_c<decltype(iterator)>);
+        REQUIRE(ok::size(iterator) == 8);
+
+        int expected = -3;
+        for (int item : deque.iter())
+            REQUIRE(item == expected++);
+        for (int item : deque.iter().reverse())
+            REQUIRE(item == --expected);
+        REQUIRE(expected == -3);
+
+        for (int& item : deque.iter())
+            item *= 10;
+        REQUIRE(deque.first() == -30);
+        REQUIRE(deque.last() == 40);
+
+        const auto& const_deque = deque;
+        int sum = 0;
+        for (const int& item : const_deque.iter())
+            sum += item;
+        REQUIRE(sum == 40);
+    }
+
+    TEST_CASE("moving and allocation failure")
+    {
+        auto deque = ring_deque::empty<std::string>(c_allocator);
+        REQUIRE(deque.push_back("first").is_success());
+        auto moved = stdc::move(deque);
+        REQUIRE(deque.is_empty());
+        REQUIRE(moved.first() == "first");
+        deque = stdc::move(moved);
+        REQUIRE(deque.last() == "first");
+
+        uint8_t buffer[256];
+        arena_t arena(buffer);
+        auto small = ring_deque::empty<int>(arena);
+        size_t pushed = 0;
+        while (small.push_front(int(pushed)).is_success())
+            ++pushed;
+        // grew past the first allocation before running out
+        REQUIRE(pushed > 4);
+        REQUIRE(small.size() == pushed);
+        for (size_t i = 0; i < pushed; ++i)
+            REQUIRE(small.pop_back().ref_or_panic() == int(i));
+    }
+}
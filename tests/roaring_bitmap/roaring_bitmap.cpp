@@ -0,0 +1,333 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/arena.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/roaring_bitmap.h"
+#include "testing_types.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+template <typename allocator_t>
+std::vector<uint32_t> values_of(const roaring_bitmap_t<allocator_t>& bitmap)
+{
+    std::vector<uint32_t> out;
+    for (uint32_t value : bitmap.iter())
+        out.push_back(value);
+    return out;
+}
+
+/// Sorted and without duplicates.
+std::vector<uint32_t> normalized(std::vector<uint32_t> values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+/// Values which end up in each kind of container: a sparse chunk, a dense
+/// chunk, a chunk with long runs, a chunk right at the array size limit, and
+/// the very top of the range.
+std::vector<uint32_t> mixed_values(uint64_t seed)
+{
+    uint64_t state = seed;
+    std::vector<uint32_t> out;
+    for (int i = 0; i < 1000; ++i)
+        out.push_back(uint32_t(next_random(state) % 65536));
+    for (int i = 0; i < 30000; ++i)
+        out.push_back((1u << 16) | uint32_t(next_random(state) % 65536));
+    for (uint32_t start = 0; start < 65536; start += 1000) {
+        const uint32_t length = uint32_t(next_random(state) % 700);
+        for (uint32_t i = 0; i < length; ++i)
+            out.push_back((5u << 16) | (start + i));
+    }
+    for (uint32_t i = 0; i < 4096; ++i)
+        out.push_back((9u << 16) | (i * 16 + uint32_t(seed % 16)));
+    for (uint32_t i = 0; i < 100; ++i)
+        out.push_back(0xffffffffu - uint32_t(next_random(state) % 200));
+    return normalized(out);
+}
+
+template <typename allocator_t>
+roaring_bitmap_t<allocator_t> bitmap_of(allocator_t& allocator,
+                                        const std::vector<uint32_t>& values,
+                                        bool optimize)
+{
+    roaring_bitmap_t<allocator_t> bitmap(allocator);
+    for (uint32_t value : values)
+        REQUIRE(bitmap.insert(value).is_success());
+    if (optimize)
+        REQUIRE(bitmap.optimize_runs().is_success());
+    return bitmap;
+}
+} // namespace
+
+TEST_SUITE("roaring_bitmap_t")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("insert, contains and remove match a sorted vector")
+    {
+        const std::vector<uint32_t> values = mixed_values(1);
+        roaring_bitmap_t bitmap(c_allocator);
+        REQUIRE(bitmap.is_empty());
+
+        for (uint32_t value : values)
+            REQUIRE(bitmap.insert(value).is_success());
+        // inserting again changes nothing
+        for (size_t i = 0; i < values.size(); i += 7)
+            REQUIRE(bitmap.insert(values[i]).is_success());
+
+        REQUIRE(bitmap.cardinality() == values.size());
+        REQUIRE(values_of(bitmap) == values);
+        for (uint32_t value : {0u, 65535u, 65536u, 5u << 16, 0xffffffffu,
+                               (9u << 16) | 3u, 123456789u}) {
+            REQUIRE(bitmap.contains(value) ==
+                    std::binary_search(values.begin(), values.end(), value));
+        }
+
+        // remove every other value, which turns the dense chunk back into
+        // an array
+        std::vector<uint32_t> remaining;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i % 2 == 0)
+                REQUIRE(bitmap.remove(values[i]).is_success());
+            else
+                remaining.push_back(values[i]);
+        }
+        REQUIRE(bitmap.remove(7).is_success());
+        REQUIRE(bitmap.cardinality() == remaining.size());
+        REQUIRE(values_of(bitmap) == remaining);
+
+        for (uint32_t value : remaining)
+            REQUIRE(bitmap.remove(value).is_success());
+        REQUIRE(bitmap.is_empty());
+        REQUIRE(values_of(bitmap).empty());
+    }
+
+    TEST_CASE("insert_range and run containers")
+    {
+        roaring_bitmap_t bitmap(c_allocator);
+        REQUIRE(bitmap.insert_range(100, 200000).is_success());
+        REQUIRE(bitmap.insert_range(0xfffffff0u, 0xffffffffu).is_success());
+        REQUIRE(bitmap.cardinality() == 200000 - 100 + 1 + 16);
+        REQUIRE(!bitmap.contains(99));
+        REQUIRE(bitmap.contains(100));
+        REQUIRE(bitmap.contains(65536));
+        REQUIRE(bitmap.contains(200000));
+        REQUIRE(!bitmap.contains(200001));
+        REQUIRE(bitmap.contains(0xffffffffu));
+        // one run per chunk
+        REQUIRE(bitmap.serialized_size() < 100);
+
+        // splitting, shrinking and joining runs
+        REQUIRE(bitmap.remove(1000).is_success());
+        REQUIRE(bitmap.remove(100).is_success());
+        REQUIRE(bitmap.remove(200000).is_success());
+        REQUIRE(!bitmap.contains(1000));
+        REQUIRE(bitmap.contains(999));
+        REQUIRE(bitmap.contains(1001));
+        REQUIRE(bitmap.cardinality() == 200000 - 100 + 1 + 16 - 3);
+        REQUIRE(bitmap.insert(1000).is_success());
+        REQUIRE(bitmap.insert(50).is_success());
+        REQUIRE(bitmap.insert_range(40, 60).is_success());
+        REQUIRE(bitmap.cardinality() == 200000 - 100 + 1 + 16 - 2 + 21);
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 40; i <= 60; ++i)
+            expected.push_back(i);
+        for (uint32_t i = 101; i < 200000; ++i)
+            expected.push_back(i);
+        for (uint32_t i = 0xfffffff0u; i != 0; ++i)
+            expected.push_back(i);
+        REQUIRE(values_of(bitmap) == expected);
+
+        // a run container split into too many runs becomes a bitmap
+        for (uint32_t i = 65536; i < 2 * 65536; i += 2)
+            REQUIRE(bitmap.remove(i).is_success());
+        REQUIRE(bitmap.cardinality() == expected.size() - 32768);
+
+        REQUIREABORTS(auto status = bitmap.insert_range(10, 9));
+    }
+
+    TEST_CASE("optimize_runs keeps the values and saves space")
+    {
+        std::vector<uint32_t> values;
+        for (uint32_t start = 0; start < 2000000; start += 5000)
+            for (uint32_t i = 0; i < 3000; ++i)
+                values.push_back(start + i);
+
+        roaring_bitmap_t bitmap = bitmap_of(c_allocator, values, false);
+        const size_t before = bitmap.serialized_size();
+        REQUIRE(bitmap.optimize_runs().is_success());
+        REQUIRE(bitmap.serialized_size() * 20 < before);
+        REQUIRE(values_of(bitmap) == values);
+
+        // and back, once the runs are broken up
+        for (size_t i = 0; i < values.size(); i += 2)
+            REQUIRE(bitmap.remove(values[i]).is_success());
+        REQUIRE(bitmap.optimize_runs().is_success());
+        std::vector<uint32_t> odd;
+        for (size_t i = 1; i < values.size(); i += 2)
+            odd.push_back(values[i]);
+        REQUIRE(values_of(bitmap) == odd);
+        REQUIRE(bitmap.serialized_size() < odd.size() * 2 + 2000);
+    }
+
+    TEST_CASE("set operations between every kind of container")
+    {
+        const std::vector<uint32_t> a_values = mixed_values(1);
+        const std::vector<uint32_t> b_values = mixed_values(2);
+
+        std::vector<uint32_t> expected_union;
+        std::set_union(a_values.begin(), a_values.end(), b_values.begin(),
+                       b_values.end(), std::back_inserter(expected_union));
+        std::vector<uint32_t> expected_intersection;
+        std::set_intersection(a_values.begin(), a_values.end(),
+                              b_values.begin(), b_values.end(),
+                              std::back_inserter(expected_intersection));
+        std::vector<uint32_t> expected_difference;
+        std::set_difference(a_values.begin(), a_values.end(),
+                            b_values.begin(), b_values.end(),
+                            std::back_inserter(expected_difference));
+
+        // with and without run containers on either side
+        for (int optimize = 0; optimize < 4; ++optimize) {
+            const bool optimize_a = optimize & 1;
+            const bool optimize_b = optimize & 2;
+            const roaring_bitmap_t b =
+                bitmap_of(c_allocator, b_values, optimize_b);
+
+            roaring_bitmap_t a = bitmap_of(c_allocator, a_values, optimize_a);
+            REQUIRE(a.union_with(b).is_success());
+            REQUIRE(a.cardinality() == expected_union.size());
+            REQUIRE(values_of(a) == expected_union);
+
+            a = bitmap_of(c_allocator, a_values, optimize_a);
+            REQUIRE(a.intersect_with(b).is_success());
+            REQUIRE(a.cardinality() == expected_intersection.size());
+            REQUIRE(values_of(a) == expected_intersection);
+
+            a = bitmap_of(c_allocator, a_values, optimize_a);
+            REQUIRE(a.subtract(b).is_success());
+            REQUIRE(a.cardinality() == expected_difference.size());
+            REQUIRE(values_of(a) == expected_difference);
+        }
+    }
+
+    TEST_CASE("set operations with ranges, empty bitmaps and themselves")
+    {
+        const std::vector<uint32_t> values = mixed_values(3);
+        roaring_bitmap_t a = bitmap_of(c_allocator, values, false);
+        roaring_bitmap_t empty(c_allocator);
+
+        REQUIRE(a.union_with(empty).is_success());
+        REQUIRE(a.union_with(a).is_success());
+        REQUIRE(a.intersect_with(a).is_success());
+        REQUIRE(a.subtract(empty).is_success());
+        REQUIRE(values_of(a) == values);
+
+        REQUIRE(empty.union_with(a).is_success());
+        REQUIRE(values_of(empty) == values);
+        REQUIRE(empty.subtract(empty).is_success());
+        REQUIRE(empty.is_empty());
+
+        // everything but the first few chunks
+        roaring_bitmap_t range(c_allocator);
+        REQUIRE(range.insert_range(65536 * 5 + 10, 0xffffffffu).is_success());
+        REQUIRE(a.intersect_with(range).is_success());
+        std::vector<uint32_t> expected;
+        for (uint32_t value : values)
+            if (value >= 65536 * 5 + 10)
+                expected.push_back(value);
+        REQUIRE(values_of(a) == expected);
+
+        REQUIRE(a.union_with(range).is_success());
+        REQUIRE(a.cardinality() == 0x100000000ull - (65536 * 5 + 10));
+        REQUIRE(a.subtract(range).is_success());
+        REQUIRE(a.is_empty());
+    }
+
+    TEST_CASE("serialize and deserialize")
+    {
+        const std::vector<uint32_t> values = mixed_values(4);
+        const roaring_bitmap_t bitmap = bitmap_of(c_allocator, values, true);
+
+        std::vector<uint8_t> buffer(bitmap.serialized_size());
+        REQUIRE(bitmap.serialize_into(raw_slice(*buffer.data(),
+                                                buffer.size())) ==
+                buffer.size());
+        const slice<const uint8_t> bytes =
+            raw_slice(*static_cast<const uint8_t*>(buffer.data()),
+                      buffer.size());
+
+        auto loaded = roaring_bitmap::deserialize(c_allocator, bytes);
+        REQUIRE(loaded.is_success());
+        REQUIRE(values_of(loaded.unwrap()) == values);
+        REQUIRE(loaded.unwrap().serialized_size() == buffer.size());
+
+        const auto status_of = [&](const std::vector<uint8_t>& modified) {
+            return roaring_bitmap::deserialize(
+                       c_allocator,
+                       raw_slice(*static_cast<const uint8_t*>(modified.data()),
+                                 modified.size()))
+                .status();
+        };
+        using roaring_bitmap::deserialize_error;
+
+        std::vector<uint8_t> truncated(buffer.begin(), buffer.end() - 1);
+        REQUIRE(status_of(truncated) == deserialize_error::malformed);
+        std::vector<uint8_t> bad_magic = buffer;
+        bad_magic[0] ^= 1;
+        REQUIRE(status_of(bad_magic) == deserialize_error::malformed);
+        // swap the first two values of the first container, an array
+        std::vector<uint8_t> unsorted = buffer;
+        const size_t first_payload = 8 + 8 * size_t(buffer[4]);
+        std::swap(unsorted[first_payload], unsorted[first_payload + 2]);
+        std::swap(unsorted[first_payload + 1], unsorted[first_payload + 3]);
+        REQUIRE(status_of(unsorted) == deserialize_error::malformed);
+        std::vector<uint8_t> bad_kind = buffer;
+        bad_kind[8 + 2] = 7;
+        REQUIRE(status_of(bad_kind) == deserialize_error::malformed);
+
+        const roaring_bitmap_t empty(c_allocator);
+        std::vector<uint8_t> empty_buffer(empty.serialized_size());
+        REQUIRE(empty.serialize_into(raw_slice(*empty_buffer.data(),
+                                               empty_buffer.size())) == 8);
+        auto loaded_empty = roaring_bitmap::deserialize(
+            c_allocator, raw_slice(*static_cast<const uint8_t*>(
+                                       empty_buffer.data()),
+                                   empty_buffer.size()));
+        REQUIRE(loaded_empty.unwrap().is_empty());
+
+        REQUIREABORTS(auto written = bitmap.serialize_into(
+                          raw_slice(*buffer.data(), buffer.size() - 1)));
+    }
+
+    TEST_CASE("copy and allocation failure")
+    {
+        const std::vector<uint32_t> values = mixed_values(5);
+        const roaring_bitmap_t bitmap = bitmap_of(c_allocator, values, true);
+
+        auto copied = roaring_bitmap::copy(c_allocator, bitmap);
+        REQUIRE(copied.is_success());
+        REQUIRE(values_of(copied.unwrap()) == values);
+        REQUIRE(copied.unwrap().insert(3).is_success());
+        REQUIRE(!bitmap.contains(3));
+
+        uint8_t buffer[1024];
+        arena_t arena(buffer);
+        REQUIRE(!roaring_bitmap::copy(arena, bitmap).is_success());
+
+        // running out partway through leaves a valid superset of the original
+        roaring_bitmap_t small(arena);
+        REQUIRE(small.insert(1).is_success());
+        REQUIRE(!small.union_with(bitmap).is_success());
+        REQUIRE(small.contains(1));
+        for (uint32_t value : values_of(small))
+            REQUIRE((value == 1 || bitmap.contains(value)));
+    }
+}
@@ -0,0 +1,159 @@
+#include "test_header.h"
+// test header must be first
+#include "allocator_tests.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/allocators/sampling_allocator.h"
+#include "okay/containers/arraylist.h"
+#include <cstdio>
+
+using namespace ok;
+
+TEST_SUITE("sampling allocator")
+{
+    TEST_CASE("allocator tests")
+    {
+        c_allocator_t backing;
+        c_allocator_t bookkeeping;
+        run_allocator_tests_static_and_dynamic_dispatch([&] {
+            return ok::opt<sampling_allocator_t>(
+                ok::in_place, backing, bookkeeping,
+                sampling_allocator::options_t{.mean_bytes_between_samples =
+                                                  256});
+        });
+    }
+
+    TEST_CASE("samples are taken roughly every mean_bytes_between_samples")
+    {
+        c_allocator_t backing;
+        c_allocator_t bookkeeping;
+        sampling_allocator_t sampler(backing, bookkeeping,
+                                     {.mean_bytes_between_samples = 1024});
+
+        auto list = arraylist::empty<void*>(backing);
+        constexpr size_t num_allocations = 10000;
+        constexpr size_t allocation_size = 64;
+        for (size_t i = 0; i < num_allocations; ++i) {
+            list.append(sampler.allocate({.num_bytes = allocation_size})
+                            .unwrap()
+                            .address_of_first())
+                .or_panic();
+        }
+
+        // expect ~625 samples
+        const size_t expected = (num_allocations * allocation_size) / 1024;
+        REQUIRE(sampler.live_samples().size() > expected / 2);
+        REQUIRE(sampler.live_samples().size() < expected * 2);
+
+        size_t estimated_bytes = 0;
+        sampler.for_each_call_site(
+            [&](const sampling_allocator::call_site_summary_t& summary) {
+                REQUIRE(summary.num_live_samples > 0);
+                REQUIRE(summary.estimated_bytes >= summary.sampled_bytes);
+                estimated_bytes += summary.estimated_bytes;
+            });
+        const size_t actual_bytes = num_allocations * allocation_size;
+        REQUIRE(estimated_bytes > actual_bytes / 2);
+        REQUIRE(estimated_bytes < actual_bytes * 2);
+
+        // freeing everything removes all the samples
+        for (size_t i = 0; i < list.size(); ++i) {
+            sampler.deallocate(list[i]);
+        }
+        REQUIRE(sampler.live_samples().is_empty());
+    }
+
+    TEST_CASE("sampled allocations follow reallocation")
+    {
+        c_allocator_t backing;
+        c_allocator_t bookkeeping;
+        // sample every byte
+        sampling_allocator_t sampler(backing, bookkeeping,
+                                     {.mean_bytes_between_samples = 1});
+
+        bytes_t bytes = sampler.allocate({.num_bytes = 100}).unwrap();
+        REQUIRE(sampler.live_samples().size() == 1);
+        REQUIRE(sampler.live_samples()[0].memory == bytes.address_of_first());
+        REQUIRE(sampler.live_samples()[0].call_site.depth > 0);
+
+        bytes_t grown = sampler
+                            .reallocate({
+                                .memory = bytes,
+                                .new_size_bytes = 10000,
+                            })
+                            .unwrap();
+        REQUIRE(sampler.live_samples().size() == 1);
+        REQUIRE(sampler.live_samples()[0].memory == grown.address_of_first());
+        REQUIRE(sampler.live_samples()[0].num_bytes == grown.size());
+
+        sampler.deallocate(grown.address_of_first());
+        REQUIRE(sampler.live_samples().is_empty());
+    }
+
+    TEST_CASE("freeing in any order forgets exactly the freed samples")
+    {
+        c_allocator_t backing;
+        c_allocator_t bookkeeping;
+        sampling_allocator_t sampler(backing, bookkeeping,
+                                     {.mean_bytes_between_samples = 1});
+
+        constexpr size_t num_allocations = 2000;
+        auto live = arraylist::empty<void*>(backing);
+        for (size_t i = 0; i < num_allocations; ++i) {
+            live.append(sampler.allocate({.num_bytes = 16})
+                            .unwrap()
+                            .address_of_first())
+                .or_panic();
+        }
+        REQUIRE(sampler.live_samples().size() == num_allocations);
+
+        // free in a scrambled order, which moves samples around inside of the
+        // live sample list
+        for (size_t step = 0; step < num_allocations / 2; ++step) {
+            const size_t index = (step * 7919) % live.size();
+            sampler.deallocate(live[index]);
+            live.remove_and_swap_last(index);
+        }
+        // some frees of sampled memory which is then reallocated elsewhere
+        for (size_t i = 0; i < 50; ++i) {
+            void* const memory = live[i];
+            live[i] = sampler
+                          .reallocate({
+                              .memory = raw_slice(*(uint8_t*)memory, 16),
+                              .new_size_bytes = 4096,
+                          })
+                          .unwrap()
+                          .address_of_first();
+        }
+
+        REQUIRE(sampler.live_samples().size() == live.size());
+        for (size_t i = 0; i < live.size(); ++i) {
+            size_t found = 0;
+            for (const auto& sample : ok::iter(sampler.live_samples()))
+                found += sample.memory == live[i];
+            REQUIRE(found == 1);
+        }
+
+        for (size_t i = 0; i < live.size(); ++i)
+            sampler.deallocate(live[i]);
+        REQUIRE(sampler.live_samples().is_empty());
+    }
+
+    TEST_CASE("text profile")
+    {
+        c_allocator_t backing;
+        c_allocator_t bookkeeping;
+        sampling_allocator_t sampler(backing, bookkeeping,
+                                     {.mean_bytes_between_samples = 1});
+
+        arraylist_t list = arraylist::empty<int>(sampler);
+        for (int i = 0; i < 100; ++i)
+            list.append(i).or_panic();
+
+        REQUIRE(!sampler.live_samples().is_empty());
+
+        FILE* devnull = ::fopen("/dev/null", "w");
+        REQUIRE(devnull);
+        sampler.write_text_profile(devnull);
+        ::fclose(devnull);
+    }
+}
@@ -523,4 +523,159 @@ TEST_SUITE("segmented list")
         REQUIRE(list.ensure_total_capacity_is_at_least(10).is_success());
         REQUIRE(list.capacity() == 15);
     }
+
+    TEST_CASE("iteration walks across blocks")
+    {
+        auto res = segmented_list::empty<size_t>(c_allocator, {});
+        auto& list = res.unwrap();
+        for (size_t i = 0; i < 100; ++i)
+            REQUIRE(list.append(i).is_success());
+
+        size_t expected = 0;
+        for (size_t& item : iter(list)) {
+            REQUIRE(item == expected);
+            ++expected;
+        }
+        REQUIRE(expected == 100);
+
+        const auto& const_list = list;
+        REQUIRE_RANGES_EQUAL(const_list, indices().take_at_most(100));
+
+        // offsetting by more than one finds the right block again
+        auto iterator = ok::iter(list);
+        iterator.offset(37);
+        REQUIRE(iterator.access() == 37);
+        iterator.offset(-30);
+        REQUIRE(iterator.access() == 7);
+        iterator.offset(1);
+        REQUIRE(iterator.access() == 8);
+    }
+
+    TEST_CASE("blocks()")
+    {
+        auto res = segmented_list::empty<int>(c_allocator, {});
+        auto& list = res.unwrap();
+        REQUIRE(list.num_occupied_blocks() == 0);
+        REQUIRE(ok::size(list.blocks()) == 0);
+
+        for (int i = 0; i < 10; ++i)
+            REQUIRE(list.append(i).is_success());
+
+        // blocks of 1, 2, 4, and then 3 out of 8
+        REQUIRE(list.num_occupied_blocks() == 4);
+        maybe_undefined_array_t expected_sizes = {1, 2, 4, 3};
+        size_t num_items = 0;
+        for (auto [block, index] : list.blocks().enumerate()) {
+            REQUIRE(block.size() == expected_sizes[index]);
+            for (size_t i = 0; i < block.size(); ++i) {
+                REQUIRE(block[i] == int(num_items));
+                ++num_items;
+            }
+        }
+        REQUIRE(num_items == 10);
+
+        REQUIREABORTS(auto&& _ = list.block(4));
+
+        list.fill(3);
+        REQUIRE_RANGES_EQUAL(list, (maybe_undefined_array_t{3, 3, 3, 3, 3, 3,
+                                                            3, 3, 3, 3}));
+    }
+
+    TEST_CASE("copy_items_from_iterator fills whole blocks")
+    {
+        segmented_list_t list = segmented_list::copy_items_from_iterator(
+                                    c_allocator, indices().take_at_most(100))
+                                    .unwrap();
+        REQUIRE(list.size() == 100);
+        REQUIRE(list.capacity() == 127);
+        REQUIRE_RANGES_EQUAL(list, indices().take_at_most(100));
+
+        // still works after growing past the initial blocks
+        for (size_t i = 100; i < 200; ++i)
+            REQUIRE(list.append(i).is_success());
+        REQUIRE_RANGES_EQUAL(list, indices().take_at_most(200));
+    }
+
+    TEST_CASE("bigger first block")
+    {
+        static_assert(segmented_list::cache_line_first_block_size<int> == 16);
+        static_assert(segmented_list::cache_line_first_block_size<char> == 64);
+        static_assert(
+            segmented_list::cache_line_first_block_size<counter_type> == 64);
+        static_assert(
+            segmented_list::cache_line_first_block_size<bit_array_t<1000>> ==
+            1);
+
+        segmented_list_t list =
+            segmented_list::empty<int, 64>(c_allocator, {}).unwrap();
+        REQUIRE(list.capacity() == 0);
+
+        // only one allocation for the first 64 items
+        REQUIRE(list.append(0).is_success());
+        REQUIRE(list.capacity() == 64);
+        for (int i = 1; i < 64; ++i)
+            REQUIRE(list.append(i).is_success());
+        REQUIRE(list.capacity() == 64);
+        REQUIRE(list.num_occupied_blocks() == 1);
+
+        for (int i = 64; i < 300; ++i)
+            REQUIRE(list.append(i).is_success());
+        // blocks of 64, 128, 256
+        REQUIRE(list.capacity() == 448);
+        REQUIRE(list.num_occupied_blocks() == 3);
+        REQUIRE(list.block(0).size() == 64);
+        REQUIRE(list.block(1).size() == 128);
+        REQUIRE(list.block(2).size() == 108);
+        REQUIRE(list.block(2)[0] == 192);
+
+        for (int i = 0; i < 300; ++i)
+            REQUIRE(list[i] == i);
+        int expected = 0;
+        for (int& item : iter(list)) {
+            REQUIRE(item == expected);
+            ++expected;
+        }
+        REQUIRE(expected == 300);
+
+        // shifting items across block boundaries
+        REQUIRE(list.remove(10) == 10);
+        REQUIRE(list[63] == 64);
+        REQUIRE(list[64] == 65);
+        REQUIRE(list.insert_at(0, -1).is_success());
+        REQUIRE(list[0] == -1);
+        REQUIRE(list[64] == 64);
+        REQUIRE(list.last() == 299);
+
+        constexpr segmented_list::empty_options_t options{
+            .expected_max_capacity = 65,
+            .should_preallocate = true,
+        };
+        segmented_list_t preallocated =
+            segmented_list::empty<int, 64>(c_allocator, options).unwrap();
+        REQUIRE(preallocated.capacity() == 192);
+    }
+
+    TEST_CASE("bigger first block with nontrivial type")
+    {
+        counter_type::reset_counters();
+        {
+            segmented_list_t list =
+                segmented_list::empty<counter_type, 4>(c_allocator, {})
+                    .unwrap();
+            for (int i = 0; i < 20; ++i)
+                REQUIRE(list.append().is_success());
+            REQUIRE(list.capacity() == 28);
+            list.clear();
+            REQUIRE(counter_type::counters.destructs == 20);
+            REQUIRE(list.capacity() == 28);
+            for (int i = 0; i < 5; ++i)
+                REQUIRE(list.append().is_success());
+
+            segmented_list_t moved(stdc::move(list));
+            REQUIRE(list.capacity() == 0);
+            REQUIRE(list.size() == 0);
+            REQUIRE(moved.size() == 5);
+        }
+        REQUIRE(counter_type::counters.destructs == 25);
+    }
 }
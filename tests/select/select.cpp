@@ -0,0 +1,161 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/algorithm/select.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/iterables/indices.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+std::vector<int> random_values(size_t count, uint64_t mod)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    std::vector<int> out(count);
+    for (int& value : out) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        value = int(state % mod);
+    }
+    return out;
+}
+
+template <typename T> slice<T> slice_of(std::vector<T>& vector)
+{
+    return raw_slice(*vector.data(), vector.size());
+}
+
+std::vector<std::vector<int>> interesting_inputs(size_t size)
+{
+    std::vector<std::vector<int>> out;
+    out.push_back(random_values(size, 1000000));
+    out.push_back(random_values(size, 3));
+    std::vector<int> ascending(size);
+    for (size_t i = 0; i < size; ++i)
+        ascending[i] = int(i);
+    out.push_back(ascending);
+    out.push_back(std::vector<int>(ascending.rbegin(), ascending.rend()));
+    out.push_back(std::vector<int>(size, 5));
+    std::vector<int> organ_pipe(size);
+    for (size_t i = 0; i < size; ++i)
+        organ_pipe[i] = int(i < size / 2 ? i : size - i);
+    out.push_back(organ_pipe);
+    return out;
+}
+} // namespace
+
+TEST_SUITE("select")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("nth_element puts the right item in place")
+    {
+        for (size_t size : {1, 2, 5, 23, 24, 100, 1000, 50000}) {
+            for (const std::vector<int>& input : interesting_inputs(size)) {
+                std::vector<int> sorted = input;
+                std::sort(sorted.begin(), sorted.end());
+
+                for (size_t n : {size_t(0), size / 3, size / 2, size - 1}) {
+                    std::vector<int> values = input;
+                    ok::nth_element(slice_of(values), n);
+                    REQUIRE(values[n] == sorted[n]);
+                    for (size_t i = 0; i < n; ++i)
+                        REQUIRE(values[i] <= values[n]);
+                    for (size_t i = n + 1; i < size; ++i)
+                        REQUIRE(values[i] >= values[n]);
+                }
+            }
+        }
+    }
+
+    TEST_CASE("nth_element out of bounds")
+    {
+        std::vector<int> values = {1, 2, 3};
+        REQUIREABORTS(ok::nth_element(slice_of(values), 3));
+    }
+
+    TEST_CASE("partial_sort sorts the first k")
+    {
+        for (const std::vector<int>& input : interesting_inputs(10000)) {
+            std::vector<int> sorted = input;
+            std::sort(sorted.begin(), sorted.end());
+
+            for (size_t k : {0, 1, 2, 10, 500, 9999, 10000, 20000}) {
+                std::vector<int> values = input;
+                ok::partial_sort(slice_of(values), k);
+                for (size_t i = 0; i < k && i < values.size(); ++i)
+                    REQUIRE(values[i] == sorted[i]);
+
+                // the rest are still the same items
+                const size_t num_sorted = std::min(k, values.size());
+                std::vector<int> rest(values.begin() + num_sorted,
+                                      values.end());
+                std::sort(rest.begin(), rest.end());
+                REQUIRE(std::equal(rest.begin(), rest.end(),
+                                   sorted.begin() + num_sorted));
+            }
+        }
+    }
+
+    TEST_CASE("custom comparison")
+    {
+        std::vector<int> values = random_values(1000, 100);
+        const auto descending = [](const int& a, const int& b) {
+            return ok::cmp(b, a);
+        };
+
+        ok::nth_element(slice_of(values), 0, descending);
+        REQUIRE(values[0] == *std::max_element(values.begin(), values.end()));
+
+        ok::partial_sort(slice_of(values), 10, descending);
+        REQUIRE(std::is_sorted(values.begin(), values.begin() + 10,
+                               [](int a, int b) { return a > b; }));
+    }
+
+    TEST_CASE("top_k of an iterator")
+    {
+        auto top = ok::top_k(c_allocator, indices().take_at_most(1000), 5)
+                       .unwrap();
+        REQUIRE(top.size() == 5);
+        for (size_t i = 0; i < 5; ++i)
+            REQUIRE(top[i] == 999 - i);
+
+        // fewer items than k
+        auto all = ok::top_k(c_allocator, indices().take_at_most(3), 10)
+                       .unwrap();
+        REQUIRE(all.size() == 3);
+        REQUIRE(all[0] == 2);
+        REQUIRE(all[2] == 0);
+
+        auto none =
+            ok::top_k(c_allocator, indices().take_at_most(3), 0).unwrap();
+        REQUIRE(none.is_empty());
+    }
+
+    TEST_CASE("top_k with a comparator, by reference")
+    {
+        struct score_t
+        {
+            int points;
+            int player;
+        };
+        std::vector<score_t> scores;
+        for (int i = 0; i < 100; ++i)
+            scores.push_back({(i * 37) % 100, i});
+        const slice<score_t> all = slice_of(scores);
+
+        auto fewest_points =
+            ok::top_k(c_allocator, all, 3,
+                      [](const score_t& a, const score_t& b) {
+                          return ok::cmp(b.points, a.points);
+                      })
+                .unwrap();
+        REQUIRE(fewest_points.size() == 3);
+        REQUIRE(fewest_points[0].points == 0);
+        REQUIRE(fewest_points[1].points == 1);
+        REQUIRE(fewest_points[2].points == 2);
+        REQUIRE(fewest_points[1].player == 73);
+    }
+}
@@ -437,6 +437,104 @@ TEST_SUITE("slice")
             bs.toggle_bit(8);
             REQUIRE(bytes[1] == 0);
         }
+
+        SUBCASE("subslice() of an offset slice points at the right bits")
+        {
+            uint8_t bytes[] = {0b10110000, 0b00000101, 0, 0b10000000};
+            const const_bit_slice_t all =
+                raw_bit_slice(slice<const uint8_t>(bytes), 32, 0);
+
+            const const_bit_slice_t middle =
+                all.subslice({.start = 5, .length = 27});
+            REQUIRE(middle.size() == 27);
+            REQUIRE(middle.get_bit(0));
+            REQUIRE(!middle.get_bit(1));
+            REQUIRE(middle.get_bit(2));
+            REQUIRE(middle.get_bit(3));
+            REQUIRE(middle.get_bit(5));
+            REQUIRE(middle.get_bit(26));
+            REQUIRE(all.subslice({.start = 32, .length = 0}).is_empty());
+            REQUIREABORTS(auto s = all.subslice({.start = 30, .length = 3}));
+        }
+
+        SUBCASE("get_word() at any offset")
+        {
+            uint8_t bytes[20];
+            for (size_t i = 0; i < sizeof(bytes); ++i)
+                bytes[i] = uint8_t(i * 37 + 11);
+            const const_bit_slice_t all =
+                raw_bit_slice(slice<const uint8_t>(bytes), 160, 0);
+
+            for (size_t offset = 0; offset < 8; ++offset) {
+                const const_bit_slice_t bits = all.subslice(
+                    {.start = offset, .length = 150 - offset});
+                const size_t last = bits.size() - 1;
+                for (size_t start : {size_t(0), size_t(1), size_t(7),
+                                     size_t(8), size_t(63), size_t(64),
+                                     size_t(100), last}) {
+                    const uint64_t word = bits.get_word(start);
+                    for (size_t i = 0; i < 64; ++i) {
+                        const bool expected = start + i < bits.size() &&
+                                              bits.get_bit(start + i);
+                        REQUIRE(((word >> i) & 1) == expected);
+                    }
+                }
+            }
+        }
+
+        SUBCASE("popcount(), find_first_set() and find_first_unset()")
+        {
+            zeroed_array_t<uint8_t, 40> bytes{};
+            const bit_slice_t all =
+                raw_bit_slice(slice(bytes), bytes.items().size_bits(), 0);
+            // skip the first 3 bits so nothing is aligned
+            const bit_slice_t bits = all.subslice({.start = 3, .length = 300});
+
+            REQUIRE(bits.popcount() == 0);
+            REQUIRE(!bits.find_first_set());
+            REQUIRE(bits.find_first_unset().ref_unchecked() == 0);
+
+            for (size_t i : {5, 64, 65, 200, 299})
+                bits.set_bit(i, bit::on());
+            REQUIRE(bits.popcount() == 5);
+            REQUIRE(bits.find_first_set().ref_unchecked() == 5);
+            REQUIRE(bits.find_first_set(6).ref_unchecked() == 64);
+            REQUIRE(bits.find_first_set(66).ref_unchecked() == 200);
+            REQUIRE(bits.find_first_set(299).ref_unchecked() == 299);
+            REQUIRE(!bits.find_first_set(300));
+            REQUIREABORTS(auto found = bits.find_first_set(301));
+
+            for (size_t i = 0; i < bits.size(); ++i)
+                bits.set_bit(i, bit::on());
+            bits.set_bit(270, bit::off());
+            REQUIRE(bits.popcount() == 299);
+            REQUIRE(bits.find_first_unset().ref_unchecked() == 270);
+            REQUIRE(!bits.find_first_unset(271));
+            // the bits around the slice are not counted
+            REQUIRE(!all.get_bit(2));
+            REQUIRE(!all.get_bit(303));
+        }
+
+        SUBCASE("iter_set_bits()")
+        {
+            zeroed_array_t<uint8_t, 40> bytes{};
+            const bit_slice_t bits =
+                raw_bit_slice(slice(bytes), bytes.items().size_bits() - 1, 1);
+            const size_t expected[] = {0, 1, 63, 64, 127, 128, 250, 318};
+            for (size_t i : expected)
+                bits.set_bit(i, bit::on());
+
+            size_t num_visited = 0;
+            for (size_t idx : bits.iter_set_bits()) {
+                REQUIRE(num_visited < sizeof(expected) / sizeof(size_t));
+                REQUIRE(idx == expected[num_visited]);
+                ++num_visited;
+            }
+            REQUIRE(num_visited == sizeof(expected) / sizeof(size_t));
+
+            const bit_slice_t empty = bits.subslice({.start = 2, .length = 0});
+            REQUIRE(!empty.iter_set_bits().next());
+        }
     }
 
 #if defined(OKAYLIB_USE_FMT)
@@ -0,0 +1,293 @@
+#include "test_header.h"
+// test header must be first
+#include "allocator_tests.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/arraylist.h"
+#include "okay/containers/fixed_arraylist.h"
+#include "okay/containers/small_arraylist.h"
+#include "testing_types.h"
+
+using namespace ok;
+
+// not trivially relocatable, and remembers whether it is currently alive so
+// that assigning to or destroying a dead object can be caught
+struct liveness_checked
+{
+    static inline int live = 0;
+    bool alive;
+    int value;
+
+    liveness_checked(int v) : alive(true), value(v) { ++live; }
+    liveness_checked(liveness_checked&& other)
+        : alive(true), value(other.value)
+    {
+        REQUIRE(other.alive);
+        ++live;
+    }
+    liveness_checked& operator=(liveness_checked&& other)
+    {
+        REQUIRE(alive);
+        REQUIRE(other.alive);
+        value = other.value;
+        return *this;
+    }
+    ~liveness_checked()
+    {
+        REQUIRE(alive);
+        alive = false;
+        --live;
+    }
+
+    // fails for negative values, without constructing anything
+    struct maybe_failing
+    {
+        static constexpr auto implemented_make_function =
+            ok::implemented_make_function::make_into_uninit;
+
+        template <typename...>
+        using associated_type = liveness_checked;
+
+        alloc::error make_into_uninit(liveness_checked& uninit,
+                                      int value) const
+        {
+            if (value < 0)
+                return alloc::error::unsupported;
+            ok::stdc::construct_at(ok::addressof(uninit), value);
+            return alloc::error::success;
+        }
+    };
+};
+
+TEST_SUITE("small arraylist")
+{
+    TEST_CASE("stays inline until it overflows")
+    {
+        c_allocator_t c_allocator;
+        memory_resource_counter_wrapper_t backing(c_allocator);
+        small_arraylist_t list = small_arraylist::empty<int, 8>(backing);
+        REQUIRE(list.is_inline());
+        REQUIRE(list.capacity() == 8);
+
+        for (int i = 0; i < 8; ++i)
+            list.append(i).or_panic();
+        REQUIRE(list.is_inline());
+        REQUIRE(backing.bytes_allocated == 0);
+
+        list.append(8).or_panic();
+        REQUIRE(!list.is_inline());
+        REQUIRE(list.capacity() >= 16);
+        REQUIRE(backing.bytes_allocated > 0);
+
+        for (int i = 0; i < 9; ++i)
+            REQUIRE(list[i] == i);
+        REQUIRE(list.items().size() == 9);
+    }
+
+    TEST_CASE("insert and remove")
+    {
+        c_allocator_t backing;
+        small_arraylist_t list = small_arraylist::empty<int, 4>(backing);
+        list.append(1).or_panic();
+        list.append(3).or_panic();
+        list.insert_at(1, 2).or_panic();
+        list.insert_at(0, 0).or_panic();
+        // spills on this one
+        list.insert_at(2, 100).or_panic();
+
+        REQUIRE_RANGES_EQUAL(list.items(), (maybe_undefined_array_t{0, 1, 100, 2, 3}));
+        REQUIRE(list.remove(2) == 100);
+        REQUIRE_RANGES_EQUAL(list.items(), (maybe_undefined_array_t{0, 1, 2, 3}));
+        REQUIRE(list.remove_and_swap_last(0) == 0);
+        REQUIRE_RANGES_EQUAL(list.items(), (maybe_undefined_array_t{3, 1, 2}));
+        REQUIRE(list.pop_last().ref_or_panic() == 2);
+
+        list.shrink_to_reclaim_unused_memory();
+        REQUIRE(list.is_inline());
+        REQUIRE_RANGES_EQUAL(list.items(), (maybe_undefined_array_t{3, 1}));
+
+        size_t count = 0;
+        auto iterator = ok::iter(list);
+        while (auto item = iterator.next()) {
+            REQUIRE(item.ref_unchecked() == list[count]);
+            ++count;
+        }
+        REQUIRE(count == 2);
+    }
+
+    TEST_CASE("failed insert_at leaves nontrivial items intact")
+    {
+        c_allocator_t backing;
+        {
+            auto list = small_arraylist::empty<liveness_checked, 8>(backing);
+            for (int i = 0; i < 4; ++i)
+                list.append(i).or_panic();
+
+            constexpr liveness_checked::maybe_failing make{};
+            REQUIRE(!list.insert_at(1, make, -1).is_success());
+            REQUIRE(!list.insert_at(list.size(), make, -1).is_success());
+            REQUIRE(!list.insert_at(0, make, -1).is_success());
+            REQUIRE(list.size() == 4);
+            REQUIRE(liveness_checked::live == 4);
+            for (int i = 0; i < 4; ++i)
+                REQUIRE(list[i].value == i);
+
+            list.insert_at(2, make, 100).or_panic();
+            REQUIRE(list.size() == 5);
+            REQUIRE(list[2].value == 100);
+            REQUIRE(list[4].value == 3);
+        }
+        REQUIRE(liveness_checked::live == 0);
+    }
+
+    TEST_CASE("resize")
+    {
+        c_allocator_t backing;
+        small_arraylist_t list = small_arraylist::empty<int, 4>(backing);
+        list.resize(3, 7).or_panic();
+        REQUIRE(list.is_inline());
+        REQUIRE_RANGES_EQUAL(list.items(), (maybe_undefined_array_t{7, 7, 7}));
+        list.resize(10).or_panic();
+        REQUIRE(!list.is_inline());
+        REQUIRE(list.size() == 10);
+        REQUIRE(list[9] == 0);
+        list.resize(1).or_panic();
+        REQUIRE_RANGES_EQUAL(list.items(), (maybe_undefined_array_t{7}));
+    }
+
+    TEST_CASE("moving inline and heap lists")
+    {
+        c_allocator_t backing;
+
+        SUBCASE("inline")
+        {
+            counter_type::reset_counters();
+            {
+                auto list = small_arraylist::empty<counter_type, 4>(backing);
+                list.append().or_panic();
+                list.append().or_panic();
+                REQUIRE(list.is_inline());
+
+                small_arraylist_t moved = std::move(list);
+                REQUIRE(moved.is_inline());
+                REQUIRE(moved.size() == 2);
+                REQUIRE(list.size() == 0);
+                REQUIRE(list.is_inline());
+                // each item had to be moved individually
+                REQUIRE(counter_type::counters.move_constructs == 2);
+            }
+            REQUIRE(counter_type::counters.destructs ==
+                    counter_type::counters.default_constructs +
+                        counter_type::counters.move_constructs);
+        }
+
+        SUBCASE("heap")
+        {
+            counter_type::reset_counters();
+            {
+                auto list = small_arraylist::empty<counter_type, 2>(backing);
+                for (size_t i = 0; i < 5; ++i)
+                    list.append().or_panic();
+                REQUIRE(!list.is_inline());
+                const size_t moves_before = counter_type::counters.move_constructs;
+
+                small_arraylist_t moved = std::move(list);
+                REQUIRE(!moved.is_inline());
+                REQUIRE(moved.size() == 5);
+                REQUIRE(list.is_inline());
+                REQUIRE(list.is_empty());
+                // the heap allocation was stolen, nothing had to move
+                REQUIRE(counter_type::counters.move_constructs == moves_before);
+
+                // move assign an inline list over a heap one
+                auto other = small_arraylist::empty<counter_type, 2>(backing);
+                other.append().or_panic();
+                moved = std::move(other);
+                REQUIRE(moved.is_inline());
+                REQUIRE(moved.size() == 1);
+            }
+            REQUIRE(counter_type::counters.destructs ==
+                    counter_type::counters.default_constructs +
+                        counter_type::counters.move_constructs);
+        }
+    }
+
+    TEST_CASE("nontrivial items survive spilling")
+    {
+        c_allocator_t backing;
+        auto list = small_arraylist::empty<moveable_t, 2>(backing);
+        for (int i = 0; i < 20; ++i) {
+            list.append().or_panic();
+            list[i].whatever = i;
+        }
+        for (int i = 0; i < 20; ++i)
+            REQUIRE(list[i].whatever == i);
+        list.remove(0);
+        REQUIRE(list[0].whatever == 1);
+    }
+
+    TEST_CASE("allocations compared to arraylist_t and fixed_arraylist_t")
+    {
+        c_allocator_t c_allocator;
+        constexpr size_t num_lists = 1000;
+        constexpr size_t items_per_list = 6;
+
+        memory_resource_counter_wrapper_t small_backing(c_allocator);
+        memory_resource_counter_wrapper_t regular_backing(c_allocator);
+
+        for (size_t i = 0; i < num_lists; ++i) {
+            auto small = small_arraylist::empty<size_t, 8>(small_backing);
+            auto regular = arraylist::empty<size_t>(regular_backing);
+            fixed_arraylist_t<size_t, 8> fixed;
+            for (size_t j = 0; j < items_per_list; ++j) {
+                small.append(j).or_panic();
+                regular.append(j).or_panic();
+                REQUIRE(fixed.append(j));
+            }
+            REQUIRE_RANGES_EQUAL(small.items(), regular.items());
+            REQUIRE_RANGES_EQUAL(small.items(), fixed.items());
+        }
+
+        REQUIRE(small_backing.bytes_allocated == 0);
+        REQUIRE(regular_backing.bytes_allocated > 0);
+    }
+
+    // run with --no-skip to see timings
+    TEST_CASE("benchmark against arraylist_t and fixed_arraylist_t" *
+              doctest::skip())
+    {
+        c_allocator_t backing;
+        constexpr size_t num_lists = 1000000;
+        constexpr size_t items_per_list = 6;
+
+        size_t sum = 0;
+        const double small_ms = time_ms([&] {
+            for (size_t i = 0; i < num_lists; ++i) {
+                auto list = small_arraylist::empty<size_t, 8>(backing);
+                for (size_t j = 0; j < items_per_list; ++j)
+                    list.append(j).or_panic();
+                sum += list[i % items_per_list];
+            }
+        });
+        const double regular_ms = time_ms([&] {
+            for (size_t i = 0; i < num_lists; ++i) {
+                auto list = arraylist::empty<size_t>(backing);
+                for (size_t j = 0; j < items_per_list; ++j)
+                    list.append(j).or_panic();
+                sum += list[i % items_per_list];
+            }
+        });
+        const double fixed_ms = time_ms([&] {
+            for (size_t i = 0; i < num_lists; ++i) {
+                fixed_arraylist_t<size_t, 8> list;
+                for (size_t j = 0; j < items_per_list; ++j)
+                    REQUIRE(list.append(j));
+                sum += list.items()[i % items_per_list];
+            }
+        });
+
+        MESSAGE("small_arraylist_t: " << small_ms << "ms, arraylist_t: "
+                                      << regular_ms << "ms, fixed_arraylist_t: "
+                                      << fixed_ms << "ms (checksum " << sum
+                                      << ")");
+    }
+}
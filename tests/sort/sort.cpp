@@ -0,0 +1,256 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/algorithm/parallel_sort.h"
+#include "okay/algorithm/sort.h"
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/arraylist.h"
+#include "testing_types.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ok;
+
+namespace {
+struct xorshift_t
+{
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+template <typename T> std::vector<T> random_values(size_t count, uint64_t mod)
+{
+    xorshift_t rng;
+    std::vector<T> out(count);
+    for (T& value : out)
+        value = T(int64_t(rng.next() % mod) - int64_t(mod / 2));
+    return out;
+}
+
+template <typename T> slice<T> slice_of(std::vector<T>& vector)
+{
+    return raw_slice(*vector.data(), vector.size());
+}
+
+// the shapes of input that pdqsort has special cases for
+std::vector<std::vector<int>> interesting_inputs(size_t size)
+{
+    std::vector<std::vector<int>> out;
+    out.push_back(random_values<int>(size, 1000000));
+    out.push_back(random_values<int>(size, 4));
+    std::vector<int> ascending(size);
+    for (size_t i = 0; i < size; ++i)
+        ascending[i] = int(i);
+    out.push_back(ascending);
+    out.push_back(std::vector<int>(ascending.rbegin(), ascending.rend()));
+    out.push_back(std::vector<int>(size, 7));
+    std::vector<int> organ_pipe(size);
+    for (size_t i = 0; i < size; ++i)
+        organ_pipe[i] = int(i < size / 2 ? i : size - i);
+    out.push_back(organ_pipe);
+    std::vector<int> sawtooth(size);
+    for (size_t i = 0; i < size; ++i)
+        sawtooth[i] = int(i % 37);
+    out.push_back(sawtooth);
+    return out;
+}
+
+struct keyed_t
+{
+    int key;
+    int original_index;
+};
+} // namespace
+
+TEST_SUITE("sort")
+{
+    c_allocator_t c_allocator;
+
+    TEST_CASE("sort matches std::sort on many input shapes")
+    {
+        for (size_t size : {0, 1, 2, 3, 10, 24, 25, 100, 129, 1000, 100000}) {
+            for (std::vector<int>& input : interesting_inputs(size)) {
+                std::vector<int> expected = input;
+                std::sort(expected.begin(), expected.end());
+
+                std::vector<int> sorted = input;
+                ok::sort(slice_of(sorted));
+                REQUIRE(sorted == expected);
+
+                std::vector<int> stable = input;
+                REQUIRE(ok::stable_sort(c_allocator, slice_of(stable))
+                            .is_success());
+                REQUIRE(stable == expected);
+
+                std::vector<int> radix = input;
+                REQUIRE(ok::radix_sort(c_allocator, slice_of(radix))
+                            .is_success());
+                REQUIRE(radix == expected);
+            }
+        }
+    }
+
+    TEST_CASE("custom comparison")
+    {
+        std::vector<int> values = random_values<int>(1000, 100);
+        ok::sort(slice_of(values), [](const int& a, const int& b) {
+            return ok::cmp(b, a);
+        });
+        REQUIRE(std::is_sorted(values.rbegin(), values.rend()));
+
+        arraylist_t list = arraylist::empty<int>(c_allocator);
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(list.append((i * 37) % 100).is_success());
+        ok::sort(list.items());
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(list[i] == i);
+    }
+
+    TEST_CASE("sort non trivial types")
+    {
+        std::vector<moveable_t> items(200);
+        for (int i = 0; i < 200; ++i)
+            items[i].whatever = (i * 7919) % 200;
+
+        ok::sort_by_key(slice_of(items),
+                        [](const moveable_t& item) { return item.whatever; });
+        for (int i = 0; i < 200; ++i) {
+            REQUIRE(items[i].whatever == i);
+            REQUIRE(items[i].nothing != nullptr);
+        }
+
+        REQUIRE(ok::stable_sort(c_allocator, slice_of(items),
+                                [](const moveable_t& a, const moveable_t& b) {
+                                    return ok::cmp(b.whatever, a.whatever);
+                                })
+                    .is_success());
+        for (int i = 0; i < 200; ++i) {
+            REQUIRE(items[i].whatever == 199 - i);
+            REQUIRE(items[i].nothing != nullptr);
+        }
+    }
+
+    TEST_CASE("stable sorts keep the order of equal keys")
+    {
+        std::vector<keyed_t> items(5000);
+        xorshift_t rng;
+        for (size_t i = 0; i < items.size(); ++i)
+            items[i] = {int(rng.next() % 50) - 25, int(i)};
+
+        const auto check_stable = [](const std::vector<keyed_t>& sorted) {
+            for (size_t i = 1; i < sorted.size(); ++i) {
+                REQUIRE(sorted[i - 1].key <= sorted[i].key);
+                if (sorted[i - 1].key == sorted[i].key)
+                    REQUIRE(sorted[i - 1].original_index <
+                            sorted[i].original_index);
+            }
+        };
+
+        std::vector<keyed_t> merged = items;
+        REQUIRE(ok::stable_sort(c_allocator, slice_of(merged),
+                                [](const keyed_t& a, const keyed_t& b) {
+                                    return ok::cmp(a.key, b.key);
+                                })
+                    .is_success());
+        check_stable(merged);
+
+        std::vector<keyed_t> radix = items;
+        REQUIRE(ok::radix_sort_by_key(c_allocator, slice_of(radix),
+                                      [](const keyed_t& item) {
+                                          return item.key;
+                                      })
+                    .is_success());
+        check_stable(radix);
+    }
+
+    TEST_CASE("radix sort calls the key function once per item")
+    {
+        static_assert(detail::to_radix_bits(int8_t(-1)) == 0x7f);
+        static_assert(detail::to_radix_bits(-1.0f) <
+                      detail::to_radix_bits(1.0f));
+
+        for (size_t size : {10, 5000}) {
+            std::vector<keyed_t> items(size);
+            xorshift_t rng;
+            for (size_t i = 0; i < items.size(); ++i)
+                items[i] = {int(rng.next() % 100000) - 50000, int(i)};
+
+            size_t calls = 0;
+            REQUIRE(ok::radix_sort_by_key(c_allocator, slice_of(items),
+                                          [&calls](const keyed_t& item) {
+                                              ++calls;
+                                              return item.key;
+                                          })
+                        .is_success());
+            REQUIRE(calls == size);
+            for (size_t i = 1; i < items.size(); ++i)
+                REQUIRE(items[i - 1].key <= items[i].key);
+        }
+    }
+
+    TEST_CASE("radix sort of floats and wide integers")
+    {
+        std::vector<double> doubles = {3.5,  -0.0,  1e300, -1e300, 0.0,
+                                       -2.5, 1e-300, 42.0, -42.0,  7.0};
+        for (int i = 0; i < 200; ++i)
+            doubles.push_back(double(i % 17) * (i % 2 ? -1.5 : 1.5));
+        std::vector<double> expected = doubles;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(ok::radix_sort(c_allocator, slice_of(doubles)).is_success());
+        for (size_t i = 0; i < doubles.size(); ++i)
+            REQUIRE(doubles[i] == expected[i]);
+
+        std::vector<int64_t> wide = random_values<int64_t>(10000, ~0ULL >> 1);
+        wide.push_back(INT64_MIN);
+        wide.push_back(INT64_MAX);
+        std::vector<int64_t> expected_wide = wide;
+        std::sort(expected_wide.begin(), expected_wide.end());
+        REQUIRE(ok::radix_sort(c_allocator, slice_of(wide)).is_success());
+        REQUIRE(wide == expected_wide);
+
+        std::vector<uint8_t> bytes(1000);
+        for (size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = uint8_t(i * 31);
+        REQUIRE(ok::radix_sort(c_allocator, slice_of(bytes)).is_success());
+        REQUIRE(std::is_sorted(bytes.begin(), bytes.end()));
+    }
+
+    TEST_CASE("parallel sort")
+    {
+        for (size_t num_threads : {2, 3, 4, 7}) {
+            for (std::vector<int>& input : interesting_inputs(50000)) {
+                std::vector<int> expected = input;
+                std::sort(expected.begin(), expected.end());
+
+                REQUIRE(ok::parallel_sort(c_allocator, slice_of(input),
+                                          {
+                                              .num_threads = num_threads,
+                                              .min_items_per_thread = 1000,
+                                          })
+                            .is_success());
+                REQUIRE(input == expected);
+            }
+        }
+
+        std::vector<int> descending = random_values<int>(100000, 1000);
+        REQUIRE(ok::parallel_sort(c_allocator, slice_of(descending),
+                                  [](const int& a, const int& b) {
+                                      return ok::cmp(b, a);
+                                  },
+                                  {.num_threads = 4,
+                                   .min_items_per_thread = 100})
+                    .is_success());
+        REQUIRE(std::is_sorted(descending.rbegin(), descending.rend()));
+
+        // too small to be worth threads, sorted on the calling thread
+        std::vector<int> small = random_values<int>(100, 1000);
+        REQUIRE(ok::parallel_sort(c_allocator, slice_of(small)).is_success());
+        REQUIRE(std::is_sorted(small.begin(), small.end()));
+    }
+}
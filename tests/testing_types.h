@@ -2,6 +2,7 @@
 #include "okay/containers/array.h"
 #include "okay/detail/abort.h"
 #include "okay/iterables/iterables.h"
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -443,3 +444,24 @@ struct arraylike_iterable_reftype_test_t
 
     int items[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
 };
+
+/// xorshift64, for tests which need lots of reproducible pseudo random
+/// numbers. The state must start out nonzero.
+inline uint64_t next_random(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/// Milliseconds taken by one call of the function, for the benchmarks which
+/// are skipped unless the tests are run with --no-skip.
+template <typename function_t> double time_ms(function_t&& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
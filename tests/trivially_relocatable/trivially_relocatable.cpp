@@ -0,0 +1,158 @@
+#include "test_header.h"
+// test header must be first
+#include "okay/allocators/c_allocator.h"
+#include "okay/containers/arraylist.h"
+#include "okay/containers/bit_arraylist.h"
+#include "okay/containers/fixed_arraylist.h"
+#include "okay/containers/segmented_list.h"
+#include "okay/containers/small_arraylist.h"
+#include "okay/smart_pointers/arc.h"
+#include "testing_types.h"
+
+using namespace ok;
+
+// counts special member calls, but promises that it can be memcpy'd
+struct relocatable_counter_t : counter_type
+{
+    int value = 0;
+
+    relocatable_counter_t() = default;
+    relocatable_counter_t(int v) : value(v) {}
+};
+
+template <>
+struct ok::is_trivially_relocatable<relocatable_counter_t> : stdc::true_type
+{};
+
+struct self_referential_t
+{
+    self_referential_t* self = this;
+    self_referential_t() = default;
+    self_referential_t(self_referential_t&&) : self(this) {}
+    self_referential_t& operator=(self_referential_t&&) { return *this; }
+};
+
+static_assert(is_trivially_relocatable_v<int>);
+static_assert(is_trivially_relocatable_v<const int>);
+static_assert(is_trivially_relocatable_v<int&>);
+static_assert(!is_trivially_relocatable_v<self_referential_t>);
+static_assert(!is_trivially_relocatable_v<counter_type>);
+static_assert(is_trivially_relocatable_v<relocatable_counter_t>);
+static_assert(is_trivially_relocatable_v<slice<int>>);
+static_assert(is_trivially_relocatable_v<opt<int>>);
+static_assert(is_trivially_relocatable_v<opt<relocatable_counter_t>>);
+static_assert(!is_trivially_relocatable_v<opt<self_referential_t>>);
+static_assert(is_trivially_relocatable_v<arraylist_t<int>>);
+static_assert(is_trivially_relocatable_v<arraylist_t<self_referential_t>>);
+static_assert(is_trivially_relocatable_v<bit_arraylist_t<>>);
+static_assert(is_trivially_relocatable_v<segmented_list_t<int>>);
+static_assert(is_trivially_relocatable_v<fixed_arraylist_t<int, 4>>);
+static_assert(
+    !is_trivially_relocatable_v<fixed_arraylist_t<self_referential_t, 4>>);
+static_assert(!is_trivially_relocatable_v<small_arraylist_t<int, 4>>);
+static_assert(is_trivially_relocatable_v<unique_rw_arc_t<int>>);
+static_assert(is_trivially_relocatable_v<opt<arraylist_t<int>>>);
+
+TEST_SUITE("trivially relocatable")
+{
+    TEST_CASE("arraylist growth does not move relocatable items")
+    {
+        c_allocator_t backing;
+        arraylist_t list = arraylist::empty<relocatable_counter_t>(backing);
+        relocatable_counter_t::reset_counters();
+
+        for (int i = 0; i < 100; ++i)
+            list.append(i).or_panic();
+
+        REQUIRE(counter_type::counters.move_constructs == 0);
+        REQUIRE(counter_type::counters.move_assigns == 0);
+        REQUIRE(counter_type::counters.destructs == 0);
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(list[i].value == i);
+    }
+
+    TEST_CASE("insert and remove on relocatable items")
+    {
+        c_allocator_t backing;
+        arraylist_t list = arraylist::empty<relocatable_counter_t>(backing);
+        for (int i = 0; i < 8; ++i)
+            list.append(i).or_panic();
+
+        relocatable_counter_t::reset_counters();
+        list.insert_at(0, 100).or_panic();
+        REQUIRE(counter_type::counters.move_constructs == 0);
+        REQUIRE(list[0].value == 100);
+        REQUIRE(list[1].value == 0);
+        REQUIRE(list[8].value == 7);
+
+        relocatable_counter_t::reset_counters();
+        {
+            relocatable_counter_t removed = list.remove(0);
+            REQUIRE(removed.value == 100);
+        }
+        // the items after the removed one were not shifted one at a time, and
+        // everything that was moved out got destroyed
+        REQUIRE(counter_type::counters.move_assigns == 0);
+        REQUIRE(counter_type::counters.destructs ==
+                counter_type::counters.move_constructs + 1);
+        for (int i = 0; i < 8; ++i)
+            REQUIRE(list[i].value == i);
+
+        relocatable_counter_t::reset_counters();
+        REQUIRE(list.remove_and_swap_last(2).value == 2);
+        REQUIRE(counter_type::counters.move_assigns == 0);
+        REQUIRE(list[2].value == 7);
+        REQUIRE(list.size() == 7);
+    }
+
+    TEST_CASE("remove keeps order for non relocatable items")
+    {
+        c_allocator_t backing;
+        arraylist_t list = arraylist::empty<counter_type>(backing);
+        fixed_arraylist_t<counter_type, 8> fixed;
+        for (int i = 0; i < 5; ++i) {
+            list.append().or_panic();
+            REQUIRE(fixed.append());
+        }
+        counter_type::reset_counters();
+        auto&& _ = list.remove(1);
+        auto&& __ = fixed.remove(1);
+        REQUIRE(list.size() == 4);
+        REQUIRE(fixed.size() == 4);
+        // three items after the removed one get shifted forward
+        REQUIRE(counter_type::counters.move_assigns == 6);
+    }
+
+    TEST_CASE("fixed, small, and segmented lists relocate items")
+    {
+        c_allocator_t backing;
+        small_arraylist_t small =
+            small_arraylist::empty<relocatable_counter_t, 4>(backing);
+        fixed_arraylist_t<relocatable_counter_t, 16> fixed;
+        segmented_list_t segmented =
+            segmented_list::empty<relocatable_counter_t>(backing, {})
+                .unwrap();
+
+        relocatable_counter_t::reset_counters();
+        for (int i = 0; i < 10; ++i) {
+            small.insert_at(0, i).or_panic();
+            REQUIRE(fixed.insert_at(0, i));
+            REQUIRE(segmented.insert_at(0, i).is_success());
+        }
+        REQUIRE(counter_type::counters.move_constructs == 0);
+        REQUIRE(counter_type::counters.move_assigns == 0);
+
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(small[i].value == 9 - i);
+            REQUIRE(fixed.items()[i].value == 9 - i);
+            REQUIRE(segmented[i].value == 9 - i);
+        }
+
+        auto&& a = small.remove(3);
+        auto&& b = fixed.remove(3);
+        auto&& c = segmented.remove(3);
+        REQUIRE(small[3].value == 5);
+        REQUIRE(fixed.items()[3].value == 5);
+        REQUIRE(segmented[3].value == 5);
+    }
+}